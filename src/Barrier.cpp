@@ -327,6 +327,14 @@ bool Barrier::cross(QLineF line) {
     return false;
 }
 
+/* segments in lon/lat, not in scene coordinates: the routing projects them in its own frame */
+void Barrier::appendSegments(QList<QLineF> * segments) {
+    for(int i=0;i<(points.count()-1);++i)
+        segments->append(QLineF(points.at(i)->get_position(),points.at(i+1)->get_position()));
+    if(isClosed && !points.isEmpty())
+        segments->append(QLineF(points.at(0)->get_position(),points.at(points.count()-1)->get_position()));
+}
+
 void Barrier::printBarrier(void) {
     for(int i=0;i<(points.count()-1);++i) {
         qWarning() << "P" << i << ": " << points.at(i)->get_position();
@@ -124,6 +124,7 @@ class Barrier: public QObject, QGraphicsPathItem {
         int is_firstLast(QPointF screenPosition);
 
         bool cross(QLineF line);
+        void appendSegments(QList<QLineF> * segments);
 
         void printBarrier(void);
 
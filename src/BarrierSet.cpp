@@ -68,6 +68,12 @@ bool BarrierSet::cross(QLineF line) {
     return false;
 }
 
+void BarrierSet::appendSegments(QList<QLineF> * segments) {
+    QList<Barrier*>::const_iterator i;
+    for(i=barrierList.begin();i<barrierList.end();++i)
+        (*i)->appendSegments(segments);
+}
+
 void BarrierSet::set_color(QColor color) {
     this->color=color;
     for(int i=0;i<barrierList.count();++i) {
@@ -40,6 +40,7 @@ class BarrierSet: public QObject
         ~BarrierSet(void);
 
         bool cross(QLineF line);
+        void appendSegments(QList<QLineF> * segments);
 
         static void readBarriersFromDisk(MainWindow * mainWindow);
         static void saveBarriersToDisk(void);
@@ -185,20 +185,21 @@ ColorElement::ColorElement(QString name, int transparence) {
     this->transparence=transparence;
     cacheCoef=DEFAULT_CACHE_COEF;
     colorCache=NULL;
+    cacheSize=0;
     cacheLoaded=false;
     cacheLoadedSmooth=false;
 }
 
-QRgb ColorElement::get_color(double v, bool smooth) {
+QRgb ColorElement::get_color(double v, bool smooth) const {
     /* exact match */
     //if(colorMap.contains(v)) return colorMap.value(v);
 
     /* out of bounderies */
-    if(v<=minVal) return colorMap.begin().value();
-    if(v>=maxVal) return (colorMap.end()-1).value();
+    if(v<=minVal) return colorMap.constBegin().value();
+    if(v>=maxVal) return (colorMap.constEnd()-1).value();
 
     /* std case */
-    QMap<double,QRgb>::Iterator it=colorMap.lowerBound(v);
+    QMap<double,QRgb>::ConstIterator it=colorMap.lowerBound(v);
 
     if(smooth) {
         double fact=(v-(it-1).key())/((it).key()-(it-1).key());
@@ -230,15 +231,17 @@ void ColorElement::loadCache(const bool &smooth)
         colorCache[qRound(i)]=get_color(i/10.0,smooth);
 #else
     //qWarning()<<"loading colorElement cache";
-    int nbVal = maxVal-minVal;
+    /* the cache starts at minVal: scales such as the temperatures (K) or CIN do not start at 0 */
+    double nbVal = maxVal-minVal;
     curCacheCoef=cacheCoef;
     if(nbVal*cacheCoef>MAX_CACHE) {
-        curCacheCoef=(int)(MAX_CACHE/nbVal);
+        curCacheCoef=MAX_CACHE/nbVal;
         qWarning() << "Load cache: needed cache too small: color= " << name << ", size=" << nbVal*curCacheCoef << " (MAX=" << MAX_CACHE << ")";
     }
-    colorCache=new QRgb[nbVal*(int)curCacheCoef+1];
-    for (double i=minVal;i<(nbVal*curCacheCoef+1);++i)
-        colorCache[qRound(i)]=get_color(i/((double)curCacheCoef),smooth);
+    cacheSize=qRound(nbVal*curCacheCoef)+1;
+    colorCache=new QRgb[cacheSize];
+    for (int i=0;i<cacheSize;++i)
+        colorCache[i]=get_color(minVal+i/curCacheCoef,smooth);
     cacheLoadedSmooth=false;
     cacheLoaded=false;
     if(smooth)
@@ -255,13 +258,15 @@ void ColorElement::clearCache()
     if(colorCache)
         delete[] colorCache;
     colorCache=NULL;
+    cacheSize=0;
     cacheLoaded=false;
     cacheLoadedSmooth=false;
 }
 
+/* values out of the scale get its first or last color, as with get_color */
 QRgb ColorElement::get_colorCached(const double &v) const {
-    int key=qRound(v*curCacheCoef);
-    return colorCache[key];
+    int key=qRound((v-minVal)*curCacheCoef);
+    return colorCache[qBound(0,key,cacheSize-1)];
 }
 
 void ColorElement::add_color(double value,QRgb color) {
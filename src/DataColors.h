@@ -32,7 +32,7 @@ class ColorElement {
     public:
         ColorElement(QString name,int transparence);
 
-        QRgb get_color(double v, bool smooth);
+        QRgb get_color(double v, bool smooth) const;
 
         QRgb get_colorCached(const double &v) const;
 
@@ -56,6 +56,7 @@ private:
         QRgb * colorCache;
         int cacheCoef;
         double curCacheCoef;
+        int cacheSize;
 
         QString name;
 
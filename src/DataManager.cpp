@@ -18,10 +18,18 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 
+#include <algorithm>
 #include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+#include <QtAlgorithms>
 
 #include "Grib.h"
+#include "GribBlendedRecord.h"
 #include "GribRecord.h"
+#include "GribLoader.h"
+#include "GribSampler.h"
 #include "GribV1.h"
 #include "GribV1Record.h"
 #include "GribV2.h"
@@ -39,6 +47,8 @@ DataManager::DataManager() {
     // init var
     grib=NULL;
     gribCurrent=NULL;
+    loader=new GribLoader();
+    nextExtra=GRIB_EXTRA;
     currentDate=0;
     isoBarsStep = Settings::getSetting("isobarsStep", 2).toDouble();
     isoTherms0Step = Settings::getSetting("isoTherms0Step", 50).toInt();
@@ -51,28 +61,34 @@ DataManager::DataManager() {
 
 }
 
+DataManager::~DataManager() {
+    /* no background decoding left when the records go */
+    delete loader;
+    clear_blendedData();
+    qDeleteAll(extraGribs);
+    extraGribs.clear();
+}
+
 Grib * DataManager::get_grib(int gribType) {
     switch(gribType) {
         case GRIB_GRIB:
             return grib;
         case GRIB_CURRENT:
             return gribCurrent;
-        default: // just in case ...
+        default:
+            if(extraGribs.contains(gribType))
+                return extraGribs.value(gribType);
+            // just in case ...
             qWarning() << "Bad grib type: " << gribType;
             return NULL;
     }
 }
 
 Grib * DataManager::get_grib(int dataType,int levelType, int levelValue) {
-    switch(hasData(dataType,levelType,levelValue)) {
-        case GRIB_GRIB:
-            return grib;
-        case GRIB_CURRENT:
-            return gribCurrent;
-        default:
-            return NULL;
-    }
-
+    int gribType=hasData(dataType,levelType,levelValue);
+    if(gribType==GRIB_NONE)
+        return NULL;
+    return get_grib(gribType);
 }
 
 Grib ** DataManager::get_gribPtr(int gribType) {
@@ -81,25 +97,18 @@ Grib ** DataManager::get_gribPtr(int gribType) {
             return &grib;
         case GRIB_CURRENT:
             return &gribCurrent;
-        default: // just in case ...
+        default:
+            if(extraGribs.contains(gribType))
+                return &extraGribs[gribType];
+            // just in case ...
             qWarning() << "Bad grib type: " << gribType;
             return NULL;
     }
 }
 
 bool DataManager::isOk(int gribType) {
-    if(gribType==GRIB_ANY) {
-        Grib * gribPtr=get_grib(GRIB_GRIB);
-        if(gribPtr)
-            return gribPtr->isOk();
-        else {
-            gribPtr=get_grib(GRIB_CURRENT);
-            if(gribPtr)
-                return gribPtr->isOk();
-            else
-                return false;
-        }
-    }
+    if(gribType==GRIB_ANY)
+        return !sources.isEmpty();
     else {
         Grib * gribPtr=get_grib(gribType);
         if(gribPtr)
@@ -109,19 +118,28 @@ bool DataManager::isOk(int gribType) {
 }
 
 bool DataManager::load_data(QString fileName,int gribType) {
-    Grib ** gribPtr=get_gribPtr(gribType);
-    if(gribPtr) {
-        Grib * ptr=Grib::loadGrib(fileName,this);
+    if(get_gribPtr(gribType)) {
+        /* the GUI runs while loading: the current data stays in place until the new one is complete */
+        Grib * ptr=loader->load(fileName,this);
         if(!ptr) {
             qWarning() << "Can't load file " << fileName;
             return false;
         }
+        Grib ** gribPtr=get_gribPtr(gribType);
+        if(!gribPtr) {
+            delete ptr;
+            return false;
+        }
+        loader->stop_prefetch();
+        loader->stop_save(*gribPtr);
         if(*gribPtr)
             delete *gribPtr;
         *gribPtr=ptr;
+        update_sources();
         update_dateList();
         update_levelMap();
         //print_firstRecord_info();
+        trim_gribCache();
         return true;
     }
     return false;
@@ -130,27 +148,224 @@ bool DataManager::load_data(QString fileName,int gribType) {
 void DataManager::close_data(int gribType) {
     Grib ** gribPtr=get_gribPtr(gribType);
     if(gribPtr) {
+        loader->stop_prefetch();
+        loader->stop_save(*gribPtr);
         delete *gribPtr;
         *gribPtr=NULL;
+        if(gribType>=GRIB_EXTRA) {
+            extraGribs.remove(gribType);
+            extraPriorities.remove(gribType);
+        }
+        update_sources();
         update_dateList();
         update_levelMap();
     }
 }
 
+/* returns the id of the new source (GRIB_EXTRA and above) or GRIB_NONE */
+int DataManager::add_source(QString fileName,int priority) {
+    Grib * ptr=loader->load(fileName,this);
+    if(!ptr || !ptr->isOk()) {
+        qWarning() << "Can't load file " << fileName;
+        if(ptr) delete ptr;
+        return GRIB_NONE;
+    }
+    int gribType=nextExtra++;
+    extraGribs.insert(gribType,ptr);
+    extraPriorities.insert(gribType,priority);
+    update_sources();
+    update_dateList();
+    update_levelMap();
+    trim_gribCache();
+    return gribType;
+}
+
+/* setting "gribExtraSources": list of "priority;fileName" */
+void DataManager::load_extraSources(void) {
+    QStringList list=Settings::getSetting("gribExtraSources",QStringList()).toStringList();
+    for(int i=0;i<list.count();++i) {
+        int sep=list.at(i).indexOf(';');
+        if(sep<=0) continue;
+        bool ok;
+        int priority=list.at(i).left(sep).toInt(&ok);
+        QString fileName=list.at(i).mid(sep+1);
+        if(ok && QFile::exists(fileName))
+            add_source(fileName,priority);
+    }
+}
+
+void DataManager::update_sources(void) {
+    clear_blendedData();
+    sources.clear();
+    source src;
+    if(grib && grib->isOk()) {
+        src.gribType=GRIB_GRIB;
+        src.priority=0;
+        src.grib=grib;
+        sources.append(src);
+    }
+    if(gribCurrent && gribCurrent->isOk()) {
+        src.gribType=GRIB_CURRENT;
+        src.priority=-1;
+        src.grib=gribCurrent;
+        sources.append(src);
+    }
+    QMapIterator<int,Grib *> it(extraGribs);
+    while(it.hasNext()) {
+        it.next();
+        if(!it.value() || !it.value()->isOk()) continue;
+        src.gribType=it.key();
+        src.priority=extraPriorities.value(it.key(),0);
+        src.grib=it.value();
+        sources.append(src);
+    }
+    qStableSort(sources.begin(),sources.end(),sourceLessThan);
+    if(sources.count()>32) {
+        qWarning() << "Too many grib sources, only the first 32 are used";
+        while(sources.count()>32) sources.removeLast();
+    }
+
+    /* coverage map: the sources overlapping each cell, keeping the priority order.
+       A global grid has no zone and covers every cell */
+    int nb=sources.count();
+    QVector<bool> full(nb);
+    QVector<double> x0(nb),y0(nb),x1(nb),y1(nb);
+    for(int s=0;s<nb;++s)
+        full[s]=!sources.at(s).grib->getZoneExtension(&x0[s],&y0[s],&x1[s],&y1[s]);
+
+    /* time slots: a source starts to answer at its first date and, after its
+       last one, only holds its last value. The slot boundaries are these dates */
+    QVector<time_t> first(nb),after(nb);
+    std::set<time_t> boundaries;
+    for(int s=0;s<nb;++s) {
+        std::set<time_t> dates;
+        sources.at(s).grib->update_dateList(&dates);
+        first[s]=dates.empty()?0:*dates.begin();
+        after[s]=dates.empty()?0:*dates.rbegin()+1;
+        boundaries.insert(first[s]);
+        boundaries.insert(after[s]);
+    }
+    coverageSlots.clear();
+    for(std::set<time_t>::iterator it=boundaries.begin();it!=boundaries.end();++it)
+        coverageSlots.append(*it);
+    int nbSlots=coverageSlots.count()+1;
+    /* sources in their dates and sources past their end, for each slot */
+    QVector<quint32> inDates(nbSlots,0),pastEnd(nbSlots,0);
+    for(int slot=0;slot<nbSlots;++slot) {
+        if(slot==0) continue; /* before every first date: no source answers */
+        time_t t=coverageSlots.at(slot-1);
+        for(int s=0;s<nb;++s) {
+            if(t<first[s]) continue;
+            if(t<after[s])
+                inDates[slot]|=1u<<s;
+            else
+                pastEnd[slot]|=1u<<s;
+        }
+    }
+
+    coverageChains.clear();
+    coverageTable.clear();
+    coverageCells.fill(0,360*180);
+    QHash<quint32,int> maskIndex;
+    QHash<quint64,int> chainIndex;
+    for(int j=0;j<180;++j) {
+        double lat=j-90;
+        for(int i=0;i<360;++i) {
+            quint32 mask=0;
+            for(int s=0;s<nb;++s) {
+                if(!full[s]) {
+                    if(qMin(y0[s],y1[s])>lat+1 || qMax(y0[s],y1[s])<lat) continue;
+                    bool overlap=false;
+                    for(int shift=-360;shift<=360 && !overlap;shift+=360)
+                        overlap=x0[s]+shift<=i+1 && x1[s]+shift>=i;
+                    if(!overlap) continue;
+                }
+                mask|=1u<<s;
+            }
+            int idx=maskIndex.value(mask,-1);
+            if(idx==-1) {
+                /* the sources in their dates first, then the ones holding their last value */
+                idx=maskIndex.count();
+                maskIndex.insert(mask,idx);
+                for(int slot=0;slot<nbSlots;++slot) {
+                    quint32 now=mask&inDates[slot],old=mask&pastEnd[slot];
+                    quint64 key=((quint64)now<<32)|old;
+                    int chainIdx=chainIndex.value(key,-1);
+                    if(chainIdx==-1) {
+                        QVector<Grib *> chain;
+                        for(int s=0;s<nb;++s)
+                            if(now&(1u<<s)) chain.append(sources.at(s).grib);
+                        for(int s=0;s<nb;++s)
+                            if(old&(1u<<s)) chain.append(sources.at(s).grib);
+                        chainIdx=coverageChains.count();
+                        coverageChains.append(chain);
+                        chainIndex.insert(key,chainIdx);
+                    }
+                    coverageTable.append(chainIdx);
+                }
+            }
+            coverageCells[j*360+i]=idx;
+        }
+    }
+}
+
+const QVector<Grib *> & DataManager::get_coverage(double d_long,double d_lat,time_t t) const {
+    static const QVector<Grib *> noSource;
+    if(coverageCells.isEmpty() || coverageTable.isEmpty() || d_long!=d_long || d_lat!=d_lat)
+        return noSource;
+    int nbSlots=coverageSlots.count()+1;
+    return coverageChains.at(coverageTable.at(coverageCells.at(get_coverageCell(d_long,d_lat))*nbSlots+get_coverageSlot(t)));
+}
+
+int DataManager::get_coverageCell(const double &d_long,const double &d_lat) {
+    int i=(int)floor(fmod(d_long,360.0));
+    if(i<0) i+=360;
+    if(i>359) i=359;
+    int j=qBound(0,(int)floor(d_lat+90),179);
+    return j*360+i;
+}
+
+int DataManager::get_coverageSlot(time_t t) const {
+    return std::upper_bound(coverageSlots.constBegin(),coverageSlots.constEnd(),t)-coverageSlots.constBegin();
+}
+
 void DataManager::set_currentDate(time_t t) {
     if(t!=currentDate) {
         currentDate=t;
-        if(grib) grib->init_isos(t);
-        if(gribCurrent) gribCurrent->init_isos(t);
+        clear_blendedData();
+        for(int s=0;s<sources.count();++s)
+            sources.at(s).grib->init_isos(t);
+        trim_gribCache();
     }
 }
 
+/* memory cap of the records loaded lazily, to be called when no thread is reading grib data.
+   Background decoding then starts again from the current date */
+void DataManager::trim_gribCache(void) {
+    /* a grib being loaded may be reading its records (dewpoint) */
+    if(loader->isLoading())
+        return;
+    loader->stop_prefetch();
+    GribCache::set_maxSize((qint64)Settings::getSetting("gribCacheSize",512).toInt()*1024*1024);
+    GribCache::trim();
+    start_prefetch();
+}
+
+void DataManager::start_prefetch(void) {
+    if(Settings::getSetting("gribPrefetch",1).toInt()!=1)
+        return;
+    QList<Grib *> gribs;
+    for(int s=0;s<sources.count();++s)
+        gribs.append(sources.at(s).grib);
+    loader->start_prefetch(gribs,currentDate);
+}
+
 void DataManager::update_dateList(void) {
     dateList.clear();
     minDate=-1;
     maxDate=-1;
-    if(grib && grib->isOk()) grib->update_dateList(&dateList);
-    if(gribCurrent && gribCurrent->isOk()) gribCurrent->update_dateList(&dateList);
+    for(int s=0;s<sources.count();++s)
+        sources.at(s).grib->update_dateList(&dateList);
 
     /* update min / max value */
     std::set<time_t>::iterator its;
@@ -171,8 +386,8 @@ void DataManager::update_dateList(void) {
 
 void DataManager::update_levelMap(void) {
     clear_levelMap();
-    if(grib && grib->isOk()) grib->update_levelMap(&levelMap);
-    if(gribCurrent && gribCurrent->isOk()) gribCurrent->update_levelMap(&levelMap);
+    for(int s=0;s<sources.count();++s)
+        sources.at(s).grib->update_levelMap(&levelMap);
 }
 
 void DataManager::clear_levelMap(void) {
@@ -205,23 +420,23 @@ QString DataManager::get_fileName(int gribType) {
 
 QString DataManager::get_cartoucheData(void)
 {
-    if ((!grib || !grib->isOk()) && (!gribCurrent || !gribCurrent->isOk())) return QString();
+    if (sources.isEmpty()) return QString();
     return Util::formatDateTimeLong(currentDate);
 }
 
 void DataManager::set_isoBarsStep(double step) {
     if(step!=isoBarsStep) {
         isoBarsStep=step;
-        if(grib) grib->init_isoBars(currentDate);
-        if(gribCurrent) gribCurrent->init_isoBars(currentDate);
+        for(int s=0;s<sources.count();++s)
+            sources.at(s).grib->init_isoBars(currentDate);
     }
 }
 
 void DataManager::set_isoTherms0Step(int step) {
     if(step!=isoTherms0Step) {
         isoTherms0Step=step;
-        if(grib) grib->init_isoTherms0(currentDate);
-        if(gribCurrent) gribCurrent->init_isoTherms0(currentDate);
+        for(int s=0;s<sources.count();++s)
+            sources.at(s).grib->init_isoTherms0(currentDate);
     }
 }
 
@@ -233,48 +448,120 @@ bool DataManager::hasData(int dataType, int levelType, int levelValue,int gribTy
 }
 
 int DataManager::hasData(int dataType,int levelType, int levelValue) {
-    if(grib && grib->isOk() && grib->hasData(dataType,levelType,levelValue))
-        return GRIB_GRIB;
-    else if((dataType==DATA_CURRENT_VX || dataType==DATA_CURRENT_VY)
-            && gribCurrent && gribCurrent->isOk() && gribCurrent->hasData(dataType,levelType,levelValue))
-        return GRIB_CURRENT;
+    for(int s=0;s<sources.count();++s) {
+        const source &src=sources.at(s);
+        if(src.gribType==GRIB_CURRENT && dataType!=DATA_CURRENT_VX && dataType!=DATA_CURRENT_VY)
+            continue;
+        if(src.grib->hasData(dataType,levelType,levelValue))
+            return src.gribType;
+    }
     return GRIB_NONE;
 }
 
 bool DataManager::get_data1D(int dataType,int levelType, int levelValue,time_t now,time_t * tPrev,time_t * tNxt,
-                             GribRecord ** recPrev,GribRecord ** recNxt) {
-    if(grib && grib->isOk()) {
-        if(grib->get_recordsAndTime_1D(dataType,levelType,levelValue,now,tPrev,tNxt,recPrev,recNxt))
+                             GribRecord ** recPrev,GribRecord ** recNxt,int * source) {
+    for(int s=source?*source:0;s<sources.count();++s)
+        if(sources.at(s).grib->get_recordsAndTime_1D(dataType,levelType,levelValue,now,tPrev,tNxt,recPrev,recNxt)) {
+            if(source) *source=s;
             return true;
-        else if(gribCurrent && gribCurrent->isOk())
-            return gribCurrent->get_recordsAndTime_1D(dataType,levelType,levelValue,now,tPrev,tNxt,recPrev,recNxt);
-    }
+        }
     return false;
 }
 
 bool DataManager::get_data2D(int dataType1,int dataType2,int levelType, int levelValue,
                              time_t now,time_t * tPrev,time_t * tNxt,
-                             GribRecord ** recU1,GribRecord ** recV1,GribRecord ** recU2,GribRecord ** recV2) {
-    if(grib && grib->isOk()) {
-        if(grib->get_recordsAndTime_2D(dataType1,dataType2,levelType,levelValue,now,tPrev,tNxt,recU1,recV1,recU2,recV2))
+                             GribRecord ** recU1,GribRecord ** recV1,GribRecord ** recU2,GribRecord ** recV2,
+                             int * source) {
+    for(int s=source?*source:0;s<sources.count();++s)
+        if(sources.at(s).grib->get_recordsAndTime_2D(dataType1,dataType2,levelType,levelValue,
+                                                     now,tPrev,tNxt,recU1,recV1,recU2,recV2)) {
+            if(source) *source=s;
             return true;
-        else if(gribCurrent && gribCurrent->isOk())
-            return gribCurrent->get_recordsAndTime_2D(dataType1,dataType2,levelType,levelValue,
-                                                      now,tPrev,tNxt,recU1,recV1,recU2,recV2);
-    }
+        }
     return false;
 }
 
+bool DataManager::get_blendedData1D(int dataType,int levelType,int levelValue,GribRecord ** rec,int * source) {
+    if(!rec) return false;
+    QPair<qint64,int> key(GribRecord::makeKey(dataType,levelType,levelValue),source?*source:0);
+    QHash<QPair<qint64,int>,blendedField>::const_iterator it=blendedData.constFind(key);
+    if(it==blendedData.constEnd()) {
+        blendedField field;
+        field.rec1=field.rec2=NULL;
+        field.owned=false;
+        field.source=key.second;
+        GribRecord *recPrev,*recNxt;
+        time_t tPrev,tNxt;
+        if(get_data1D(dataType,levelType,levelValue,currentDate,&tPrev,&tNxt,&recPrev,&recNxt,&field.source)) {
+            if(tPrev==tNxt)
+                field.rec1=recPrev;
+            else {
+                field.rec1=GribBlendedRecord::blend_1D(recPrev,recNxt,tPrev,tNxt,currentDate);
+                field.owned=true;
+            }
+        }
+        it=blendedData.insert(key,field);
+    }
+    *rec=it.value().rec1;
+    if(*rec && source) *source=it.value().source;
+    return *rec!=NULL;
+}
+
+bool DataManager::get_blendedData2D(int dataType1,int dataType2,int levelType,int levelValue,bool UV,
+                                    GribRecord ** recU,GribRecord ** recV,int * source) {
+    if(!recU || !recV) return false;
+    QPair<qint64,int> key(((qint64)GribRecord::makeKey(dataType1,levelType,levelValue)<<32)
+                          | GribRecord::makeKey(dataType2,levelType,levelValue),source?*source:0);
+    QHash<QPair<qint64,int>,blendedField>::const_iterator it=blendedData.constFind(key);
+    if(it==blendedData.constEnd()) {
+        blendedField field;
+        field.rec1=field.rec2=NULL;
+        field.owned=false;
+        field.source=key.second;
+        GribRecord *recU1,*recV1,*recU2,*recV2;
+        time_t tPrev,tNxt;
+        if(get_data2D(dataType1,dataType2,levelType,levelValue,currentDate,&tPrev,&tNxt,&recU1,&recV1,&recU2,&recV2,
+                      &field.source)) {
+            if(tPrev==tNxt || !recU2 || !recV2) {
+                field.rec1=recU1;
+                field.rec2=recV1;
+            }
+            else {
+                GribBlendedRecord *u,*v;
+                if(GribBlendedRecord::blend_2D(recU1,recV1,recU2,recV2,tPrev,tNxt,currentDate,UV,&u,&v)) {
+                    field.rec1=u;
+                    field.rec2=v;
+                    field.owned=true;
+                }
+            }
+        }
+        it=blendedData.insert(key,field);
+    }
+    *recU=it.value().rec1;
+    *recV=it.value().rec2;
+    if(*recU && *recV && source) *source=it.value().source;
+    return *recU!=NULL && *recV!=NULL;
+}
+
+void DataManager::clear_blendedData(void) {
+    QHashIterator<QPair<qint64,int>,blendedField> it(blendedData);
+    while(it.hasNext()) {
+        it.next();
+        if(it.value().owned) {
+            if(it.value().rec1) delete it.value().rec1;
+            if(it.value().rec2) delete it.value().rec2;
+        }
+    }
+    blendedData.clear();
+}
+
 double DataManager::getInterpolatedValue_1D(int dataType,int levelType,int levelValue,
                                double d_long, double d_lat, time_t now) {
     double res;
-    if(grib && grib->isOk()) {
-        if(grib->getInterpolatedValue_1D(dataType,levelType,levelValue,d_long,d_lat,now,&res))
+    const QVector<Grib *> &chain=get_coverage(d_long,d_lat,now);
+    for(int g=0;g<chain.count();++g)
+        if(chain.at(g)->getInterpolatedValue_1D(dataType,levelType,levelValue,d_long,d_lat,now,&res))
             return res;
-        else if(gribCurrent && gribCurrent->isOk())
-            if(gribCurrent->getInterpolatedValue_1D(dataType,levelType,levelValue,d_long,d_lat,now,&res))
-                return res;
-    }
     return false;
 }
 
@@ -298,13 +585,10 @@ bool DataManager::getInterpolatedValue_2D(int dataType1,int dataType2,int levelT
     if(interpolation_type == INTERPOLATION_UKN)
         interpolation_type=interpolationMode;
 
-    if(grib && grib->isOk()) {
-        if(grib->getInterpolatedValue_2D(dataType1,dataType2,levelType,levelValue,d_long,d_lat,now,u,v,interpolation_type,UV,debug))
+    const QVector<Grib *> &chain=get_coverage(d_long,d_lat,now);
+    for(int g=0;g<chain.count();++g)
+        if(chain.at(g)->getInterpolatedValue_2D(dataType1,dataType2,levelType,levelValue,d_long,d_lat,now,u,v,interpolation_type,UV,debug))
             return true;
-        else if(gribCurrent && gribCurrent->isOk())
-            if(gribCurrent->getInterpolatedValue_2D(dataType1,dataType2,levelType,levelValue,d_long,d_lat,now,u,v,interpolation_type,UV,debug))
-                return true;
-    }
     return false;
 }
 
@@ -338,6 +622,72 @@ bool DataManager::getInterpolatedCurrent(double d_long, double d_lat, time_t now
                                    d_long,d_lat,now,u,v,interpolation_type,true,debug);
 }
 
+/* resolves once what getInterpolatedValue_2D looks up for each point: forced values,
+   the records around 'now' in each source and the chain of sources of each cell */
+void DataManager::init_sampler(GribSampler * sampler,int dataType1,int dataType2,int levelType,int levelValue,
+                               time_t now,int interpolation_type) {
+    if(!sampler) return;
+    sampler->clear();
+    sampler->date=now;
+    if(interpolation_type == INTERPOLATION_UKN)
+        interpolation_type=interpolationMode;
+    sampler->interpolationType=interpolation_type;
+    sampler->valid=true;
+
+    if(forceWind && dataType1==DATA_WIND_VX) {
+        sampler->forced=true;
+        sampler->forcedU=forcedTWS;
+        sampler->forcedV=forcedTWD;
+        return;
+    }
+
+    if(forceCurrents && dataType1==DATA_CURRENT_VX) {
+        sampler->forced=true;
+        sampler->forcedU=forcedCS;
+        sampler->forcedV=forcedCD;
+        return;
+    }
+
+    QHash<Grib *,int> index;
+    for(int g=0;g<sources.count() && sampler->nbSources<GRIB_SAMPLER_MAX_SOURCES;++g) {
+        GribSampler::source &src=sampler->sources[sampler->nbSources];
+        src.t2=0;
+        if(sources.at(g).grib->get_recordsAndTime_2D(dataType1,dataType2,levelType,levelValue,now,&src.t1,&src.t2,
+                                                     &src.recU1,&src.recV1,&src.recU2,&src.recV2)) {
+            index.insert(sources.at(g).grib,sampler->nbSources);
+            ++sampler->nbSources;
+        }
+    }
+
+    /* the coverage at 'now': for each set of sources of the cells (see update_sources),
+       its chain in this time slot, as sampler sources */
+    if(coverageCells.isEmpty() || coverageTable.isEmpty())
+        return;
+    int nbSlots=coverageSlots.count()+1;
+    int slot=get_coverageSlot(now);
+    int nbSets=coverageTable.count()/nbSlots;
+    sampler->coverageCells=coverageCells;
+    sampler->chains.resize(nbSets);
+    for(int set=0;set<nbSets;++set) {
+        const QVector<Grib *> &chain=coverageChains.at(coverageTable.at(set*nbSlots+slot));
+        GribSampler::chain &samplerChain=sampler->chains[set];
+        samplerChain.nb=0;
+        for(int g=0;g<chain.count();++g) {
+            int s=index.value(chain.at(g),-1);
+            if(s!=-1)
+                samplerChain.src[samplerChain.nb++]=s;
+        }
+    }
+}
+
+void DataManager::init_windSampler(GribSampler * sampler,time_t now,int interpolation_type) {
+    init_sampler(sampler,DATA_WIND_VX,DATA_WIND_VY,DATA_LV_ABOV_GND,10,now,interpolation_type);
+}
+
+void DataManager::init_currentSampler(GribSampler * sampler,time_t now,int interpolation_type) {
+    init_sampler(sampler,DATA_CURRENT_VX,DATA_CURRENT_VY,DATA_LV_MSL,0,now,interpolation_type);
+}
+
 bool DataManager::getZoneExtension (int gribType,double *x0,double *y0, double *x1,double *y1) {
     Grib * gribPtr = get_grib(gribType);
     if(gribPtr) {
@@ -22,6 +22,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define DATAMANAGER_H
 
 #include <set>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVector>
 
 #include "dataDef.h"
 #include "class_list.h"
@@ -30,10 +34,16 @@ class DataManager
 {
     public:
         DataManager();
+        ~DataManager();
 
         bool load_data(QString fileName,int gribType);
         void close_data(int gribType);
 
+        /* extra sources (nested regional models, wave files, ...) on top of grib and gribCurrent:
+           sources are asked by decreasing priority, grib has priority 0 and gribCurrent -1 */
+        int add_source(QString fileName,int priority);
+        void load_extraSources(void);
+
         void set_currentDate(time_t t);
         FCT_GET(time_t,currentDate)
         FCT_GET(time_t,minDate)
@@ -55,10 +65,19 @@ class DataManager
         int hasData(int dataType,int levelType, int levelValue);
         bool hasData(int dataType, int levelType, int levelValue,int gribType);
 
+        /* source: index of the first source to look in (by decreasing priority), set to the
+           one found. Map drawing takes the next ones for the cells out of its zone */
         bool get_data1D(int dataType,int levelType, int levelValue,time_t now,time_t * tPrev,time_t * tNxt,
-                                     GribRecord ** recPrev,GribRecord ** recNxt);
+                                     GribRecord ** recPrev,GribRecord ** recNxt,int * source=NULL);
         bool get_data2D(int dataType1,int dataType2,int levelType, int levelValue,time_t now,time_t * tPrev,time_t * tNxt,
-                                     GribRecord ** recU1,GribRecord ** recV1,GribRecord ** recU2,GribRecord ** recV2);
+                                     GribRecord ** recU1,GribRecord ** recV1,GribRecord ** recU2,GribRecord ** recV2,
+                                     int * source=NULL);
+
+        /* fields of currentDate already interpolated in time, for map drawing: the caller only
+           interpolates in space (no next record). false when the records can't be blended */
+        bool get_blendedData1D(int dataType,int levelType,int levelValue,GribRecord ** rec,int * source=NULL);
+        bool get_blendedData2D(int dataType1,int dataType2,int levelType,int levelValue,bool UV,
+                               GribRecord ** recU,GribRecord ** recV,int * source=NULL);
 
         double getInterpolatedValue_1D(int dataType,int levelType,int levelValue,
                                        double d_long, double d_lat, time_t now);
@@ -69,9 +88,14 @@ class DataManager
                                               int interpolation_type=INTERPOLATION_UKN,bool debug=false);
         bool getInterpolatedCurrent(double d_long, double d_lat, time_t now,double * u, double * v,
                                               int interpolation_type=INTERPOLATION_UKN,bool debug=false);
+        void init_sampler(GribSampler * sampler,int dataType1,int dataType2,int levelType,int levelValue,
+                          time_t now,int interpolation_type=INTERPOLATION_UKN);
+        void init_windSampler(GribSampler * sampler,time_t now,int interpolation_type=INTERPOLATION_UKN);
+        void init_currentSampler(GribSampler * sampler,time_t now,int interpolation_type=INTERPOLATION_UKN);
 
 
         bool getZoneExtension (int gribType,double *x0,double *y0, double *x1,double *y1);
+        static int get_coverageCell(const double &d_long,const double &d_lat);
 
         FCT_SETGET(int,interpolationMode)
 
@@ -83,11 +107,13 @@ class DataManager
         FCT_GET(int,isoTherms0Step)
 
         void load_forcedParam();
+        void trim_gribCache(void);
 
         enum { GRIB_NONE=0,
                GRIB_GRIB,
                GRIB_CURRENT,
-               GRIB_ANY
+               GRIB_ANY,
+               GRIB_EXTRA
              };
 
         void print_firstRecord_bmap(void);
@@ -97,10 +123,46 @@ class DataManager
 
         Grib * grib;
         Grib * gribCurrent;
+        GribLoader * loader;
+        void start_prefetch(void);
 
         Grib ** get_gribPtr(int gribType);
 
+        struct source {
+            int gribType;
+            int priority;
+            Grib * grib;
+        };
+        static bool sourceLessThan(const source &s1,const source &s2) { return s1.priority>s2.priority; }
+
+        QMap<int,Grib *> extraGribs;
+        QMap<int,int> extraPriorities;
+        int nextExtra;
+
+        /* loaded sources by decreasing priority, and for each 1 degree cell and time slot
+           the chain of the sources whose zone overlaps the cell, the ones covering the
+           slot first. coverageCells gives the set of sources of a cell, coverageTable
+           the chain of a set in each slot (cells sharing a set share its entries) */
+        QList<source> sources;
+        QVector<quint16> coverageCells;
+        QVector<time_t> coverageSlots;
+        QVector<int> coverageTable;
+        QVector<QVector<Grib *> > coverageChains;
+        void update_sources(void);
+        const QVector<Grib *> & get_coverage(double d_long,double d_lat,time_t t) const;
+        int get_coverageSlot(time_t t) const;
+
         time_t currentDate;
+        struct blendedField {
+            GribRecord * rec1;
+            GribRecord * rec2;
+            bool owned;      // blended copies, otherwise records of a grib (no blend needed)
+            int source;
+        };
+        /* for currentDate, by data key and first source looked in, see get_blendedData1D/2D */
+        QHash<QPair<qint64,int>,blendedField> blendedData;
+        void clear_blendedData(void);
+
         void update_dateList(void);
         std::set<time_t> dateList;
         time_t minDate;
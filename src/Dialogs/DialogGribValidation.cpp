@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "dataDef.h"
 #include "settings.h"
 #include "DataManager.h"
+#include "Grib.h"
 
 #ifdef __QTVLM_WITH_TEST
 extern int nbWarning;
@@ -95,6 +96,11 @@ void DialogGribValidation::interpolationChanged(int newMode)
         newMode++;
         dataManager->set_interpolationMode(newMode);
         qWarning() << "Setting interpolation mode to " << newMode;
+#ifdef __QTVLM_WITH_TEST
+        Grib * grib=dataManager->get_grib(DataManager::GRIB_GRIB);
+        if(grib && !grib->check_interpolationBatch(dataManager->get_currentDate()))
+            qWarning() << "Batch interpolation differs from point interpolation";
+#endif
     }
 
     this->my_centralWidget->send_redrawAll();
@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "boatReal.h"
 #include "Player.h"
 #include "Util.h"
+#include "Polar.h"
 
 DialogRealBoatConfig::DialogRealBoatConfig(myCentralWidget *parent) : QDialog(parent)
 {
@@ -108,6 +109,8 @@ void DialogRealBoatConfig::done(int result)
             curBoat->emitMoveBoat();
         curBoat->setMinSpeedForEngine(minSpeedForEngine->value());
         curBoat->setSpeedWithEngine(speedWithEngine->value());
+        if(curBoat->getPolarData())
+            curBoat->getPolarData()->slot_updateEngine();
         this->parent->emitUpdateRoute(curBoat);
     }
     QDialog::done(result);
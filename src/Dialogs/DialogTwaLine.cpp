@@ -299,10 +299,7 @@ void DialogTwaLine::traceIt()
             Util::getCoordFromDistanceAngle(current.lat, current.lon, distanceParcourue, cap,&lat,&lon);
             if(!crossing && map && mapQuality>=3)
             {
-                double I1,J1,I2,J2;
-                parent->getProj()->map2screenDouble(current.lon,current.lat,&I1,&J1);
-                parent->getProj()->map2screenDouble(lon,lat,&I2,&J2);
-                crossing=map->crossing(QLineF(I1,J1,I2,J2),QLineF(current.lon,current.lat,lon,lat));
+                crossing=map->crossing(QLineF(current.lon,current.lat,lon,lat));
             }
             current.lon=lon;
             current.lat=lat;
@@ -22,8 +22,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <math.h>
 
 #include <cassert>
+#include <algorithm>
 #include <QDebug>
 #include <QVector>
+#include <QTime>
 
 #include "Grib.h"
 #include "Util.h"
@@ -38,6 +40,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "GribV2.h"
 #include "GribV1Record.h"
 #include "GribV2Record.h"
+#include "GribCacheFile.h"
+#include "GribBlendedRecord.h"
+#include "GribCache.h"
 #include <QMap>
 
 #include "interpolation.h"
@@ -49,6 +54,11 @@ Grib::Grib(DataManager * dataManager) {
     version=0;
     fileName="";
     fileSize=0;
+    cacheFile=NULL;
+    packData=false;
+    loadState=NULL;
+    isoBarsDate=0;
+    isoTherms0Date=0;
 
     dewpointDataStatus = NO_DATA_IN_FILE;
 }
@@ -56,27 +66,135 @@ Grib::Grib(DataManager * dataManager) {
 Grib::~Grib() {
     if(ok)
         clean_all_vectors();
-    Util::cleanListPointers(listIsobars);
-    Util::cleanListPointers(listIsotherms0);
+    clear_isos();
+    if(cacheFile)
+        delete cacheFile;
 }
 
-Grib * Grib::loadGrib(QString fileName,DataManager *dataManager) {
+Grib * Grib::loadGrib(QString fileName,DataManager *dataManager,GribLoadState * state) {
     Grib * grib=NULL;
     /* first try to find grib version */
-    if(GribV1::isGribV1(fileName)) {
-            GribV1 * ptr=new GribV1(dataManager);
-            ptr->loadFile(fileName);
-            grib=(Grib*)ptr;
-        }
-    else if(GribV2::isGribV2(fileName)) {
-        GribV2 * ptr=new GribV2(dataManager);
-        ptr->loadFile(fileName);
-        grib=(Grib*)ptr;
+    if(GribV1::isGribV1(fileName))
+        grib=new GribV1(dataManager);
+    else if(GribV2::isGribV2(fileName))
+        grib=new GribV2(dataManager);
+    if(!grib)
+        return NULL;
+
+    grib->loadState=state;
+
+    /* records are kept on 16 bits, see GribRecord::packData. The mode belongs to
+       this grib: the setting can change while the previous one is still drawn */
+    grib->packData=state?state->packData:Settings::getSetting("gribPackedData",0).toInt()==1;
+
+    /* the sidecar cache of a previous load is mapped instead of decoding the file */
+    bool useCache=state?state->useDiskCache:Settings::getSetting("gribDiskCache",1).toInt()==1;
+    if(!useCache || !GribCacheFile::load(grib,fileName)) {
+        grib->loadFile(fileName);
+        if(grib->packData && grib->isOk())
+            grib->packRecords();
     }
 
+    grib->loadState=NULL;
     return grib;
 }
 
+void Grib::set_loadProgress(qint64 done,qint64 total) {
+    if(!loadState) return;
+    loadState->kbTotal.fetchAndStoreRelaxed((int)(total>>10));
+    loadState->kbDone.fetchAndStoreRelaxed((int)(done>>10));
+}
+
+void Grib::get_recordsToPrefetch(time_t date,QList<GribRecord *> * records) {
+    if(!ok || !records) return;
+    /* wind, then current, then the rest; by distance to date in each group */
+    QMultiMap<qint64,GribRecord *> sorted;
+    std::map<long int,QMap<time_t,GribRecord *>*>::iterator it;
+    for(it=mapGribRecords.begin();it!=mapGribRecords.end();++it) {
+        QMap<time_t,GribRecord *>::iterator itRec;
+        for(itRec=it->second->begin();itRec!=it->second->end();++itRec) {
+            GribRecord * rec=itRec.value();
+            if(!rec || !rec->isOk() || rec->isDataReady()) continue;
+            qint64 group=2;
+            if((rec->get_dataType()==DATA_WIND_VX || rec->get_dataType()==DATA_WIND_VY)
+                    && rec->get_levelType()==DATA_LV_ABOV_GND && rec->get_levelValue()==10)
+                group=0;
+            else if(rec->get_dataType()==DATA_CURRENT_VX || rec->get_dataType()==DATA_CURRENT_VY)
+                group=1;
+            sorted.insert((group<<40)+qAbs((qint64)itRec.key()-(qint64)date),rec);
+        }
+    }
+    *records=sorted.values();
+}
+
+/* records still in float (lazy records are packed when read) */
+void Grib::packRecords(void) {
+    std::map<long int,QMap<time_t,GribRecord *>*>::iterator it;
+    for(it=mapGribRecords.begin();it!=mapGribRecords.end();++it) {
+        QMap<time_t,GribRecord *>::iterator itRec;
+        for(itRec=it->second->begin();itRec!=it->second->end();++itRec) {
+            GribRecord * rec=itRec.value();
+            if(rec->isOk())
+                rec->packData();
+        }
+    }
+}
+
+/* memory gain, error and interpolation cost of the packed storage: a float
+   copy of the first wind record is compared to a packed copy of it, the
+   records of the grib are left as they are */
+void Grib::benchmark_packedData(void) {
+    if(tList.empty())
+        return;
+    GribBlendedRecord * rec=GribBlendedRecord::copy(getGribRecord(DATA_WIND_VX,DATA_LV_ABOV_GND,10,*tList.begin()));
+    GribBlendedRecord * recPacked=GribBlendedRecord::copy(rec);
+    if(!rec || !recPacked) {
+        if(rec) delete rec;
+        return;
+    }
+    recPacked->packData();
+    const int nbSamples=200000;
+    QVector<double> lon(nbSamples),lat(nbSamples);
+    for(int k=0;k<nbSamples;++k) {
+        lon[k]=rec->get_lonMin()+(rec->get_lonMax()-rec->get_lonMin())*qrand()/RAND_MAX;
+        lat[k]=rec->get_latMin()+(rec->get_latMax()-rec->get_latMin())*qrand()/RAND_MAX;
+    }
+    QTime timer;
+    timer.start();
+    for(int k=0;k<nbSamples;++k)
+        rec->getInterpolatedValue(lon[k],lat[k]);
+    int tFloat=timer.elapsed();
+
+    /* sizes from the headers, lazy records are not read for this */
+    qint64 sizeFloat=0,sizePacked=0;
+    std::map<long int,QMap<time_t,GribRecord *>*>::iterator it;
+    for(it=mapGribRecords.begin();it!=mapGribRecords.end();++it) {
+        QMap<time_t,GribRecord *>::iterator itRec;
+        for(itRec=it->second->begin();itRec!=it->second->end();++itRec) {
+            GribRecord * r=itRec.value();
+            sizeFloat+=r->get_dataSize()*sizeof(float)+r->get_bmapSize()*sizeof(bool);
+            sizePacked+=r->get_dataSize()*sizeof(quint16)+r->get_bmapSize()*sizeof(bool);
+        }
+    }
+
+    double maxError=0;
+    for(int j=0;j<rec->get_Nj();++j)
+        for(int i=0;i<rec->get_Ni();++i)
+            if(rec->hasValue(i,j))
+                maxError=qMax(maxError,(double)qAbs(recPacked->getValue(i,j)-rec->getValue(i,j)));
+
+    timer.start();
+    for(int k=0;k<nbSamples;++k)
+        recPacked->getInterpolatedValue(lon[k],lat[k]);
+    int tPacked=timer.elapsed();
+    delete rec;
+    delete recPacked;
+
+    qWarning() << "packed grib benchmark: memory" << sizeFloat/1024 << "KB ->" << sizePacked/1024
+               << "KB, wind max error" << maxError << "m/s, " << nbSamples << "interpolations:"
+               << tFloat << "ms ->" << tPacked << "ms";
+}
+
 /**************************
  * Info string            *
  **************************/
@@ -132,6 +250,8 @@ void Grib::clean_all_vectors() {
         delete ls;
     }
     mapGribRecords.clear();
+    qDeleteAll(timelines);
+    timelines.clear();
 }
 
 void Grib::clean_vector(QMap<time_t, GribRecord *> *ls) {
@@ -147,10 +267,22 @@ void Grib::addRecord(GribRecord * rec) {
     }
     /* adds the record to vector created for record's data type */
     mapGribRecords[rec->get_dataKey()]->insert(rec->get_curDate(),rec);
+
+    GribTimeline * timeline=timelines.value(rec->get_dataKey(),NULL);
+    if(!timeline) {
+        timeline=new GribTimeline();
+        timelines.insert(rec->get_dataKey(),timeline);
+    }
+    timeline->insert(rec);
+}
+
+const GribTimeline * Grib::getTimeline(int dataType,int levelType,int levelValue) const {
+    return timelines.value(GribRecord::makeKey(dataType,levelType,levelValue),NULL);
 }
 
 bool Grib::hasData(int dataType,int levelType,int levelValue) {
-    return getNumberOfGribRecords(dataType,levelType,levelValue)!=0;
+    const GribTimeline * timeline=getTimeline(dataType,levelType,levelValue);
+    return timeline && timeline->size()!=0;
 }
 
 QMap<time_t,GribRecord *> * Grib::getFirstNonEmptyList() {
@@ -166,8 +298,9 @@ QMap<time_t,GribRecord *> * Grib::getFirstNonEmptyList() {
 
 QMap<time_t,GribRecord *> * Grib::getListOfGribRecords(int dataType,int levelType,int levelValue) {
         long int key = GribRecord::makeKey(dataType,levelType,levelValue);
-        if (mapGribRecords.find(key) != mapGribRecords.end())
-                return mapGribRecords[key];
+        std::map <long int, QMap<time_t,GribRecord *>* >::iterator it = mapGribRecords.find(key);
+        if (it != mapGribRecords.end())
+                return (*it).second;
         else
                 return NULL;
 }
@@ -251,7 +384,9 @@ void Grib::createDewPointData(void) {
               && getNumberOfGribRecords(DATA_TEMP, DATA_LV_ABOV_GND, 2) > 0) {
             dewpointDataStatus = COMPUTED_DATA;
             std::set<time_t>::iterator iter;
-            std::set<time_t> * dateList = dataManager->get_dateList();
+            /* dates of this grib: it is not published yet and may be computed in a
+               GribLoader worker, the dates of the DataManager are not to be used */
+            std::set<time_t> * dateList = &tList;
             for (iter=dateList->begin(); iter!=dateList->end(); ++iter) {
                 time_t date = *iter;
                 GribRecord *recModel = getGribRecord(DATA_TEMP,DATA_LV_ABOV_GND,2,date);
@@ -360,34 +495,104 @@ void Grib::update_levelMap(QMap<int,QMap<int,QList<int>*>*> * levelMap) {
  * Get records arround date  *
  *****************************/
 
+GribTimeline::GribTimeline() {
+    cursor=0;
+}
+
+void GribTimeline::insert(GribRecord * rec) {
+    time_t date=rec->get_curDate();
+    std::vector<time_t>::iterator it=std::lower_bound(dates.begin(),dates.end(),date);
+    int i=it-dates.begin();
+    if(it!=dates.end() && *it==date) {
+        /* same behaviour as QMap::insert: the last record read wins */
+        records[i]=rec;
+        return;
+    }
+    dates.insert(it,date);
+    records.insert(records.begin()+i,rec);
+}
+
+/* index of the first date >= date (size() if none), same as QMap::lowerBound */
+int GribTimeline::lowerBound(const time_t &date) const {
+    const int n=size();
+#ifdef QT_V5
+    int c=cursor.load();
+#else
+    int c=cursor;
+#endif
+    for(int k=0;k<2 && c<=n;++k,++c) {
+        if((c==n || dates[c]>=date) && (c==0 || dates[c-1]<date)) {
+            if(k)
+                cursor.fetchAndStoreRelaxed(c);
+            return c;
+        }
+        if(c==n || dates[c]>=date)
+            break;
+    }
+    c=std::lower_bound(dates.begin(),dates.end(),date)-dates.begin();
+    cursor.fetchAndStoreRelaxed(c);
+    return c;
+}
+
+/* true if 'other' would give the same lowerBound index i (other being the U of this V) */
+bool GribTimeline::sameDatesAt(const GribTimeline * other,const int &i) const {
+    if(!other || other->size()!=size())
+        return false;
+    if(i<size() && dates[i]!=other->dates[i])
+        return false;
+    if(i>0 && dates[i-1]!=other->dates[i-1])
+        return false;
+    return true;
+}
+
+void GribTimeline::recordsAround(const int &i,const time_t &date,GribRecord **before, GribRecord **after) const {
+    *before = NULL;
+    *after  = NULL;
+    if(dates.empty())
+        return;
+    if(i<size())
+    {
+        *after=records[i];
+        if(dates[i]==date)
+            *before=*after;
+    }
+    if(*before==NULL && i>0)
+        *before=records[i-1];
+    if(*before) (*before)->touch();
+    if(*after) (*after)->touch();
+}
+
 void Grib::find_recordsAroundDate (int dataType,int levelType,int levelValue, time_t date,
                                                         GribRecord **before, GribRecord **after) {
     if(!before || !after)
         return;
-    QMap<time_t,GribRecord *> *ls = getListOfGribRecords(dataType,levelType,levelValue);
+    const GribTimeline * timeline = getTimeline(dataType,levelType,levelValue);
 
     *before = NULL;
     *after  = NULL;
 
-    if(ls==NULL || ls->isEmpty())
+    if(timeline==NULL)
         return;
-    QMap<time_t,GribRecord *>::Iterator it=ls->lowerBound(date);
-    if(it!=ls->end())
-    {
-        *after=it.value();
-        if(it.key()==date)
-            *before=*after;
-    }
-    if(*before==NULL && it!=ls->begin())
-        *before=(it-1).value();
+    timeline->recordsAround(timeline->lowerBound(date),date,before,after);
 }
 
 bool Grib::get_recordsAndTime_2D(int dataType_1,int dataType_2,int levelType,int levelValue,
                                  time_t now,time_t * t1,time_t * t2,GribRecord ** recU1,GribRecord ** recV1,
                            GribRecord ** recU2,GribRecord ** recV2,bool debug) {
     if(t1 && t2 && recU1 && recV1 && recU2 && recV2) {
-        find_recordsAroundDate(dataType_1,levelType,levelValue,now,recU1,recU2);
-        find_recordsAroundDate(dataType_2,levelType,levelValue,now,recV1,recV2);
+        /* U and V are almost always at the same dates: one search for both */
+        const GribTimeline * timelineU=getTimeline(dataType_1,levelType,levelValue);
+        const GribTimeline * timelineV=getTimeline(dataType_2,levelType,levelValue);
+        *recU1=*recU2=*recV1=*recV2=NULL;
+        int iU=0;
+        if(timelineU) {
+            iU=timelineU->lowerBound(now);
+            timelineU->recordsAround(iU,now,recU1,recU2);
+        }
+        if(timelineV) {
+            int iV=timelineV->sameDatesAt(timelineU,iU)?iU:timelineV->lowerBound(now);
+            timelineV->recordsAround(iV,now,recV1,recV2);
+        }
         if(*recU1 && *recV1) {
             if(*recU1==*recU2) {
                 *t1=(*recU1)->get_curDate();
@@ -501,16 +706,35 @@ bool Grib::interpolateValue_2D(double d_long, double d_lat, time_t now, time_t t
                                               double * u, double * v,int interpolation_type,bool UV,bool debug) {
     windData wData_prev;
     windData wData_nxt;
-    double gridOriginLat_1,gridOriginLon_1,gridOriginLat_2,gridOriginLon_2;
-
-    bool hasNxt=false;
-    double gribStep_t1_lon=1,gribStep_t2_lon=1;
-    double gribStep_t1_lat=1,gribStep_t2_lat=1;
 
     /*sanity check */
     if(!u || !v || !recU1 || !recV1)
         return false;
 
+    if(!recU1->getValue_TWSA(d_long,d_lat,&(wData_prev.u0),&(wData_prev.u1),&(wData_prev.u2),&(wData_prev.u3),debug))
+        return false;
+    if(!recV1->getValue_TWSA(d_long,d_lat,&(wData_prev.v0),&(wData_prev.v1),&(wData_prev.v2),&(wData_prev.v3),debug))
+        return false;
+
+    if(recU2 && recV2) {
+        if(!recU2->getValue_TWSA(d_long,d_lat,&(wData_nxt.u0),(&wData_nxt.u1),&(wData_nxt.u2),&(wData_nxt.u3),debug))
+            return false;
+        if(!recV2->getValue_TWSA(d_long,d_lat,&(wData_nxt.v0),(&wData_nxt.v1),&(wData_nxt.v2),&(wData_nxt.v3),debug))
+            return false;
+    }
+    return interpolateCorners_2D(d_long,d_lat,now,t1,t2,recU1,recV1,recU2,recV2,
+                                 &wData_prev,(recU2 && recV2)?&wData_nxt:NULL,u,v,interpolation_type,UV,debug);
+}
+
+/* second half of interpolateValue_2D, once the values around the point have been read (by it or by a GribSampler) */
+bool Grib::interpolateCorners_2D(double d_long, double d_lat, time_t now, time_t t1,time_t t2,
+                                 GribRecord *recU1,GribRecord *recV1,GribRecord *recU2,GribRecord *recV2,
+                                 windData * wData_prev,windData * wData_nxt,
+                                 double * u, double * v,int interpolation_type,bool UV,bool debug) {
+    double gridOriginLat_1,gridOriginLon_1,gridOriginLat_2=0,gridOriginLon_2=0;
+
+    double gribStep_t1_lon=1,gribStep_t2_lon=1;
+    double gribStep_t1_lat=1,gribStep_t2_lat=1;
 
     gridOriginLat_1=recV1->get_latMin();
     gridOriginLon_1=recV1->get_lonMin();
@@ -519,23 +743,12 @@ bool Grib::interpolateValue_2D(double d_long, double d_lat, time_t now, time_t t
     gribStep_t1_lon=recU1->get_Di()==0?1:recU1->get_Di();
     gribStep_t1_lat=recU1->get_Dj()==0?1:recU1->get_Dj();
 
-    if(!recU1->getValue_TWSA(d_long,d_lat,&(wData_prev.u0),&(wData_prev.u1),&(wData_prev.u2),&(wData_prev.u3),debug))
-        return false;
-    if(!recV1->getValue_TWSA(d_long,d_lat,&(wData_prev.v0),&(wData_prev.v1),&(wData_prev.v2),&(wData_prev.v3),debug))
-        return false;
-
-    if(recU2 && recV2) {
-        hasNxt=true;
+    if(wData_nxt) {
         gridOriginLat_2=recV2->get_latMin();
         gridOriginLon_2=recV2->get_lonMin();
         //isHighRes_t2=(recU2->get_Di()==0.5 || recU2->get_Di()==-0.5)?1:0;
         gribStep_t2_lon=recU2->get_Di()==0?1:recU2->get_Di();
         gribStep_t2_lat=recU2->get_Dj()==0?1:recU2->get_Dj();
-
-        if(!recU2->getValue_TWSA(d_long,d_lat,&(wData_nxt.u0),(&wData_nxt.u1),&(wData_nxt.u2),&(wData_nxt.u3),debug))
-            return false;
-        if(!recV2->getValue_TWSA(d_long,d_lat,&(wData_nxt.v0),(&wData_nxt.v1),&(wData_nxt.v2),&(wData_nxt.v3),debug))
-            return false;
     }
     gribStep_t1_lon=qAbs(gribStep_t1_lon);
     gribStep_t2_lon=qAbs(gribStep_t2_lon);
@@ -546,7 +759,7 @@ bool Grib::interpolateValue_2D(double d_long, double d_lat, time_t now, time_t t
             if(debug)
                 qWarning() << "Interpolation TWSA";
             interpolation::get_wind_info_latlong_TWSA(d_long,d_lat,now,t1,t2,
-                                                      &wData_prev,(hasNxt?(&wData_nxt):NULL),
+                                                      wData_prev,wData_nxt,
                                                       gribStep_t1_lat,gribStep_t1_lon,gribStep_t2_lat,gribStep_t2_lon,
                                                       u,v,UV,debug);
             break;
@@ -554,7 +767,7 @@ bool Grib::interpolateValue_2D(double d_long, double d_lat, time_t now, time_t t
             if(debug)
                 qWarning() << "Interpolation selective-TWSA";
             interpolation::get_wind_info_latlong_selective_TWSA(d_long,d_lat,now,t1,t2,
-                                                                &wData_prev,(hasNxt?(&wData_nxt):NULL),
+                                                                wData_prev,wData_nxt,
                                                                 gribStep_t1_lat,gribStep_t1_lon,gribStep_t2_lat,gribStep_t2_lon,
                                                                 u,v,UV,debug);
             break;
@@ -562,7 +775,7 @@ bool Grib::interpolateValue_2D(double d_long, double d_lat, time_t now, time_t t
             if(debug)
                 qWarning() << "Interpolation Hybrid";
             interpolation::get_wind_info_latlong_hybrid(d_long,d_lat,now,t1,t2,
-                                                        &wData_prev,(hasNxt?(&wData_nxt):NULL),
+                                                        wData_prev,wData_nxt,
                                                         gribStep_t1_lat,gribStep_t1_lon,gribStep_t2_lat,gribStep_t2_lon,
                                                         u,v,gridOriginLat_1,gridOriginLon_1,gridOriginLat_2,gridOriginLon_2,UV,debug);
             break;
@@ -574,7 +787,181 @@ bool Grib::interpolateValue_2D(double d_long, double d_lat, time_t now, time_t t
     return true;
 }
 
+/* grid square of a point in a U/V record pair, as read by getValue_TWSA */
+struct windCell
+{
+    int iU0,jU0,iU1,sigU;
+    int iV0,jV0,iV1,sigV;
+    bool operator==(const windCell &c) const {
+        return iU0==c.iU0 && jU0==c.jU0 && iU1==c.iU1 && sigU==c.sigU
+                && iV0==c.iV0 && jV0==c.jV0 && iV1==c.iV1 && sigV==c.sigV;
+    }
+};
+
+static bool get_windCell(GribRecord * recU,GribRecord * recV,double d_long,double d_lat,windCell * cell) {
+    return recU->getCell_TWSA(d_long,d_lat,&cell->iU0,&cell->jU0,&cell->iU1,&cell->sigU)
+            && recV->getCell_TWSA(d_long,d_lat,&cell->iV0,&cell->jV0,&cell->iV1,&cell->sigV);
+}
+
+static bool get_windCorners(GribRecord * recU,GribRecord * recV,const windCell &cell,
+                            int interpolation_type,bool UV,windCorners * corners) {
+    windData wData;
+    if(!recU->getCorners_TWSA(cell.iU0,cell.jU0,cell.iU1,cell.sigU,&wData.u0,&wData.u1,&wData.u2,&wData.u3))
+        return false;
+    if(!recV->getCorners_TWSA(cell.iV0,cell.jV0,cell.iV1,cell.sigV,&wData.v0,&wData.v1,&wData.v2,&wData.v3))
+        return false;
+    interpolation::prepare_corners(&wData,interpolation_type,UV,corners);
+    return true;
+}
+
+static void get_windGrid(GribRecord * recU,GribRecord * recV,windGrid * grid) {
+    grid->originLat=recV->get_latMin();
+    grid->originLon=recV->get_lonMin();
+    grid->lon_step=qAbs(recU->get_Di()==0?1:recU->get_Di());
+    grid->lat_step=qAbs(recU->get_Dj()==0?1:recU->get_Dj());
+}
 
+/*
+ * interpolateValue_2D on a batch of points of one date: the corners of a grid square
+ * are read and converted (polar decomposition) once for the consecutive points falling
+ * in it. Results are the ones of interpolateValue_2D, u=v=0 where it would fail.
+ * Returns the number of points ok.
+ */
+int Grib::interpolateValues_2D(const double * d_long, const double * d_lat, const int &count,
+                               time_t now, time_t t1,time_t t2,
+                               GribRecord *recU1,GribRecord *recV1,GribRecord *recU2,GribRecord *recV2,
+                               double * u, double * v, bool * ok,int interpolation_type,bool UV) {
+    if(!u || !v || !ok || count<=0)
+        return 0;
+    for(int k=0;k<count;++k) {
+        u[k]=0;
+        v[k]=0;
+        ok[k]=false;
+    }
+    if(!recU1 || !recV1)
+        return 0;
+    bool hasNxt=recU2 && recV2;
+
+    windGrid grid_prev,grid_nxt;
+    get_windGrid(recU1,recV1,&grid_prev);
+    grid_nxt=grid_prev;
+    if(hasNxt)
+        get_windGrid(recU2,recV2,&grid_nxt);
+
+    /* corners of the squares met, as indexes since the vector grows */
+    QVector<windCorners> corners;
+    QVector<int> idx_prev,idx_nxt,points;
+    windCell cell,last_prev,last_nxt;
+    int cur_prev=0,cur_nxt=0;
+    bool seen_prev=false,seen_nxt=false;
+    bool valid_prev=false,valid_nxt=false;
+    for(int k=0;k<count;++k) {
+        if(!get_windCell(recU1,recV1,d_long[k],d_lat[k],&cell))
+            continue;
+        if(!seen_prev || !(cell==last_prev)) {
+            seen_prev=true;
+            last_prev=cell;
+            windCorners c;
+            valid_prev=get_windCorners(recU1,recV1,cell,interpolation_type,UV,&c);
+            if(valid_prev) {
+                corners.append(c);
+                cur_prev=corners.count()-1;
+            }
+        }
+        if(!valid_prev)
+            continue;
+        if(hasNxt) {
+            if(!get_windCell(recU2,recV2,d_long[k],d_lat[k],&cell))
+                continue;
+            if(!seen_nxt || !(cell==last_nxt)) {
+                seen_nxt=true;
+                last_nxt=cell;
+                windCorners c;
+                valid_nxt=get_windCorners(recU2,recV2,cell,interpolation_type,UV,&c);
+                if(valid_nxt) {
+                    corners.append(c);
+                    cur_nxt=corners.count()-1;
+                }
+            }
+            if(!valid_nxt)
+                continue;
+            idx_nxt.append(cur_nxt);
+        }
+        idx_prev.append(cur_prev);
+        points.append(k);
+    }
+
+    int nb=points.count();
+    if(nb==0)
+        return 0;
+    QVector<const windCorners *> ptr_prev(nb),ptr_nxt(hasNxt?nb:0);
+    QVector<double> lon(nb),lat(nb),u_res(nb),v_res(nb);
+    for(int n=0;n<nb;++n) {
+        ptr_prev[n]=&corners.at(idx_prev.at(n));
+        if(hasNxt)
+            ptr_nxt[n]=&corners.at(idx_nxt.at(n));
+        lon[n]=d_long[points.at(n)];
+        lat[n]=d_lat[points.at(n)];
+    }
+    if(!interpolation::get_wind_info_batch(interpolation_type,nb,lon.constData(),lat.constData(),now,t1,t2,
+                                           ptr_prev.constData(),hasNxt?ptr_nxt.constData():NULL,
+                                           grid_prev,grid_nxt,u_res.data(),v_res.data()))
+        return 0;
+    for(int n=0;n<nb;++n) {
+        int k=points.at(n);
+        u[k]=u_res.at(n);
+        v[k]=v_res.at(n);
+        ok[k]=true;
+    }
+    return nb;
+}
+
+#ifdef __QTVLM_WITH_TEST
+/* regression check of interpolateValues_2D against interpolateValue_2D, every interpolation mode */
+bool Grib::check_interpolationBatch(time_t now) {
+    GribRecord *recU1,*recV1,*recU2,*recV2;
+    time_t t1,t2;
+    if(!ok || !get_recordsAndTime_2D(DATA_WIND_VX,DATA_WIND_VY,DATA_LV_ABOV_GND,10,now,&t1,&t2,&recU1,&recV1,&recU2,&recV2))
+        return false;
+    const int nbPoints=20000;
+    QVector<double> lon(nbPoints),lat(nbPoints),u(nbPoints),v(nbPoints);
+    QVector<bool> res(nbPoints);
+    /* rows of close points, as drawn, then scattered points */
+    for(int k=0;k<nbPoints;++k) {
+        if(k<nbPoints/2) {
+            lon[k]=recU1->get_lonMin()+(recU1->get_lonMax()-recU1->get_lonMin())*(k/100)/(nbPoints/200.0);
+            lat[k]=recU1->get_latMin()+(recU1->get_latMax()-recU1->get_latMin())*(k%100)/100.0;
+        }
+        else {
+            lon[k]=recU1->get_lonMin()+(recU1->get_lonMax()-recU1->get_lonMin())*qrand()/RAND_MAX;
+            lat[k]=recU1->get_latMin()+(recU1->get_latMax()-recU1->get_latMin())*qrand()/RAND_MAX;
+        }
+    }
+    bool allOk=true;
+    for(int mode=INTERPOLATION_TWSA;mode<=INTERPOLATION_HYBRID;++mode) {
+        interpolateValues_2D(lon.constData(),lat.constData(),nbPoints,now,t1,t2,recU1,recV1,recU2,recV2,
+                             u.data(),v.data(),res.data(),mode,true);
+        double maxDiff=0;
+        int nbFail=0;
+        for(int k=0;k<nbPoints;++k) {
+            double us=0,vs=0;
+            bool resScalar=interpolateValue_2D(lon[k],lat[k],now,t1,t2,recU1,recV1,recU2,recV2,&us,&vs,mode,true);
+            if(resScalar!=res[k]) {
+                ++nbFail;
+                continue;
+            }
+            if(!resScalar) continue;
+            double da=qAbs(vs-v[k]);
+            if(da>PI) da=TWO_PI-da;
+            maxDiff=qMax(maxDiff,qMax(qAbs(us-u[k]),da));
+        }
+        qWarning() << "batch interpolation, mode" << mode << ": max diff" << maxDiff << ", status mismatch" << nbFail;
+        if(maxDiff>1e-6 || nbFail!=0)
+            allOk=false;
+    }
+    return allOk;
+}
+#endif
 
 /*************************************************
  *     Isolines                                  *
@@ -586,49 +973,74 @@ void Grib::init_isos(time_t t) {
 }
 
 void Grib::init_isoBars(time_t t) {
-    if (!ok)
-        return;
+    isoBarsDate=t;
+}
 
-    int step=dataManager->get_isoBarsStep();
+void Grib::init_isoTherms0(time_t t) {
+    isoTherms0Date=t;
+}
 
-    Util::cleanListPointers(listIsobars);
+std::list<IsoLine *> * Grib::get_isobars(void) {
+    return get_isoLines(isoBarsCache,DATA_PRESSURE,DATA_LV_MSL,isoBarsDate,
+                        840,1120,(int)dataManager->get_isoBarsStep(),100);
+}
 
-    GribRecord *rec_prev,*rec_nxt;
-    time_t tPrev,tNxt;
-    if(get_recordsAndTime_1D(DATA_PRESSURE,DATA_LV_MSL,0,t,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-    {
-        Util::cleanListPointers(listIsobars);
-        IsoLine *iso;
-        for (double press=840; press<1120; press += step)
-        {
-                iso = new IsoLine(press*100, t, tPrev,tNxt, rec_prev,rec_nxt);
-                listIsobars.push_back(iso);
-        }
-    }
+std::list<IsoLine *> * Grib::get_isotherms0(void) {
+    return get_isoLines(isoTherms0Cache,DATA_GEOPOT_HGT,DATA_LV_ISOTHERM0,isoTherms0Date,
+                        0,12000,dataManager->get_isoTherms0Step(),1);
 }
 
-void Grib::init_isoTherms0(time_t t) {
+/* levels first, first+step, ... < last (times coef), extracted in one pass over the grid */
+std::list<IsoLine *> * Grib::get_isoLines(QList<isoSet *> &cache,int dataType,int levelType,time_t t,
+                                          double first,double last,double step,double coef) {
     if (!ok)
-        return;
-
-    int step=dataManager->get_isoTherms0Step();
-
-    Util::cleanListPointers(listIsotherms0);
+        return &noIsoLines;
 
     GribRecord *rec_prev,*rec_nxt;
     time_t tPrev,tNxt;
-    if(get_recordsAndTime_1D(DATA_GEOPOT_HGT,DATA_LV_ISOTHERM0,0,t,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-    {
-        Util::cleanListPointers(listIsotherms0);
-        IsoLine *iso;
-        for (double alt=0; alt<12000; alt += step)
-        {
-                iso = new IsoLine(alt, t, tPrev,tNxt, rec_prev,rec_nxt);
-                listIsotherms0.push_back(iso);
+    if(!get_recordsAndTime_1D(dataType,levelType,0,t,&tPrev,&tNxt,&rec_prev,&rec_nxt))
+        return &noIsoLines;
+    /* same lines for every date when there is no time blending */
+    if(tPrev==tNxt) t=tPrev;
+
+    for(int i=0;i<cache.count();++i) {
+        isoSet * set=cache.at(i);
+        if(set->rec_prev==rec_prev && set->rec_nxt==rec_nxt && set->date==t && set->step==step) {
+            if(i!=0) cache.move(i,0);
+            return &set->lines;
         }
     }
+
+    isoSet * set=new isoSet;
+    set->rec_prev=rec_prev;
+    set->rec_nxt=rec_nxt;
+    set->date=t;
+    set->step=step;
+    QVector<double> levels;
+    if(step>0)
+        for (double val=first; val<last; val += step)
+            levels.append(val*coef);
+    IsoLine::extractIsoLines(levels,t,tPrev,tNxt,rec_prev,rec_nxt,&set->lines);
+    cache.prepend(set);
+    while(cache.count()>GRIB_ISO_CACHE_SIZE) {
+        isoSet * old=cache.takeLast();
+        Util::cleanListPointers(old->lines);
+        delete old;
+    }
+    return &set->lines;
+}
+
+void Grib::clear_isoCache(QList<isoSet *> &cache) {
+    for(int i=0;i<cache.count();++i) {
+        Util::cleanListPointers(cache.at(i)->lines);
+        delete cache.at(i);
+    }
+    cache.clear();
+}
+
+void Grib::clear_isos(void) {
+    clear_isoCache(isoBarsCache);
+    clear_isoCache(isoTherms0Cache);
 }
 
 
@@ -29,6 +29,9 @@ Lecture mise en memoire d'un fichier GRIB
 #include <QPainter>
 #include <QApplication>
 #include <QObject>
+#include <QHash>
+#include <QAtomicInt>
+#include <QFile>
 
 #include <iostream>
 #include <cmath>
@@ -42,17 +45,60 @@ Lecture mise en memoire d'un fichier GRIB
 
 #include "dataDef.h"
 
+#define GRIB_ISO_CACHE_SIZE 8
+
+/* a load run by GribLoader in a worker thread: settings are read beforehand in the
+   GUI thread, progress is in KB of the file (read, then decoded for GRIB2) */
+struct GribLoadState
+{
+    GribLoadState() : packData(false), useDiskCache(true), lazy(false) {}
+    bool packData;
+    bool useDiskCache;
+    bool lazy;
+    QAtomicInt cancelled;
+    QAtomicInt kbDone;
+    QAtomicInt kbTotal;
+};
+
+//===============================================================
+/* records of one (dataType,level) as two flat arrays sorted by date,
+   kept beside mapGribRecords for the lookups done for each interpolated value.
+   cursor remembers the last hit: routing and animation mostly move forward in time */
+class GribTimeline
+{
+    public:
+        GribTimeline();
+        void insert(GribRecord * rec);
+
+        int size(void) const {return (int)dates.size();}
+        time_t dateAt(const int &i) const {return dates[i];}
+        GribRecord * recordAt(const int &i) const {return records[i];}
+
+        int lowerBound(const time_t &date) const;
+        bool sameDatesAt(const GribTimeline * other,const int &i) const;
+        void recordsAround(const int &i,const time_t &date,GribRecord **before, GribRecord **after) const;
+
+    private:
+        std::vector<time_t> dates;
+        std::vector<GribRecord *> records;
+        mutable QAtomicInt cursor;
+};
 
 //===============================================================
 class Grib: public QObject
 { Q_OBJECT
+    friend class GribCacheFile;
     public:
         Grib(DataManager * dataManager);
         ~Grib();
 
         bool  isOk()                 {return ok;}
+        bool  isFromCacheFile() const {return cacheFile!=NULL;}
+        bool  get_packData() const {return packData;}
 
-        static Grib * loadGrib(QString fileName,DataManager *dataManager);
+        static Grib * loadGrib(QString fileName,DataManager *dataManager,GribLoadState * state=NULL);
+        void packRecords(void);
+        void benchmark_packedData(void);
 
         virtual bool loadFile(QString fileName) = 0;
 
@@ -80,11 +126,16 @@ class Grib: public QObject
         GribRecord * getFirstRecord(void);
         int getNumberOfGribRecords(int dataType,int levelType,int levelValue);
 
-        /* iso management */
-        std::list<IsoLine *> * get_isobars(void) { return &listIsobars; }
-        std::list<IsoLine *> * get_isotherms0(void) { return &listIsotherms0; }
+        /* iso management: init_* only set the date, lines are extracted when first asked for
+           and kept for the last GRIB_ISO_CACHE_SIZE (record pair, date, step) */
+        std::list<IsoLine *> * get_isobars(void);
+        std::list<IsoLine *> * get_isotherms0(void);
         void init_isoBars(time_t t);
         void init_isoTherms0(time_t t);
+        void clear_isos(void);
+
+        /* lazy records still on disk, wind then current around date first (see GribLoader) */
+        void get_recordsToPrefetch(time_t date,QList<GribRecord *> * records);
 
         /* get records arround a date */
         void find_recordsAroundDate(int dataType,int levelType,int levelValue, time_t date,
@@ -107,6 +158,17 @@ class Grib: public QObject
         static bool interpolateValue_2D(double d_long, double d_lat, time_t now, time_t t1,time_t t2,
                                                       GribRecord *recU1,GribRecord *recV1,GribRecord *recU2,GribRecord *recV2,
                                                       double * u, double * v,int interpolation_type,bool UV,bool debug=false);
+        static int interpolateValues_2D(const double * d_long, const double * d_lat, const int &count,
+                                        time_t now, time_t t1,time_t t2,
+                                        GribRecord *recU1,GribRecord *recV1,GribRecord *recU2,GribRecord *recV2,
+                                        double * u, double * v, bool * ok,int interpolation_type,bool UV);
+#ifdef __QTVLM_WITH_TEST
+        bool check_interpolationBatch(time_t now);
+#endif
+        static bool interpolateCorners_2D(double d_long, double d_lat, time_t now, time_t t1,time_t t2,
+                                          GribRecord *recU1,GribRecord *recV1,GribRecord *recU2,GribRecord *recV2,
+                                          windData * wData_prev,windData * wData_nxt,
+                                          double * u, double * v,int interpolation_type,bool UV,bool debug=false);
 
     protected:
         bool   ok;
@@ -114,8 +176,15 @@ class Grib: public QObject
         int version;
         QString fileName;
         long fileSize;
+        QFile * cacheFile;   // mapping of the records loaded from a cache file
+        bool packData;       // records kept on 16 bits (gribPackedData when loaded), see GribRecord::packData
+        GribLoadState * loadState;   // only while loadFile runs under a GribLoader
+        bool loadCancelled(void) const { return loadState && loadState->cancelled.fetchAndAddRelaxed(0)!=0; }
+        void set_loadProgress(qint64 done,qint64 total);
 
         std::map <long int,QMap<time_t,GribRecord *> *>  mapGribRecords;
+        QHash<long int,GribTimeline *> timelines;
+        const GribTimeline * getTimeline(int dataType,int levelType,int levelValue) const;
         void addRecord(GribRecord * rec);
         void clean_vector(QMap<time_t, GribRecord *> *ls);
         void clean_all_vectors();
@@ -123,8 +192,21 @@ class Grib: public QObject
         std::set<time_t>  tList;
 
 
-        std::list<IsoLine *> listIsobars;      // liste d'isobares precalculees
-        std::list<IsoLine *> listIsotherms0;   // liste d'isothermes 0C precalculees
+        struct isoSet {
+            GribRecord * rec_prev;
+            GribRecord * rec_nxt;
+            time_t date;
+            double step;
+            std::list<IsoLine *> lines;
+        };
+        QList<isoSet *> isoBarsCache;          // isobares precalculees, most recent first
+        QList<isoSet *> isoTherms0Cache;       // isothermes 0C precalculees
+        std::list<IsoLine *> noIsoLines;
+        time_t isoBarsDate;
+        time_t isoTherms0Date;
+        std::list<IsoLine *> * get_isoLines(QList<isoSet *> &cache,int dataType,int levelType,time_t t,
+                                            double first,double last,double step,double coef);
+        void clear_isoCache(QList<isoSet *> &cache);
 
         void createDewPointData(void);
         int	dewpointDataStatus;
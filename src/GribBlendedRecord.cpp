@@ -0,0 +1,198 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2013 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QList>
+#include <QThread>
+#ifdef QT_V5
+#include <QtConcurrent/QtConcurrentMap>
+#else
+#include <QtConcurrentMap>
+#endif
+
+#include "GribBlendedRecord.h"
+
+GribBlendedRecord::GribBlendedRecord(const GribRecord * model,time_t date) : GribRecord() {
+    /* same grid and description as the model, the date excepted */
+    QByteArray header;
+    QDataStream out(&header,QIODevice::WriteOnly);
+    model->writeHeader(out);
+    QDataStream in(header);
+    readHeader(in);
+    curDate=date;
+    bmapSize=0;
+    dataSize=ok?Ni*Nj:0;
+    if(dataSize)
+        data=new float[dataSize];
+    else
+        ok=false;
+}
+
+bool GribBlendedRecord::hasValue(int i, int j) const {
+    return ok && (data || data16) && valueAt(j*Ni+i)!=GRIB_NOTDEF;
+}
+
+GribBlendedRecord * GribBlendedRecord::copy(const GribRecord * rec) {
+    if(!rec || !rec->isOk())
+        return NULL;
+    GribBlendedRecord * res=new GribBlendedRecord(rec,rec->get_curDate());
+    if(!res->isOk()) {
+        delete res;
+        return NULL;
+    }
+    for(int j=0;j<(int)res->Nj;++j)
+        for(int i=0;i<(int)res->Ni;++i)
+            res->data[j*res->Ni+i]=rec->hasValue(i,j)?rec->getValue(i,j):GRIB_NOTDEF;
+    return res;
+}
+
+bool GribBlendedRecord::sameGrid(const GribRecord * rec1,const GribRecord * rec2) {
+    return rec1 && rec2 && rec1->isOk() && rec2->isOk()
+            && rec1->get_Ni()==rec2->get_Ni() && rec1->get_Nj()==rec2->get_Nj()
+            && rec1->get_Di()==rec2->get_Di() && rec1->get_Dj()==rec2->get_Dj()
+            && rec1->getX(0)==rec2->getX(0) && rec1->getY(0)==rec2->getY(0);
+}
+
+GribBlendedRecord * GribBlendedRecord::blend_1D(GribRecord * rec1,GribRecord * rec2,
+                                                time_t t1,time_t t2,time_t now) {
+    if(t1==t2 || !sameGrid(rec1,rec2))
+        return NULL;
+    GribBlendedRecord * rec=new GribBlendedRecord(rec1,now);
+    if(!rec->isOk()) {
+        delete rec;
+        return NULL;
+    }
+    gribBlendBand band;
+    band.recA1=rec1;
+    band.recA2=rec2;
+    band.recB1=NULL;
+    band.recB2=NULL;
+    band.outA=rec->data;
+    band.outB=NULL;
+    band.ratio=((double)(now-t1))/((double)(t2-t1));
+    band.UV=false;
+    run(band,rec->Nj);
+    return rec;
+}
+
+bool GribBlendedRecord::blend_2D(GribRecord * recU1,GribRecord * recV1,GribRecord * recU2,GribRecord * recV2,
+                                 time_t t1,time_t t2,time_t now,bool UV,
+                                 GribBlendedRecord ** recU,GribBlendedRecord ** recV) {
+    if(!recU || !recV || t1==t2
+            || !sameGrid(recU1,recV1) || !sameGrid(recU1,recU2) || !sameGrid(recU1,recV2))
+        return false;
+    *recU=new GribBlendedRecord(recU1,now);
+    *recV=new GribBlendedRecord(recV1,now);
+    if(!(*recU)->isOk() || !(*recV)->isOk()) {
+        delete *recU;
+        delete *recV;
+        *recU=*recV=NULL;
+        return false;
+    }
+    gribBlendBand band;
+    band.recA1=recU1;
+    band.recA2=recU2;
+    band.recB1=recV1;
+    band.recB2=recV2;
+    band.outA=(*recU)->data;
+    band.outB=(*recV)->data;
+    band.ratio=((double)(now-t1))/((double)(t2-t1));
+    band.UV=UV;
+    run(band,(*recU)->Nj);
+    return true;
+}
+
+/* rows are split between threads, the source data has to be read before */
+void GribBlendedRecord::run(gribBlendBand model,int Nj) {
+    model.recA1->ensureData();
+    model.recA2->ensureData();
+    if(model.recB1) {
+        model.recB1->ensureData();
+        model.recB2->ensureData();
+    }
+    QList<gribBlendBand> bands;
+    int nbBands=qBound(1,QThread::idealThreadCount()*2,Nj);
+    int rows=(Nj+nbBands-1)/nbBands;
+    for(int j=0;j<Nj;j+=rows) {
+        model.j0=j;
+        model.j1=qMin(j+rows,Nj);
+        bands.append(model);
+    }
+    QtConcurrent::blockingMap(bands,GribBlendedRecord::blendBand);
+}
+
+void GribBlendedRecord::blendBand(gribBlendBand &band) {
+    const int Ni=band.recA1->get_Ni();
+    const double r=band.ratio;
+    for(int j=band.j0;j<band.j1;++j) {
+        for(int i=0;i<Ni;++i) {
+            const int ind=j*Ni+i;
+            if(!band.recA1->hasValue(i,j) || !band.recA2->hasValue(i,j)
+                    || (band.recB1 && (!band.recB1->hasValue(i,j) || !band.recB2->hasValue(i,j)))) {
+                band.outA[ind]=GRIB_NOTDEF;
+                if(band.outB) band.outB[ind]=GRIB_NOTDEF;
+                continue;
+            }
+            double a1=band.recA1->getValue(i,j);
+            double a2=band.recA2->getValue(i,j);
+            if(!band.recB1) {
+                /* same formula as the per pixel blend of MapDataDrawer::rasterValue */
+                band.outA[ind]=a1+((a2-a1)*r);
+                continue;
+            }
+            double b1=band.recB1->getValue(i,j);
+            double b2=band.recB2->getValue(i,j);
+            double s1,s2,d1,d2;
+            if(band.UV) {
+                /* speed and direction as in interpolation.cpp (_transform_u_v) */
+                s1=sqrt(a1*a1+b1*b1);
+                s2=sqrt(a2*a2+b2*b2);
+                d1=atan2(-a1,-b1);
+                d2=atan2(-a2,-b2);
+            }
+            else {
+                s1=a1;
+                s2=a2;
+                d1=degToRad(b1);
+                d2=degToRad(b2);
+            }
+            double s=s1+(s2-s1)*r;
+            double angle=d2-d1;
+            if(angle>PI)
+                angle-=TWO_PI;
+            else if(angle<-PI)
+                angle+=TWO_PI;
+            double d=d1+angle*r;
+            if(d<0)
+                d+=TWO_PI;
+            else if(d>=TWO_PI)
+                d-=TWO_PI;
+            if(band.UV) {
+                band.outA[ind]=-s*sin(d);
+                band.outB[ind]=-s*cos(d);
+            }
+            else {
+                band.outA[ind]=s;
+                band.outB[ind]=radToDeg(d);
+            }
+        }
+    }
+}
@@ -0,0 +1,67 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2013 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef GRIBBLENDEDRECORD_H
+#define GRIBBLENDEDRECORD_H
+
+#include <ctime>
+
+#include "class_list.h"
+#include "GribRecord.h"
+
+/* rows of a time blend, see GribBlendedRecord::blendBand */
+struct gribBlendBand
+{
+    int j0,j1;
+    const GribRecord * recA1;
+    const GribRecord * recA2;
+    const GribRecord * recB1;   // NULL for a 1D field
+    const GribRecord * recB2;
+    float * outA;
+    float * outB;
+    double ratio;
+    bool UV;
+};
+
+/* grid of a record pair interpolated in time at one date (see DataManager::get_blendedData1D/2D).
+   Drawing it with no next record only leaves the space interpolation to do */
+class GribBlendedRecord: public GribRecord
+{
+    public:
+        GribBlendedRecord(const GribRecord * model,time_t date);
+
+        bool hasValue(int i, int j) const;
+
+        static bool sameGrid(const GribRecord * rec1,const GribRecord * rec2);
+        /* float copy of a record (packed or mapped ones included), NULL if it has no data */
+        static GribBlendedRecord * copy(const GribRecord * rec);
+        static GribBlendedRecord * blend_1D(GribRecord * rec1,GribRecord * rec2,
+                                            time_t t1,time_t t2,time_t now);
+        /* in the TWSA form: speed (or height) and direction are blended, not the components */
+        static bool blend_2D(GribRecord * recU1,GribRecord * recV1,GribRecord * recU2,GribRecord * recV2,
+                             time_t t1,time_t t2,time_t now,bool UV,
+                             GribBlendedRecord ** recU,GribBlendedRecord ** recV);
+
+    private:
+        static void run(gribBlendBand model,int Nj);
+        static void blendBand(gribBlendBand &band);
+};
+
+#endif // GRIBBLENDEDRECORD_H
@@ -0,0 +1,111 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2013 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <algorithm>
+
+#include "GribCache.h"
+#include "GribRecord.h"
+
+//#define traceCache
+
+QMutex GribCache::mutex;
+QMutex GribCache::recordMutexes[NB_RECORD_MUTEX];
+QList<GribRecord *> GribCache::loaded;
+qint64 GribCache::loadedSize=0;
+qint64 GribCache::maxSize=512*1024*1024;
+QAtomicInt GribCache::clock(1);
+
+static bool olderThan(GribRecord * rec1, GribRecord * rec2) {
+    return rec1->get_lastUse() < rec2->get_lastUse();
+}
+
+QMutex & GribCache::recordMutex(GribRecord * rec) {
+    quintptr h=(quintptr)rec;
+    return recordMutexes[(h>>4 ^ h>>10)%NB_RECORD_MUTEX];
+}
+
+void GribCache::materialize(GribRecord * rec) {
+    QMutexLocker recordLocker(&recordMutex(rec));
+    /* checked again under the lock: another thread may have loaded it meanwhile */
+    if(rec->dataReady.fetchAndAddAcquire(0))
+        return;
+    if(rec->loadData()) {
+        if(rec->packOnLoad)
+            rec->packData();
+        rec->lastUse=tick();
+        QMutexLocker locker(&mutex);
+        rec->inCache=true;
+        loaded.append(rec);
+        loadedSize+=rec->get_memSize();
+    }
+    else
+        qWarning() << "Can't read data of grib record, key=" << rec->get_dataKey() << ", date=" << rec->get_curDate();
+    /* a record that can't be read stays without data (getValue gives GRIB_NOTDEF) */
+    rec->dataReady.fetchAndStoreRelease(1);
+}
+
+void GribCache::forget(GribRecord * rec) {
+    QMutexLocker locker(&mutex);
+    if(!rec->inCache)
+        return;
+    loaded.removeOne(rec);
+    loadedSize-=rec->get_memSize();
+    rec->inCache=false;
+}
+
+void GribCache::trim(void) {
+    QList<GribRecord *> released;
+    mutex.lock();
+    if(loadedSize<=maxSize) {
+        mutex.unlock();
+        return;
+    }
+    std::sort(loaded.begin(),loaded.end(),olderThan);
+    while(!loaded.isEmpty() && loadedSize>maxSize) {
+        GribRecord * rec=loaded.takeFirst();
+        loadedSize-=rec->get_memSize();
+        rec->inCache=false;
+        released.append(rec);
+    }
+#ifdef traceCache
+    qWarning() << "Grib cache: " << released.size() << " records released, " << loaded.size() << " kept (" << loadedSize/(1024*1024) << " MB)";
+#endif
+    mutex.unlock();
+    /* out of the cache lock: materialize takes the record lock first */
+    for(int i=0;i<released.size();++i) {
+        GribRecord * rec=released.at(i);
+        QMutexLocker recordLocker(&recordMutex(rec));
+        rec->dataReady.fetchAndStoreRelaxed(0);
+        rec->releaseData();
+    }
+}
+
+bool GribCache::hasRoom(void) {
+    QMutexLocker locker(&mutex);
+    return loadedSize<maxSize;
+}
+
+void GribCache::set_maxSize(const qint64 &bytes) {
+    QMutexLocker locker(&mutex);
+    maxSize=bytes;
+}
@@ -0,0 +1,61 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2013 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+
+#ifndef GRIBCACHE_H
+#define GRIBCACHE_H
+
+#include <QMutex>
+#include <QList>
+#include <QAtomicInt>
+
+#include "class_list.h"
+
+#define NB_RECORD_MUTEX 64
+
+/* decoded data of the records indexed without it (lazy GRIB loading):
+   data is read on first access from any thread, and given back, least
+   recently used first, by trim() once over the memory cap. trim() must
+   only be called from the GUI thread while no worker reads GRIB data.
+   A record is decoded under its own lock (one of recordMutex), mutex only
+   guards the list of the loaded records and their size */
+class GribCache
+{
+    public:
+        static void materialize(GribRecord * rec);
+        static void forget(GribRecord * rec);
+        static void trim(void);
+        static bool hasRoom(void);
+
+        static int tick(void) {return clock.fetchAndAddRelaxed(1);}
+        static void set_maxSize(const qint64 &bytes);
+
+    private:
+        static QMutex & recordMutex(GribRecord * rec);
+
+        static QMutex mutex;
+        static QMutex recordMutexes[NB_RECORD_MUTEX];
+        static QList<GribRecord *> loaded;
+        static qint64 loadedSize;
+        static qint64 maxSize;
+        static QAtomicInt clock;
+};
+
+#endif // GRIBCACHE_H
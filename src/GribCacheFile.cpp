@@ -0,0 +1,327 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2013 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QCryptographicHash>
+#include <QVector>
+#include <cstring>
+
+#include "GribCacheFile.h"
+#include "Grib.h"
+#include "GribCache.h"
+#include "dataDef.h"
+
+#define GRIB_CACHE_MAGIC    "QVLMGRBC"
+#define GRIB_CACHE_VERSION  2
+#define GRIB_CACHE_SAMPLE   65536
+
+/* log the cache writes, hits and evictions */
+//#define traceCache
+
+QString GribCacheFile::cacheName(const QString &fileName) {
+    QByteArray path=QFileInfo(fileName).absoluteFilePath().toUtf8();
+    return appFolder.value("gribCache")+QCryptographicHash::hash(path,QCryptographicHash::Md5).toHex()+".gcache";
+}
+
+/* size, date and hash of the first and last 64KB of the source file:
+   hashing all of it would cost more than what the cache saves */
+QByteArray GribCacheFile::sourceKey(const QString &fileName) {
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(file.read(GRIB_CACHE_SAMPLE));
+    if(file.size()>GRIB_CACHE_SAMPLE) {
+        file.seek(qMax((qint64)GRIB_CACHE_SAMPLE,file.size()-GRIB_CACHE_SAMPLE));
+        hash.addData(file.read(GRIB_CACHE_SAMPLE));
+    }
+    QByteArray key;
+    QDataStream stream(&key,QIODevice::WriteOnly);
+    stream << (qint64)file.size() << (qint64)QFileInfo(fileName).lastModified().toTime_t() << hash.result();
+    return key;
+}
+
+/*
+ * Layout: magic, offset of the index, then the grids (and the masks of
+ * the grids with undefined points) 8 bytes aligned, then the index:
+ * source key, grib info and the header + grid offsets of each record.
+ * Packed records (gribPackedData) keep their 16 bits grid and packing
+ */
+bool GribCacheFile::save(Grib * grib,QAtomicInt * cancel) {
+    if(!grib || !grib->isOk())
+        return false;
+    QByteArray key=sourceKey(grib->fileName);
+    if(key.isEmpty())
+        return false;
+
+#ifdef traceCache
+    QTime tSave;
+    tSave.start();
+#endif
+
+    QString name=cacheName(grib->fileName);
+    QFile file(name+".tmp");
+    if(!file.open(QIODevice::WriteOnly|QIODevice::Truncate)) {
+        qWarning() << "Can't write grib cache " << file.fileName();
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    stream.writeRawData(GRIB_CACHE_MAGIC,8);
+    stream << (qint64)0;
+
+    static const char padding[8]={0,0,0,0,0,0,0,0};
+    QList<GribRecord *> records;
+    QList<qint64> offsets;
+    bool ok=true;
+    std::map<long int,QMap<time_t,GribRecord *>*>::iterator it;
+    for(it=grib->mapGribRecords.begin();ok && it!=grib->mapGribRecords.end();++it) {
+        QMap<time_t,GribRecord *>::iterator itRec;
+        for(itRec=it->second->begin();ok && itRec!=it->second->end();++itRec) {
+            GribRecord * rec=itRec.value();
+            /* records of a lazy load are not decoded just to be written here */
+            if((cancel && cancel->fetchAndAddRelaxed(0)) || !rec->isDataReady()
+                    || !rec->isOk() || (!rec->data && !rec->data16)) {
+                ok=false;
+                break;
+            }
+            int size=rec->Ni*rec->Nj;
+            bool packed=rec->isPacked();
+            QVector<float> grid(packed?0:size);
+            QVector<quint16> grid16(packed?size:0);
+            QByteArray mask(size,1);
+            bool full=true;
+            for(int j=0;j<(int)rec->Nj;++j)
+                for(int i=0;i<(int)rec->Ni;++i) {
+                    if(packed)
+                        grid16[j*rec->Ni+i]=rec->data16[j*rec->Ni+i];
+                    else
+                        grid[j*rec->Ni+i]=rec->getValue(i,j);
+                    if(!rec->hasValue(i,j)) {
+                        mask[j*rec->Ni+i]=0;
+                        full=false;
+                    }
+                }
+            stream.writeRawData(padding,(8-file.pos()%8)%8);
+            offsets.append(file.pos());
+            if(packed)
+                stream.writeRawData((const char *)grid16.constData(),size*sizeof(quint16));
+            else
+                stream.writeRawData((const char *)grid.constData(),size*sizeof(float));
+
+            if(full)
+                offsets.append(-1);
+            else {
+                offsets.append(file.pos());
+                stream.writeRawData(mask.constData(),size);
+            }
+            records.append(rec);
+        }
+    }
+
+    qint64 indexOffset=file.pos();
+    stream << (qint32)GRIB_CACHE_VERSION << (qint32)Q_BYTE_ORDER << key;
+    stream << (qint32)grib->version << (qint64)grib->fileSize << (qint32)grib->dewpointDataStatus;
+    stream << (qint32)records.count();
+    for(int k=0;k<records.count();++k) {
+        records.at(k)->writeHeader(stream);
+        stream << offsets.at(2*k) << offsets.at(2*k+1);
+        stream << (qint32)records.at(k)->isPacked() << records.at(k)->packMin << records.at(k)->packStep;
+    }
+    file.seek(8);
+    stream << indexOffset;
+    ok=ok && stream.status()==QDataStream::Ok;
+    file.close();
+
+    if(!ok) {
+#ifdef traceCache
+        qWarning() << "Grib cache not written: " << file.fileName();
+#endif
+        QFile::remove(file.fileName());
+        return false;
+    }
+    QFile::remove(name);
+    if(!QFile::rename(file.fileName(),name)) {
+        QFile::remove(file.fileName());
+        return false;
+    }
+#ifdef traceCache
+    qWarning() << "Grib cache written: " << name << " - " << records.count() << " records in " << tSave.elapsed() << " ms";
+#endif
+    return true;
+}
+
+/* size of the grids of the cache file of grib (float32, or 16 bits when packed),
+   masks and index excepted */
+qint64 GribCacheFile::estimatedSize(Grib * grib) {
+    qint64 size=0;
+    if(!grib)
+        return size;
+    std::map<long int,QMap<time_t,GribRecord *>*>::iterator it;
+    for(it=grib->mapGribRecords.begin();it!=grib->mapGribRecords.end();++it) {
+        QMap<time_t,GribRecord *>::iterator itRec;
+        for(itRec=it->second->begin();itRec!=it->second->end();++itRec) {
+            GribRecord * rec=itRec.value();
+            size+=(qint64)rec->Ni*rec->Nj*(rec->isPacked()?sizeof(quint16):sizeof(float));
+        }
+    }
+    return size;
+}
+
+/* removes the least recently used cache files (last read or written) until
+   the folder holds maxSize bytes at most */
+void GribCacheFile::evict(const qint64 &maxSize) {
+    QDir dir(appFolder.value("gribCache"));
+    QFileInfoList files=dir.entryInfoList(QStringList("*.gcache"),QDir::Files);
+    QMultiMap<QDateTime,QFileInfo> byUse;
+    qint64 total=0;
+    for(int f=0;f<files.count();++f) {
+        const QFileInfo &info=files.at(f);
+        total+=info.size();
+        byUse.insert(qMax(info.lastRead(),info.lastModified()),info);
+    }
+    QMultiMap<QDateTime,QFileInfo>::const_iterator it;
+    for(it=byUse.constBegin();total>maxSize && it!=byUse.constEnd();++it) {
+        if(!QFile::remove(it.value().absoluteFilePath()))
+            continue;
+        total-=it.value().size();
+#ifdef traceCache
+        qWarning() << "Grib cache evicted: " << it.value().fileName();
+#endif
+    }
+}
+
+bool GribCacheFile::load(Grib * grib,const QString &fileName) {
+    QString name=cacheName(fileName);
+    if(!grib || !QFile::exists(name))
+        return false;
+    QByteArray key=sourceKey(fileName);
+    if(key.isEmpty())
+        return false;
+
+#ifdef traceCache
+    QTime tLoad;
+    tLoad.start();
+#endif
+
+    QFile * file=new QFile(name);
+    const uchar * map=NULL;
+    qint64 mapSize=0;
+    if(file->open(QIODevice::ReadOnly)) {
+        mapSize=file->size();
+        if(mapSize>16)
+            map=file->map(0,mapSize);
+    }
+    if(!map || memcmp(map,GRIB_CACHE_MAGIC,8)!=0) {
+        delete file;
+        return false;
+    }
+
+    QByteArray raw=QByteArray::fromRawData((const char *)map,mapSize);
+    QDataStream stream(raw);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    stream.skipRawData(8);
+    qint64 indexOffset;
+    stream >> indexOffset;
+    if(indexOffset<16 || indexOffset>=mapSize || !stream.device()->seek(indexOffset)) {
+        delete file;
+        return false;
+    }
+
+    /* stale cache: it is overwritten once the file is decoded again */
+    qint32 cacheVersion,byteOrder,version,dewpointStatus,nbRecords;
+    qint64 fileSize;
+    QByteArray cachedKey;
+    stream >> cacheVersion >> byteOrder >> cachedKey;
+    if(stream.status()!=QDataStream::Ok || cacheVersion!=GRIB_CACHE_VERSION
+            || byteOrder!=Q_BYTE_ORDER || cachedKey!=key) {
+        delete file;
+        return false;
+    }
+    stream >> version >> fileSize >> dewpointStatus >> nbRecords;
+    if(stream.status()!=QDataStream::Ok || version!=grib->version || nbRecords<=0) {
+        delete file;
+        return false;
+    }
+
+    /* a cache written with the other gribPackedData setting is stale too */
+    QList<GribRecord *> records;
+    for(int k=0;k<nbRecords;++k) {
+        GribRecord * rec=new GribMappedRecord(stream,map,mapSize);
+        if(!rec->isOk() || rec->isPacked()!=grib->packData) {
+            delete rec;
+            qDeleteAll(records);
+            delete file;
+            return false;
+        }
+        records.append(rec);
+    }
+    for(int k=0;k<records.count();++k)
+        grib->addRecord(records.at(k));
+
+    grib->fileName=fileName;
+    grib->fileSize=fileSize;
+    grib->dewpointDataStatus=dewpointStatus;
+    grib->cacheFile=file;
+    grib->ok=true;
+
+#ifdef traceCache
+    qWarning() << "Grib loaded from cache: " << name << " - " << nbRecords << " records in " << tLoad.elapsed() << " ms";
+#endif
+    return true;
+}
+
+/*************************
+ * GribMappedRecord      *
+ *************************/
+
+GribMappedRecord::GribMappedRecord(QDataStream &stream,const uchar * map,const qint64 &mapSize) : GribRecord() {
+    mask=NULL;
+    readHeader(stream);
+    qint64 dataOffset,maskOffset;
+    qint32 packed;
+    stream >> dataOffset >> maskOffset >> packed >> packMin >> packStep;
+    qint64 size=(qint64)Ni*Nj;
+    qint64 valueSize=packed?sizeof(quint16):sizeof(float);
+    if(!ok || stream.status()!=QDataStream::Ok
+            || dataOffset<16 || dataOffset%8!=0 || dataOffset+size*valueSize>mapSize
+            || (maskOffset>=0 && maskOffset+size>mapSize)) {
+        ok=false;
+        return;
+    }
+    /* read only mapping: the grid of a cached record is never written */
+    if(packed)
+        data16=(quint16 *)(map+dataOffset);
+    else
+        data=(float *)(map+dataOffset);
+    mappedData=true;
+    if(maskOffset>=0)
+        mask=map+maskOffset;
+}
+
+bool GribMappedRecord::hasValue(int i, int j) const {
+    return ok && (!mask || mask[j*Ni+i]);
+}
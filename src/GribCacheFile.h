@@ -0,0 +1,66 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2013 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+
+#ifndef GRIBCACHEFILE_H
+#define GRIBCACHEFILE_H
+
+#include <QString>
+#include <QAtomicInt>
+#include <QByteArray>
+
+#include "class_list.h"
+#include "GribRecord.h"
+
+/* sidecar file of a decoded GRIB: record index + float32 grids, the
+   computed dewpoint included. It is mapped on the next load of the same
+   file (same path, size, date and content) instead of decoding it.
+   It is written in the background once the grib is published (see GribLoader),
+   the least recently used files go when the folder is over gribDiskCacheSize MB */
+class GribCacheFile
+{
+    public:
+        static bool load(Grib * grib,const QString &fileName);
+        static bool save(Grib * grib,QAtomicInt * cancel=NULL);
+        static void evict(const qint64 &maxSize);
+        static qint64 estimatedSize(Grib * grib);
+
+        static QString cacheName(const QString &fileName);
+
+    private:
+        static QByteArray sourceKey(const QString &fileName);
+};
+
+/* record whose grid points into the mapping of a cache file */
+class GribMappedRecord: public GribRecord
+{
+    public:
+        GribMappedRecord(QDataStream &stream,const uchar * map,const qint64 &mapSize);
+
+        bool hasValue(int i, int j) const;
+
+    protected:
+        void releaseData(void) { }
+
+    private:
+        const uchar * mask;  // 1 byte per point, NULL if all points are defined
+};
+
+#endif // GRIBCACHEFILE_H
@@ -0,0 +1,207 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2013 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <QDebug>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QFileInfo>
+#include <QGraphicsView>
+#include <QProgressDialog>
+#include <QTimer>
+#ifdef QT_V5
+#include <QtConcurrent/QtConcurrentRun>
+#else
+#include <QtConcurrentRun>
+#endif
+
+#include "Grib.h"
+#include "GribCache.h"
+#include "GribCacheFile.h"
+#include "GribRecord.h"
+#include "settings.h"
+
+#include "GribLoader.h"
+
+GribLoader::GribLoader() {
+    loading=false;
+    savedGrib=NULL;
+}
+
+GribLoader::~GribLoader() {
+    stop_prefetch();
+    stop_save(NULL);
+}
+
+/* while the worker runs, the windows can't be closed and menus, shortcuts and
+   dialogs get no input: closing the grib or the application from the nested
+   loop would delete what the loader works for. The progress dialog and the map
+   (pan and zoom with the mouse, the current data stays drawn) keep running */
+class GribLoadFilter: public QObject
+{
+    public:
+        GribLoadFilter(QWidget * dialog) : dialog(dialog) { }
+
+    protected:
+        bool eventFilter(QObject * obj,QEvent * event) {
+            switch(event->type()) {
+                case QEvent::MouseButtonPress:
+                case QEvent::MouseButtonRelease:
+                case QEvent::Wheel:
+                    if(isMap(obj))
+                        return false;
+                    break;
+                case QEvent::Close:
+                case QEvent::MouseButtonDblClick:
+                case QEvent::KeyPress:
+                case QEvent::KeyRelease:
+                case QEvent::Shortcut:
+                case QEvent::ShortcutOverride:
+                case QEvent::ContextMenu:
+                    break;
+                default:
+                    return false;
+            }
+            QWidget * widget=qobject_cast<QWidget *>(obj);
+            if(!widget || widget==dialog || dialog->isAncestorOf(widget))
+                return false;
+            event->ignore();
+            return true;
+        }
+
+    private:
+        QWidget * dialog;
+
+        static bool isMap(QObject * obj) {
+            QWidget * widget=qobject_cast<QWidget *>(obj);
+            QGraphicsView * view=widget?qobject_cast<QGraphicsView *>(widget->parentWidget()):NULL;
+            return view && view->viewport()==widget;
+        }
+};
+
+Grib * GribLoader::load(QString fileName,DataManager * dataManager) {
+    if(loading) {
+        qWarning() << "A grib is already loading, can't load " << fileName;
+        return NULL;
+    }
+    loading=true;
+
+    /* settings are not read from the worker */
+    GribLoadState state;
+    state.packData=Settings::getSetting("gribPackedData",0).toInt()==1;
+    state.useDiskCache=Settings::getSetting("gribDiskCache",1).toInt()==1;
+    state.lazy=Settings::getSetting("gribLazyLoad",1).toInt()==1;
+
+    QFuture<Grib *> future=QtConcurrent::run(GribLoader::run,fileName,dataManager,&state);
+
+    QProgressDialog p(QObject::tr("Chargement du grib"),QObject::tr("Annuler"),0,100);
+    p.setWindowTitle(QFileInfo(fileName).fileName());
+    p.setMinimumDuration(500);
+    p.setAutoClose(false);
+    p.setAutoReset(false);
+    GribLoadFilter filter(&p);
+    QCoreApplication::instance()->installEventFilter(&filter);
+    /* wakes the loop up to follow the worker */
+    QTimer timer;
+    timer.start(50);
+    while(!future.isFinished()) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents|QEventLoop::WaitForMoreEvents);
+        if(p.wasCanceled())
+            state.cancelled.fetchAndStoreRelaxed(1);
+        else {
+            int total=state.kbTotal.fetchAndAddRelaxed(0);
+            if(total>0)
+                p.setValue(qBound(0,(int)((qint64)state.kbDone.fetchAndAddRelaxed(0)*100/total),99));
+        }
+    }
+    timer.stop();
+    QCoreApplication::instance()->removeEventFilter(&filter);
+
+    Grib * grib=future.result();
+    loading=false;
+    if(grib && (!grib->isOk() || state.cancelled.fetchAndAddRelaxed(0))) {
+        delete grib;
+        grib=NULL;
+    }
+    /* records of a lazy load are not all in memory, there is nothing to write */
+    if(grib && state.useDiskCache && !state.lazy && !grib->isFromCacheFile())
+        start_save(grib);
+    return grib;
+}
+
+Grib * GribLoader::run(QString fileName,DataManager * dataManager,GribLoadState * state) {
+    Grib * grib=Grib::loadGrib(fileName,dataManager,state);
+    /* the grib lives in the GUI thread once published */
+    if(grib)
+        grib->moveToThread(QCoreApplication::instance()->thread());
+    return grib;
+}
+
+/* the previous write goes to its end first: it can belong to a grib still in use */
+void GribLoader::start_save(Grib * grib) {
+    saveFuture.waitForFinished();
+    savedGrib=grib;
+    saveCancel.fetchAndStoreRelaxed(0);
+    qint64 maxSize=(qint64)Settings::getSetting("gribDiskCacheSize",1024).toInt()*1024*1024;
+    saveFuture=QtConcurrent::run(GribLoader::save,grib,&saveCancel,maxSize);
+}
+
+void GribLoader::stop_save(Grib * grib) {
+    if(grib && grib!=savedGrib)
+        return;
+    saveCancel.fetchAndStoreRelaxed(1);
+    saveFuture.waitForFinished();
+    savedGrib=NULL;
+}
+
+/* a cache file over the cap would be evicted as soon as written */
+void GribLoader::save(Grib * grib,QAtomicInt * cancel,qint64 maxSize) {
+    if(GribCacheFile::estimatedSize(grib)>maxSize)
+        return;
+    if(GribCacheFile::save(grib,cancel))
+        GribCacheFile::evict(maxSize);
+}
+
+void GribLoader::start_prefetch(const QList<Grib *> &gribs,time_t date) {
+    stop_prefetch();
+    QList<GribRecord *> records;
+    for(int g=0;g<gribs.count();++g) {
+        QList<GribRecord *> list;
+        if(gribs.at(g)) gribs.at(g)->get_recordsToPrefetch(date,&list);
+        records+=list;
+    }
+    if(records.isEmpty())
+        return;
+    prefetchCancel.fetchAndStoreRelaxed(0);
+    prefetchFuture=QtConcurrent::run(GribLoader::prefetch,records,&prefetchCancel);
+}
+
+void GribLoader::stop_prefetch(void) {
+    prefetchCancel.fetchAndStoreRelaxed(1);
+    prefetchFuture.waitForFinished();
+}
+
+/* stops at the memory cap of GribCache: trim() would give back the records read first */
+void GribLoader::prefetch(QList<GribRecord *> records,QAtomicInt * cancel) {
+    for(int r=0;r<records.count();++r) {
+        if(cancel->fetchAndAddRelaxed(0) || !GribCache::hasRoom())
+            return;
+        records.at(r)->ensureData();
+    }
+}
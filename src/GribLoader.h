@@ -0,0 +1,70 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2013 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef GRIBLOADER_H
+#define GRIBLOADER_H
+
+#include <ctime>
+#include <QAtomicInt>
+#include <QFuture>
+#include <QList>
+#include <QString>
+
+#include "class_list.h"
+
+/* a grib is read in a worker thread while the GUI keeps running (progress in
+   bytes of the file and cancellation in a dialog, the map can be moved). It is
+   handed to the caller, to be published at once, only when complete.
+   By default (gribLazyLoad) a GRIB2 is only indexed: it is published as soon as
+   the index is read, and its records are then decoded in the background, wind
+   around the display date first, so that the map and the router can start
+   while the other data and dates come in behind.
+   A decoded grib is written to the disk cache (GribCacheFile) in the background too */
+class GribLoader
+{
+    public:
+        GribLoader();
+        ~GribLoader();
+
+        Grib * load(QString fileName,DataManager * dataManager);
+        bool isLoading(void) const { return loading; }
+
+        void start_prefetch(const QList<Grib *> &gribs,time_t date);
+        /* to be called before a grib is deleted or GribCache trimmed */
+        void stop_prefetch(void);
+        /* to be called before a grib is deleted, NULL for any grib */
+        void stop_save(Grib * grib);
+
+    private:
+        bool loading;
+        QFuture<void> prefetchFuture;
+        QAtomicInt prefetchCancel;
+        QFuture<void> saveFuture;
+        Grib * savedGrib;
+        QAtomicInt saveCancel;
+
+        void start_save(Grib * grib);
+
+        static Grib * run(QString fileName,DataManager * dataManager,GribLoadState * state);
+        static void prefetch(QList<GribRecord *> records,QAtomicInt * cancel);
+        static void save(Grib * grib,QAtomicInt * cancel,qint64 maxSize);
+};
+
+#endif // GRIBLOADER_H
@@ -34,11 +34,117 @@ GribRecord::GribRecord(void) {
     refSecond=0;
     deltaPeriod=0;
     data=NULL;
+    data16=NULL;
+    packMin=0;
+    packStep=0;
+    mappedData=false;
+    dataSize=0;
+    bmapSize=0;
+    dataReady.fetchAndStoreRelaxed(1);
+    inCache=false;
+    packOnLoad=false;
+    lastUse=0;
 }
 GribRecord::~GribRecord()
 {    
+    GribCache::forget(this);
+    if(data && !mappedData)
+        delete[] data;
+    if(data16 && !mappedData)
+        delete[] data16;
+}
+
+void GribRecord::writeHeader(QDataStream &stream) const {
+    stream << (qint32)editionNumber << (qint32)idCenter << (qint32)idModel << (qint32)idGrid;
+    stream << (qint32)dataType << (qint32)levelType << (qint32)levelValue << (qint64)dataKey;
+    stream << (qint32)gridType << (quint32)Ni << (quint32)Nj;
+    stream << La1 << Lo1 << La2 << Lo2 << latMin << lonMin << latMax << lonMax << Di << Dj;
+    stream << (quint8)resolFlags << (quint8)scanFlags;
+    stream << hasDiDj << isScanIpositive << isScanJpositive << isAdjacentI << isFull << knownData;
+    stream << (qint32)deltaPeriod << (qint32)dataSize << (qint32)bmapSize;
+    stream << (quint32)refYear << (quint32)refMonth << (quint32)refDay;
+    stream << (quint32)refHour << (quint32)refMinute << (quint32)refSecond;
+    stream << (qint64)refDate << (qint64)curDate;
+}
+
+void GribRecord::readHeader(QDataStream &stream) {
+    qint32 i32;
+    quint32 u32;
+    qint64 i64;
+    quint8 u8;
+    stream >> i32; editionNumber=i32;
+    stream >> i32; idCenter=i32;
+    stream >> i32; idModel=i32;
+    stream >> i32; idGrid=i32;
+    stream >> i32; dataType=i32;
+    stream >> i32; levelType=i32;
+    stream >> i32; levelValue=i32;
+    stream >> i64; dataKey=i64;
+    stream >> i32; gridType=i32;
+    stream >> u32; Ni=u32;
+    stream >> u32; Nj=u32;
+    stream >> La1 >> Lo1 >> La2 >> Lo2 >> latMin >> lonMin >> latMax >> lonMax >> Di >> Dj;
+    stream >> u8; resolFlags=u8;
+    stream >> u8; scanFlags=u8;
+    stream >> hasDiDj >> isScanIpositive >> isScanJpositive >> isAdjacentI >> isFull >> knownData;
+    stream >> i32; deltaPeriod=i32;
+    stream >> i32; dataSize=i32;
+    stream >> i32; bmapSize=i32;
+    stream >> u32; refYear=u32;
+    stream >> u32; refMonth=u32;
+    stream >> u32; refDay=u32;
+    stream >> u32; refHour=u32;
+    stream >> u32; refMinute=u32;
+    stream >> u32; refSecond=u32;
+    stream >> i64; refDate=i64;
+    stream >> i64; curDate=i64;
+    ok=stream.status()==QDataStream::Ok;
+}
+
+void GribRecord::touch(void) {
+    lastUse=GribCache::tick();
+}
+
+void GribRecord::releaseData(void) {
     if(data)
         delete[] data;
+    data=NULL;
+    if(data16)
+        delete[] data16;
+    data16=NULL;
+}
+
+/*
+ * Linear quantisation of the grid on 16 bits between its min and max:
+ * value = packMin + q*packStep, q=GRIB_PACKED_NOTDEF for undefined points.
+ * Halves the memory, the error is at most packStep/2 = (max-min)/131068
+ * (under 0.1 Pa for pressure, 0.001 m/s for wind). Data is read only after this.
+ */
+void GribRecord::packData(void) {
+    /* lazy records are packed by GribCache when read, mapped ones are stored packed in the cache file */
+    if(!data || data16 || dataSize<=0 || inCache || mappedData)
+        return;
+    float vMin=0,vMax=0;
+    bool found=false;
+    for(int i=0;i<dataSize;++i) {
+        if(data[i]==(float)GRIB_NOTDEF) continue;
+        if(!found || data[i]<vMin) vMin=data[i];
+        if(!found || data[i]>vMax) vMax=data[i];
+        found=true;
+    }
+    packMin=vMin;
+    packStep=(vMax-vMin)/(GRIB_PACKED_NOTDEF-1);
+    data16=new quint16[dataSize];
+    for(int i=0;i<dataSize;++i) {
+        if(data[i]==(float)GRIB_NOTDEF)
+            data16[i]=GRIB_PACKED_NOTDEF;
+        else if(packStep>0)
+            data16[i]=(quint16)qRound((data[i]-packMin)/packStep);
+        else
+            data16[i]=0;
+    }
+    delete[] data;
+    data=NULL;
 }
 
 void  GribRecord::set_dataType(int t) {
@@ -56,6 +162,8 @@ time_t GribRecord::makeDate(unsigned int year,unsigned int month,unsigned int da
 }
 
 void GribRecord::multiplyAllData(double k) {
+    if(!data)
+        return;
     for (unsigned int j=0; j<Nj; j++)
         for (unsigned int i=0; i<Ni; i++)
             if (hasValue(i,j))
@@ -63,6 +171,11 @@ void GribRecord::multiplyAllData(double k) {
 }
 
 void GribRecord::unitConversion(void) {
+    convertData();
+    translateDataType();
+}
+
+void GribRecord::convertData(void) {
     switch(dataType) {
         case DATA_PRECIP_RATE: // mm/s -> mm/h
             multiplyAllData(3600);
@@ -79,7 +192,6 @@ void GribRecord::unitConversion(void) {
             break;
 
     }
-    translateDataType();
 }
 void  GribRecord::translateDataType()
 {
@@ -123,15 +235,11 @@ void  GribRecord::translateDataType()
 }
 
 //===============================================================================================
-bool GribRecord::getValue_TWSA(double px, double py,double * a00,double * a01,double * a10,double * a11,bool debug) {
-    int sigDj;
-
+/* finds the grid square around (px,py), px being brought back in the grid if it went round the world */
+bool GribRecord::getCell_TWSA(double px, double py,int * i0,int * j0,int * i1,int * sigDj,bool debug) const {
     if (!ok || Di==0 || Dj==0)
         return false;
 
-    if(!a00 || !a01 || !a10 || !a11)
-        return false;
-
     if (!isPointInMap(px,py)) {
         px += 360.0;               // tour du monde a droite ?
         if (!isPointInMap(px,py)) {
@@ -144,58 +252,66 @@ bool GribRecord::getValue_TWSA(double px, double py,double * a00,double * a01,do
     // 00 10      point is in a square
     // 01 11
     /*note that (int) truncates, for instance (int) -3.5 returns 3, while floor(-3.5) returns -4*/
-    int i0 = (int) floor((px-Lo1)/Di);  // point 00
-    int j0 = (int) floor((py-La1)/Dj);
-    int j0_init=j0;
-    int i1;
+    *i0 = (int) floor((px-Lo1)/Di);  // point 00
+    *j0 = (int) floor((py-La1)/Dj);
 
     if(isFull && px>=Lo2)
-        i1=0;
+        *i1=0;
     else
-        i1=i0+1;
+        *i1=*i0+1;
 
-    if(((py-La1)/Dj)-j0==0.0) {
+    if(((py-La1)/Dj)-*j0==0.0) {
         if(debug)
             qWarning() << "on grib point";
-        sigDj=0;
+        *sigDj=0;
     }
     else {
         if(Dj<0) {
-            sigDj=-1;
-            j0++;
+            *sigDj=-1;
+            (*j0)++;
         }
         else
-            sigDj=1;
+            *sigDj=1;
     }
 
     if(debug) {
         qWarning() << "Lo1=" << Lo1 << ", La1=" << La1 << ", Di=" << Di << ", Dj" << Dj;
-        qWarning() << "Rec date = " << this->get_curDate();
-        qWarning() << "px=" << px << ", py=" << py << ", i0=" << i0 << ", j0=" << j0 << ", i1=" << i1 << ", j1=" << j0+sigDj;
+        qWarning() << "Rec date = " << curDate;
+        qWarning() << "px=" << px << ", py=" << py << ", i0=" << *i0 << ", j0=" << *j0 << ", i1=" << *i1 << ", j1=" << *j0+*sigDj;
     }
+    return true;
+}
 
-    int nbval = 0;     // how many values in grid ?
-    if (hasValue(i0,   j0))
-        nbval ++;
-    if (hasValue(i1, j0))
-        nbval ++;
-    if (hasValue(i0,   j0+sigDj))
-        nbval ++;
-    if (hasValue(i1, j0+sigDj))
-        nbval ++;
-
-    if(debug)
-        qWarning() << "Nb Val =" << nbval;
-
-    if (nbval != 4)
+bool GribRecord::getCorners_TWSA(const int &i0,const int &j0,const int &i1,const int &sigDj,
+                                 double * a00,double * a01,double * a10,double * a11) const {
+    if (!hasValue(i0,   j0) || !hasValue(i1, j0)
+            || !hasValue(i0,   j0+sigDj) || !hasValue(i1, j0+sigDj))
         return false;
 
     *a00 = getValue(i0,   j0);
     *a01 = getValue(i0,   j0+sigDj);
     *a10 = getValue(i1, j0);
     *a11 = getValue(i1, j0+sigDj);
+    return true;
+}
+
+bool GribRecord::getValue_TWSA(double px, double py,double * a00,double * a01,double * a10,double * a11,bool debug) {
+    int i0,j0,i1,sigDj;
+
+    if(!a00 || !a01 || !a10 || !a11)
+        return false;
+
+    if(!getCell_TWSA(px,py,&i0,&j0,&i1,&sigDj,debug))
+        return false;
+
+    if(!getCorners_TWSA(i0,j0,i1,sigDj,a00,a01,a10,a11)) {
+        if(debug)
+            qWarning() << "missing values around point";
+        return false;
+    }
 
     if(debug) {
+        int j0_init=(sigDj==-1)?j0-1:j0;
         qWarning() << "val around 00\n" << *a00
                    << "\n" << getValue(i0-1,   j0_init)
                    << "\n" << getValue(i0-1,   j0_init+1)
@@ -215,7 +331,17 @@ bool GribRecord::getValue_TWSA(double px, double py,double * a00,double * a01,do
 //
 
 double GribRecord::getInterpolatedValue(double px, double py, bool numericalInterpolation) {
-    double val;
+    int i0,i1,j0,sigDj;
+    double dx,dy;
+    if(!getGridPosX(px,&i0,&i1,&dx) || !getGridPosY(py,&j0,&sigDj,&dy))
+        return GRIB_NOTDEF;
+    return getInterpolatedValueAt(i0,i1,dx,j0,sigDj,dy,numericalInterpolation);
+}
+
+#ifdef timeStat
+/* grid position computed per point, as before getGridPosX/Y: reference of
+   MapDataDrawer::benchmark_screenLookup */
+double GribRecord::getInterpolatedValue_OLD(double px, double py, bool numericalInterpolation) const {
     if (!ok || Di==0 || Dj==0) {
         return GRIB_NOTDEF;
     }
@@ -251,6 +377,47 @@ double GribRecord::getInterpolatedValue(double px, double py, bool numericalInte
     if(((py-La1)/Dj)-j0==0.0)
         sigDj=0;
 
+    return getInterpolatedValueAt(i0,i1,dx,j0,sigDj,dy,numericalInterpolation);
+}
+#endif
+
+/* the grid position of a point only depends on its longitude for i and on its
+   latitude for j: a raster can compute them once per column and once per row */
+bool GribRecord::getGridPosX(double px, int * i0, int * i1, double * dx) const {
+    if (!ok || Di==0 || Dj==0)
+        return false;
+    if (!isXInMap(px)) {
+        px += 360.0;               // tour du monde a droite ?
+        if (!isXInMap(px)) {
+            px -= 2*360.0;              // tour du monde a gauche ?
+            if (!isXInMap(px))
+                return false;
+        }
+    }
+    double pi = (px-Lo1)/Di;     // coord. in grid unit
+    *i0 = (int) floor(pi);  // point 00
+    if(isFull && px>=Lo2)
+        *i1=0;
+    else
+        *i1=*i0+1;
+    *dx = pi-*i0;   // distance to 00
+    return true;
+}
+
+bool GribRecord::getGridPosY(double py, int * j0, int * sigDj, double * dy) const {
+    if (!ok || Di==0 || Dj==0 || !isYInMap(py))
+        return false;
+    double pj = (py-La1)/Dj;
+    *j0 = (int) floor(pj);
+    *dy = pj-*j0;
+    *sigDj = (*dy==0.0)?0:1;
+    return true;
+}
+
+double GribRecord::getInterpolatedValueAt(const int &i0, const int &i1, double dx,
+                                          const int &j0, const int &sigDj, double dy,
+                                          bool numericalInterpolation) const {
+    double val;
     bool h00,h01,h10,h11;
     int nbval = 0;     // how many values in grid ?
     if ((h00=hasValue(i0,   j0)))
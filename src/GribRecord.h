@@ -24,13 +24,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define GRIBRECORD_H
 
 #include <cmath>
+#include <QDataStream>
+#include <QAtomicInt>
 
 #include "class_list.h"
 #include "dataDef.h"
+#include "GribCache.h"
 
 #define MUST_INTERPOLATE_VALUE true
 
+/* benchmark of the grib drawing (MapDataDrawer::benchmark_screenLookup) */
+//#define timeStat
+
 class GribRecord {
+    friend class GribCache;
+    friend class GribCacheFile;
     public:
         GribRecord();
         virtual ~GribRecord();
@@ -76,6 +84,19 @@ class GribRecord {
 
         FCT_GET_CST(int,dataSize)
         FCT_GET_CST(int,bmapSize)
+        int get_memSize(void) const { return dataSize*(data16?sizeof(quint16):sizeof(float))+bmapSize*sizeof(bool); }
+
+        /* 16 bits storage of the grid, see packData() */
+        void packData(void);
+        bool isPacked(void) const { return data16!=NULL; }
+        /* lazy record: packed by GribCache when read, set when the record is indexed */
+        void set_packOnLoad(const bool &pack) { packOnLoad=pack; }
+
+        /* lazy loading: data is read on first access, see GribCache */
+        FCT_GET(int,lastUse)
+        void touch(void);
+        inline void ensureData(void) const;
+        bool isDataReady(void) const { return dataReady.fetchAndAddAcquire(0)!=0; }
 
         // coordonnees d'un point de la grille
         inline float  getX(const int &i) const   { return ok ? Lo1+i*Di : GRIB_NOTDEF;}
@@ -83,13 +104,24 @@ class GribRecord {
 
         // Valeur pour un point de la grille
         virtual bool hasValue(int i, int j) const =0;
-        inline float getValue(const int &i, const int &j) const  { return ok ? data[j*Ni+i] : GRIB_NOTDEF;}
-        void setValue(unsigned int i, unsigned int j, double v) { if (i<Ni && j<Nj) data[j*Ni+i] = v; }
+        inline float getValue(const int &i, const int &j) const  { ensureData(); return ok && (data||data16) ? valueAt(j*Ni+i) : GRIB_NOTDEF;}
+        void setValue(unsigned int i, unsigned int j, double v) { if (data && i<Ni && j<Nj) data[j*Ni+i] = v; }
 
         // interpolation:
         double getInterpolatedValue(double px, double py, bool numericalInterpolation=MUST_INTERPOLATE_VALUE);
+#ifdef timeStat
+        double getInterpolatedValue_OLD(double px, double py, bool numericalInterpolation=MUST_INTERPOLATE_VALUE) const;
+#endif
+        bool getGridPosX(double px, int * i0, int * i1, double * dx) const;
+        bool getGridPosY(double py, int * j0, int * sigDj, double * dy) const;
+        double getInterpolatedValueAt(const int &i0, const int &i1, double dx,
+                                      const int &j0, const int &sigDj, double dy,
+                                      bool numericalInterpolation=MUST_INTERPOLATE_VALUE) const;
         bool getValue_TWSA(double px, double py,
                                        double * a00,double * a01,double * a10,double * a11,bool debug);
+        bool getCell_TWSA(double px, double py,int * i0,int * j0,int * i1,int * sigDj,bool debug=false) const;
+        bool getCorners_TWSA(const int &i0,const int &j0,const int &i1,const int &sigDj,
+                             double * a00,double * a01,double * a10,double * a11) const;
 
         // Le point est-il a  l'interieur de la grille ?
         inline bool   isPointInMap(const double &x, const double &y) const;
@@ -98,6 +130,10 @@ class GribRecord {
 
         void print_bitmap(void);
 
+        /* grid and date description, data excepted (see GribCacheFile) */
+        void writeHeader(QDataStream &stream) const;
+        void readHeader(QDataStream &stream);
+
 protected:
         bool ok;
 
@@ -126,8 +162,22 @@ protected:
         int deltaPeriod;
 
         float  *data;
+        quint16 *data16;     // packed grid, replaces data (see packData)
+        float packMin, packStep;
+        bool mappedData;     // data is not ours (GribMappedRecord)
+        inline float valueAt(const int &ind) const;
         bool knownData;
+        /* 0 while data of a lazy record is not in memory. Set with release once the
+           data is in place (GribCache::materialize), read with acquire */
+        mutable QAtomicInt dataReady;
+        bool inCache;
+        bool packOnLoad;
+        int lastUse;
+        virtual bool loadData(void) { return false; }
+        virtual void releaseData(void);
         void   multiplyAllData(double k);
+        void   convertData(void);
+        void   translateDataType();
 
 
         int dataSize;
@@ -139,9 +189,6 @@ protected:
         time_t makeDate(unsigned int year,unsigned int month,
                         unsigned int day,unsigned int hour,unsigned int min,unsigned int sec);
 
-
-private:
-        void translateDataType();
 };
 Q_DECLARE_TYPEINFO(GribRecord,Q_MOVABLE_TYPE);
 
@@ -151,6 +198,20 @@ inline long int GribRecord::makeKey(int dataType,int levelType,int levelValue) {
     return res;
 }
 
+inline void GribRecord::ensureData(void) const {
+    if(!dataReady.fetchAndAddAcquire(0))
+        GribCache::materialize(const_cast<GribRecord *>(this));
+}
+
+#define GRIB_PACKED_NOTDEF 0xFFFF
+
+inline float GribRecord::valueAt(const int &ind) const {
+    if(!data16)
+        return data[ind];
+    quint16 q=data16[ind];
+    return q==GRIB_PACKED_NOTDEF ? GRIB_NOTDEF : packMin+q*packStep;
+}
+
 inline bool GribRecord::isPointInMap(const double &x, const double &y) const {
     return isXInMap(x) && isYInMap(y);
 }
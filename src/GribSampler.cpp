@@ -0,0 +1,191 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2013 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+
+#include <QVector>
+
+#include "GribSampler.h"
+#include "GribRecord.h"
+#include "Grib.h"
+#include "DataManager.h"
+#include "dataDef.h"
+
+GribSamplerCache::GribSamplerCache()
+{
+    for(int n=0;n<SAMPLER_CACHE_SIZE;++n)
+        entries[n].rec=NULL;
+}
+
+GribSampler::GribSampler()
+{
+    clear();
+}
+
+void GribSampler::clear(void)
+{
+    valid=false;
+    date=0;
+    interpolationType=INTERPOLATION_UKN;
+    forced=false;
+    forcedU=0;
+    forcedV=0;
+    nbSources=0;
+    coverageCells.clear();
+    chains.clear();
+}
+
+const GribSampler::chain * GribSampler::get_chain(const double &d_long, const double &d_lat) const
+{
+    if(coverageCells.isEmpty() || d_long!=d_long || d_lat!=d_lat)
+        return NULL;
+    int set=coverageCells.at(DataManager::get_coverageCell(d_long,d_lat));
+    return set<chains.count()?&chains.at(set):NULL;
+}
+
+bool GribSampler::sample(const double &d_long, const double &d_lat, double * u, double * v,
+                         GribSamplerCache * cache) const
+{
+    if(!u || !v) return false;
+    if(forced) {
+        *u=forcedU;
+        *v=forcedV;
+        return true;
+    }
+    const chain * sourceChain=get_chain(d_long,d_lat);
+    for(int s=0;sourceChain && s<sourceChain->nb;++s) {
+        *u=0;
+        *v=0;
+        if(sampleSource(sources[sourceChain->src[s]],d_long,d_lat,u,v,cache))
+            return true;
+    }
+    *u=0;
+    *v=0;
+    return false;
+}
+
+/* batch: at each rank of the chains, each source interpolates at once the points
+   whose chain gives it at this rank and that are not found yet */
+int GribSampler::sample(const double * d_long, const double * d_lat, const int &count,
+                        double * u, double * v, bool * ok) const
+{
+    QVector<int> todo;
+    QVector<const chain *> pointChain(count);
+    for(int n=0;n<count;++n) {
+        u[n]=forced?forcedU:0;
+        v[n]=forced?forcedV:0;
+        ok[n]=forced;
+        if(forced) continue;
+        pointChain[n]=get_chain(d_long[n],d_lat[n]);
+        if(pointChain.at(n) && pointChain.at(n)->nb>0)
+            todo.append(n);
+    }
+    if(forced)
+        return count;
+
+    int nbOk=0;
+    QVector<double> lon,lat,su,sv;
+    QVector<bool> sok;
+    QVector<int> points;
+    for(int rank=0;rank<GRIB_SAMPLER_MAX_SOURCES && !todo.isEmpty();++rank) {
+        QVector<int> left;
+        for(int s=0;s<nbSources;++s) {
+            points.clear();
+            for(int n=0;n<todo.count();++n)
+                if(pointChain.at(todo.at(n))->src[rank]==s)
+                    points.append(todo.at(n));
+            if(points.isEmpty())
+                continue;
+            const source &src=sources[s];
+            int nb=points.count();
+            lon.resize(nb);
+            lat.resize(nb);
+            su.resize(nb);
+            sv.resize(nb);
+            sok.resize(nb);
+            for(int n=0;n<nb;++n) {
+                lon[n]=d_long[points.at(n)];
+                lat[n]=d_lat[points.at(n)];
+            }
+            Grib::interpolateValues_2D(lon.constData(),lat.constData(),nb,date,src.t1,src.t2,
+                                       src.recU1,src.recV1,src.recU2,src.recV2,
+                                       su.data(),sv.data(),sok.data(),interpolationType,true);
+            for(int n=0;n<nb;++n) {
+                int k=points.at(n);
+                if(sok.at(n)) {
+                    u[k]=su.at(n);
+                    v[k]=sv.at(n);
+                    ok[k]=true;
+                    ++nbOk;
+                }
+                else if(pointChain.at(k)->nb>rank+1)
+                    left.append(k);
+            }
+        }
+        todo=left;
+    }
+    return nbOk;
+}
+
+bool GribSampler::sampleSource(const source &src, const double &d_long, const double &d_lat,
+                               double * u, double * v, GribSamplerCache * cache) const
+{
+    windData wData_prev;
+    windData wData_nxt;
+    if(!getCorners(src.recU1,d_long,d_lat,&(wData_prev.u0),&(wData_prev.u1),&(wData_prev.u2),&(wData_prev.u3),cache))
+        return false;
+    if(!getCorners(src.recV1,d_long,d_lat,&(wData_prev.v0),&(wData_prev.v1),&(wData_prev.v2),&(wData_prev.v3),cache))
+        return false;
+    bool hasNxt=src.recU2 && src.recV2;
+    if(hasNxt) {
+        if(!getCorners(src.recU2,d_long,d_lat,&(wData_nxt.u0),&(wData_nxt.u1),&(wData_nxt.u2),&(wData_nxt.u3),cache))
+            return false;
+        if(!getCorners(src.recV2,d_long,d_lat,&(wData_nxt.v0),&(wData_nxt.v1),&(wData_nxt.v2),&(wData_nxt.v3),cache))
+            return false;
+    }
+    return Grib::interpolateCorners_2D(d_long,d_lat,date,src.t1,src.t2,src.recU1,src.recV1,src.recU2,src.recV2,
+                                       &wData_prev,hasNxt?&wData_nxt:NULL,u,v,interpolationType,true);
+}
+
+bool GribSampler::getCorners(GribRecord * rec, const double &d_long, const double &d_lat,
+                             double * a00, double * a01, double * a10, double * a11,
+                             GribSamplerCache * cache)
+{
+    int i0,j0,i1,sigDj;
+    if(!rec->getCell_TWSA(d_long,d_lat,&i0,&j0,&i1,&sigDj))
+        return false;
+    if(!cache)
+        return rec->getCorners_TWSA(i0,j0,i1,sigDj,a00,a01,a10,a11);
+    GribSamplerCache::entry &e=cache->entries[(((quintptr)rec>>4)+(quint32)i0*31u+(quint32)j0*17u)%SAMPLER_CACHE_SIZE];
+    if(e.rec!=rec || e.i0!=i0 || e.j0!=j0 || e.i1!=i1 || e.sigDj!=sigDj) {
+        e.rec=rec;
+        e.i0=i0;
+        e.j0=j0;
+        e.i1=i1;
+        e.sigDj=sigDj;
+        e.ok=rec->getCorners_TWSA(i0,j0,i1,sigDj,&e.a00,&e.a01,&e.a10,&e.a11);
+    }
+    if(!e.ok)
+        return false;
+    *a00=e.a00;
+    *a01=e.a01;
+    *a10=e.a10;
+    *a11=e.a11;
+    return true;
+}
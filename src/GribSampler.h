@@ -0,0 +1,103 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2013 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+
+#ifndef GRIBSAMPLER_H
+#define GRIBSAMPLER_H
+
+#include <ctime>
+#include <QVector>
+
+#include "class_list.h"
+
+#define SAMPLER_CACHE_SIZE 64
+#define GRIB_SAMPLER_MAX_SOURCES 8
+
+/* values read around the last grid squares, to be kept on the caller's stack:
+   each thread has its own and neighbouring points mostly fall in the same squares */
+struct GribSamplerCache
+{
+    GribSamplerCache();
+    struct entry
+    {
+        const GribRecord * rec;
+        int i0,j0,i1,sigDj;
+        bool ok;
+        double a00,a01,a10,a11;
+    };
+    entry entries[SAMPLER_CACHE_SIZE];
+};
+
+/* a 2D field (wind, current) frozen at one date: the records around the date and the
+   coverage of the sources are looked up once by DataManager::init_sampler, then sample()
+   only interpolates. Results are the ones of DataManager::getInterpolatedValue_2D for the
+   same date */
+class GribSampler
+{
+    public:
+        GribSampler();
+        void clear(void);
+
+        bool isValid(void) const {return valid;}
+        time_t get_date(void) const {return date;}
+
+        bool sample(const double &d_long, const double &d_lat, double * u, double * v,
+                    GribSamplerCache * cache=NULL) const;
+        int sample(const double * d_long, const double * d_lat, const int &count,
+                   double * u, double * v, bool * ok) const;
+
+    private:
+        friend class DataManager;
+        struct source
+        {
+            time_t t1,t2;
+            GribRecord * recU1;
+            GribRecord * recV1;
+            GribRecord * recU2;
+            GribRecord * recV2;
+        };
+
+        bool valid;
+        time_t date;
+        int interpolationType;
+        bool forced;
+        double forcedU,forcedV;
+        int nbSources;
+        source sources[GRIB_SAMPLER_MAX_SOURCES];
+
+        /* the sources to try, in order, for a set of cells (see DataManager::get_coverage).
+           coverageCells, shared with the DataManager, gives the set of each 1 degree cell */
+        struct chain
+        {
+            int nb;
+            int src[GRIB_SAMPLER_MAX_SOURCES];
+        };
+        QVector<quint16> coverageCells;
+        QVector<chain> chains;
+        const chain * get_chain(const double &d_long, const double &d_lat) const;
+
+        bool sampleSource(const source &src, const double &d_long, const double &d_lat,
+                          double * u, double * v, GribSamplerCache * cache) const;
+        static bool getCorners(GribRecord * rec, const double &d_long, const double &d_lat,
+                               double * a00, double * a01, double * a10, double * a11,
+                               GribSamplerCache * cache);
+};
+
+#endif // GRIBSAMPLER_H
@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 
 #include <QDebug>
+#include <QFile>
 #include <map>
 
 
@@ -147,8 +148,7 @@ bool GribV1::loadFile(QString fileName) {
 
     /* clean data structure + iso lines */
     clean_all_vectors();
-    Util::cleanListPointers(listIsobars);
-    Util::cleanListPointers(listIsotherms0);
+    clear_isos();
 
     if(!readAllGribRecords(fname.c_str(),compressMode))
         return false;
@@ -172,13 +172,28 @@ bool GribV1::readAllGribRecords(const char * fname,int compressMode) {
 
     fileSize = zu_filesize(fptr);
 
+    /* uncompressed files are decoded straight from a mapping of the file,
+     * the others share one buffer for all their records */
+    GribV1Input input;
+    QFile mappedFile(QString::fromLocal8Bit(fname));
+    if(fptr->type==ZU_COMPRESS_NONE && mappedFile.open(QIODevice::ReadOnly)) {
+        input.mapSize=mappedFile.size();
+        input.map=mappedFile.map(0,input.mapSize);
+        if(!input.map)
+            input.mapSize=0;
+    }
+
     //--------------------------------------------------------
     // Lecture de l'ensemble des GribRecord du fichier
     // et stockage dans les listes appropriees.
     //--------------------------------------------------------
 
     while(true) {
-        rec = new GribV1Record(fptr);
+        set_loadProgress(zu_tell(fptr),fileSize);
+        if(loadCancelled())
+            break;
+
+        rec = new GribV1Record(fptr,&input);
 
         recAdded=false;
 
@@ -222,6 +237,12 @@ bool GribV1::readAllGribRecords(const char * fname,int compressMode) {
     if(fptr)
         zu_close(fptr);
 
+    if(loadCancelled()) {
+        qWarning() << "GRIBV1 load cancelled";
+        clean_all_vectors();
+        return false;
+    }
+
     qWarning() << "GRIBV1 load finished";
     qWarning() << "NB key: " << mapGribRecords.size();
     qWarning() << "List:";
@@ -39,11 +39,14 @@ GribV1Record::GribV1Record(const GribV1Record &rec)
 {
     *this = rec;
     // recopie les champs de bits
-    if (rec.data != NULL) {
+    this->data = NULL;
+    this->data16 = NULL;
+    this->mappedData = false;
+    if (rec.data != NULL || rec.data16 != NULL) {
         int size = rec.Ni*rec.Nj;
         this->data = new float[size];
         for (int i=0; i<size; i++)
-            this->data[i] = rec.data[i];
+            this->data[i] = rec.valueAt(i);
     }
     if (rec.BMSbits != NULL) {
         int size = rec.sectionSize3-6;
@@ -53,7 +56,7 @@ GribV1Record::GribV1Record(const GribV1Record &rec)
     }
 }
 //-------------------------------------------------------------------------------
-GribV1Record::GribV1Record(ZUFILE* file) : GribRecord()
+GribV1Record::GribV1Record(ZUFILE* file, GribV1Input * input) : GribRecord()
 {
     seekStart = zu_tell(file);
     data    = NULL;
@@ -77,7 +80,13 @@ GribV1Record::GribV1Record(ZUFILE* file) : GribRecord()
         zu_seek(file, fileOffset3+sectionSize3, SEEK_SET);
     }
     if (ok) {
-        ok = readGribSection4_BDS(file);
+        if (input) {
+            ok = readGribSection4_BDS(file, input);
+        }
+        else {
+            GribV1Input localInput;
+            ok = readGribSection4_BDS(file, &localInput);
+        }
         zu_seek(file, fileOffset4+sectionSize4, SEEK_SET);
     }
     if (ok) {
@@ -573,16 +582,18 @@ bool GribV1Record::readGribSection3_BMS(ZUFILE* file) {
     if (!BMSbits) {
         //erreur("Record: out of memory");
         ok = false;
+        return ok;
     }
-    for (zuint i=0; i<sectionSize3-6; i++) {
-        BMSbits[i] = readChar(file);
+    if (zu_read(file, BMSbits, sectionSize3-6) != (int)(sectionSize3-6)) {
+        ok = false;
+        eof = true;
     }
     return ok;
 }
 //----------------------------------------------
 // SECTION 4: BINARY DATA SECTION (BDS)
 //----------------------------------------------
-bool GribV1Record::readGribSection4_BDS(ZUFILE* file) {
+bool GribV1Record::readGribSection4_BDS(ZUFILE* file, GribV1Input * input) {
     fileOffset4  = zu_tell(file);
     sectionSize4 = readInt3(file);  // byte 1-2-3
 
@@ -615,78 +626,102 @@ bool GribV1Record::readGribSection4_BDS(ZUFILE* file) {
         return ok;
     }
 
-    // Allocate memory for the data
-    data = new float[Ni*Nj];
-    if (!data) {
-        //erreur("Record: out of memory");
+    if (nbBitsInPack > 32) {
+        //erreur("Record: too many bits per value");
         ok = false;
+        return ok;
     }
 
-    zuint  startbit  = 0;
-    int  datasize = sectionSize4-11;
-    zuchar *buf = new zuchar[datasize+4];  // +4 pour simplifier les decalages ds readPackedBits
-    if (!buf) {
-        //erreur("Record: out of memory");
+    int nbPoints = Ni*Nj;
+    int datasize = sectionSize4-11;
+    if (datasize < 0) {
         ok = false;
+        return ok;
     }
-    if (zu_read(file, buf, datasize) != datasize) {
-        //erreur("Record: data read error");
+    if (hasBMS && BMSbits && (int)(sectionSize3-6)*8 < nbPoints) {
+        //erreur("Record: bitmap too short");
         ok = false;
-        eof = true;
+        return ok;
     }
-    if (!ok) {
+
+    // Allocate memory for the data
+    data = new float[nbPoints];
+    dataSize = nbPoints;
+    if (!data) {
+        //erreur("Record: out of memory");
+        ok = false;
         return ok;
     }
-    // Initialize the las 4 bytes of buf since we didn't read them
-    buf[datasize+0] = buf[datasize+1] = buf[datasize+2] = buf[datasize+3] = 0;
-
-    // Read data in the order given by isAdjacentI
-    zuint i, j, x;
-    int ind;
-    if (isAdjacentI) {
-        for (j=0; j<Nj; j++) {
-            for (i=0; i<Ni; i++) {
-                if (!hasDiDj && !isScanJpositive) {
-                    ind = (Nj-1 -j)*Ni+i;
-                }
-                else {
-                    ind = j*Ni+i;
-                }
-                if (hasValue(i,j)) {
-                    x = readPackedBits(buf, startbit, nbBitsInPack);
-                    data[ind] = (refValue + x*scaleFactorEpow2)/decimalFactorD;
-                    startbit += nbBitsInPack;
-                }
-                else {
-                    data[ind] = (float) GRIB_NOTDEF;
-                }
-            }
-        }
+
+    // Packed values: straight from the mapping when the file is not
+    // compressed, else read in the buffer shared by all records.
+    // 4 more bytes are always readable for the word-at-a-time unpacker.
+    const zuchar *buf;
+    long pos = zu_tell(file);
+    if (input->map && pos+datasize+4 <= input->mapSize) {
+        buf = input->map + pos;
     }
     else {
-        for (i=0; i<Ni; i++) {
-            for (j=0; j<Nj; j++) {
-                if (!hasDiDj && !isScanJpositive) {
-                    ind = (Nj-1 -j)*Ni+i;
-                }
-                else {
-                    ind = j*Ni+i;
-                }
-                if (hasValue(i,j)) {
-                    x = readPackedBits(buf, startbit, nbBitsInPack);
-                    startbit += nbBitsInPack;
-                    data[ind] = (refValue + x*scaleFactorEpow2)/decimalFactorD;
-                }
-                else {
-                    data[ind] = (float)GRIB_NOTDEF;
-                }
-            }
+        if (input->buffer.size() < datasize+4)
+            input->buffer.resize(datasize+4);
+        zuchar *readBuf = input->buffer.data();
+        if (zu_read(file, readBuf, datasize) != datasize) {
+            //erreur("Record: data read error");
+            ok = false;
+            eof = true;
+            return ok;
+        }
+        readBuf[datasize+0] = readBuf[datasize+1] = readBuf[datasize+2] = readBuf[datasize+3] = 0;
+        buf = readBuf;
+    }
+
+    // Number of packed values = number of points present in the bitmap
+    const zuchar *bms = hasBMS ? BMSbits : NULL;
+    int nbValues = nbPoints;
+    if (bms) {
+        nbValues = 0;
+        for (int b=0; b<nbPoints/8; b++) {
+            for (zuchar c=bms[b]; c; c&=c-1)
+                nbValues++;
+        }
+        for (int b=nbPoints&~7; b<nbPoints; b++) {
+            if (bms[b>>3] & (128>>(b&7)))
+                nbValues++;
         }
     }
-
-    if (buf) {
-        delete [] buf;
-        buf = NULL;
+    if (input->values.size() < nbValues)
+        input->values.resize(nbValues);
+    zuint *values = input->values.data();
+    int nbPacked = nbValues;
+    if (nbBitsInPack > 0 && (qint64)nbPacked*nbBitsInPack > (qint64)datasize*8)
+        nbPacked = ((qint64)datasize*8)/nbBitsInPack;
+    unpackBits(buf, nbBitsInPack, nbPacked, values);
+    for (int k=nbPacked; k<nbValues; k++)
+        values[k] = 0;
+
+    // Expand the bitmap in one pass, in the order given by isAdjacentI
+    bool flipJ = !hasDiDj && !isScanJpositive;
+    int nbLines  = isAdjacentI ? Nj : Ni;
+    int lineSize = isAdjacentI ? Ni : Nj;
+    int bit = 0;
+    for (int l=0; l<nbLines; l++) {
+        int ind, step;
+        if (isAdjacentI) {
+            ind  = (flipJ ? Nj-1-l : l)*Ni;
+            step = 1;
+        }
+        else {
+            ind  = flipJ ? (Nj-1)*Ni+l : l;
+            step = flipJ ? -(int)Ni : (int)Ni;
+        }
+        for (int k=0; k<lineSize; k++, ind+=step, bit++) {
+            if (bms && (bms[bit>>3] & (128>>(bit&7))) == 0) {
+                data[ind] = (float) GRIB_NOTDEF;
+            }
+            else {
+                data[ind] = (refValue + (*values++)*scaleFactorEpow2)/decimalFactorD;
+            }
+        }
     }
     return ok;
 }
@@ -799,6 +834,53 @@ zuint GribV1Record::makeInt2(zuchar b, zuchar c) {
     return ((zuint)b<<8)+(zuint)c;
 }
 //----------------------------------------------
+// Unpack count consecutive big endian integers of nbBits bits.
+// Reads up to 3 bytes past the last packed value.
+//----------------------------------------------
+void GribV1Record::unpackBits(const zuchar *buf, zuint nbBits, int count, zuint *out)
+{
+    int k;
+    switch (nbBits) {
+        case 0:
+            for (k=0; k<count; k++)
+                out[k] = 0;
+            return;
+        case 8:
+            for (k=0; k<count; k++)
+                out[k] = buf[k];
+            return;
+        case 12:
+            for (k=0; k+1<count; k+=2, buf+=3) {
+                out[k]   = ((zuint)buf[0]<<4) | (buf[1]>>4);
+                out[k+1] = ((zuint)(buf[1]&0x0F)<<8) | buf[2];
+            }
+            if (k < count)
+                out[k] = ((zuint)buf[0]<<4) | (buf[1]>>4);
+            return;
+        case 16:
+            for (k=0; k<count; k++)
+                out[k] = ((zuint)buf[2*k]<<8) | buf[2*k+1];
+            return;
+        case 24:
+            for (k=0; k<count; k++)
+                out[k] = ((zuint)buf[3*k]<<16) | ((zuint)buf[3*k+1]<<8) | buf[3*k+2];
+            return;
+    }
+    // other widths: 64 bits accumulator refilled 32 bits at a time
+    quint64 acc = 0;
+    zuint accBits = 0;
+    quint64 mask = (((quint64)1)<<nbBits) - 1;
+    for (k=0; k<count; k++) {
+        if (accBits < nbBits) {
+            acc = (acc<<32) | ((zuint)buf[0]<<24) | ((zuint)buf[1]<<16) | ((zuint)buf[2]<<8) | buf[3];
+            buf += 4;
+            accBits += 32;
+        }
+        accBits -= nbBits;
+        out[k] = (zuint)((acc >> accBits) & mask);
+    }
+}
+//----------------------------------------------
 zuint GribV1Record::readPackedBits(zuchar *buf, zuint first, zuint nbBits)
 {
     zuint oct = first / 8;
@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <iostream>
 #include <cmath>
+#include <QVector>
 
 #include "class_list.h"
 #include "dataDef.h"
@@ -40,11 +41,26 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define zuchar unsigned char
 
 
+//----------------------------------------------
+// Input shared by all the records of a file: the mapping of an
+// uncompressed file, or scratch buffers reused from record to record
+//----------------------------------------------
+class GribV1Input
+{
+    public:
+        GribV1Input() : map(NULL), mapSize(0) {}
+
+        const zuchar *map;          // whole file, NULL for gzip/bzip2
+        qint64 mapSize;
+        QVector<zuchar> buffer;     // packed data of the current record
+        QVector<zuint>  values;     // unpacked integers of the current record
+};
+
 //----------------------------------------------
 class GribV1Record: public GribRecord
 {
     public:
-        GribV1Record(ZUFILE* file);
+        GribV1Record(ZUFILE* file, GribV1Input * input=NULL);
         GribV1Record(const GribV1Record &rec);
 
         ~GribV1Record();
@@ -117,7 +133,7 @@ class GribV1Record: public GribRecord
         bool readGribSection1_PDS(ZUFILE* file);
         bool readGribSection2_GDS(ZUFILE* file);
         bool readGribSection3_BMS(ZUFILE* file);
-        bool readGribSection4_BDS(ZUFILE* file);
+        bool readGribSection4_BDS(ZUFILE* file, GribV1Input * input);
         bool readGribSection5_ES (ZUFILE* file);
 
         //---------------------------------------------
@@ -131,6 +147,7 @@ class GribV1Record: public GribRecord
         double readFloat4(ZUFILE* file);
 
         zuint  readPackedBits(zuchar *buf, zuint first, zuint nbBits);
+        static void unpackBits(const zuchar *buf, zuint nbBits, int count, zuint *out);
         zuint  makeInt3(zuchar a, zuchar b, zuchar c);
         zuint  makeInt2(zuchar b, zuchar c);
 
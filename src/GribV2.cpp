@@ -20,16 +20,32 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 
 #include <QDebug>
+#include <QTime>
+#ifdef QT_V5
+#include <QtConcurrent/QtConcurrentMap>
+#else
+#include <QtConcurrentMap>
+#endif
 
 #include <grib2.h>
+/* from jasper's jpc_t1cod.h, not part of its public headers */
+extern "C" void jpc_initluts(void);
 
 #include "GribV2.h"
 #include "GribV2Record.h"
 #include "IsoLine.h"
 #include "Util.h"
+#include "settings.h"
 
 GribV2::GribV2(DataManager * dataManager): Grib(dataManager) {
     version=2;
+    dataFile=NULL;
+}
+
+GribV2::~GribV2() {
+    /* the records are deleted by ~Grib, they don't read their file anymore */
+    if(dataFile)
+        delete dataFile;
 }
 
 bool GribV2::isGribV2(QString fileName) {
@@ -76,6 +92,9 @@ bool GribV2::loadFile(QString fileName) {
     this->fileName=fileName;
 
     QTime tLoad;
+    QTime tPhase;
+    int m_sec_scan=0;
+    int m_sec_decode=0;
     int m_sec_readCgrib=0;
     int m_sec_ginfo=0;
     int m_sec_g2_getfld=0;
@@ -92,8 +111,6 @@ bool GribV2::loadFile(QString fileName) {
     std::string fname = qPrintable(fileName);
     if(fileName == "") return false;
 
-    gribfield  *gfld=NULL;
-
     ok=false;
 
     fptr=fopen(fname.c_str(),"rb");
@@ -108,79 +125,139 @@ bool GribV2::loadFile(QString fileName) {
 
     /* clean data structure + iso lines */
     clean_all_vectors();
-    Util::cleanListPointers(listIsobars);
-    Util::cleanListPointers(listIsotherms0);
-
-    for(;;) {
-
-        msg++;
-
-        seekgb(fptr,iseek,32000,&lskip,&lgrib);
-        if (lgrib == 0) break;    // end loop at EOF or problem
-
-        cgrib=(unsigned char *)malloc(lgrib);
+    clear_isos();
+
+    /* lazy mode: records are indexed now and decoded when first used (see GribCache) */
+    bool lazy=loadState?loadState->lazy:Settings::getSetting("gribLazyLoad",1).toInt()==1;
+    if(dataFile)
+        delete dataFile;
+    dataFile=lazy?new GribV2DataFile(fileName):NULL;
+
+    /* rdieee sets up its constants on first call and jpc_initluts fills the jpeg2000
+       tables: do both here rather than in a race between workers */
+    g2int ieee=0;
+    g2float ieeeValue;
+    rdieee(&ieee,&ieeeValue,1);
+    jpc_initluts();
+
+    /* the file is read by batches of about GRIB2_BATCH_SIZE bytes of msgs, so that
+       only one batch of raw msgs is in memory at a time */
+    QList<unsigned char *> buffers;
+    QVector<GribV2Field> fields;
+    int nbFields=0;
+    qint64 batchStart=0;
+    bool eof=false;
+    while(!eof && !loadCancelled()) {
+        /* phase 1: serial scan of the msgs, only the sections 0 and 1 are read */
+        tPhase.start();
+        while(iseek-batchStart<GRIB2_BATCH_SIZE) {
+            set_loadProgress(batchStart+iseek,2*(qint64)fileSize);
+            if(loadCancelled())
+                break;
+
+            msg++;
+
+            seekgb(fptr,iseek,32000,&lskip,&lgrib);
+            if (lgrib == 0) {    // end loop at EOF or problem
+                eof=true;
+                break;
+            }
 
-        fseek(fptr,lskip,SEEK_SET);
-        tLoad.start();
-        fread(cgrib,sizeof(unsigned char),lgrib,fptr);
-        m_sec_readCgrib+=tLoad.elapsed();
-        //qWarning() << "Size of cgrib: " << lgrib << ", skip=" << lskip;
-        //qWarning() << "Bytes read from file: " << bRead;
-        //qWarning() << "EOF=" << feof(fptr) << ", ferror=" << ferror(fptr);
-        //qWarning() << "File pos=" << ftell(fptr);
-        //qWarning() << "End of grib=" << cgrib[lgrib-4] << cgrib[lgrib-3] << cgrib[lgrib-2] << cgrib[lgrib-1];
+            cgrib=(unsigned char *)malloc(lgrib);
 
-        iseek=lskip+lgrib;
+            fseek(fptr,lskip,SEEK_SET);
+            tLoad.start();
+            fread(cgrib,sizeof(unsigned char),lgrib,fptr);
+            m_sec_readCgrib+=tLoad.elapsed();
 
-        tLoad.start();
-        ierr=g2_info(cgrib,listsec0,listsec1,&numfields,&numlocal);
-        m_sec_ginfo+=tLoad.elapsed();
-        if(ierr) {
-            qWarning() << "msg " << msg << ": g2_info error num=" << ierr;
-            fclose(fptr);
-            return false;
-        }
+            iseek=lskip+lgrib;
 
+            tLoad.start();
+            ierr=g2_info(cgrib,listsec0,listsec1,&numfields,&numlocal);
+            m_sec_ginfo+=tLoad.elapsed();
+            if(ierr) {
+                qWarning() << "msg " << msg << ": g2_info error num=" << ierr;
+                free(cgrib);
+                for(int i=0;i<buffers.size();++i)
+                    free(buffers.at(i));
+                fclose(fptr);
+                clean_all_vectors();
+                return false;
+            }
 
+            // accepting only GRIB2 with discipline=0 => Meteorological product (table 0.0)
+            if(listsec0[1]!=2 || (listsec0[0]!=0 && listsec0[0]!=10)) {
+                qWarning() << "msg " << msg << ": wrong version " << listsec0[1] << ", or discipline: " << listsec0[0];
+                free(cgrib);
+                continue;
+            }
 
-        // accepting only GRIB2 with discipline=0 => Meteorological product (table 0.0)
-        if(listsec0[1]!=2 || (listsec0[0]!=0 && listsec0[0]!=10)) {
-            qWarning() << "msg " << msg << ": wrong version " << listsec0[1] << ", or discipline: " << listsec0[0];
-            continue;
-        }
+            if(listsec1[4]!=1) {
+                qWarning() << "msg " << msg << ": wrong reference time type: " << listsec1[4];
+                free(cgrib);
+                continue;
+            }
 
-        if(listsec1[4]!=1) {
-            qWarning() << "msg " << msg << ": wrong reference time type: " << listsec1[4];
-            continue;
+            /* 1 field = 1 GribRecord */
+            buffers.append(cgrib);
+            for(int i=0;i<numfields;++i) {
+                GribV2Field field;
+                field.cgrib=cgrib;
+                field.msg=msg;
+                field.field=i;
+                field.record=NULL;
+                field.m_sec_g2_getfld=0;
+                field.m_sec_grecConst=0;
+                field.lazy=lazy;
+                field.pack=packData;
+                field.state=loadState;
+                field.kb=i==0?(int)((lskip+lgrib)>>10)-(int)(lskip>>10):0;
+                field.location.file=dataFile;
+                field.location.offset=lskip;
+                field.location.size=lgrib;
+                field.location.msg=msg;
+                field.location.field=i;
+                fields.append(field);
+            }
         }
+        m_sec_scan+=tPhase.elapsed();
+        /* scanned bytes are counted once, the decoding adds them a second time */
+        set_loadProgress(batchStart+iseek,2*(qint64)fileSize);
 
-        /* loop on th fields => 1 field = 1 GribRecord */
-        //qWarning() << "nb fields=" << numfields << ", nb locals=" << numlocal;
+        /* phase 2: unpacking (jpeg2000, complex packing...) is where the time goes, fields are independent */
+        tPhase.start();
+        if(!loadCancelled())
+            QtConcurrent::blockingMap(fields,GribV2::decodeField);
+        m_sec_decode+=tPhase.elapsed();
 
-        for(int i=0;i<numfields;++i) {
-            tLoad.start();
-            ierr=g2_getfld(cgrib,i+1,GRB2_UNPACK,GRB2_EXPAND,&gfld);
-            m_sec_g2_getfld+=tLoad.elapsed();
-            if(ierr) {
-                qWarning() << "msg=" << msg << "- field=" << i << ": g2_getfld error num=" << ierr;
-                continue;
-            }
-            tLoad.start();
-            GribV2Record * record = new GribV2Record(gfld,msg,i);
-            m_sec_grecConst+=tLoad.elapsed();
-            tLoad.start();
-            if(record && record->isOk() && record->isDataKnown())
+        /* records are added in file order, so that duplicates resolve as they did with a serial load */
+        tLoad.start();
+        for(int i=0;i<fields.size();++i) {
+            GribV2Record * record=fields.at(i).record;
+            m_sec_g2_getfld+=fields.at(i).m_sec_g2_getfld;
+            m_sec_grecConst+=fields.at(i).m_sec_grecConst;
+            if(record && record->isOk() && record->isDataKnown() && !loadCancelled())
                 addRecord(record);
             else
                 if(record) delete record;
-            g2_free(gfld);
-            m_sec_endLoop+=tLoad.elapsed();
         }
-        free(cgrib);
+        nbFields+=fields.size();
+        fields.clear();
+        for(int i=0;i<buffers.size();++i)
+            free(buffers.at(i));
+        buffers.clear();
+        batchStart=iseek;
+        m_sec_endLoop+=tLoad.elapsed();
     }
 
     if(fptr) fclose(fptr);
 
+    if(loadCancelled()) {
+        qWarning() << "GRIBV2 load cancelled";
+        clean_all_vectors();
+        return false;
+    }
+
     qWarning() << "GRIBV2 load finished";
     qWarning() << "NB key: " << mapGribRecords.size();
     qWarning() << "List:";
@@ -192,10 +269,12 @@ bool GribV2::loadFile(QString fileName) {
     }
 
     qWarning() << "Time stat:";
-    qWarning() << "\t read Cgrib: " << m_sec_readCgrib;
-    qWarning() << "\t call gInfo: " << m_sec_ginfo;
-    qWarning() << "\t call getFld: " << m_sec_g2_getfld;
-    qWarning() << "\t const GribRecordV2: " << m_sec_grecConst;
+    qWarning() << "\t scan (phase 1): " << m_sec_scan;
+    qWarning() << "\t\t read Cgrib: " << m_sec_readCgrib;
+    qWarning() << "\t\t call gInfo: " << m_sec_ginfo;
+    qWarning() << "\t decode (phase 2, " << nbFields << (lazy?" fields, index only): ":" fields): ") << m_sec_decode;
+    qWarning() << "\t\t call getFld (sum over threads): " << m_sec_g2_getfld;
+    qWarning() << "\t\t const GribRecordV2 (sum over threads): " << m_sec_grecConst;
     qWarning() << "\t End loop: " << m_sec_endLoop;
 
     createDewPointData();
@@ -204,6 +283,32 @@ bool GribV2::loadFile(QString fileName) {
     return true;
 }
 
+void GribV2::decodeField(GribV2Field &field) {
+    QTime tLoad;
+    gribfield  *gfld=NULL;
+    if(field.state && field.state->cancelled.fetchAndAddRelaxed(0))
+        return;
+    tLoad.start();
+    g2int ierr;
+    if(field.lazy)
+        ierr=g2_getfld(field.cgrib,field.field+1,0,0,&gfld);
+    else
+        ierr=g2_getfld(field.cgrib,field.field+1,GRB2_UNPACK,GRB2_EXPAND,&gfld);
+    field.m_sec_g2_getfld=tLoad.elapsed();
+    if(ierr) {
+        qWarning() << "msg=" << field.msg << "- field=" << field.field << ": g2_getfld error num=" << ierr;
+        return;
+    }
+    tLoad.start();
+    field.record = new GribV2Record(gfld,field.msg,field.field,field.lazy?&field.location:NULL);
+    if(field.lazy)
+        field.record->set_packOnLoad(field.pack);
+    field.m_sec_grecConst=tLoad.elapsed();
+    g2_free(gfld);
+    if(field.state)
+        field.state->kbDone.fetchAndAddRelaxed(field.kb);
+}
+
 /*
 GrbType GribV2::dataToGrb(int data) {
     GrbType res;
@@ -26,10 +26,28 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "dataDef.h"
 #include "class_list.h"
 #include "Grib.h"
+#include "GribV2Record.h"
 
 /* switch 1/0 for g2_getfld */
 #define GRB2_UNPACK 1
 #define GRB2_EXPAND 1
+#define GRIB2_BATCH_SIZE (64<<20) /* bytes of raw msgs held at once while loading */
+
+/* one field of the file: located by the serial scan, decoded by a worker thread */
+struct GribV2Field
+{
+    unsigned char * cgrib; // msg buffer, shared by the fields of the msg
+    int msg;
+    int field;
+    bool lazy;             // only index the field, its data is read on first access
+    bool pack;             // lazy field: packed when read (see GribRecord::packData)
+    GribV2Location location;
+    GribV2Record * record;
+    GribLoadState * state; // progress and cancellation, NULL out of a GribLoader
+    int kb;                // share of the file counted in the progress once decoded
+    int m_sec_g2_getfld;
+    int m_sec_grecConst;
+};
 
 /*struct GrbType {
     int cat;
@@ -41,11 +59,16 @@ class GribV2: public Grib
 {
     public:
         GribV2(DataManager *dataManager);
+        ~GribV2();
 
         virtual bool loadFile(QString fileName);
 
         static bool isGribV2(QString fileName);
 
+    private:
+        static void decodeField(GribV2Field &field);
+        GribV2DataFile * dataFile;   // data of the lazy records
+
 };
 
 #endif // GRIBV2_H
@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <grib2.h>
 
 #include "GribV2Record.h"
+#include "GribV2.h"
 
 QMap<grb2DataType,int> GRBV2_TO_DATA;
 grb2DataType DATA_TO_GRBV2[256];
@@ -31,18 +32,30 @@ int DATA_TO_GRBV2_LV[256];
 
 GribV2Record::GribV2Record(GribV2Record &rec)
 {
+    rec.ensureData();
     *this = rec;
+    /* the copy is a plain in-memory record */
+    dataReady.fetchAndStoreRelaxed(1);
+    inCache=false;
+    packOnLoad=false;
+    data16=NULL;
+    mappedData=false;
     data=new float[dataSize];
     for(int i=0;i<dataSize;++i)
         data[i]=rec.get_data(i);
-    bmap=new bool[bmapSize];
-    for(int i=0;i<bmapSize;++i)
-        bmap[i]=rec.get_bmap(i);
+    if(rec.bmap) {
+        bmap=new bool[bmapSize];
+        for(int i=0;i<bmapSize;++i)
+            bmap[i]=rec.get_bmap(i);
+    }
+    else
+        bmap=NULL;
 }
 
-GribV2Record::GribV2Record(gribfield  *gfld, int msg, int field):GribRecord() {
+GribV2Record::GribV2Record(gribfield  *gfld, int msg, int field, const GribV2Location * location):GribRecord() {
     data=NULL;
     bmap=NULL;
+    bmapApplies=false;
     ok=false;
     knownData=false;
     dataSize=0;
@@ -224,15 +237,51 @@ GribV2Record::GribV2Record(gribfield  *gfld, int msg, int field):GribRecord() {
 
     // REM nothing to do with ref value / scale factor as it is already done by lib
 
+    if(location) {
+        /* indexed only: section 6 and 7 are read on first access (loadData) */
+        this->location=*location;
+        bmapApplies=gfld->ibmap==0 || gfld->ibmap==254;
+        if(!bmapApplies && gfld->ibmap!=255) {
+            qWarning() << "Msg " << msg << " - field " << field << ": unsupported bmap indicator: " << gfld->ibmap;
+            return;
+        }
+        dataSize=gfld->ngrdpts;
+        bmapSize=bmapApplies?gfld->ngrdpts:0;
+        ok=true;
+        dataReady.fetchAndStoreRelaxed(0);
+    }
+    else {
+        ok=true;
+        if(!readData(gfld,msg,field)) {
+            ok=false;
+            return;
+        }
+    }
+
+    if(dataType!=DATA_NOTDEF && levelType!=DATA_LV_NOTDEF) {
+        knownData = true;
+        if(dataReady.fetchAndAddRelaxed(0))
+            unitConversion();
+        else
+            translateDataType(); // data is converted by loadData
+    }
+    else
+        knownData = false;
+
+    computeKey();
+}
+
+/* sections 6 and 7 of an unpacked field: bmap and data */
+bool GribV2Record::readData(gribfield  *gfld, int msg, int field) {
     /* check for unpack / expanded */
     if(!gfld->unpacked) {
         qWarning() << "Msg " << msg << " - field " << field << ": bitmap & data not unpacked";
-        return;
+        return false;
     }
 
     if(!gfld->expanded) {
         qWarning() << "Msg " << msg << " - field " << field << ": data not expanded";
-        return;
+        return false;
     }
 
     /**********************
@@ -244,12 +293,13 @@ GribV2Record::GribV2Record(gribfield  *gfld, int msg, int field):GribRecord() {
             qWarning() << "Msg " << msg << " - field " << field
                      << ": empty bmap array (size=" << gfld->ndpts << ")"
                      << ", while in bmap mode: " << gfld->ibmap;
-            return;
+            return false;
         }
+        bmapApplies=true;
         bmap=new bool[gfld->ngrdpts];
         if(!bmap) {
             qWarning() << "Msg " << msg << " - field " << field << ": unable to allocate mem for data array (size=" << gfld->ngrdpts << ")";
-            return;
+            return false;
         }
         bmapSize=gfld->ngrdpts;
         for(int i=0;i<gfld->ngrdpts;++i)
@@ -261,7 +311,7 @@ GribV2Record::GribV2Record(gribfield  *gfld, int msg, int field):GribRecord() {
             bmap=NULL;
         else {
             qWarning() << "Msg " << msg << " - field " << field << ": unsupported bmap indicator: " << gfld->ibmap;
-            return;
+            return false;
         }
     }
 
@@ -271,7 +321,7 @@ GribV2Record::GribV2Record(gribfield  *gfld, int msg, int field):GribRecord() {
 #if 0
     if(gfld->ndpts<=0) {
         qWarning() << "Msg " << msg << " - field " << field << ": empty data array (size=" << gfld->ndpts << ")";
-        return;
+        return false;
     }
 #endif
 
@@ -282,11 +332,9 @@ GribV2Record::GribV2Record(gribfield  *gfld, int msg, int field):GribRecord() {
 #endif
     if(!data) {
         qWarning() << "Msg " << msg << " - field " << field << ": unable to allocate mem for data array (size=" << gfld->ndpts << ")";
-        return;
+        return false;
     }
 
-    ok=true;
-
 #if 0
     qWarning() << "ndpts=" << gfld->ndpts << ", ngrdpts=" << gfld->ngrdpts << ", Ni*Nj=" << Ni*Nj;
     dataSize=gfld->ndpts;
@@ -339,16 +387,52 @@ GribV2Record::GribV2Record(gribfield  *gfld, int msg, int field):GribRecord() {
         }
 #endif
 
-   // ok=true;
+    return true;
+}
+
+GribV2DataFile::GribV2DataFile(const QString &fileName) {
+    this->fileName=fileName;
+    fptr=NULL;
+}
 
-    if(dataType!=DATA_NOTDEF && levelType!=DATA_LV_NOTDEF) {
-        knownData = true;
-        unitConversion();
+GribV2DataFile::~GribV2DataFile(void) {
+    if(fptr)
+        fclose(fptr);
+}
+
+bool GribV2DataFile::read(const long &offset, const long &size, unsigned char * buffer) {
+    QMutexLocker locker(&mutex);
+    if(!fptr)
+        fptr=fopen(qPrintable(fileName),"rb");
+    return fptr && fseek(fptr,offset,SEEK_SET)==0
+            && (long)fread(buffer,sizeof(unsigned char),size,fptr)==size;
+}
+
+/* called by GribCache::materialize, out of the lock of the cache */
+bool GribV2Record::loadData(void) {
+    bool res=false;
+    if(!location.file)
+        return false;
+    unsigned char * cgrib=(unsigned char *)malloc(location.size);
+    if(cgrib && location.file->read(location.offset,location.size,cgrib)) {
+        gribfield  *gfld=NULL;
+        if(g2_getfld(cgrib,location.field+1,GRB2_UNPACK,GRB2_EXPAND,&gfld)==0) {
+            res=readData(gfld,location.msg,location.field);
+            if(res && knownData)
+                convertData();
+            g2_free(gfld);
+        }
     }
-    else
-        knownData = false;
+    if(cgrib) free(cgrib);
+    return res;
+}
 
-    computeKey();
+void GribV2Record::releaseData(void) {
+    GribRecord::releaseData();
+    if (bmap) {
+        delete [] bmap;
+        bmap = NULL;
+    }
 }
 
 GribV2Record::~GribV2Record(void) {
@@ -22,16 +22,46 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef GRIBV2RECORD_H
 #define GRIBV2RECORD_H
 
+#include <QMutex>
+#include <QString>
+#include <cstdio>
+
 #include "class_list.h"
 #include "dataDef.h"
 #include <grib2.h>
 
 #include "GribRecord.h"
 
+/* file of the lazy records of a GribV2, opened once on first read. The msgs
+   are read under its lock, they are decoded out of it */
+class GribV2DataFile
+{
+    public:
+        GribV2DataFile(const QString &fileName);
+        ~GribV2DataFile(void);
+        bool read(const long &offset, const long &size, unsigned char * buffer);
+
+    private:
+        QString fileName;
+        FILE * fptr;
+        QMutex mutex;
+};
+
+/* where a field is in its file, to read its data later */
+struct GribV2Location
+{
+    GribV2DataFile * file;   // owned by the GribV2
+    long offset;
+    long size;
+    int msg;
+    int field;
+    GribV2Location(void) { file=NULL; offset=size=0; msg=field=0; }
+};
+
 class GribV2Record: public GribRecord
 {
     public:
-        GribV2Record(gribfield  *gfld, int msg, int field);
+        GribV2Record(gribfield  *gfld, int msg, int field, const GribV2Location * location=NULL);
         GribV2Record(GribV2Record &rec);
         ~GribV2Record(void);
 
@@ -40,10 +70,12 @@ class GribV2Record: public GribRecord
         // La valeur est-elle definie (grille a trous) ?
         inline bool   hasValue(int i, int j) const;
 
-        double get_data(int i) { if(ok) return data[i]; else return 0; }
-        bool get_bmap(int i) { if(ok) return bmap[i]; else return 0; }
-
+        double get_data(int i) { ensureData(); if(ok && (data||data16)) return valueAt(i); else return 0; }
+        bool get_bmap(int i) { ensureData(); if(ok && bmap) return bmap[i]; else return 0; }
 
+    protected:
+        bool loadData(void);
+        void releaseData(void);
 
     private:
         int productTemplate;
@@ -54,7 +86,10 @@ class GribV2Record: public GribRecord
         int levelTypeV2;
 
         bool * bmap;
+        bool bmapApplies;
+        GribV2Location location;
 
+        bool readData(gribfield  *gfld, int msg, int field);
         int computeTimeOffset(int type,int val);
 
 };
@@ -62,7 +97,11 @@ class GribV2Record: public GribRecord
 inline bool GribV2Record::hasValue(int i, int j) const {
     if(!ok) return false;
 
-    if(!bmap) return true;
+    if(!bmap) {
+        if(!bmapApplies) return true;
+        ensureData();
+        if(!bmap) return false;
+    }
 
     int bit;
     if (isAdjacentI)  bit = j*Ni + i;
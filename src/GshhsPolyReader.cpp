@@ -17,6 +17,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 
 #include <QDebug>
+#include <QHash>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "GshhsPolyReader.h"
 #include "Projection.h"
@@ -55,24 +59,28 @@ contour tmp_contour; \
 int num_vertices,num_contours; \
 int value; \
 POLY->clear(); \
-fread(&(num_contours), sizeof(int), 1, polyfile); \
+if(fread(&(num_contours), sizeof(int), 1, polyfile)!=1) \
+    return false; \
 for (int c= 0; c < num_contours; ++c) \
 { \
-    fread(&(value), sizeof(int), 1, polyfile); /* discarding hole value */ \
-    fread(&(value), sizeof(int), 1, polyfile); \
+    if(fread(&(value), sizeof(int), 1, polyfile)!=1) /* discarding hole value */ \
+        return false; \
+    if(fread(&(value), sizeof(int), 1, polyfile)!=1) \
+        return false; \
     num_vertices=value; \
     tmp_contour.clear(); \
     for (int v= 0; v < num_vertices; ++v) \
     { \
-        fread(&(X), sizeof(double), 1, polyfile); \
-        fread(&(Y), sizeof(double), 1, polyfile); \
+        if(fread(&(X), sizeof(double), 1, polyfile)!=1 || fread(&(Y), sizeof(double), 1, polyfile)!=1) \
+            return false; \
         tmp_contour.append(QPointF(X*GSHHS_SCL,Y*GSHHS_SCL)); \
     } \
     POLY->append(tmp_contour); \
 } \
 }
 
-void GshhsPolyCell::ReadPolygonFile (FILE *polyfile,
+/* false on a short read (truncated file) */
+bool GshhsPolyCell::ReadPolygonFile (FILE *polyfile,
                         const int &x, const int &y,
                         const int &pas_x, const int &pas_y,
                         contour_list *p1, contour_list *p2, contour_list *p3, contour_list *p4, contour_list *p5)
@@ -82,15 +90,18 @@ void GshhsPolyCell::ReadPolygonFile (FILE *polyfile,
 
     tab_data = (x/pas_x)*(180/pas_y) + (y+90)/pas_y;
     fseek(polyfile, sizeof(PolygonFileHeader) + tab_data*sizeof(int), SEEK_SET);
-    fread(&pos_data, sizeof(int), 1, polyfile);
+    if(fread(&pos_data, sizeof(int), 1, polyfile)!=1)
+        return false;
 
-    fseek(polyfile, pos_data, SEEK_SET);
+    if(fseek(polyfile, pos_data, SEEK_SET)!=0)
+        return false;
 
     READ_POLY(p1)
     READ_POLY(p2)
     READ_POLY(p3)
     READ_POLY(p4)
     READ_POLY(p5)
+    return true;
 }
 
 void  GshhsPolyCell::DrawPolygonFilled(QPainter &pnt, contour_list * p, const double &dx, Projection *proj, const QColor &color)
@@ -189,11 +200,6 @@ void GshhsPolyCell::DrawPolygonContour(QPainter &pnt, contour_list * p, const do
                 proj->map2screenByReference(x1+dx,A,x2+dx,y2, &C, &D);
                 if(qRound(A)!=qRound(C) || qRound(B)!=qRound(D))
                     pnt.drawLine(QPointF(A,B),QPointF(C,D));
-                if(A!=C || B!=D)
-                {
-                    if(proj->isInBounderies(qRound(A),qRound(B)) || proj->isInBounderies(qRound(C),qRound(D)))
-                        coasts.append(QLineF(A,B,C,D));
-                }
             }
         }
 
@@ -209,11 +215,6 @@ void GshhsPolyCell::DrawPolygonContour(QPainter &pnt, contour_list * p, const do
             proj->map2screenByReference(x1+dx, A, x2+dx,y2, &C, &D);
             if(qRound(A)!=qRound(C) || qRound(B)!=qRound(D))
                 pnt.drawLine(QPointF(A,B),QPointF(C,D));
-            if(A!=C || B!=D)
-            {
-                if(proj->isInBounderies(qRound(A),qRound(B)) || proj->isInBounderies(qRound(C),qRound(D)))
-                    coasts.append(QLineF(A,B,C,D));
-            }
         }
     }
 }
@@ -222,7 +223,6 @@ void GshhsPolyCell::DrawPolygonContour(QPainter &pnt, contour_list * p, const do
 
 void GshhsPolyCell::drawSeaBorderLines(QPainter &pnt, const double &dx, Projection *proj)
 {
-    coasts.clear();
     DRAW_POLY_CONTOUR(&poly1)
     DRAW_POLY_CONTOUR(&poly2)
     DRAW_POLY_CONTOUR(&poly3)
@@ -248,7 +248,7 @@ GshhsPolyReader::GshhsPolyReader(std::string Polypath):
         }
     }
     currentQuality = -1;
-    this->abortRequested=false;
+    coastIndex = new GshhsCoastIndex(path);
 }
 
 
@@ -266,6 +266,7 @@ GshhsPolyReader::~GshhsPolyReader()
         }
         if(fpoly)
             fclose(fpoly);
+        delete coastIndex;
 }
 
 //-------------------------------------------------------------------------
@@ -357,8 +358,41 @@ void GshhsPolyReader::readPolygonFileHeader(FILE *polyfile, PolygonFileHeader *h
 }
 
 //-------------------------------------------------------------------------
+GshhsPolyCell * GshhsPolyReader::getCell(const int &cxx, const int &cy, Projection *proj, const bool &load)
+{
+    GshhsPolyCell * cel=allCells[cxx][cy+90];
+    if (cel == NULL && load) {
+        cel = new GshhsPolyCell(fpoly,cxx, cy,proj,&polyHeader);
+        assert(cel);
+        allCells[cxx][cy+90] = cel;
+    }
+    return cel;
+}
+
+void GshhsPolyReader::loadCells(Projection *proj)
+{
+    if (!fpoly)
+        return;
+    int cxmin, cxmax, cymax, cymin;
+    cxmin = (int) floor (proj->getXmin());
+    cxmax = (int) ceil  (proj->getXmax());
+    cymin = (int) floor (proj->getYmin());
+    cymax = (int) ceil  (proj->getYmax());
+    for (int cx=cxmin; cx<cxmax; ++cx) {
+        int cxx = cx;
+        while (cxx < 0)
+            cxx += 360;
+        while (cxx >= 360)
+            cxx -= 360;
+        for (int cy=cymin; cy<cymax; ++cy) {
+            if (cy>=-90 && cy<=89)
+                getCell(cxx,cy,proj,true);
+        }
+    }
+}
+
 void GshhsPolyReader::drawGshhsPolyMapPlain(QPainter &pnt, Projection *proj,
-                    const QColor &seaColor, const QColor &landColor )
+                    const QColor &seaColor, const QColor &landColor, const bool &loadCells )
 {
     if (!fpoly)
         return;
@@ -381,14 +415,9 @@ void GshhsPolyReader::drawGshhsPolyMapPlain(QPainter &pnt, Projection *proj,
         for (cy=cymin; cy<cymax; ++cy) {
             if (cxx>=0 && cxx<=359 && cy>=-90 && cy<=89)
             {
-                if (allCells[cxx][cy+90] == NULL) {
-                    cel = new GshhsPolyCell(fpoly,cxx, cy,proj,&polyHeader);
-                    assert(cel);
-                    allCells[cxx][cy+90] = cel;
-                }
-                else {
-                    cel = allCells[cxx][cy+90];
-                }
+                cel = getCell(cxx,cy,proj,loadCells);
+                if (cel == NULL)
+                    continue;
                 dx = cx-cxx;
                 cel -> drawMapPlain(pnt, dx, proj, seaColor, landColor);
             }
@@ -401,7 +430,6 @@ void GshhsPolyReader::drawGshhsPolyMapSeaBorders( QPainter &pnt, Projection *pro
 {
     if (!fpoly)
         return;
-    this->abortRequested=true;
     int cxmin, cxmax, cymax, cymin;  // cellules visibles
     cxmin = (int) floor (proj->getXmin());
     cxmax = (int) ceil  (proj->getXmax());
@@ -433,5 +461,329 @@ void GshhsPolyReader::drawGshhsPolyMapSeaBorders( QPainter &pnt, Projection *pro
             }
         }
     }
-    this->abortRequested=false;
+}
+
+//========================================================================
+//                GshhsCoastCell
+//========================================================================
+// implementation is based on Graphics Gems III's "Faster Line Segment Intersection"
+static inline bool segmentCrossing(const double &ax, const double &ay, const double &bx, const double &by,
+                                   const double &x1, const double &y1, const double &x2, const double &y2)
+{
+    const double a_x=bx-ax;
+    const double a_y=by-ay;
+    const double b_x=x1-x2;
+    const double b_y=y1-y2;
+    const double c_x=ax-x1;
+    const double c_y=ay-y1;
+
+    const double denominator = a_y * b_x - a_x * b_y;
+    if (denominator == 0)
+        return false;
+
+    const double reciprocal = 1 / denominator;
+    const double na = (b_y * c_x - b_x * c_y) * reciprocal;
+    if (na < INTER_MIN_LIMIT || na > INTER_MAX_LIMIT)
+        return false;
+
+    const double nb = (a_x * c_y - a_y * c_x) * reciprocal;
+    if (nb < INTER_MIN_LIMIT || nb > INTER_MAX_LIMIT)
+        return false;
+
+    return true;
+}
+#ifdef __SSE2__
+/* same test as segmentCrossing, two coast segments at a time */
+static inline bool segmentCrossing2(const double &ax, const double &ay, const double &bx, const double &by,
+                                    const double * x1, const double * y1, const double * x2, const double * y2)
+{
+    const __m128d X1=_mm_loadu_pd(x1);
+    const __m128d Y1=_mm_loadu_pd(y1);
+    const __m128d A_X=_mm_set1_pd(bx-ax);
+    const __m128d A_Y=_mm_set1_pd(by-ay);
+    const __m128d B_X=_mm_sub_pd(X1,_mm_loadu_pd(x2));
+    const __m128d B_Y=_mm_sub_pd(Y1,_mm_loadu_pd(y2));
+    const __m128d C_X=_mm_sub_pd(_mm_set1_pd(ax),X1);
+    const __m128d C_Y=_mm_sub_pd(_mm_set1_pd(ay),Y1);
+
+    const __m128d denominator=_mm_sub_pd(_mm_mul_pd(A_Y,B_X),_mm_mul_pd(A_X,B_Y));
+    const __m128d reciprocal=_mm_div_pd(_mm_set1_pd(1.0),denominator);
+    const __m128d na=_mm_mul_pd(_mm_sub_pd(_mm_mul_pd(B_Y,C_X),_mm_mul_pd(B_X,C_Y)),reciprocal);
+    const __m128d nb=_mm_mul_pd(_mm_sub_pd(_mm_mul_pd(A_X,C_Y),_mm_mul_pd(A_Y,C_X)),reciprocal);
+    const __m128d minLimit=_mm_set1_pd(INTER_MIN_LIMIT);
+    const __m128d maxLimit=_mm_set1_pd(INTER_MAX_LIMIT);
+    __m128d ok=_mm_cmpneq_pd(denominator,_mm_setzero_pd());
+    ok=_mm_and_pd(ok,_mm_cmpge_pd(na,minLimit));
+    ok=_mm_and_pd(ok,_mm_cmple_pd(na,maxLimit));
+    ok=_mm_and_pd(ok,_mm_cmpge_pd(nb,minLimit));
+    ok=_mm_and_pd(ok,_mm_cmple_pd(nb,maxLimit));
+    return _mm_movemask_pd(ok)!=0;
+}
+#endif
+/* bit l of the result is set when leg l (a->b, at most COAST_LEGS of them) crosses the cell's coast */
+quint32 GshhsCoastCell::crossingMask(const double * ax, const double * ay, const double * bx, const double * by, const int &nbLegs) const
+{
+    quint32 mask=0;
+    const quint32 all=nbLegs>=32?0xFFFFFFFFu:((1u<<nbLegs)-1);
+    const int count=x1.size();
+    const double * X1=x1.constData();
+    const double * Y1=y1.constData();
+    const double * X2=x2.constData();
+    const double * Y2=y2.constData();
+    for(int chunk=0;chunk*COAST_CHUNK<count && mask!=all;++chunk)
+    {
+        const double * box=boxes.constData()+4*chunk;
+        const int begin=chunk*COAST_CHUNK;
+        const int end=qMin(count,begin+COAST_CHUNK);
+        for(int l=0;l<nbLegs;++l)
+        {
+            if(mask&(1u<<l)) continue;
+            if(box[0]>qMax(ax[l],bx[l]) || box[2]<qMin(ax[l],bx[l]) ||
+               box[1]>qMax(ay[l],by[l]) || box[3]<qMin(ay[l],by[l]))
+                continue;
+            int s=begin;
+#ifdef __SSE2__
+            for(;s+1<end;s+=2)
+            {
+                if(segmentCrossing2(ax[l],ay[l],bx[l],by[l],X1+s,Y1+s,X2+s,Y2+s))
+                {
+                    mask|=1u<<l;
+                    break;
+                }
+            }
+            if(mask&(1u<<l)) continue;
+#endif
+            for(;s<end;++s)
+            {
+                if(segmentCrossing(ax[l],ay[l],bx[l],by[l],X1[s],Y1[s],X2[s],Y2[s]))
+                {
+                    mask|=1u<<l;
+                    break;
+                }
+            }
+        }
+    }
+    return mask;
+}
+
+//========================================================================
+//                GshhsCoastIndex
+//========================================================================
+GshhsCoastIndex::GshhsCoastIndex(const std::string &path_):
+    path (path_)
+{
+    fpoly = NULL;
+    nextQuality = 0;
+}
+GshhsCoastIndex::~GshhsCoastIndex()
+{
+    for (int i=0; i<360; ++i) {
+        for (int j=0; j<180; ++j) {
+            GshhsCoastCell * cell=cells[i][j].fetchAndAddAcquire(0);
+            if (cell != NULL)
+                delete cell;
+        }
+    }
+    if(fpoly)
+        fclose(fpoly);
+}
+double GshhsCoastIndex::mercatorLat(const double &lat)
+{
+    const double y=qBound(-89.9999,lat,89.9999);
+    return radToDeg(log(tan(degToRad(y)/2.0 + M_PI_4)));
+}
+/* brings a leg into (lon, mercator lat), lon2 unwrapped so that the leg does not go round the world */
+static void prepareLeg(const QLineF &trajectWorld, double * lon1, double * y1, double * lon2, double * y2,
+                       int * cxmin, int * cxmax, int * cymin, int * cymax)
+{
+    *lon1=trajectWorld.x1();
+    *lon2=trajectWorld.x2();
+    if(*lon2-*lon1>180.0)
+        *lon2-=360.0;
+    else if(*lon1-*lon2>180.0)
+        *lon2+=360.0;
+    *y1=GshhsCoastIndex::mercatorLat(trajectWorld.y1());
+    *y2=GshhsCoastIndex::mercatorLat(trajectWorld.y2());
+    *cxmin = (int) floor (qMin(*lon1,*lon2));
+    *cxmax = (int) floor (qMax(*lon1,*lon2));
+    *cymin = qMax(-90,(int) floor (qMin(trajectWorld.y1(),trajectWorld.y2())));
+    *cymax = qMin(89,(int) floor (qMax(trajectWorld.y1(),trajectWorld.y2())));
+}
+static inline int wrapCell(const int &cx)
+{
+    int cxx = cx;
+    while (cxx < 0)
+        cxx += 360;
+    while (cxx >= 360)
+        cxx -= 360;
+    return cxx;
+}
+/* segments are tested in (lon, mercator lat) so that a leg keeps the shape it has on the chart */
+bool GshhsCoastIndex::crossing(const QLineF &trajectWorld) const
+{
+    double lon1,y1,lon2,y2;
+    int cxmin,cxmax,cymin,cymax;
+    prepareLeg(trajectWorld,&lon1,&y1,&lon2,&y2,&cxmin,&cxmax,&cymin,&cymax);
+    for (int cx=cxmin; cx<=cxmax; ++cx)
+    {
+        const int cxx=wrapCell(cx);
+        const double ax=lon1-(cx-cxx);
+        const double bx=lon2-(cx-cxx);
+        for (int cy=cymin; cy<=cymax; ++cy)
+        {
+            const GshhsCoastCell * cell=getCell(cxx,cy);
+            if(cell==NULL || cell->x1.isEmpty()) continue;
+            if(cell->crossingMask(&ax,&y1,&bx,&y2,1))
+                return true;
+        }
+    }
+    return false;
+}
+/* batched version: legs are grouped by cell and each cell is scanned once per COAST_LEGS legs */
+void GshhsCoastIndex::crossing(const QList<QLineF> &trajectsWorld, QBitArray * hits) const
+{
+    const int nbLegs=trajectsWorld.size();
+    hits->fill(false,nbLegs);
+    QVector<double> lon1(nbLegs),y1(nbLegs),lon2(nbLegs),y2(nbLegs);
+    QHash<qint64,QVector<int> > byCell;
+    for(int l=0;l<nbLegs;++l)
+    {
+        int cxmin,cxmax,cymin,cymax;
+        prepareLeg(trajectsWorld.at(l),&lon1[l],&y1[l],&lon2[l],&y2[l],&cxmin,&cxmax,&cymin,&cymax);
+        for (int cx=cxmin; cx<=cxmax; ++cx)
+            for (int cy=cymin; cy<=cymax; ++cy)
+                byCell[(qint64)cx*1000+(cy+90)].append(l);
+    }
+    double ax[COAST_LEGS],ay[COAST_LEGS],bx[COAST_LEGS],by[COAST_LEGS];
+    int legs[COAST_LEGS];
+    QHash<qint64,QVector<int> >::const_iterator it;
+    for(it=byCell.constBegin();it!=byCell.constEnd();++it)
+    {
+        const int cx=(int)floor(it.key()/1000.0);
+        const int cy=it.key()-(qint64)cx*1000-90;
+        const int cxx=wrapCell(cx);
+        const GshhsCoastCell * cell=getCell(cxx,cy);
+        if(cell==NULL || cell->x1.isEmpty()) continue;
+        const QVector<int> &cellLegs=it.value();
+        int n=0;
+        for(int i=0;i<=cellLegs.size();++i)
+        {
+            if(i<cellLegs.size())
+            {
+                const int l=cellLegs.at(i);
+                if(hits->testBit(l)) continue;
+                legs[n]=l;
+                ax[n]=lon1.at(l)-(cx-cxx);
+                ay[n]=y1.at(l);
+                bx[n]=lon2.at(l)-(cx-cxx);
+                by[n]=y2.at(l);
+                ++n;
+                if(n<COAST_LEGS) continue;
+            }
+            if(n==0) continue;
+            const quint32 mask=cell->crossingMask(ax,ay,bx,by,n);
+            for(int k=0;k<n;++k)
+            {
+                if(mask&(1u<<k))
+                    hits->setBit(legs[k]);
+            }
+            n=0;
+        }
+    }
+}
+const GshhsCoastCell * GshhsCoastIndex::getCell(const int &cx, const int &cy) const
+{
+    GshhsCoastCell * cell=cells[cx][cy+90].fetchAndAddAcquire(0);
+    if(cell) return cell;
+    QMutexLocker locker(&mutex);
+    cell=cells[cx][cy+90].fetchAndAddAcquire(0);
+    if(cell==NULL)
+    {
+        cell=readCell(cx,cy);
+        cells[cx][cy+90].fetchAndStoreRelease(cell);
+    }
+    return cell;
+}
+/* opens the best poly-*-1.dat left, a file with a short header is skipped.
+   Called with the mutex held */
+bool GshhsCoastIndex::openFile(void) const
+{
+    const char qualities[]="fhilc";
+    while(!fpoly && nextQuality<5)
+    {
+        QString fname=QString().fromStdString(path)+QString().sprintf("poly-%c-1.dat",qualities[nextQuality++]);
+        fpoly = fopen( fname.toStdString().c_str(), "rb");
+        if(!fpoly) continue;
+        fseek(fpoly, 0 , SEEK_SET);
+        if(fread(&header, sizeof(PolygonFileHeader), 1, fpoly)!=1 || header.pasx<=0 || header.pasy<=0)
+        {
+            qWarning()<<"invalid coast file"<<fname;
+            fclose(fpoly);
+            fpoly=NULL;
+        }
+    }
+    return fpoly!=NULL;
+}
+/* called with the mutex held. A truncated file is dropped and the cell read
+   again from the next quality, as are the cells that follow */
+GshhsCoastCell * GshhsCoastIndex::readCell(const int &cx, const int &cy) const
+{
+    GshhsCoastCell * cell=new GshhsCoastCell;
+    contour_list polys[5];
+    while(openFile())
+    {
+        if(GshhsPolyCell::ReadPolygonFile(fpoly,cx,cy,header.pasx,header.pasy,&polys[0],&polys[1],&polys[2],&polys[3],&polys[4]))
+            break;
+        qWarning()<<"truncated coast file, reading cell"<<cx<<cy<<"from a lower quality";
+        fclose(fpoly);
+        fpoly=NULL;
+        for(int l=0;l<5;++l)
+            polys[l].clear();
+    }
+    if(!fpoly) return cell;
+    const double long_min=(double)cx;
+    const double lat_min=(double)cy;
+    const double long_max=((double)cx+(double)header.pasx);
+    const double lat_max=((double)cy+(double)header.pasy);
+    for(int l=0;l<5;++l)
+    {
+        const contour_list &p=polys[l];
+        for (int i= 0; i < p.count(); ++i)
+        {
+            const contour &c=p.at(i);
+            for (int v= 0; v < c.count(); ++v)
+            {
+                const double xa=c.at(v).x();
+                const double ya=c.at(v).y();
+                const double xb=c.at((v+1)%c.count()).x();
+                const double yb=c.at((v+1)%c.count()).y();
+                /* cell borders are not coasts, same rule as DrawPolygonContour */
+                if (((xa==xb) && ((xa==long_min) || (xa==long_max))) || ((ya==yb) && ((ya==lat_min) || (ya==lat_max))))
+                    continue;
+                if(xa==xb && ya==yb)
+                    continue;
+                cell->x1.append(xa);
+                cell->y1.append(mercatorLat(ya));
+                cell->x2.append(xb);
+                cell->y2.append(mercatorLat(yb));
+            }
+        }
+    }
+    const int count=cell->x1.size();
+    for(int chunk=0;chunk*COAST_CHUNK<count;++chunk)
+    {
+        double xmin=10e6,ymin=10e6,xmax=-10e6,ymax=-10e6;
+        for(int s=chunk*COAST_CHUNK;s<qMin(count,(chunk+1)*COAST_CHUNK);++s)
+        {
+            xmin=qMin(xmin,qMin(cell->x1.at(s),cell->x2.at(s)));
+            xmax=qMax(xmax,qMax(cell->x1.at(s),cell->x2.at(s)));
+            ymin=qMin(ymin,qMin(cell->y1.at(s),cell->y2.at(s)));
+            ymax=qMax(ymax,qMax(cell->y1.at(s),cell->y2.at(s)));
+        }
+        cell->boxes.append(xmin);
+        cell->boxes.append(ymin);
+        cell->boxes.append(xmax);
+        cell->boxes.append(ymax);
+    }
+    return cell;
 }
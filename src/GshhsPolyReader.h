@@ -25,6 +25,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QImage>
 #include <QPainter>
+#include <QVector>
+#include <QBitArray>
+#include <QMutex>
+#include <QAtomicPointer>
 
 #include "class_list.h"
 
@@ -55,6 +59,42 @@ Q_DECLARE_TYPEINFO(PolygonFileHeader,Q_PRIMITIVE_TYPE);
 typedef QList<QPointF> contour;
 typedef QList<contour> contour_list;
 
+#define COAST_CHUNK 32
+#define COAST_LEGS  32 /* legs per crossingMask call, one bit each */
+
+/* coast segments of one cell, packed by columns in (longitude, mercator latitude)
+   degrees and grouped by COAST_CHUNK under a bounding box */
+struct GshhsCoastCell
+{
+    QVector<double> x1,y1,x2,y2;
+    QVector<double> boxes; /* xmin,ymin,xmax,ymax per chunk */
+    quint32 crossingMask(const double * ax, const double * ay, const double * bx, const double * by, const int &nbLegs) const;
+};
+
+/* projection independent coastline used for collision checks (routing, routes,
+   compass...). Cells are read lazily from the best poly-*-1.dat available and
+   then shared read-only between threads: a cell never changes once published,
+   so only its first read takes the mutex */
+class GshhsCoastIndex
+{
+    public:
+        GshhsCoastIndex(const std::string &path);
+        ~GshhsCoastIndex();
+        bool crossing(const QLineF &trajectWorld) const;
+        void crossing(const QList<QLineF> &trajectsWorld, QBitArray * hits) const;
+        static double mercatorLat(const double &lat);
+    private:
+        std::string path;
+        mutable FILE *fpoly;
+        mutable int nextQuality;
+        mutable PolygonFileHeader header;
+        mutable QAtomicPointer<GshhsCoastCell> cells[360][180];
+        mutable QMutex mutex;
+        const GshhsCoastCell * getCell(const int &cx, const int &cy) const;
+        GshhsCoastCell * readCell(const int &cx, const int &cy) const;
+        bool openFile(void) const;
+};
+
 //==========================================================================
 class GshhsPolyCell
 {
@@ -67,26 +107,22 @@ class GshhsPolyCell
                     const QColor &seaColor, const QColor &landColor );
 
         void  drawSeaBorderLines(QPainter &pnt, const double &dx, Projection *proj);
-        const QList<QLineF> * getCoasts() const {return & coasts;}
+        static bool ReadPolygonFile (FILE *polyfile,
+                                const int &x, const int &y,
+                                const int &pas_x, const int &pas_y,
+                                contour_list *p1, contour_list *p2, contour_list *p3, contour_list *p4, contour_list *p5);
     private:
         int nbpoints;
         int x0cell, y0cell;
 
         FILE *fpoly;
 
-        QList<QLineF> coasts;
         Projection *proj;
         PolygonFileHeader *header;
         contour_list poly1,poly2,poly3,poly4,poly5;
 
         void DrawPolygonFilled(QPainter &pnt,contour_list * poly,const double &dx,Projection *proj,const QColor &color);
         void DrawPolygonContour(QPainter &pnt,contour_list * poly, const double &dx, Projection *proj);
-
-        void ReadPolygonFile (FILE *polyfile,
-                                const int &x, const int &y,
-                                const int &pas_x, const int &pas_y,
-                                contour_list *p1, contour_list *p2, contour_list *p3, contour_list *p4, contour_list *p5);
-
 };
 Q_DECLARE_TYPEINFO(GshhsPolyCell,Q_MOVABLE_TYPE);
 
@@ -97,12 +133,16 @@ class GshhsPolyReader
         ~GshhsPolyReader();
 
         void drawGshhsPolyMapPlain( QPainter &pnt, Projection *proj,
-                    const QColor &seaColor, const QColor &landColor );
+                    const QColor &seaColor, const QColor &landColor, const bool &loadCells=true );
+        /* reads the cells seen by proj: drawing with loadCells=false is then
+           safe from worker threads as long as the quality does not change */
+        void loadCells(Projection *proj);
 
         void drawGshhsPolyMapSeaBorders( QPainter &pnt, Projection *proj);
 
         void setQuality(const int &quality); // 5 levels: 0=low ... 4=full
-        bool crossing(const QLineF &traject, const QLineF &trajectWorld) const;
+        bool crossing(const QLineF &trajectWorld) const {return coastIndex->crossing(trajectWorld);}
+        void crossing(const QList<QLineF> &trajectsWorld, QBitArray * hits) const {coastIndex->crossing(trajectsWorld,hits);}
         int currentQuality;
         void setProj(Projection * p){this->proj=p;}
         int  getPolyVersion();
@@ -116,89 +156,12 @@ class GshhsPolyReader
 #if 0
         bool vlm_intersects(QLineF line1,QLineF line2) const;
 #endif
-        bool my_intersects(const QLineF &line1,const QLineF &line2) const;
         void readPolygonFileHeader(FILE *polyfile, PolygonFileHeader *header);
-        bool abortRequested;
+        GshhsPolyCell * getCell(const int &cxx, const int &cy, Projection *proj, const bool &load);
         Projection * proj;
-        QList<QLineF>coasts;
+        GshhsCoastIndex * coastIndex;
 };
 Q_DECLARE_TYPEINFO(GshhsPolyReader,Q_MOVABLE_TYPE);
-inline bool GshhsPolyReader::crossing(const QLineF &traject, const QLineF &trajectWorld) const
-{
-    if(proj==NULL) return false;
-    if(!proj->isInBounderies(traject.p1().x(),traject.p1().y()) &&
-       !proj->isInBounderies(traject.p2().x(),traject.p2().y()))
-        return false;
-    //QPointF dummy;
-    int cxmin, cxmax, cymax, cymin;  // cellules visibles
-    cxmin = (int) floor (qMin(trajectWorld.p1().x(),trajectWorld.p2().x()));
-    cxmax = (int) ceil  (qMax(trajectWorld.p1().x(),trajectWorld.p2().x()));
-    cymin = (int) floor (qMin(trajectWorld.p1().y(),trajectWorld.p2().y()));
-    cymax = (int) ceil  (qMax(trajectWorld.p1().y(),trajectWorld.p2().y()));
-    int cx, cxx, cy;
-    GshhsPolyCell *cel;
-
-    for (cx=cxmin; cx<cxmax; cx++)
-    {
-        cxx = cx;
-        while (cxx < 0)
-            cxx += 360;
-        while (cxx >= 360)
-            cxx -= 360;
-
-        for (cy=cymin; cy<cymax; cy++)
-        {
-            if(this->abortRequested) return false;
-            if (cxx>=0 && cxx<=359 && cy>=-90 && cy<=89)
-            {
-                if(this->abortRequested) return false;
-                if (allCells[cxx][cy+90] == NULL) continue;
-                cel = allCells[cxx][cy+90];
-                const QList<QLineF> *coasts=cel->getCoasts();
-                if (coasts->isEmpty()) continue;
-                for(int cs=0;cs<coasts->count();cs++)
-                {
-#if 1
-                    if(this->abortRequested)
-                    {
-                        return false;
-                    }
-                    if (my_intersects(traject,coasts->at(cs)))
-#else
-                    QPointF dummy;
-                    if(coasts->at(cs).intersect(traject,&dummy)==QLineF::BoundedIntersection)
-#endif
-                        return true;
-                }
-            }
-        }
-    }
-    return false;
-}
-inline bool GshhsPolyReader::my_intersects(const QLineF &line1, const QLineF &line2) const
-{
-
-    // implementation is based on Graphics Gems III's "Faster Line Segment Intersection"
-    const QPointF a = line1.p2() - line1.p1();
-    const QPointF b = line2.p1() - line2.p2();
-    const QPointF c = line1.p1() - line2.p1();
-
-    const qreal denominator = a.y() * b.x() - a.x() * b.y();
-    if (denominator == 0)
-        return false;
-
-    const qreal reciprocal = 1 / denominator;
-    const qreal na = (b.y() * c.x() - b.x() * c.y()) * reciprocal;
-
-    if (na < INTER_MIN_LIMIT || na > INTER_MAX_LIMIT)
-        return false;
-
-    const qreal nb = (a.x() * c.y() - a.y() * c.x()) * reciprocal;
-    if (nb < INTER_MIN_LIMIT || nb > INTER_MAX_LIMIT)
-        return false;
-
-    return true;
-}
 #if 0
 inline bool GshhsPolyReader::vlm_intersects(QLineF line1,QLineF line2) const
 {
@@ -485,6 +485,24 @@ void GshhsReader::drawContinents( QPainter &pnt, Projection *proj,
     gshhsPoly_reader->drawGshhsPolyMapPlain(pnt, proj, seaColor, landColor);
 }
 
+//-----------------------------------------------------------------------
+int GshhsReader::prepareContinents(Projection *view)
+{
+    selectBestQuality(view);
+    return quality;
+}
+
+void GshhsReader::loadContinentCells(Projection *proj)
+{
+    gshhsPoly_reader->loadCells(proj);
+}
+
+void GshhsReader::drawContinentsLoaded( QPainter &pnt, Projection *proj,
+            const QColor &seaColor, const QColor &landColor)
+{
+    gshhsPoly_reader->drawGshhsPolyMapPlain(pnt, proj, seaColor, landColor, false);
+}
+
 //-----------------------------------------------------------------------
 void GshhsReader::drawSeaBorders( QPainter &pnt, Projection *proj)
 {
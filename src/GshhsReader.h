@@ -117,14 +117,24 @@ class GshhsReader
         void drawContinents( QPainter &pnt, Projection *proj,
                 QColor seaColor, QColor landColor);
                 
+        /* continents drawn by tiles (GshhsTileCache): the quality is chosen
+           and the cells are read on the GUI thread, tiles are then drawn
+           from worker threads with drawContinentsLoaded */
+        int  prepareContinents(Projection *view);
+        void loadContinentCells(Projection *proj);
+        void drawContinentsLoaded( QPainter &pnt, Projection *proj,
+                const QColor &seaColor, const QColor &landColor);
+
         void drawSeaBorders( QPainter &pnt, Projection *proj);
         void drawBoundaries( QPainter &pnt, Projection *proj);
         void drawRivers( QPainter &pnt, Projection *proj);
         
         bool gshhsFilesExists(int quality);
         int  getQuality()   {return quality;}
+        const std::string & getPath() const {return fpath;}
 
-        bool crossing(const QLineF &traject, const QLineF &trajectWorld) const;
+        bool crossing(const QLineF &trajectWorld) const;
+        void crossing(const QList<QLineF> &trajectsWorld, QBitArray * hits) const {gshhsPoly_reader->crossing(trajectsWorld,hits);}
         void setProj(Projection * p){this->gshhsPoly_reader->setProj(p);}
         int  getPolyVersion();
         void clearCells(){this->gshhsPoly_reader->clearCells();}
@@ -213,9 +223,9 @@ inline int GshhsPolygon_WDB::readInt2() {
     }
     return ((int)tab[0]<<8)+((int)tab[1]);
 }
-inline bool GshhsReader::crossing(const QLineF &traject, const QLineF &trajectWorld) const
+inline bool GshhsReader::crossing(const QLineF &trajectWorld) const
 {
-    return this->gshhsPoly_reader->crossing(traject, trajectWorld);
+    return this->gshhsPoly_reader->crossing(trajectWorld);
 }
 
 
@@ -0,0 +1,203 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2013 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include <cmath>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QMap>
+#include <QCryptographicHash>
+#ifdef QT_V5
+#include <QtConcurrent/QtConcurrentMap>
+#else
+#include <QtConcurrentMap>
+#endif
+
+#include "GshhsReader.h"
+#include "Projection.h"
+#include "settings.h"
+#include "dataDef.h"
+
+#include "GshhsTileCache.h"
+
+struct gshhsTileJob
+{
+    GshhsTileKey key;
+    int ox,oy;          /* position in the view */
+    Projection * proj;  /* tile sized projection */
+    GshhsReader * reader;
+    QColor seaColor,landColor;
+    QString fileName;   /* empty without disk cache */
+    bool fromDisk;
+    bool written;       /* saved to the disk cache */
+    QImage * img;
+};
+
+static void renderTile(gshhsTileJob &job)
+{
+    job.img=new QImage();
+    if(job.fromDisk)
+    {
+        if(job.img->load(job.fileName,"PNG") && job.img->width()==GSHHS_TILE_SIZE && job.img->height()==GSHHS_TILE_SIZE)
+        {
+            *job.img=job.img->convertToFormat(QImage::Format_ARGB32_Premultiplied);
+            return;
+        }
+        /* the cells of this tile were not read: drop the file, the tile is drawn
+           again once its cells are read (see drawContinents) */
+        QFile::remove(job.fileName);
+        delete job.img;
+        job.img=NULL;
+        return;
+    }
+    *job.img=QImage(GSHHS_TILE_SIZE,GSHHS_TILE_SIZE,QImage::Format_ARGB32_Premultiplied);
+    job.img->fill(Qt::transparent);
+    QPainter pnt(job.img);
+    pnt.setRenderHint(QPainter::Antialiasing, true);
+    pnt.setCompositionMode(QPainter::CompositionMode_Source);
+    job.reader->drawContinentsLoaded(pnt,job.proj,job.seaColor,job.landColor);
+    pnt.end();
+    if(!job.fileName.isEmpty())
+        job.written=job.img->save(job.fileName,"PNG");
+}
+
+GshhsTileCache::GshhsTileCache() {
+    tiles.setMaxCost(Settings::getSetting("gshhsTileCacheSize",64).toInt()*1024);
+    useDiskCache=Settings::getSetting("gshhsTileDiskCache",0).toInt()==1;
+    diskCacheSize=(qint64)Settings::getSetting("gshhsTileDiskCacheSize",256).toInt()*1024*1024;
+    nbWritten=0;
+    mapsReader=NULL;
+    if(useDiskCache)
+        evictDiskCache();
+}
+
+/* removes the least recently used tiles (last read or written) until the
+   folder holds diskCacheSize bytes at most */
+void GshhsTileCache::evictDiskCache(void) {
+    nbWritten=0;
+    QDir dir(appFolder.value("mapsCache"));
+    QFileInfoList files=dir.entryInfoList(QStringList("*.png"),QDir::Files);
+    QMultiMap<QDateTime,QFileInfo> byUse;
+    qint64 total=0;
+    for(int f=0;f<files.count();++f) {
+        const QFileInfo &info=files.at(f);
+        total+=info.size();
+        byUse.insert(qMax(info.lastRead(),info.lastModified()),info);
+    }
+    QMultiMap<QDateTime,QFileInfo>::const_iterator it;
+    for(it=byUse.constBegin();total>diskCacheSize && it!=byUse.constEnd();++it) {
+        if(QFile::remove(it.value().absoluteFilePath()))
+            total-=it.value().size();
+    }
+}
+
+void GshhsTileCache::drawContinents(QPainter &pnt, Projection *proj, GshhsReader *reader,
+                                    const QColor &seaColor, const QColor &landColor) {
+    const int quality=reader->prepareContinents(proj);
+    const double scale=proj->getScale();
+    /* top left corner of the view in global mercator pixels */
+    const double PY=radToDeg(log(tan(degToRad(proj->getCY())/2 + M_PI_4)));
+    const double gx0=scale*proj->getCX()-proj->getW()/2.0;
+    const double gy0=-scale*PY-proj->getH()/2.0;
+    const int tx0=(int)floor(gx0/GSHHS_TILE_SIZE);
+    const int tx1=(int)floor((gx0+proj->getW())/GSHHS_TILE_SIZE);
+    const int ty0=(int)floor(gy0/GSHHS_TILE_SIZE);
+    const int ty1=(int)floor((gy0+proj->getH())/GSHHS_TILE_SIZE);
+
+    /* the disk tiles of other maps (path or update) must not be used */
+    if(useDiskCache && reader!=mapsReader) {
+        mapsReader=reader;
+        QFileInfo maps(QString::fromStdString(reader->getPath())+"poly-c-1.dat");
+        mapsId=maps.absoluteFilePath()+QString().sprintf("_%u",maps.lastModified().toTime_t());
+    }
+
+    QList<gshhsTileJob> jobs;
+    for(int tx=tx0;tx<=tx1;++tx) {
+        for(int ty=ty0;ty<=ty1;++ty) {
+            gshhsTileJob job;
+            job.key.scale=scale;
+            job.key.tx=tx;
+            job.key.ty=ty;
+            job.key.quality=quality;
+            job.key.seaColor=seaColor.rgba();
+            job.key.landColor=landColor.rgba();
+            job.ox=qRound(tx*GSHHS_TILE_SIZE-gx0);
+            job.oy=qRound(ty*GSHHS_TILE_SIZE-gy0);
+            QImage * img=tiles.object(job.key);
+            if(img) {
+                pnt.drawImage(job.ox,job.oy,*img);
+                continue;
+            }
+            const double lon=(tx*GSHHS_TILE_SIZE+GSHHS_TILE_SIZE/2.0)/scale;
+            const double lat=radToDeg(2*atan(exp(degToRad(-(ty*GSHHS_TILE_SIZE+GSHHS_TILE_SIZE/2.0)/scale)))-M_PI_2);
+            job.proj=new Projection(GSHHS_TILE_SIZE,GSHHS_TILE_SIZE,lon,lat);
+            job.proj->setUseTempo(false);
+            job.proj->setScale(scale);
+            job.reader=reader;
+            job.seaColor=seaColor;
+            job.landColor=landColor;
+            job.img=NULL;
+            job.fromDisk=false;
+            job.written=false;
+            if(useDiskCache) {
+                QString name=mapsId+QString().sprintf("_%d_%.9g_%d_%d_%d_%08x_%08x",GSHHS_TILE_VERSION,scale,tx,ty,quality,
+                                                      job.key.seaColor,job.key.landColor);
+                job.fileName=appFolder.value("mapsCache")
+                        +QCryptographicHash::hash(name.toUtf8(),QCryptographicHash::Md5).toHex()+".png";
+                job.fromDisk=QFile::exists(job.fileName);
+            }
+            /* cells are read from the file here, workers only draw them */
+            if(!job.fromDisk)
+                reader->loadContinentCells(job.proj);
+            jobs.append(job);
+        }
+    }
+    if(jobs.isEmpty()) return;
+    QtConcurrent::blockingMap(jobs,renderTile);
+    /* tiles whose file could not be read are drawn now */
+    QList<int> failed;
+    for(int n=0;n<jobs.size();++n) {
+        if(jobs.at(n).img || !jobs.at(n).fromDisk) continue;
+        jobs[n].fromDisk=false;
+        reader->loadContinentCells(jobs.at(n).proj);
+        failed.append(n);
+    }
+    if(!failed.isEmpty()) {
+        QList<gshhsTileJob> retry;
+        for(int f=0;f<failed.size();++f)
+            retry.append(jobs.at(failed.at(f)));
+        QtConcurrent::blockingMap(retry,renderTile);
+        for(int f=0;f<failed.size();++f)
+            jobs[failed.at(f)]=retry.at(f);
+    }
+    for(int n=0;n<jobs.size();++n) {
+        const gshhsTileJob &job=jobs.at(n);
+        delete job.proj;
+        if(job.written) ++nbWritten;
+        if(!job.img) continue;
+        pnt.drawImage(job.ox,job.oy,*job.img);
+        tiles.insert(job.key,job.img,job.img->byteCount()>>10);
+    }
+    /* the folder is listed again only after a few hundred new tiles */
+    if(nbWritten>=256)
+        evictDiskCache();
+}
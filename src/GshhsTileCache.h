@@ -0,0 +1,76 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2013 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef GSHHSTILECACHE_H
+#define GSHHSTILECACHE_H
+
+#include <QCache>
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+
+#include "class_list.h"
+
+#define GSHHS_TILE_SIZE 256
+#define GSHHS_TILE_VERSION 1 /* part of the disk cache names, to be raised when the drawing changes */
+
+/* a land/sea tile: global mercator pixels at a given scale, so that
+   panning at a fixed zoom finds the tiles already drawn */
+struct GshhsTileKey
+{
+    double scale;
+    int tx,ty;
+    int quality;
+    QRgb seaColor,landColor;
+    bool operator==(const GshhsTileKey &k) const {
+        return scale==k.scale && tx==k.tx && ty==k.ty && quality==k.quality
+                && seaColor==k.seaColor && landColor==k.landColor;
+    }
+};
+inline uint qHash(const GshhsTileKey &k)
+{
+    return qHash(qRound64(k.scale*1000.0)) ^ (uint)(k.tx*73856093) ^ (uint)(k.ty*19349663)
+            ^ (uint)(k.quality<<28) ^ k.landColor;
+}
+
+/* continents of Terrain, drawn by tiles: missing tiles are drawn in parallel
+   and kept in a memory LRU (setting gshhsTileCacheSize, MB), and optionally
+   on disk (setting gshhsTileDiskCache). The disk tiles are named after the maps
+   they come from, the least recently used go when maps/cache is over
+   gshhsTileDiskCacheSize MB */
+class GshhsTileCache
+{
+    public:
+        GshhsTileCache();
+        void drawContinents(QPainter &pnt, Projection *proj, GshhsReader *reader,
+                            const QColor &seaColor, const QColor &landColor);
+        void clear(void) {tiles.clear(); mapsReader=NULL;}
+
+    private:
+        QCache<GshhsTileKey,QImage> tiles;
+        bool useDiskCache;
+        qint64 diskCacheSize;
+        int nbWritten;      /* tiles written since the last eviction */
+        GshhsReader * mapsReader;
+        QString mapsId;     /* path and date of the maps of mapsReader */
+        void evictDiskCache(void);
+};
+
+#endif // GSHHSTILECACHE_H
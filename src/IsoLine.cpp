@@ -22,6 +22,14 @@ Copyright (C) 2008 - Jacques Zaninetti - http://zygrib.free.fr
 
 ***********************************************************************/
 
+#include <cstring>
+#include <QThread>
+#ifdef QT_V5
+#include <QtConcurrent/QtConcurrentMap>
+#else
+#include <QtConcurrentMap>
+#endif
+
 #include "IsoLine.h"
 
 #include "GribRecord.h"
@@ -39,17 +47,19 @@ IsoLine::IsoLine(double val, time_t now, time_t tPrev, time_t tNxt,GribRecord *r
     extractIsoLine(now,tPrev,tNxt, rec_prev,rec_nxt);
 //printf("create Isobar : press=%4.0f long=%d\n", pressure/100, trace.size());
 }
+
+IsoLine::IsoLine(double val, int w, int h)
+{
+    value = val;
+    W = w;
+    H = h;
+    int gr = 80;
+    isoLineColor = QColor(gr,gr,gr);
+}
 //---------------------------------------------------------------
 IsoLine::~IsoLine()
 {
 //printf("delete Isobar : press=%4.0f long=%d\n", pressure/100, trace.size());
-
-    std::list<Segment *>::iterator it;
-    for (it=trace.begin(); it!=trace.end(); ++it) {
-        delete *it;
-        *it = NULL;
-    }
-    trace.clear();
 }
 
 
@@ -58,17 +68,15 @@ IsoLine::~IsoLine()
 void IsoLine::drawIsoLine(QPainter &pnt,
                             const Projection *proj)
 {
-    std::list<Segment *>::iterator it;
     int   a,b,c,d;
-    int nb = 0;
 	pnt.setRenderHint(QPainter::Antialiasing, true);
 
     //---------------------------------------------------------
     // Dessine les segments
     //---------------------------------------------------------
-    for (it=trace.begin(); it!=trace.end(); ++it,++nb)
+    for (int nb=0; nb<trace.count(); ++nb)
     {
-        Segment *seg = *it;
+        const Segment *seg = &trace.at(nb);
 
         // Teste la visibilite (bug clipping sous windows avec pen.setWidthF())
         if ( proj->isPointVisible(seg->px1, seg->py1)
@@ -94,7 +102,6 @@ void IsoLine::drawIsoLineLabels(QPainter &pnt, QColor &couleur,
                             const Projection *proj,
                             int density, int first, double coef)
 {
-    std::list<Segment *>::iterator it;
     int   a,b,c,d;
     int nb = first;
     QString label;
@@ -118,10 +125,10 @@ void IsoLine::drawIsoLineLabels(QPainter &pnt, QColor &couleur,
     //---------------------------------------------------------
     // Ecrit les labels
     //---------------------------------------------------------
-    for (it=trace.begin(); it!=trace.end(); ++it,++nb)
+    for (int s=0; s<trace.count(); ++s,++nb)
     {
         if (nb % density == 0) {
-            Segment *seg = *it;
+            const Segment *seg = &trace.at(s);
     		rect = fmet.boundingRect(label);
             proj->map2screen( seg->px1, seg->py1, &a, &b );
             proj->map2screen( seg->px2, seg->py2, &c, &d );
@@ -199,83 +206,169 @@ void Segment::traduitCode(int I, int J, char c1, int &i, int &j) {
     }
 }
 
+//-----------------------------------------------------------------------
+// Determine si 1 ou 2 segments traversent la case ab-cd
+// a  b
+// c  d
+// codes: 4 chars per segment, returns the number of segments
+//---------------------------------------------------------
+int IsoLine::cellSegments(double a, double b, double c, double d, double value, char *codes)
+{
+    const char *res;
+    int nb=1;
+    //--------------------------------
+    // 1 segment en diagonale
+    //--------------------------------
+    if     ((a<=value && b<=value && c<=value  && d>value)
+         || (a>value && b>value && c>value  && d<=value))
+        res="cdbd";
+    else if ((a<=value && c<=value && d<=value  && b>value)
+         || (a>value && c>value && d>value  && b<=value))
+        res="abbd";
+    else if ((c<=value && d<=value && b<=value  && a>value)
+         || (c>value && d>value && b>value  && a<=value))
+        res="abac";
+    else if ((a<=value && b<=value && d<=value  && c>value)
+         || (a>value && b>value && d>value  && c<=value))
+        res="accd";
+    //--------------------------------
+    // 1 segment H ou V
+    //--------------------------------
+    else if ((a<=value && b<=value   &&  c>value && d>value)
+         || (a>value && b>value   &&  c<=value && d<=value))
+        res="acbd";
+    else if ((a<=value && c<=value   &&  b>value && d>value)
+         || (a>value && c>value   &&  b<=value && d<=value))
+        res="abcd";
+    //--------------------------------
+    // 2 segments en diagonale
+    //--------------------------------
+    else if  (a<=value && d<=value   &&  c>value && b>value) {
+        res="abbdaccd";
+        nb=2;
+    }
+    else if  (a>value && d>value   &&  c<=value && b<=value) {
+        res="abacbdcd";
+        nb=2;
+    }
+    else
+        return 0;
+    memcpy(codes,res,4*nb);
+    return nb;
+}
+
 //-----------------------------------------------------------------------
 // Genere la liste des segments.
 // Les coordonnees sont les indices dans la grille du GribRecord
 //---------------------------------------------------------
 void IsoLine::extractIsoLine(time_t now, time_t tPrev, time_t tNxt,GribRecord *rec_prev,GribRecord *rec_nxt)
 {
-    int i, j, W, H;
+    QVector<double> levels;
+    levels.append(value);
+    isoLineBand band;
+    band.j0=1;
+    band.j1=rec_prev->get_Nj();
+    band.levels=&levels;
+    band.now=now;
+    band.tPrev=tPrev;
+    band.tNxt=tNxt;
+    band.rec_prev=rec_prev;
+    band.rec_nxt=rec_nxt;
+    extractBand(band);
+    trace=band.segments.at(0);
+}
+
+/* rows [j0,j1[ of the grid (row 0 only serves as the top of the first cells),
+   the blended corners of a cell are computed once for all the levels */
+void IsoLine::extractBand(isoLineBand &band)
+{
+    const QVector<double> &levels=*band.levels;
+    GribRecord *rec_prev=band.rec_prev;
+    GribRecord *rec_nxt=band.rec_nxt;
+    const bool blend=band.tPrev!=band.tNxt;
+    int W = rec_prev->get_Ni();
     double a,b,c,d,a1,b1,c1,d1;
-//    double x,y;
-    W = rec_prev->get_Ni();
-    H = rec_prev->get_Nj();
+    char codes[8];
+
+    band.segments.resize(levels.count());
 
-    for (j=1; j<H; j++)     // !!!! 1 to end
+    for (int j=band.j0; j<band.j1; j++)
     {
-        for (i=1; i<W; i++)
+        for (int i=1; i<W; i++)
         {
-//            x = rec_prev->getX(i);
-//            y = rec_prev->getY(j);
-
             a = rec_prev->getValue( i-1, j-1 );
             b = rec_prev->getValue( i,   j-1 );
             c = rec_prev->getValue( i-1, j   );
             d = rec_prev->getValue( i,   j   );
 
-            if(tPrev!=tNxt)
+            if(blend)
             {
                 a1 = rec_nxt->getValue( i-1, j-1 );
                 b1 = rec_nxt->getValue( i,   j-1 );
                 c1 = rec_nxt->getValue( i-1, j   );
                 d1 = rec_nxt->getValue( i,   j   );
 
-                a = a + ((a1-a)/((double)(tNxt-tPrev)))*((double)(now-tPrev));
-                b = b + ((b1-b)/((double)(tNxt-tPrev)))*((double)(now-tPrev));
-                c = c + ((c1-c)/((double)(tNxt-tPrev)))*((double)(now-tPrev));
-                d = d + ((d1-d)/((double)(tNxt-tPrev)))*((double)(now-tPrev));
+                a = a + ((a1-a)/((double)(band.tNxt-band.tPrev)))*((double)(band.now-band.tPrev));
+                b = b + ((b1-b)/((double)(band.tNxt-band.tPrev)))*((double)(band.now-band.tPrev));
+                c = c + ((c1-c)/((double)(band.tNxt-band.tPrev)))*((double)(band.now-band.tPrev));
+                d = d + ((d1-d)/((double)(band.tNxt-band.tPrev)))*((double)(band.now-band.tPrev));
             }
 
-            // Determine si 1 ou 2 segments traversent la case ab-cd
-            // a  b
-            // c  d
-            //--------------------------------
-            // 1 segment en diagonale
-            //--------------------------------
-            if     ((a<=value && b<=value && c<=value  && d>value)
-                 || (a>value && b>value && c>value  && d<=value))
-                trace.push_back(new Segment(i,j, 'c','d',  'b','d', now,tPrev,tNxt, rec_prev,rec_nxt,value));
-            else if ((a<=value && c<=value && d<=value  && b>value)
-                 || (a>value && c>value && d>value  && b<=value))
-                trace.push_back(new Segment(i,j, 'a','b',  'b','d', now,tPrev,tNxt, rec_prev,rec_nxt,value));
-            else if ((c<=value && d<=value && b<=value  && a>value)
-                 || (c>value && d>value && b>value  && a<=value))
-                trace.push_back(new Segment(i,j, 'a','b',  'a','c', now,tPrev,tNxt, rec_prev,rec_nxt,value));
-            else if ((a<=value && b<=value && d<=value  && c>value)
-                 || (a>value && b>value && d>value  && c<=value))
-                trace.push_back(new Segment(i,j, 'a','c',  'c','d', now,tPrev,tNxt, rec_prev,rec_nxt,value));
-            //--------------------------------
-            // 1 segment H ou V
-            //--------------------------------
-            else if ((a<=value && b<=value   &&  c>value && d>value)
-                 || (a>value && b>value   &&  c<=value && d<=value))
-                trace.push_back(new Segment(i,j, 'a','c',  'b','d', now,tPrev,tNxt, rec_prev,rec_nxt,value));
-            else if ((a<=value && c<=value   &&  b>value && d>value)
-                 || (a>value && c>value   &&  b<=value && d<=value))
-                trace.push_back(new Segment(i,j, 'a','b',  'c','d', now,tPrev,tNxt, rec_prev,rec_nxt,value));
-            //--------------------------------
-            // 2 segments en diagonale
-            //--------------------------------
-            else if  (a<=value && d<=value   &&  c>value && b>value) {
-                trace.push_back(new Segment(i,j, 'a','b',  'b','d', now,tPrev,tNxt, rec_prev,rec_nxt,value));
-                trace.push_back(new Segment(i,j, 'a','c',  'c','d', now,tPrev,tNxt, rec_prev,rec_nxt,value));
-            }
-            else if  (a>value && d>value   &&  c<=value && b<=value) {
-                trace.push_back(new Segment(i,j, 'a','b',  'a','c', now,tPrev,tNxt, rec_prev,rec_nxt,value));
-                trace.push_back(new Segment(i,j, 'b','d',  'c','d', now,tPrev,tNxt, rec_prev,rec_nxt,value));
+            /* a level crosses the cell only if min<=level<max */
+            double vMin=qMin(qMin(a,b),qMin(c,d));
+            double vMax=qMax(qMax(a,b),qMax(c,d));
+            int l=qLowerBound(levels.constBegin(),levels.constEnd(),vMin)-levels.constBegin();
+            for(;l<levels.count() && levels.at(l)<vMax;++l)
+            {
+                int nb=cellSegments(a,b,c,d,levels.at(l),codes);
+                for(int s=0;s<nb;++s)
+                    band.segments[l].append(Segment(i,j, codes[4*s],codes[4*s+1],  codes[4*s+2],codes[4*s+3],
+                                                    band.now,band.tPrev,band.tNxt, rec_prev,rec_nxt,levels.at(l)));
             }
-
         }
     }
 }
 
+void IsoLine::extractIsoLines(const QVector<double> &levels, time_t now, time_t tPrev, time_t tNxt,
+                              GribRecord *rec_prev, GribRecord *rec_nxt, std::list<IsoLine *> *out)
+{
+    if(!rec_prev || !rec_nxt || !out || levels.isEmpty())
+        return;
+    /* data has to be there before the threads read it */
+    rec_prev->ensureData();
+    rec_nxt->ensureData();
+
+    int W = rec_prev->get_Ni();
+    int H = rec_prev->get_Nj();
+
+    QList<isoLineBand> bands;
+    int nbBands=qBound(1,QThread::idealThreadCount()*4,qMax(1,H-1));
+    int rows=(H-1+nbBands-1)/nbBands;
+    for(int j=1;j<H;j+=rows)
+    {
+        isoLineBand band;
+        band.j0=j;
+        band.j1=qMin(j+rows,H);
+        band.levels=&levels;
+        band.now=now;
+        band.tPrev=tPrev;
+        band.tNxt=tNxt;
+        band.rec_prev=rec_prev;
+        band.rec_nxt=rec_nxt;
+        bands.append(band);
+    }
+    QtConcurrent::blockingMap(bands,IsoLine::extractBand);
+
+    /* bands are joined in row order: same segment order as a serial scan */
+    for(int l=0;l<levels.count();++l)
+    {
+        IsoLine *iso=new IsoLine(levels.at(l),W,H);
+        int nb=0;
+        for(int b=0;b<bands.count();++b)
+            nb+=bands.at(b).segments.at(l).count();
+        iso->trace.reserve(nb);
+        for(int b=0;b<bands.count();++b)
+            iso->trace+=bands.at(b).segments.at(l);
+        out->push_back(iso);
+    }
+}
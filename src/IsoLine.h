@@ -37,6 +37,7 @@ Dessin des donnÃ©es GRIB (avec QT)
 
 #include <QApplication>
 #include <QPainter>
+#include <QVector>
 #include "class_list.h"
 
 #include "Projection.h"
@@ -52,6 +53,7 @@ Dessin des donnÃ©es GRIB (avec QT)
 class Segment
 {
     public:
+        Segment () {}
         Segment (int I, int J,
                 char c1, char c2, char c3, char c4,
                 time_t now, time_t tPrev, time_t tNxt,GribRecord *rec_prev,GribRecord *rec_nxt, double pressure);
@@ -70,6 +72,17 @@ class Segment
 };
 Q_DECLARE_TYPEINFO(Segment,Q_MOVABLE_TYPE);
 
+/* a band of grid rows for IsoLine::extractIsoLines, segments are kept per level */
+struct isoLineBand
+{
+    int j0,j1;
+    const QVector<double> * levels;
+    time_t now,tPrev,tNxt;
+    GribRecord * rec_prev;
+    GribRecord * rec_nxt;
+    QVector<QVector<Segment> > segments;
+};
+
 //===============================================================
 class IsoLine
 {
@@ -83,15 +96,25 @@ class IsoLine
         void drawIsoLineLabels(QPainter &pnt, QColor &couleur, const Projection *proj,
                                 int density, int first, double coef);
 
-        int getNbSegments()     {return (int)trace.size();}
+        int getNbSegments()     {return trace.count();}
+
+        /* all the levels in one pass over the grid, rows are split between threads.
+           levels must be sorted, one IsoLine per level is appended to out */
+        static void extractIsoLines(const QVector<double> &levels, time_t now, time_t tPrev, time_t tNxt,
+                                    GribRecord *rec_prev, GribRecord *rec_nxt, std::list<IsoLine *> *out);
 
     private:
+        IsoLine(double val, int w, int h);
+
         double value;
         int    W, H;     // taille de la grille
         const  GribRecord *rec;
 
         QColor isoLineColor;
-        std::list<Segment *> trace;
+        QVector<Segment> trace;
+
+        static void extractBand(isoLineBand &band);
+        static int cellSegments(double a, double b, double c, double d, double value, char *codes);
 
         void intersectionAreteGrille(int i,int j, int k,int l, double *x, double *y,
                         const GribRecord *rec);
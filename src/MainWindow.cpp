@@ -71,6 +71,7 @@ Copyright (C) 2008 - Jacques Zaninetti - http://zygrib.free.fr
 #include "MapDataDrawer.h"
 #include "DataColors.h"
 #include "DataManager.h"
+#include "Grib.h"
 
 #include "DialogPoiDelete.h"
 #include "DialogPoi.h"
@@ -753,11 +754,17 @@ void MainWindow::closeProgress(void)
             pnt.end();
             //imgAll->save("calib2.jpg");
             delete imgAll;
+            mapDataDrawer->benchmark_screenLookup(proj);
             proj->zoomOnZone(xW,yN, xE,yS);
             proj->blockSignals(false);
             qWarning()<<"result of benchmark: multiThread="<<cal1<<"monoThread="<<cal2;
             Settings::setSetting("gribBench1",cal1);
             Settings::setSetting("gribBench2",cal2);
+            if(Settings::getSetting("gribPackedData",0).toInt()==1) {
+                Grib * grib=dataManager->get_grib(DataManager::GRIB_GRIB);
+                if(grib)
+                    grib->benchmark_packedData();
+            }
 
             /** **/
             dataManager->close_data(DataManager::GRIB_GRIB);
@@ -786,6 +793,8 @@ void MainWindow::closeProgress(void)
         openGribFile(fname, false,true);
         gribFileNameCurrent=fname;
     }
+    if(my_centralWidget->get_dataManager())
+        my_centralWidget->get_dataManager()->load_extraSources();
     slot_updateGribMono();
     my_centralWidget->getTerre()->setColorMapMode(curMode);
     my_centralWidget->updateGribMenu();
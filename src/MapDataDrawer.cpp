@@ -33,10 +33,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DataColors.h"
 #include "DataManager.h"
 #include <QRgb>
+#include <QTime>
 
 #include "MapDataDrawer.h"
 #include "mycentralwidget.h"
-//#define timeStat
 
 MapDataDrawer::MapDataDrawer(myCentralWidget *centralWidget) {
     this->centralWidget=centralWidget;
@@ -91,48 +91,6 @@ void MapDataDrawer::initDataCodes(void) {
  * color getter
  ***************************************************************************/
 
-QRgb  MapDataDrawer::getRainColor(double v, bool smooth) {
-    return DataColors::get_color("rain_mmh",v,smooth);
-}
-
-QRgb  MapDataDrawer::getSnowDepthColor(double v, bool smooth) {
-    return DataColors::get_color("snowdepth_m",v,smooth);
-}
-
-QRgb  MapDataDrawer::getCloudColor(double v, bool smooth) {
-    QRgb rgb;
-    int tr;
-    if (isCloudsColorModeWhite) {
-        rgb = DataColors::get_color("clouds_white_pc",v, smooth);
-        tr = (int)(2.5*v);
-    }
-    else {
-        rgb = DataColors::get_color("clouds_black_pc",v, smooth);
-        tr = mapColorTransp;
-    }
-    return qRgba (qRed(rgb), qGreen(rgb), qBlue(rgb), tr);
-}
-
-QRgb  MapDataDrawer::getDeltaTemperaturesColor(double v, bool smooth) {
-    return DataColors::get_color("deltatemp_celcius",v,smooth);
-}
-
-QRgb  MapDataDrawer::getHumidColor(double v, bool smooth) {
-    return DataColors::get_color("humidrel_pc",v,smooth);
-}
-
-QRgb  MapDataDrawer::getCINColor(double v, bool smooth) {
-    return DataColors::get_color("cin_jkg",v,smooth);
-}
-
-QRgb  MapDataDrawer::getCAPEColor(double v, bool smooth) {
-    return DataColors::get_color("cape_jkg",v,smooth);
-}
-
-QRgb  MapDataDrawer::getTemperatureColor(double v, bool smooth) {
-    return DataColors::get_color("temp_celcius",v,smooth);
-}
-
 QRgb  MapDataDrawer::getPressureColor(double v, bool smooth) {
     // Même échelle colorée que pour le vent
     double x = v/100.0;	// Pa->hPa
@@ -158,512 +116,500 @@ QColor MapDataDrawer::getCurrentColorStatic(const double &v, const bool &smooth)
     return QColor(DataColors::get_color("current_kts",v,smooth));
 }
 
-QRgb MapDataDrawer::getBinaryColor(double v, bool smooth) {
-    return DataColors::get_color("binary",v,smooth);
-}
-
-QRgb MapDataDrawer::getWavesColor(double v, bool smooth) {
-    return DataColors::get_color("waves_m",v,smooth);
-}
-
-QRgb MapDataDrawer::getWavesWhiteCapColor(double v, bool smooth) {
-    return DataColors::get_color("whitecap_prb",v,smooth);
-}
-
 //--------------------------------------------------------------------------
-// Carte de couleurs generique en dimension 1
+// Carte de couleurs generique d'un champ de toutes les sources: les blocs
+// hors de la zone d'une source sont pris dans la suivante
 //--------------------------------------------------------------------------
-void MapDataDrawer::drawColorMapGeneric_1D (
-                QPainter &pnt, const Projection *proj, bool smooth,
-                time_t now,time_t tPrev,time_t tNxt,
-                GribRecord * recPrev,GribRecord * recNxt,
-                QRgb (MapDataDrawer::*function_getColor) (double v, bool smooth)
-        )
+void MapDataDrawer::drawColorMapSources_1D(QPainter &pnt, const Projection *proj, bool smooth,
+                                           int dataType, int levelType, int levelValue,
+                                           const QString &color_name, const double &alphaCoef)
 {
-    if (recPrev == NULL)
-        return;
-    int i, j;
-    double x, y, v, v_2;
-    int W = proj->getW();
-    int H = proj->getH();
-    QRgb   rgb;
-    QImage *image = new QImage(W,H,QImage::Format_ARGB32);
-    image->fill( qRgba(0,0,0,0));
-
-    //qWarning() << "1D";
-
-    for (i=0; i<W-1; i+=2) {
-        for (j=0; j<H-1; j+=2) {
-            proj->screen2map(i,j, &x, &y);
-            if (! recPrev->isXInMap(x))
-                x += 360.0;    // tour complet ?
-            if (recPrev->isPointInMap(x, y)) {
-                v = recPrev->getInterpolatedValue(x, y, MUST_INTERPOLATE_VALUE);
-                if(v != GRIB_NOTDEF && tPrev!=tNxt)
-                {
-                    v_2=recNxt->getInterpolatedValue(x, y, MUST_INTERPOLATE_VALUE);
-                    if(v_2 != GRIB_NOTDEF)
-                        v=v+((v_2-v)/((double)(tNxt-tPrev)))*((double)(now-tPrev));
-                }
-                if (v != GRIB_NOTDEF) {
-                    rgb = (this->*function_getColor) (v, smooth);
-                    image->setPixel(i,  j, rgb);
-                    image->setPixel(i+1,j, rgb);
-                    image->setPixel(i,  j+1, rgb);
-                    image->setPixel(i+1,j+1, rgb);
-                }
-            }
+    const time_t currentDate=dataManager->get_currentDate();
+    QVector<GribRasterField> fields;
+    GribRasterField field;
+    field.dim=1;
+    field.now=currentDate;
+    field.nbRec=1;
+    field.alphaCoef=alphaCoef;
+    field.next=NULL;
+    for(int s=0;;++s)
+    {
+        if(dataManager->get_blendedData1D(dataType,levelType,levelValue,&field.recPrev[0],&s))
+        {
+            field.tPrev[0]=field.tNxt[0]=currentDate;
+            field.recNxt[0]=field.recPrev[0];
         }
+        else if(!dataManager->get_data1D(dataType,levelType,levelValue,currentDate,
+                                         &field.tPrev[0],&field.tNxt[0],&field.recPrev[0],&field.recNxt[0],&s))
+            break;
+        fields.append(field);
     }
+    if(fields.isEmpty())
+        return;
+    for(int k=0;k+1<fields.size();++k)
+        fields[k].next=&fields[k+1];
+    drawColorMapRaster(pnt,proj,smooth,fields[0],color_name,gribMonoCpu);
+}
 
-    pnt.drawImage(0,0,*image);
-    delete image;
+void MapDataDrawer::drawColorMapSources_2D(QPainter &pnt, Projection *proj, const bool &smooth,
+                                           const bool &showArrows, const bool &barbules,
+                                           int dataType1, int dataType2, int levelType, int levelValue,
+                                           const QString &color_name, const bool &UV, int interpolation_mode)
+{
+    const time_t currentDate=dataManager->get_currentDate();
+    if(interpolation_mode==INTERPOLATION_UKN)
+        interpolation_mode=dataManager->get_interpolationMode();
+    QVector<GribRasterField> fields;
+    GribRasterField field;
+    field.dim=2;
+    field.now=currentDate;
+    field.interpolMode=interpolation_mode;
+    field.UV=UV;
+    field.alphaCoef=0;
+    field.next=NULL;
+    for(int s=0;;++s)
+    {
+        if(dataManager->get_blendedData2D(dataType1,dataType2,levelType,levelValue,UV,
+                                          &field.recPrev[0],&field.recPrev[1],&s))
+        {
+            field.tPrev[0]=field.tNxt[0]=currentDate;
+            field.recNxt[0]=field.recNxt[1]=NULL;
+        }
+        else if(!dataManager->get_data2D(dataType1,dataType2,levelType,levelValue,currentDate,
+                                         &field.tPrev[0],&field.tNxt[0],&field.recPrev[0],&field.recPrev[1],
+                                         &field.recNxt[0],&field.recNxt[1],&s))
+            break;
+        fields.append(field);
+    }
+    if(fields.isEmpty())
+        return;
+    for(int k=0;k+1<fields.size();++k)
+        fields[k].next=&fields[k+1];
+    if(drawColorMapRaster(pnt,proj,smooth,fields[0],color_name,gribMonoCpu) && showArrows)
+        drawRasterArrows(pnt,fields[0],barbules);
 }
 
-//--------------------------------------------------------------------------
-// Carte de couleurs du vent
-//--------------------------------------------------------------------------
+/****************************************************************************
+ * Screen to geo lookup
+ ****************************************************************************/
+GribScreenLookup::GribScreenLookup(void) {
+    proj=NULL;
+    W=H=0;
+    xW=yN=scale=0;
+}
 
-bool MapDataDrawer::drawColorMapGeneric_2D_Partial(const GribThreadData &g)
+/* tables are rebuilt only when the view changes */
+void GribScreenLookup::update(const Projection * proj) {
+    if(this->proj==proj && W==proj->getW() && H==proj->getH() && xW==proj->getXmin()
+            && yN==proj->getYmax() && scale==proj->getScale())
+        return;
+    this->proj=proj;
+    W=proj->getW();
+    H=proj->getH();
+    xW=proj->getXmin();
+    yN=proj->getYmax();
+    scale=proj->getScale();
+    lons.resize(W);
+    lats.resize(H);
+    double x,y;
+    for(int i=0;i<W;++i)
     {
-    const Projection * proj=g.proj;
-    const bool showWindArrows=g.showWindArrows;
-    const bool barbules=g.barbules;
-    const time_t now=g.now;
-    const time_t t1=g.t1;
-    const time_t t2=g.t2;
-    GribRecord * recU1=g.recU1;
-    GribRecord * recV1=g.recV1;
-    GribRecord * recU2=g.recU2;
-    GribRecord * recV2=g.recV2;
-    const QPoint from=g.from;
-    const QPoint to=g.to;
-    const bool UV=g.UV;
-    ColorElement * colorElement=g.colorElement;
-    QRect paintZone(from,to);
-    int interpolation_mode=g.interpolMode;
-    int i, j;
-    double u,v,x,y;
-    int W = paintZone.width();
-    int H = paintZone.height();
-    W+=W%2;
-    H+=H%2;
-    int space=1;
-    int offsetX=0,offsetY=0;
-    int W_s=0,H_s=0;
-    QRgb   rgb;
-
-
-    int sz=1;
-    if(showWindArrows)
+        proj->screen2map(i,0,&x,&y);
+        lons[i]=x;
+    }
+    for(int j=0;j<H;++j)
     {
-        if (barbules)
-            space =  g.windBarbuleSpace;
-        else
-            space =  g.windArrowSpace;
-        W+=W%space;
-        H+=H%space;
-        W_s=W/space+2;
-        H_s=H/space+2;
-        sz=(W_s+2)*(H_s+2);
-        offsetX=from.x()%space;
-        offsetY=from.y()%space;
+        proj->screen2map(0,j,&x,&y);
+        lats[j]=y;
     }
-    QVector<double> u_tab(sz,-1.0);
-    QVector<double> v_tab(sz);
-    QVector<bool> y_tab(sz);
+}
 
-    uchar * buffer=new uchar [(W+2)*(H+2)*4];
-    int indice=0;
-    const int W4=(W+2)*4;
+void GribScreenLookup::screen2mapOut(const int &i, const int &j, double *x, double *y) const {
+    proj->screen2map(i,j,x,y);
+}
 
-    for (i=0; i<=W; i+=2)
-    {
-        for (j=0; j<=H; j+=2)
-        {
-            proj->screen2map(i+from.x(),j+from.y(), &x, &y);
-            if(Grib::interpolateValue_2D(x,y,now,t1,t2,recU1,recV1,recU2,recV2,&u,&v,interpolation_mode,UV))
-            {
-                if(showWindArrows && i%space==0 && j%space==0)
-                {
-                    int i_s=i/space;
-                    int j_s=j/space;
-                    indice=i_s*H_s+j_s;
-                    u_tab[indice]=u;
-                    v_tab[indice]=v;
-                    y_tab[indice]=(y<0);
-                }
+void GribGridLookup::init(const GribScreenLookup &screen, const GribRecord * rec, const int &nbCols, const int &nbRows) {
+    i0.resize(nbCols);
+    i1.resize(nbCols);
+    dx.resize(nbCols);
+    okX.resize(nbCols);
+    for(int c=0;c<nbCols;++c)
+        okX[c]=rec->getGridPosX(screen.lons.at(2*c),&i0[c],&i1[c],&dx[c]);
+    j0.resize(nbRows);
+    sigDj.resize(nbRows);
+    dy.resize(nbRows);
+    okY.resize(nbRows);
+    for(int r=0;r<nbRows;++r)
+        okY[r]=rec->getGridPosY(screen.lats.at(2*r),&j0[r],&sigDj[r],&dy[r]);
+}
 
-                rgb=colorElement->get_colorCached(u);
-                const int alpha=qAlpha(rgb);
-                const int red=qRed(rgb);
-                const int green=qGreen(rgb);
-                const int blue=qBlue(rgb);
-                int index=(j*W4)+(i*4);
-                buffer[index+3]=alpha;
-                buffer[index+2]=red;
-                buffer[index+1]=green;
-                buffer[index]=blue;
-                index=(j*W4)+((i+1)*4);
-                buffer[index+3]=alpha;
-                buffer[index+2]=red;
-                buffer[index+1]=green;
-                buffer[index]=blue;
-                index=((j+1)*W4)+(i*4);
-                buffer[index+3]=alpha;
-                buffer[index+2]=red;
-                buffer[index+1]=green;
-                buffer[index]=blue;
-                index=((j+1)*W4)+((i+1)*4);
-                buffer[index+3]=alpha;
-                buffer[index+2]=red;
-                buffer[index+1]=green;
-                buffer[index]=blue;
-            }
-            else
-            {
-                int index=(j*W4)+(i*4);
-                buffer[index+3]=0;
-                buffer[index+2]=0;
-                buffer[index+1]=0;
-                buffer[index]=0;
-                index=(j*W4)+((i+1)*4);
-                buffer[index+3]=0;
-                buffer[index+2]=0;
-                buffer[index+1]=0;
-                buffer[index]=0;
-                index=((j+1)*W4)+(i*4);
-                buffer[index+3]=0;
-                buffer[index+2]=0;
-                buffer[index+1]=0;
-                buffer[index]=0;
-                index=((j+1)*W4)+((i+1)*4);
-                buffer[index+3]=0;
-                buffer[index+2]=0;
-                buffer[index+1]=0;
-                buffer[index]=0;
-            }
+/* per block screen2map and interpolation, as before the lookup tables, against the table
+   paths of the 1-D colour maps, of the 2-D colour map and of the arrows, on the wind of the view */
+void MapDataDrawer::benchmark_screenLookup(const Projection * proj) {
+#ifndef timeStat
+    Q_UNUSED(proj);
+#else
+    GribRecord *recU1,*recV1,*recU2,*recV2;
+    time_t tPrev,tNxt;
+    const time_t now=dataManager->get_currentDate();
+    if(!dataManager->get_data2D(DATA_WIND_VX,DATA_WIND_VY,DATA_LV_ABOV_GND,10,now,
+                                &tPrev,&tNxt,&recU1,&recV1,&recU2,&recV2))
+        return;
+    const int W=proj->getW();
+    const int H=proj->getH();
+    const int nbCols=W/2;
+    const int nbRows=H/2;
+    if(nbCols<=0 || nbRows<=0)
+        return;
+    const int mode=dataManager->get_interpolationMode();
+    QVector<double> refVal(nbCols*nbRows),newVal(nbCols*nbRows);
+    double x,y;
+    QTime timer;
+
+    /* 1-D colour map */
+    timer.start();
+    for(int r=0;r<nbRows;++r)
+        for(int c=0;c<nbCols;++c)
+        {
+            proj->screen2map(2*c,2*r,&x,&y);
+            refVal[r*nbCols+c]=recU1->getInterpolatedValue_OLD(x,y);
         }
+    int tRef1D=timer.elapsed();
+    timer.start();
+    GribScreenLookup lookup;
+    lookup.update(proj);
+    GribGridLookup grid;
+    grid.init(lookup,recU1,nbCols,nbRows);
+    for(int r=0;r<nbRows;++r)
+        for(int c=0;c<nbCols;++c)
+            newVal[r*nbCols+c]=grid.okX.at(c) && grid.okY.at(r)?
+                        recU1->getInterpolatedValueAt(grid.i0.at(c),grid.i1.at(c),grid.dx.at(c),
+                                                      grid.j0.at(r),grid.sigDj.at(r),grid.dy.at(r))
+                      :GRIB_NOTDEF;
+    int tNew1D=timer.elapsed();
+    int nbDiff1D=0;
+    for(int k=0;k<refVal.size();++k)
+        if(refVal.at(k)!=newVal.at(k))
+            ++nbDiff1D;
+
+    /* 2-D colour map: columns of blocks through screen2map, against rows of blocks through the tables */
+    QVector<double> colX(nbRows),colY(nbRows),colU(nbRows),colV(nbRows);
+    QVector<bool> colOk(nbRows);
+    timer.start();
+    for(int c=0;c<nbCols;++c)
+    {
+        for(int r=0;r<nbRows;++r)
+            proj->screen2map(2*c,2*r,&colX[r],&colY[r]);
+        Grib::interpolateValues_2D(colX.constData(),colY.constData(),nbRows,now,tPrev,tNxt,recU1,recV1,recU2,recV2,
+                                   colU.data(),colV.data(),colOk.data(),mode,true);
+        for(int r=0;r<nbRows;++r)
+            refVal[r*nbCols+c]=colOk.at(r)?colU.at(r):GRIB_NOTDEF;
     }
-    if(showWindArrows)
+    int tRef2D=timer.elapsed();
+    QVector<double> rowX(nbCols),rowY(nbCols),rowU(nbCols),rowV(nbCols);
+    QVector<bool> rowOk(nbCols);
+    timer.start();
+    for(int c=0;c<nbCols;++c)
+        rowX[c]=lookup.lons.at(2*c);
+    for(int r=0;r<nbRows;++r)
     {
-        int i,j;
-        if(W%space!=0)
+        rowY.fill(lookup.lats.at(2*r));
+        Grib::interpolateValues_2D(rowX.constData(),rowY.constData(),nbCols,now,tPrev,tNxt,recU1,recV1,recU2,recV2,
+                                   rowU.data(),rowV.data(),rowOk.data(),mode,true);
+        for(int c=0;c<nbCols;++c)
+            newVal[r*nbCols+c]=rowOk.at(c)?rowU.at(c):GRIB_NOTDEF;
+    }
+    int tNew2D=timer.elapsed();
+    double maxDiff2D=0;
+    int nbDiff2D=0;
+    for(int k=0;k<refVal.size();++k)
+    {
+        if((refVal.at(k)==GRIB_NOTDEF)!=(newVal.at(k)==GRIB_NOTDEF))
+            ++nbDiff2D;
+        else if(refVal.at(k)!=GRIB_NOTDEF)
+            maxDiff2D=qMax(maxDiff2D,qAbs(refVal.at(k)-newVal.at(k)));
+    }
+
+    /* arrows: one point at a time, against rows of arrows */
+    const int space=windArrowSpace;
+    const int nbArrows=W/space+1;
+    double u,v,sumRef=0,sumNew=0;
+    timer.start();
+    for(int j=0;j<=H;j+=space)
+        for(int i=0;i<=W;i+=space)
         {
-            i=W+W%space;
-            for (j=0;j<=H+H%space;j+=2)
-            {
-                if(j%space==0)
-                {
-                    proj->screen2map(i+from.x(),j+from.y(), &x, &y);
-                    if(Grib::interpolateValue_2D(x,y,now,t1,t2,recU1,recV1,recU2,recV2,&u,&v,interpolation_mode,UV))
-                    {
-                        int i_s=i/space;
-                        int j_s=j/space;
-                        indice=i_s*H_s+j_s;
-                        u_tab[indice]=u;
-                        v_tab[indice]=v;
-                        y_tab[indice]=(y<0);
-                    }
-                }
-            }
-        }
-        if(H%space!=0)
-        {
-            j=H+H%space;
-            for (i=0;i<=W+W%space;i+=2)
-            {
-                if(i%space==0)
-                {
-                    proj->screen2map(i+from.x(),j+from.y(), &x, &y);
-                    if(Grib::interpolateValue_2D(x,y,now,t1,t2,recU1,recV1,recU2,recV2,&u,&v,interpolation_mode,UV))
-                    {
-                        int i_s=i/space;
-                        int j_s=j/space;
-                        indice=i_s*H_s+j_s;
-                        u_tab[indice]=u;
-                        v_tab[indice]=v;
-                        y_tab[indice]=(y<0);
-                    }
-                }
-            }
+            proj->screen2map(i,j,&x,&y);
+            if(Grib::interpolateValue_2D(x,y,now,tPrev,tNxt,recU1,recV1,recU2,recV2,&u,&v,mode,true))
+                sumRef+=u;
         }
+    int tRefArrows=timer.elapsed();
+    QVector<double> arrowX(nbArrows),arrowY(nbArrows),arrowU(nbArrows),arrowV(nbArrows);
+    QVector<bool> arrowOk(nbArrows);
+    timer.start();
+    for(int j=0;j<=H;j+=space)
+    {
+        for(int c=0;c<nbArrows;++c)
+            lookup.screen2map(c*space,j,&arrowX[c],&arrowY[c]);
+        Grib::interpolateValues_2D(arrowX.constData(),arrowY.constData(),nbArrows,now,tPrev,tNxt,recU1,recV1,recU2,recV2,
+                                   arrowU.data(),arrowV.data(),arrowOk.data(),mode,true);
+        for(int c=0;c<nbArrows;++c)
+            if(arrowOk.at(c))
+                sumNew+=arrowU.at(c);
     }
+    int tNewArrows=timer.elapsed();
 
-//    QImage buf(buffer,W+2,H+2, W4, QImage::Format_ARGB32);
-//    QImage image(W+2,H+2,QImage::Format_ARGB32);
-//    QPainter pnt(&image);
-//    pnt.setRenderHint(QPainter::Antialiasing, true);
-//    pnt.drawImage(0,0,buf); //ugly but only way to delete the buffer later.
-//    delete[] buffer;
-    QImage image(buffer,W+2,H+2, W4, QImage::Format_ARGB32);
-    QPainter pnt(&image);
-    pnt.setRenderHint(QPainter::Antialiasing, true);
-    if(showWindArrows)
+    qWarning() << "screen lookup benchmark:" << nbCols*nbRows << "blocks";
+    qWarning() << "  1-D map:" << tRef1D << "ms ->" << tNew1D << "ms, different blocks:" << nbDiff1D;
+    qWarning() << "  2-D map:" << tRef2D << "ms ->" << tNew2D << "ms, different blocks:" << nbDiff2D << "max diff:" << maxDiff2D;
+    qWarning() << "  arrows:" << tRefArrows << "ms ->" << tNewArrows << "ms, sum diff:" << sumNew-sumRef;
+#endif
+}
+
+//--------------------------------------------------------------------------
+// Moteur des cartes de couleurs: la vue est decoupee en bandes de lignes
+// dessinees en parallele, par blocs de 2x2 pixels.
+// Les positions dans la grille sont calculees une fois par colonne et par
+// ligne (GribGridLookup), les couleurs viennent du cache du ColorElement,
+// charge ici dans le thread de l'interface
+//--------------------------------------------------------------------------
+#define RASTER_BAND_ROWS 16
+bool MapDataDrawer::drawColorMapRaster(QPainter &pnt, const Projection *proj, bool smooth,
+                                       GribRasterField &field, const QString &color_name,
+                                       const bool &monoCpu)
+{
+    const int W = proj->getW();
+    const int H = proj->getH();
+    const int nbCols=W/2;
+    const int nbRows=H/2;
+    if(nbCols<=0 || nbRows<=0) return false;
+    ColorElement * colorElement=DataColors::get_colorElement(color_name);
+    if(!colorElement) return false;
+    if(!colorElement->isCacheLoaded(smooth))
+    {
+        colorElement->clearCache();
+        colorElement->loadCache(smooth);
+    }
+    screenLookup.update(proj);
+    for(GribRasterField * f=&field;f;f=f->next)
     {
-        for (i=0; i<=W_s+2; ++i)
+        f->colorElement=colorElement;
+        f->lookup=&screenLookup;
+        if(f->dim==1)
         {
-            for (j=0; j<=H_s+2; ++j)
+            for(int k=0;k<f->nbRec;++k)
             {
-                indice=i*H_s+j;
-                u=u_tab.at(indice);
-                v=v_tab.at(indice);
-                if(u<0)
-                    continue;
-                if (barbules)
-                    g.mapDataDrawer->drawWindArrowWithBarbs(pnt, (i*space)-offsetX,(j*space)-offsetY, u,v, y_tab.at(indice));
-                else
-                    g.mapDataDrawer->drawWindArrow(pnt, i*space-offsetX,j*space-offsetY, v);
-
+                f->gridPrev[k].init(screenLookup,f->recPrev[k],nbCols,nbRows);
+                if(f->tPrev[k]!=f->tNxt[k])
+                    f->gridNxt[k].init(screenLookup,f->recNxt[k],nbCols,nbRows);
             }
         }
     }
-//    QPen pen;
-//    pen.setWidth(2);
-//    pen.setColor(Qt::black);
-//    pnt.setPen(pen);
-//    pnt.drawRect(image.rect());
-    pnt.end();
-    g.mapDataDrawer->paintImage(&image,g.pntGrib,from);
-    delete[] buffer;
+
+    QImage image(W,H,QImage::Format_ARGB32);
+    image.fill(qRgba(0,0,0,0));
+
+    GribRasterBand band;
+    band.nbCols=nbCols;
+    band.field=&field;
+    band.bits=image.bits();
+    band.bytesPerLine=image.bytesPerLine();
+    QList<GribRasterBand> bands;
+    for(int r=0;r<nbRows;r+=RASTER_BAND_ROWS)
+    {
+        band.r0=r;
+        band.r1=qMin(nbRows,r+RASTER_BAND_ROWS);
+        bands.append(band);
+    }
+    if(monoCpu || QThread::idealThreadCount()<=1)
+    {
+        for(int n=0;n<bands.size();++n)
+            drawRasterBand(bands[n]);
+    }
+    else
+        QtConcurrent::blockingMap(bands,MapDataDrawer::drawRasterBand);
+
+    pnt.drawImage(0,0,image);
     return true;
 }
-void MapDataDrawer::paintImage(QImage * image, QPainter * pnt, const QPoint &point)
+
+double MapDataDrawer::rasterValue(const GribRasterField &field, const int &k, const int &c, const int &r)
 {
-    mutex.lock();
-    pnt->drawImage(point,*image);
-    mutex.unlock();
+    const GribGridLookup &prev=field.gridPrev[k];
+    if(!prev.okX.at(c) || !prev.okY.at(r))
+        return GRIB_NOTDEF;
+    double v = field.recPrev[k]->getInterpolatedValueAt(prev.i0.at(c),prev.i1.at(c),prev.dx.at(c),
+                                                        prev.j0.at(r),prev.sigDj.at(r),prev.dy.at(r));
+    if(v != GRIB_NOTDEF && field.tPrev[k]!=field.tNxt[k])
+    {
+        const GribGridLookup &nxt=field.gridNxt[k];
+        if(!nxt.okX.at(c) || !nxt.okY.at(r))
+            return v;
+        double v_2=field.recNxt[k]->getInterpolatedValueAt(nxt.i0.at(c),nxt.i1.at(c),nxt.dx.at(c),
+                                                           nxt.j0.at(r),nxt.sigDj.at(r),nxt.dy.at(r));
+        if(v_2 != GRIB_NOTDEF)
+            v=v+((v_2-v)/((double)(field.tNxt[k]-field.tPrev[k])))*((double)(field.now-field.tPrev[k]));
+    }
+    return v;
 }
 
-void MapDataDrawer::drawColorMapGeneric_2D_OLD(QPainter &pnt, const Projection *proj, const bool &smooth,
-                                               const bool &showWindArrows, const bool &barbules,
-                                               const time_t &now, const time_t &t1, const time_t &t2,
-                                               GribRecord * recU1, GribRecord * recV1, GribRecord * recU2, GribRecord * recV2,
-                                               const QString &color_name, const bool &UV, int interpolation_mode)
+/* values of a row of points of a 2-D field, the ones out of its zone from the next sources */
+void MapDataDrawer::rasterValues_2D(const GribRasterField &field, const double * x, const double * y, const int &nb,
+                                    double * u, double * v, bool * ok)
 {
-//    QTime tot;
-//    tot.start();
-    int i, j;
-    double u,v,x,y;
-    const int W = proj->getW();
-    const int H = proj->getH();
-    int space=1;
-    int W_s=0,H_s=0;
-    QRgb   rgb;
-
-    ColorElement * colorElement=DataColors::get_colorElement(color_name);
-    if(!colorElement) return;
-    if(!colorElement->isCacheLoaded(smooth))
+    Grib::interpolateValues_2D(x,y,nb,field.now,field.tPrev[0],field.tNxt[0],
+                               field.recPrev[0],field.recPrev[1],field.recNxt[0],field.recNxt[1],
+                               u,v,ok,field.interpolMode,field.UV);
+    if(!field.next)
+        return;
+    QVector<int> left;
+    for(int n=0;n<nb;++n)
+        if(!ok[n])
+            left.append(n);
+    if(left.isEmpty())
+        return;
+    const int nbLeft=left.size();
+    QVector<double> leftX(nbLeft),leftY(nbLeft),leftU(nbLeft),leftV(nbLeft);
+    QVector<bool> leftOk(nbLeft);
+    for(int n=0;n<nbLeft;++n)
     {
-        colorElement->clearCache();
-        colorElement->loadCache(smooth);
+        leftX[n]=x[left.at(n)];
+        leftY[n]=y[left.at(n)];
     }
-
-    int sz=1;
-    if(showWindArrows)
+    rasterValues_2D(*field.next,leftX.constData(),leftY.constData(),nbLeft,leftU.data(),leftV.data(),leftOk.data());
+    for(int n=0;n<nbLeft;++n)
     {
-        if (barbules)
-            space =  windBarbuleSpace;
-        else
-            space =  windArrowSpace;
-
-        W_s=W/space+1;
-        H_s=H/space+1;
-        sz=(W_s+2)*(H_s+2);
+        if(!leftOk.at(n)) continue;
+        u[left.at(n)]=leftU.at(n);
+        v[left.at(n)]=leftV.at(n);
+        ok[left.at(n)]=true;
     }
-    QVector<double> u_tab(sz,-1.0);
-    QVector<double> v_tab(sz);
-    QVector<bool> y_tab(sz);
+}
 
-    uchar * buffer=new uchar [W*H*4];
-    int indice=0;
-    const int W4=W*4;
-    if(interpolation_mode==INTERPOLATION_UKN)
-        interpolation_mode=dataManager->get_interpolationMode();
-    for (i=0; i<W-2; i+=2)
+QRgb MapDataDrawer::rasterColor(const GribRasterField &field, const double &v)
+{
+    const QRgb rgb=field.colorElement->get_colorCached(v);
+    if(field.alphaCoef==0)
+        return rgb;
+    return qRgba(qRed(rgb),qGreen(rgb),qBlue(rgb),(int)(field.alphaCoef*v));
+}
+
+void MapDataDrawer::drawRasterBand(GribRasterBand &band)
+{
+    const GribRasterField &field=*band.field;
+    /* 2-D fields: a row of blocks is interpolated at once */
+    QVector<double> rowX,rowY,rowU,rowV;
+    QVector<bool> rowOk;
+    if(field.dim==2)
+    {
+        rowX.resize(band.nbCols);
+        rowY.resize(band.nbCols);
+        rowU.resize(band.nbCols);
+        rowV.resize(band.nbCols);
+        rowOk.resize(band.nbCols);
+        for(int c=0;c<band.nbCols;++c)
+            rowX[c]=field.lookup->lons.at(2*c);
+    }
+    for(int r=band.r0;r<band.r1;++r)
     {
-        for (j=0; j<H-2; j+=2)
+        QRgb * line0=(QRgb *)(band.bits+(2*r)*band.bytesPerLine);
+        QRgb * line1=(QRgb *)(band.bits+(2*r+1)*band.bytesPerLine);
+        if(field.dim==2)
         {
-            proj->screen2map(i,j, &x, &y);
-            if(Grib::interpolateValue_2D(x,y,now,t1,t2,recU1,recV1,recU2,recV2,&u,&v,interpolation_mode,UV))
+            rowY.fill(field.lookup->lats.at(2*r));
+            rasterValues_2D(field,rowX.constData(),rowY.constData(),band.nbCols,
+                            rowU.data(),rowV.data(),rowOk.data());
+        }
+        for(int c=0;c<band.nbCols;++c)
+        {
+            double v;
+            if(field.dim==2)
             {
-                if(showWindArrows && i%space==0 && j%space==0)
-                {
-                    int i_s=i/space;
-                    int j_s=j/space;
-                    indice=i_s*H_s+j_s;
-                    u_tab[indice]=u;
-                    v_tab[indice]=v;
-                    y_tab[indice]=(y<0);
-                }
-
-                rgb=colorElement->get_colorCached(u);
-                const int alpha=qAlpha(rgb);
-                const int red=qRed(rgb);
-                const int green=qGreen(rgb);
-                const int blue=qBlue(rgb);
-                int index=(j*W4)+(i*4);
-                buffer[index+3]=alpha;
-                buffer[index+2]=red;
-                buffer[index+1]=green;
-                buffer[index]=blue;
-                index=(j*W4)+((i+1)*4);
-                buffer[index+3]=alpha;
-                buffer[index+2]=red;
-                buffer[index+1]=green;
-                buffer[index]=blue;
-                index=((j+1)*W4)+(i*4);
-                buffer[index+3]=alpha;
-                buffer[index+2]=red;
-                buffer[index+1]=green;
-                buffer[index]=blue;
-                index=((j+1)*W4)+((i+1)*4);
-                buffer[index+3]=alpha;
-                buffer[index+2]=red;
-                buffer[index+1]=green;
-                buffer[index]=blue;
+                if(!rowOk.at(c)) continue;
+                v=rowU.at(c);
             }
             else
             {
-                int index=(j*W4)+(i*4);
-                buffer[index+3]=0;
-                buffer[index+2]=0;
-                buffer[index+1]=0;
-                buffer[index]=0;
-                index=(j*W4)+((i+1)*4);
-                buffer[index+3]=0;
-                buffer[index+2]=0;
-                buffer[index+1]=0;
-                buffer[index]=0;
-                index=((j+1)*W4)+(i*4);
-                buffer[index+3]=0;
-                buffer[index+2]=0;
-                buffer[index+1]=0;
-                buffer[index]=0;
-                index=((j+1)*W4)+((i+1)*4);
-                buffer[index+3]=0;
-                buffer[index+2]=0;
-                buffer[index+1]=0;
-                buffer[index]=0;
+                /* out of the zone of a source: the next one */
+                v=GRIB_NOTDEF;
+                for(const GribRasterField * f=&field;f && v == GRIB_NOTDEF;f=f->next)
+                {
+                    v=rasterValue(*f,0,c,r);
+                    if(v != GRIB_NOTDEF && f->nbRec==2)
+                    {
+                        const double v2=rasterValue(*f,1,c,r);
+                        v=v2 == GRIB_NOTDEF?GRIB_NOTDEF:fabs(v-v2);
+                    }
+                }
+                if(v == GRIB_NOTDEF) continue;
             }
+            const QRgb rgb=rasterColor(field,v);
+            line0[2*c]=rgb;
+            line0[2*c+1]=rgb;
+            line1[2*c]=rgb;
+            line1[2*c+1]=rgb;
         }
     }
+}
 
-    QImage image(buffer,W,H, W4, QImage::Format_ARGB32);
-    pnt.drawImage(0,0,image);
-    delete[] buffer;
-
-    if(showWindArrows)
+/* arrows or barbs of a 2-D field, on a grid of windArrowSpace/windBarbuleSpace pixels */
+void MapDataDrawer::drawRasterArrows(QPainter &pnt, const GribRasterField &field, const bool &barbules)
+{
+    const GribScreenLookup &lookup=*field.lookup;
+    const int space=barbules?windBarbuleSpace:windArrowSpace;
+    const int W=lookup.lons.size();
+    const int H=lookup.lats.size();
+    const int nbCols=W/space+1;
+    QVector<double> x(nbCols),y(nbCols),u(nbCols),v(nbCols);
+    QVector<bool> ok(nbCols);
+    pnt.save();
+    pnt.setRenderHint(QPainter::Antialiasing, true);
+    for(int j=0;j<=H;j+=space)
     {
-        for (i=0; i<W_s; ++i)
+        for(int c=0;c<nbCols;++c)
+            lookup.screen2map(c*space,j,&x[c],&y[c]);
+        rasterValues_2D(field,x.constData(),y.constData(),nbCols,u.data(),v.data(),ok.data());
+        for(int c=0;c<nbCols;++c)
         {
-            for (j=0; j<H_s; ++j)
-            {
-                indice=i*H_s+j;
-                u=u_tab.at(indice);
-                v=v_tab.at(indice);
-
-                if(u<0)
-                    continue;
-                if (barbules)
-                    drawWindArrowWithBarbs(pnt, i*space,j*space, u,v, y_tab.at(indice));
-                else
-                    drawWindArrow(pnt, i*space,j*space, v);
-
-            }
+            if(!ok.at(c)) continue;
+            if (barbules)
+                drawWindArrowWithBarbs(pnt, c*space,j, u.at(c),v.at(c), y.at(c)<0);
+            else
+                drawWindArrow(pnt, c*space,j, v.at(c));
         }
     }
-    //qWarning()<<"time to draw monocpu"<<tot.elapsed();
-    //colorElement->clearCache();
+    pnt.restore();
 }
+
+//--------------------------------------------------------------------------
+// Carte de couleurs du vent
+//--------------------------------------------------------------------------
+
 void MapDataDrawer::drawColorMapGeneric_2D(QPainter &pnt, Projection *proj, const bool &smooth,
                                                const bool &showWindArrows, const bool &barbules,
                                                const time_t &now, const time_t &t1, const time_t &t2,
                                                GribRecord * recU1, GribRecord * recV1, GribRecord * recU2, GribRecord * recV2,
-                                               const QString &color_name, const bool &UV, int interpolation_mode)
+                                               const QString &color_name, const bool &UV, int interpolation_mode,
+                                               const bool &forceMonoCpu)
 {
-    if(gribMonoCpu || QThread::idealThreadCount()<=1) {
-        drawColorMapGeneric_2D_OLD(pnt,proj,smooth,showWindArrows,barbules,now,t1,t2,recU1,recV1,recU2,recV2,
-                                   color_name,UV,interpolation_mode);
+    if(recU1 == NULL || recV1 == NULL)
         return;
-    }
-
-    GribThreadData g;
-    g.now=now;
-    g.recU1=recU1;
-    g.recU2=recU2;
-    g.recV1=recV1;
-    g.recV2=recV2;
-    g.t1=t1;
-    g.t2=t2;
-    g.showWindArrows=showWindArrows;
-    g.barbules=barbules;
     if(interpolation_mode==INTERPOLATION_UKN)
         interpolation_mode=dataManager->get_interpolationMode();
-    g.interpolMode=interpolation_mode;
-    g.dataManager=dataManager;
-    g.mapDataDrawer=this;
-    g.proj=proj;
-    g.UV=UV;
-    g.showWindArrows=showWindArrows;
-    g.barbules=barbules;
-    g.windArrowSpace=windArrowSpace;
-    g.windBarbuleSpace=windBarbuleSpace;
-    g.pntGrib=&pnt;
-    ColorElement * colorElement=DataColors::get_colorElement(color_name);
-    if(!colorElement) return;
-    if(!colorElement->isCacheLoaded(smooth))
-    {
-        colorElement->clearCache();
-        colorElement->loadCache(smooth);
-    }
-    g.colorElement=colorElement;
-    QList<GribThreadData> data;
-#if 1
-    double nCpu=qMax(2,QThread::idealThreadCount());
-    int w=floor((double)proj->getW()/(double)(nCpu/2.0));
-    int h=floor((double)proj->getH()/2.0);
-
-    for(int i=0;i<nCpu/2;++i)
-    {
-        int decalw=0;
-        if(i>0)
-            decalw=1;
-        g.from=QPoint(i*w+decalw,0);
-        g.to=QPoint((i+1)*w,h);
-        data.append(g);
-        g.from=QPoint(i*w+decalw,h+1);
-        g.to=QPoint((i+1)*w,proj->getH());
-        data.append(g);
-    }
-//    qWarning()<<nCpu<<data.size()<<w<<h;
-//    foreach(GribThreadData g,data)
-//        qWarning()<<g.from<<g.to<<QRect(g.from,g.to).size();
-#else
-    g.from=QPoint(0,0);
-    g.to=QPoint(proj->getW()/2,proj->getH()/2);
-    data.append(g);
-    g.from=QPoint(proj->getW()/2+1,0);
-    g.to=QPoint(proj->getW(),proj->getH()/2);
-    data.append(g);
-    g.from=QPoint(0,proj->getH()/2+1);
-    g.to=QPoint(proj->getW()/2,proj->getH());
-    data.append(g);
-    g.from=QPoint(proj->getW()/2+1,proj->getH()/2+1);
-    g.to=QPoint(proj->getW(),proj->getH());
-    data.append(g);
-#endif
-#if 0
-    for (int n=0;n<data.size();++n)
-        result.append(drawColorMapGeneric_2D_Partial(data.at(n)));
-#else
-    QtConcurrent::blockingMapped(data, MapDataDrawer::drawColorMapGeneric_2D_Partial);
-#endif
-//    pnt.drawImage(data.at(0).from,result.at(0));
-//    pnt.drawImage(data.at(1).from,result.at(1));
-//    pnt.drawImage(data.at(2).from,result.at(2));
-//    pnt.drawImage(data.at(3).from,result.at(3));
-    return;
+    GribRasterField field;
+    field.dim=2;
+    field.now=now;
+    field.tPrev[0]=t1;
+    field.tNxt[0]=t2;
+    field.recPrev[0]=recU1;
+    field.recPrev[1]=recV1;
+    field.recNxt[0]=recU2;
+    field.recNxt[1]=recV2;
+    field.interpolMode=interpolation_mode;
+    field.UV=UV;
+    field.alphaCoef=0;
+    field.next=NULL;
+    if(drawColorMapRaster(pnt,proj,smooth,field,color_name,gribMonoCpu || forceMonoCpu) && showWindArrows)
+        drawRasterArrows(pnt,field,barbules);
 }
 //--------------------------------------------------------------------------
 // Carte de couleurs generique de la difference entre 2 champs
@@ -672,57 +618,25 @@ void  MapDataDrawer::drawColorMapGeneric_Abs_Delta_Data (
                 QPainter &pnt, const Projection *proj, bool smooth,time_t now,
                 time_t tPrevTemp,time_t tNxtTemp,GribRecord * recPrevTemp,GribRecord * recNxtTemp,
                 time_t tPrevDewpoint,time_t tNxtDewpoint,GribRecord * recPrevDewpoint,GribRecord * recNxtDewpoint,
-                QRgb (MapDataDrawer::*function_getColor) (double v, bool smooth)
+                const QString &color_name
         )
 {
     if (recPrevTemp == NULL || recPrevDewpoint == NULL) return;
-    int i, j;
-    double x, y, vx, vy, v, vx2, vy2;
-    int W = proj->getW();
-    int H = proj->getH();
-    QRgb   rgb;
-    QImage *image = new QImage(W,H,QImage::Format_ARGB32);
-    image->fill( qRgba(0,0,0,0));
-    for (i=0; i<W-1; i+=2) {
-        for (j=0; j<H-1; j+=2)
-        {
-            proj->screen2map(i,j, &x, &y);
-
-            if (! recPrevTemp->isXInMap(x))
-                x += 360.0;    // tour complet ?
-
-            if (recPrevTemp->isPointInMap(x, y))
-            {
-                vx = recPrevTemp->getInterpolatedValue(x, y, MUST_INTERPOLATE_VALUE);
-                if(vx != GRIB_NOTDEF && tPrevTemp!=tNxtTemp)
-                {
-                    vx2=recNxtTemp->getInterpolatedValue(x, y, MUST_INTERPOLATE_VALUE);
-                    if(vx2 != GRIB_NOTDEF)
-                        vx=vx+((vx2-vx)/((double)(tNxtTemp-tPrevTemp)))*((double)(now-tPrevTemp));
-                }
-
-                vy = recPrevDewpoint->getInterpolatedValue(x, y, MUST_INTERPOLATE_VALUE);
-                if(vy != GRIB_NOTDEF && tPrevDewpoint!=tNxtDewpoint)
-                {
-                    vy2=recNxtDewpoint->getInterpolatedValue(x, y, MUST_INTERPOLATE_VALUE);
-                    if(vy2 != GRIB_NOTDEF)
-                        vy=vy+((vy2-vy)/((double)(tNxtDewpoint-tPrevDewpoint)))*((double)(now-tPrevDewpoint));
-                }
-
-                if (vx != GRIB_NOTDEF && vy != GRIB_NOTDEF)
-                {
-                    v = fabs(vx-vy);
-                    rgb = (this->*function_getColor) (v, smooth);
-                    image->setPixel(i,  j, rgb);
-                    image->setPixel(i+1,j, rgb);
-                    image->setPixel(i,  j+1, rgb);
-                    image->setPixel(i+1,j+1, rgb);
-                }
-            }
-        }
-    }
-        pnt.drawImage(0,0,*image);
-    delete image;
+    GribRasterField field;
+    field.dim=1;
+    field.now=now;
+    field.nbRec=2;
+    field.tPrev[0]=tPrevTemp;
+    field.tNxt[0]=tNxtTemp;
+    field.recPrev[0]=recPrevTemp;
+    field.recNxt[0]=recNxtTemp;
+    field.tPrev[1]=tPrevDewpoint;
+    field.tNxt[1]=tNxtDewpoint;
+    field.recPrev[1]=recPrevDewpoint;
+    field.recNxt[1]=recNxtDewpoint;
+    field.alphaCoef=0;
+    field.next=NULL;
+    drawColorMapRaster(pnt,proj,smooth,field,color_name,gribMonoCpu);
 }
 
 /****************************************************************************
@@ -730,90 +644,51 @@ void  MapDataDrawer::drawColorMapGeneric_Abs_Delta_Data (
  ***************************************************************************/
 
 void MapDataDrawer::draw_WIND_Color(QPainter &pnt, Projection *proj, bool smooth,bool showWindArrows,bool barbules) {
-    GribRecord *recU1,*recV1,*recU2,*recV2;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data2D(DATA_WIND_VX,DATA_WIND_VY,DATA_LV_ABOV_GND,10,currentDate,
-                                 &tPrev,&tNxt,&recU1,&recV1,&recU2,&recV2))
-        drawColorMapGeneric_2D(pnt,proj,smooth, showWindArrows,barbules,currentDate,tPrev,tNxt,
-                               recU1,recV1,recU2,recV2,"wind_kts",true);
+    drawColorMapSources_2D(pnt,proj,smooth,showWindArrows,barbules,
+                           DATA_WIND_VX,DATA_WIND_VY,DATA_LV_ABOV_GND,10,"wind_kts",true);
 }
 
 void MapDataDrawer::draw_wavesSigHgtComb(QPainter &pnt, const Projection *proj, bool smooth) {
-    GribRecord *rec_prev,*rec_nxt;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data1D(DATA_WAVES_SIG_HGT_COMB,DATA_LV_GND_SURF,0,currentDate,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, &MapDataDrawer::getWavesColor);
+    drawColorMapSources_1D(pnt,proj,smooth,DATA_WAVES_SIG_HGT_COMB,DATA_LV_GND_SURF,0,"waves_m");
 }
 
 void MapDataDrawer::draw_wavesWnd(QPainter &pnt, Projection *proj, bool smooth,bool showArrows) {
-    GribRecord *recU1,*recV1,*recU2,*recV2;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data2D(DATA_WAVES_WND_HGT,DATA_WAVES_WND_DIR,DATA_LV_GND_SURF,0,currentDate,
-                                 &tPrev,&tNxt,&recU1,&recV1,&recU2,&recV2))
-        drawColorMapGeneric_2D(pnt,proj,smooth, showArrows,false,currentDate,
-                               tPrev,tNxt,recU1,recV1,recU2,recV2, "waves_m",false,INTERPOLATION_TWSA);
+    drawColorMapSources_2D(pnt,proj,smooth,showArrows,false,
+                           DATA_WAVES_WND_HGT,DATA_WAVES_WND_DIR,DATA_LV_GND_SURF,0,"waves_m",false,INTERPOLATION_TWSA);
 }
 
 void MapDataDrawer::draw_wavesSwl(QPainter &pnt, Projection *proj, bool smooth,bool showArrows) {
-    GribRecord *recU1,*recV1,*recU2,*recV2;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data2D(DATA_WAVES_SWL_HGT,DATA_WAVES_SWL_DIR,DATA_LV_GND_SURF,0,currentDate,
-                                 &tPrev,&tNxt,&recU1,&recV1,&recU2,&recV2))
-        drawColorMapGeneric_2D(pnt,proj,smooth, showArrows,false,currentDate,
-                               tPrev,tNxt,recU1,recV1,recU2,recV2, "waves_m",false,INTERPOLATION_TWSA);
+    drawColorMapSources_2D(pnt,proj,smooth,showArrows,false,
+                           DATA_WAVES_SWL_HGT,DATA_WAVES_SWL_DIR,DATA_LV_GND_SURF,0,"waves_m",false,INTERPOLATION_TWSA);
 }
 
 void MapDataDrawer::draw_wavesMax(QPainter &pnt, Projection *proj, bool smooth,bool showArrows) {
-    GribRecord *recU1,*recV1,*recU2,*recV2;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data2D(DATA_WAVES_MAX_HGT,DATA_WAVES_MAX_DIR,DATA_LV_GND_SURF,0,currentDate,
-                                 &tPrev,&tNxt,&recU1,&recV1,&recU2,&recV2))
-        drawColorMapGeneric_2D(pnt,proj,smooth, showArrows,false,currentDate,
-                               tPrev,tNxt,recU1,recV1,recU2,recV2, "waves_m",false,INTERPOLATION_TWSA);
+    drawColorMapSources_2D(pnt,proj,smooth,showArrows,false,
+                           DATA_WAVES_MAX_HGT,DATA_WAVES_MAX_DIR,DATA_LV_GND_SURF,0,"waves_m",false,INTERPOLATION_TWSA);
 }
 
 void MapDataDrawer::draw_wavesWhiteCap(QPainter &pnt, Projection *proj, bool smooth) {
-    GribRecord *rec_prev,*rec_nxt;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data1D(DATA_WAVES_WHITE_CAP,DATA_LV_GND_SURF,0,currentDate,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, &MapDataDrawer::getWavesWhiteCapColor);
+    drawColorMapSources_1D(pnt,proj,smooth,DATA_WAVES_WHITE_CAP,DATA_LV_GND_SURF,0,"whitecap_prb");
 }
 
-void MapDataDrawer::draw_WIND_Color_OLD(QPainter &pnt, const Projection *proj, bool smooth,bool showWindArrows,bool barbules) {
+void MapDataDrawer::draw_WIND_Color_OLD(QPainter &pnt, Projection *proj, bool smooth,bool showWindArrows,bool barbules) {
     GribRecord *recU1,*recV1,*recU2,*recV2;
     time_t tPrev,tNxt;
     time_t currentDate=dataManager->get_currentDate();
     if(dataManager->get_data2D(DATA_WIND_VX,DATA_WIND_VY,DATA_LV_ABOV_GND,10,currentDate,
-                                 &tPrev,&tNxt,&recU1,&recV1,&recU2,&recV2))
-        drawColorMapGeneric_2D_OLD(pnt,proj,smooth, showWindArrows,barbules,currentDate,tPrev,tNxt,
-                               recU1,recV1,recU2,recV2,"wind_kts",true);
+                                 &tPrev,&tNxt,&recU1,&recV1,&recU2,&recV2)) {
+        drawColorMapGeneric_2D(pnt,proj,smooth, showWindArrows,barbules,currentDate,tPrev,tNxt,
+                               recU1,recV1,recU2,recV2,"wind_kts",true,INTERPOLATION_UKN,true);
+    }
 }
 
 void MapDataDrawer::draw_CURRENT_Color(QPainter &pnt, Projection *proj, bool smooth,bool showWindArrows,bool barbules) {
-    GribRecord *recU1,*recV1,*recU2,*recV2;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data2D(DATA_CURRENT_VX,DATA_CURRENT_VY,DATA_LV_MSL,0,currentDate,
-                                 &tPrev,&tNxt,&recU1,&recV1,&recU2,&recV2))
-        drawColorMapGeneric_2D(pnt,proj,smooth, showWindArrows,barbules,currentDate,tPrev,tNxt,
-                               recU1,recV1,recU2,recV2,"current_kts",true);
+    drawColorMapSources_2D(pnt,proj,smooth,showWindArrows,barbules,
+                           DATA_CURRENT_VX,DATA_CURRENT_VY,DATA_LV_MSL,0,"current_kts",true);
 }
 
 void MapDataDrawer::draw_RAIN_Color(QPainter &pnt, const Projection *proj, bool smooth) {
-    GribRecord *rec_prev,*rec_nxt;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data1D(DATA_PRECIP_TOT,DATA_LV_GND_SURF,0,currentDate,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, &MapDataDrawer::getRainColor);
+    drawColorMapSources_1D(pnt,proj,smooth,DATA_PRECIP_TOT,DATA_LV_GND_SURF,0,"rain_mmh");
 }
 
 /*
@@ -824,100 +699,58 @@ void MapDataDrawer::draw_SNOW_DEPTH_Color(QPainter &pnt, const Projection *proj,
     time_t currentDate=dataManager->get_currentDate();
     if(grib->getGribRecordArroundDates(DATA_SNOW_DEPTH,DATA_LV_GND_SURF,0,currentDate,
                                  &tPrev,&tNxt,&rec_prev,&rec_nxt))
-        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, &MapDataDrawer::getSnowDepthColor);
+        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, "snowdepth_m");
 }
 */
 
 void MapDataDrawer::draw_SNOW_CATEG_Color(QPainter &pnt, const Projection *proj, bool smooth) {
     if(!dataManager || !dataManager->isOk()) return;
-    GribRecord *rec_prev,*rec_nxt;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data1D(DATA_SNOW_CATEG,DATA_LV_GND_SURF,0,currentDate,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, &MapDataDrawer::getBinaryColor);
+    drawColorMapSources_1D(pnt,proj,smooth,DATA_SNOW_CATEG,DATA_LV_GND_SURF,0,"binary");
 }
 
 void MapDataDrawer::draw_FRZRAIN_CATEG_Color(QPainter &pnt, const Projection *proj, bool smooth) {
     if(!dataManager || !dataManager->isOk()) return;
-    GribRecord *rec_prev,*rec_nxt;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data1D(DATA_FRZRAIN_CATEG,DATA_LV_GND_SURF,0,currentDate,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, &MapDataDrawer::getBinaryColor);
+    drawColorMapSources_1D(pnt,proj,smooth,DATA_FRZRAIN_CATEG,DATA_LV_GND_SURF,0,"binary");
 }
 
 void MapDataDrawer::draw_CLOUD_Color(QPainter &pnt, const Projection *proj, bool smooth) {
     if(!dataManager || !dataManager->isOk()) return;
     isCloudsColorModeWhite = Settings::getSetting("cloudsColorMode", "white").toString() == "white";
+    /* white clouds: the opacity follows the cover (%) */
+    const QString cloudColor=isCloudsColorModeWhite?"clouds_white_pc":"clouds_black_pc";
+    const double cloudAlpha=isCloudsColorModeWhite?2.5:0;
 
-    GribRecord *rec_prev,*rec_nxt;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data1D(DATA_CLOUD_TOT,DATA_LV_ATMOS_ALL,0,currentDate,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, &MapDataDrawer::getCloudColor);
+    drawColorMapSources_1D(pnt,proj,smooth,DATA_CLOUD_TOT,DATA_LV_ATMOS_ALL,0,cloudColor,cloudAlpha);
 }
 
 void MapDataDrawer::draw_HUMID_Color(QPainter &pnt, const Projection *proj, bool smooth) {
     if(!dataManager || !dataManager->isOk()) return;
-    GribRecord *rec_prev,*rec_nxt;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data1D(DATA_HUMID_REL,DATA_LV_ABOV_GND,2,currentDate,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, &MapDataDrawer::getHumidColor);
+    drawColorMapSources_1D(pnt,proj,smooth,DATA_HUMID_REL,DATA_LV_ABOV_GND,2,"humidrel_pc");
 }
 
 void MapDataDrawer::draw_Temp_Color(QPainter &pnt, const Projection *proj, bool smooth) {
     if(!dataManager || !dataManager->isOk()) return;
-    GribRecord *rec_prev,*rec_nxt;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data1D(DATA_TEMP,DATA_LV_ABOV_GND,2,currentDate,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, &MapDataDrawer::getTemperatureColor);
+    drawColorMapSources_1D(pnt,proj,smooth,DATA_TEMP,DATA_LV_ABOV_GND,2,"temp_celcius");
 }
 
 void MapDataDrawer::draw_TempPot_Color(QPainter &pnt, const Projection *proj, bool smooth) {
     if(!dataManager || !dataManager->isOk()) return;
-    GribRecord *rec_prev,*rec_nxt;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data1D(DATA_TEMP_POT,DATA_LV_SIGMA,9950,currentDate,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, &MapDataDrawer::getTemperatureColor);
+    drawColorMapSources_1D(pnt,proj,smooth,DATA_TEMP_POT,DATA_LV_SIGMA,9950,"temp_celcius");
 }
 
 void MapDataDrawer::draw_Dewpoint_Color(QPainter &pnt, const Projection *proj, bool smooth) {
     if(!dataManager || !dataManager->isOk()) return;
-    GribRecord *rec_prev,*rec_nxt;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data1D(DATA_DEWPOINT,DATA_LV_ABOV_GND,2,currentDate,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, &MapDataDrawer::getTemperatureColor);
+    drawColorMapSources_1D(pnt,proj,smooth,DATA_DEWPOINT,DATA_LV_ABOV_GND,2,"temp_celcius");
 }
 
 void MapDataDrawer::draw_CAPEsfc(QPainter &pnt, const Projection *proj, bool smooth) {
     if(!dataManager || !dataManager->isOk()) return;
-    GribRecord *rec_prev,*rec_nxt;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data1D(DATA_CAPE,DATA_LV_GND_SURF,0,currentDate,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, &MapDataDrawer::getCAPEColor);
+    drawColorMapSources_1D(pnt,proj,smooth,DATA_CAPE,DATA_LV_GND_SURF,0,"cape_jkg");
 }
 
 void MapDataDrawer::draw_CINsfc(QPainter &pnt, const Projection *proj, bool smooth) {
     if(!dataManager || !dataManager->isOk()) return;
-    GribRecord *rec_prev,*rec_nxt;
-    time_t tPrev,tNxt;
-    time_t currentDate=dataManager->get_currentDate();
-    if(dataManager->get_data1D(DATA_CIN,DATA_LV_GND_SURF,0,currentDate,
-                                 &tPrev,&tNxt,&rec_prev,&rec_nxt))
-        drawColorMapGeneric_1D(pnt,proj,smooth, currentDate,tPrev,tNxt,rec_prev,rec_nxt, &MapDataDrawer::getCINColor);
+    drawColorMapSources_1D(pnt,proj,smooth,DATA_CIN,DATA_LV_GND_SURF,0,"cin_jkg");
 }
 
 void MapDataDrawer::draw_DeltaDewpoint_Color(QPainter &pnt, const Projection *proj, bool smooth) {
@@ -935,7 +768,7 @@ void MapDataDrawer::draw_DeltaDewpoint_Color(QPainter &pnt, const Projection *pr
             drawColorMapGeneric_Abs_Delta_Data (pnt,proj,smooth,currentDate,
                                                 tPrevTemp,tNxtTemp,rec_prevTemp,rec_nxtTemp,
                                                 tPrevDewpoint,tNxtDewpoint,rec_prevDewpoint,rec_nxtDewpoint,
-                                                        &MapDataDrawer::getDeltaTemperaturesColor );
+                                                "deltatemp_celcius");
 }
 
 /****************************************************************************
@@ -24,27 +24,80 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QPainter>
 #include <QMap>
 #include <QMutex>
+#include <QVector>
 
 #include "class_list.h"
 #include "dataDef.h"
 #include "Grib.h"
 
-struct GribThreadData
+/* screen to geo lookup of a view: screen2map is separable, the longitude only
+   depends on the pixel column and the latitude on the pixel row */
+class GribScreenLookup
 {
-    time_t  now, t1, t2;
-    GribRecord *recU1, *recV1, *recU2, *recV2;
-    int interpolMode,windBarbuleSpace,windArrowSpace;
-    DataManager * dataManager;
-    MapDataDrawer * mapDataDrawer;
-    ColorElement * colorElement;
-    bool UV, showWindArrows, barbules;
-    Projection * proj;
-    QPoint from,to;
-    QPainter *pntGrib;
+    public:
+        GribScreenLookup(void);
+        void update(const Projection * proj);
+        inline void screen2map(const int &i, const int &j, double *x, double *y) const;
+
+        QVector<double> lons,lats;
+
+    private:
+        const Projection * proj;
+        int W,H;
+        double xW,yN,scale;
+        void screen2mapOut(const int &i, const int &j, double *x, double *y) const;
 };
-Q_DECLARE_TYPEINFO(GribThreadData,Q_PRIMITIVE_TYPE);
 
-bool drawColorMapGeneric_2D_Partial(const GribThreadData &g);
+inline void GribScreenLookup::screen2map(const int &i, const int &j, double *x, double *y) const {
+    if(i>=0 && i<W && j>=0 && j<H) {
+        *x=lons.at(i);
+        *y=lats.at(j);
+    }
+    else
+        screen2mapOut(i,j,x,y);  // outside of the view (wind arrows of the borders)
+}
+
+/* grid position in one record (see GribRecord::getGridPosX/Y) of the columns and rows
+   of 2x2 pixel blocks of a GribScreenLookup */
+struct GribGridLookup
+{
+    void init(const GribScreenLookup &screen, const GribRecord * rec, const int &nbCols, const int &nbRows);
+    QVector<int> i0,i1,j0,sigDj;
+    QVector<double> dx,dy;
+    QVector<bool> okX,okY;
+};
+
+/* a colour map field, with dim==1: the (time interpolated) value of recPrev[0]/recNxt[0],
+   or, with nbRec==2, the absolute difference of the two fields.
+   With dim==2: the speed (or height) of the vector field of u recPrev[0]/recNxt[0]
+   and v recPrev[1]/recNxt[1], at tPrev[0]/tNxt[0].
+   The blocks without value are taken in next, the field of the next source */
+struct GribRasterField
+{
+    int dim;
+    time_t now;
+    time_t tPrev[2],tNxt[2];
+    GribRecord *recPrev[2],*recNxt[2];
+    int nbRec;
+    int interpolMode;   // dim==2
+    bool UV;            // dim==2
+    double alphaCoef;   // if not 0, the opacity is alphaCoef*value (white clouds)
+    GribRasterField * next;
+    /* filled by drawColorMapRaster */
+    GribGridLookup gridPrev[2],gridNxt[2];
+    const GribScreenLookup * lookup;
+    const ColorElement * colorElement;
+};
+
+/* rows [r0,r1[ of 2x2 pixel blocks of a colour map, drawn by one worker */
+struct GribRasterBand
+{
+    int r0,r1;
+    int nbCols;
+    const GribRasterField *field;
+    uchar *bits;
+    int bytesPerLine;
+};
 
 class MapDataDrawer
 {
@@ -57,16 +110,14 @@ class MapDataDrawer
                                                        const bool &showWindArrows, const bool &barbules,
                                                        const time_t &now, const time_t &t1, const time_t &t2,
                                                        GribRecord * recU1, GribRecord * recV1, GribRecord * recU2, GribRecord * recV2,
-                                                       const QString &color_name, const bool &UV, int interpolation_mode=INTERPOLATION_UKN);
-        void drawColorMapGeneric_2D_OLD(QPainter &pnt, const Projection *proj, const bool &smooth,
-                                                       const bool &showWindArrows, const bool &barbules,
-                                                       const time_t &now, const time_t &t1, const time_t &t2,
-                                                       GribRecord * recU1, GribRecord * recV1, GribRecord * recU2, GribRecord * recV2,
-                                                       const QString &color_name, const bool &UV, int interpolation_mode=INTERPOLATION_UKN);
+                                                       const QString &color_name, const bool &UV, int interpolation_mode=INTERPOLATION_UKN,
+                                                       const bool &forceMonoCpu=false);
 
         // Carte de couleurs des precipitations
         void draw_WIND_Color(QPainter &pnt, Projection *proj, bool smooth, bool showWindArrows, bool barbules);
-        void draw_WIND_Color_OLD(QPainter &pnt, const Projection *proj, bool smooth,bool showWindArrows,bool barbules);
+        /* single thread drawing of the wind, used to benchmark the multi thread one */
+        void draw_WIND_Color_OLD(QPainter &pnt, Projection *proj, bool smooth,bool showWindArrows,bool barbules);
+        void benchmark_screenLookup(const Projection *proj);
         void draw_CURRENT_Color(QPainter &pnt, Projection *proj, bool smooth, bool showWindArrows, bool barbules);
         void draw_RAIN_Color(QPainter &pnt, const Projection *proj, bool smooth);
         //void draw_SNOW_DEPTH_Color(QPainter &pnt, const Projection *proj, bool smooth);
@@ -138,10 +189,7 @@ class MapDataDrawer
             MAX_DRAWGRIB_DATAMODE
         };
 
-        void paintImage(QImage *image, QPainter *pnt, const QPoint &point);
-        static bool drawColorMapGeneric_2D_Partial(const GribThreadData &g);
 private:
-        QMutex mutex;
         myCentralWidget *centralWidget;
         DataManager * dataManager;
 
@@ -160,18 +208,31 @@ private:
         void initDataCodes(void);
 
 
-        void drawColorMapGeneric_1D (
-                QPainter &pnt, const Projection *proj, bool smooth,
-                time_t now,time_t tPrev,time_t tNxt,
-                GribRecord * recPrev,GribRecord * recNxt,
-                QRgb (MapDataDrawer::*function_getColor) (double v, bool smooth)
-                );
+        /* colour map of a field in every source, by decreasing priority */
+        void drawColorMapSources_1D(QPainter &pnt, const Projection *proj, bool smooth,
+                                    int dataType, int levelType, int levelValue,
+                                    const QString &color_name, const double &alphaCoef=0);
+        void drawColorMapSources_2D(QPainter &pnt, Projection *proj, const bool &smooth,
+                                    const bool &showArrows, const bool &barbules,
+                                    int dataType1, int dataType2, int levelType, int levelValue,
+                                    const QString &color_name, const bool &UV, int interpolation_mode=INTERPOLATION_UKN);
+
+        GribScreenLookup screenLookup;   // shared by the colour maps and the wind arrows
+
+        bool drawColorMapRaster(QPainter &pnt, const Projection *proj, bool smooth,
+                GribRasterField &field, const QString &color_name, const bool &monoCpu);
+        static void drawRasterBand(GribRasterBand &band);
+        static QRgb rasterColor(const GribRasterField &field, const double &v);
+        void drawRasterArrows(QPainter &pnt, const GribRasterField &field, const bool &barbules);
+        static double rasterValue(const GribRasterField &field, const int &k, const int &c, const int &r);
+        static void rasterValues_2D(const GribRasterField &field, const double * x, const double * y, const int &nb,
+                                    double * u, double * v, bool * ok);
 
         void  drawColorMapGeneric_Abs_Delta_Data (
                         QPainter &pnt, const Projection *proj, bool smooth,time_t now,
                         time_t tPrevTemp,time_t tNxtTemp,GribRecord * recPrevTemp,GribRecord * recNxtTemp,
                         time_t tPrevDewpoint,time_t tNxtDewpoint,GribRecord * recPrevDewpoint,GribRecord * recNxtDewpoint,
-                        QRgb (MapDataDrawer::*function_getColor) (double v, bool smooth)
+                        const QString &color_name
                 );
         void draw_IsoLinesLabels(QPainter &pnt, QColor &couleur, const Projection *proj,
                                                         std::list<IsoLine *> *liste, double coef);
@@ -188,18 +249,7 @@ private:
 
         QRgb   getWindColor              (const double v, const bool smooth);
         QRgb   getCurrentColor           (const double v, const bool smooth);
-        QRgb   getWavesColor             (const double v, const bool smooth);
-        QRgb   getWavesWhiteCapColor     (double v, bool smooth);
-        QRgb   getTemperatureColor       (double v, bool smooth);
-        QRgb   getRainColor              (double v, bool smooth);
-        QRgb   getSnowDepthColor         (double v, bool smooth);
-        QRgb   getCloudColor             (double v, bool smooth);
-        QRgb   getCAPEColor              (double v, bool smooth);
-        QRgb   getCINColor               (double v, bool smooth);
-        QRgb   getDeltaTemperaturesColor (double v, bool smooth);
-        QRgb   getHumidColor             (double v, bool smooth);
         QRgb   getPressureColor          (double v, bool smooth);
-        QRgb   getBinaryColor            (double v, bool smooth);
 
 
         QMap<int,DataCode> dataCodeMap;
@@ -24,7 +24,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTextStream>
 #include <QDebug>
 #include <QDateTime>
-#include <QProgressDialog>
+#include <QApplication>
+#include <qmath.h>
+#ifdef QT_V5
+#include <QtConcurrent/QtConcurrentMap>
+#else
+#include <QtConcurrentMap>
+#endif
 #include "MainWindow.h"
 #include "Polar.h"
 #include "dataDef.h"
@@ -32,22 +38,62 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Orthodromie.h"
 #include "settings.h"
 #include "boat.h"
+#include "libs/sha1/sha1.h"
+
+/* log the time taken by the best-VMG precompute */
+//#define traceTime
 
 Polar::Polar(MainWindow * mainWindow)
 {
     loaded=false;
+    bvmgTable=NULL;
+    lattice=NULL;
     nbUsed=0;
+    engineEnabled=false;
+    engineMinSpeed=engineSpeed=0;
     this->mainWindow=mainWindow;
+    slot_updateEngine();
+    connect(mainWindow,SIGNAL(boatSelected(boat*)),this,SLOT(slot_updateEngine()));
 }
 
 Polar::Polar(QString fname,MainWindow * mainWindow)
 {
     loaded=false;
+    bvmgTable=NULL;
+    lattice=NULL;
     nbUsed=0;
+    engineEnabled=false;
+    engineMinSpeed=engineSpeed=0;
     this->mainWindow=mainWindow;
+    slot_updateEngine();
+    connect(mainWindow,SIGNAL(boatSelected(boat*)),this,SLOT(slot_updateEngine()));
     setPolarName(fname);
 }
 
+Polar::~Polar()
+{
+    releaseBvmgTable();
+    if(lattice)
+        qFreeAligned(lattice);
+}
+
+/* engine parameters of the selected boat, read once here instead of on every getSpeed() */
+void Polar::slot_updateEngine()
+{
+    boat * selected=mainWindow->getSelectedBoat();
+    bool enabled=selected!=NULL;
+    double minSpeed=selected?selected->getMinSpeedForEngine():0;
+    double speed=selected?selected->getSpeedWithEngine():0;
+    if(enabled==engineEnabled && minSpeed==engineMinSpeed && speed==engineSpeed)
+        return;
+    engineEnabled=enabled;
+    engineMinSpeed=minSpeed;
+    engineSpeed=speed;
+    /* the best-VMG table is computed with the engine on */
+    if(loaded)
+        loadBvmgTable();
+}
+
 #define getInt(INC,RES) { \
     bool ok;                 \
     RES=list[INC].toInt(&ok);  \
@@ -80,6 +126,7 @@ void Polar::setPolarName(QString fname)
 {
     isCsv=true;
     loaded=false;
+    releaseBvmgTable();
     clearPolar();
     if(this->mainWindow->getSelectedBoat() && this->mainWindow->getSelectedBoat()->get_boatType()==BOAT_REAL)
         coeffPolar=Settings::getSetting("polarEfficiency",100).toInt()/100.0;
@@ -213,6 +260,18 @@ void Polar::setPolarName(QString fname)
     mid_twa=qRound(twa.count()/2.0);
     mid_tws=qRound(tws.count()/2.0);
     /* polaire chargee */
+    if(Settings::getSetting("polarLattice",1).toInt()==1)
+    {
+        buildLattice();
+        /* off the lattice the lookups would be approximated: keep the scan */
+        if(lattice && !latticeExact)
+        {
+            qFreeAligned(lattice);
+            lattice=NULL;
+        }
+    }
+    if(Settings::getSetting("polarBenchmark",0).toInt()==1)
+        benchmarkLattice();
 
 /* pre-calculate B-VMG for every tws at 0.1 precision with a twa step of 1 and then .1 */
 
@@ -284,58 +343,297 @@ void Polar::setPolarName(QString fname)
         wa=0.0;
         ws=ws+.1;
     }while(ws<60.1);
-    loaded=true;
+    file.close();
     QFileInfo fi(file.fileName());
-    QString nameFVmg = appFolder.value("polar")+fi.baseName()+".vmg";
-    fileVMG.setFileName(nameFVmg);
-    if (fileVMG.open(QIODevice::ReadOnly | QIODevice::Text ))
+    /* the old text cache is superseded by the binary one */
+    QFile::remove(appFolder.value("polar")+fi.baseName()+".vmg");
+    polarFileName=file.fileName();
+    fileBvmg.setFileName(appFolder.value("polar")+fi.baseName()+".bvmg");
+    loadBvmgTable();
+    /* polaire chargee, table de B-VMG comprise */
+    loaded=true;
+}
+
+/* best-VMG table from the cache, or computed (and cached) when the polar file,
+ * its coefficient or the engine parameters changed */
+void Polar::loadBvmgTable()
+{
+    releaseBvmgTable();
+    unsigned char digest[20];
+    if(!polarDigest(polarFileName,digest))
+        memset(digest,0,20);
+    if(loadBvmgCache(digest))
+        return;
+    //qWarning() << "Start computing vmg";
+#ifdef traceTime
+    QTime timer;
+    timer.start();
+#endif
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    computeBvmgTable();
+    QApplication::restoreOverrideCursor();
+#ifdef traceTime
+    qWarning()<<"vmg table for"<<name<<"computed in"<<timer.elapsed()<<"ms";
+#endif
+    bvmgTable=bvmgBuffer.constData();
+    saveBvmgCache(digest);
+}
+
+/* the table may be mapped from the cache file: unmap and close it before reusing fileBvmg */
+void Polar::releaseBvmgTable()
+{
+    if(bvmgTable && bvmgTable!=bvmgBuffer.constData())
+        fileBvmg.unmap((uchar *)bvmgTable);
+    if(fileBvmg.isOpen())
+        fileBvmg.close();
+    bvmgTable=NULL;
+    bvmgBuffer.clear();
+}
+
+/* parallel best-VMG precompute: one tws row per task, the row speed function
+ * reproduces getSpeed() operation by operation so the table is identical
+ * to the one computed through bvmgWind() */
+void Polar::computeBvmgTable()
+{
+    bvmgBuffer.resize(BVMG_TWS_COUNT*BVMG_TWA_COUNT);
+    bvmgCos.resize(90);
+    for(int i=0;i<90;++i)
+        bvmgCos[i]=cos(degToRad(((double)i)));
+    bool useEngine=engineEnabled;
+    double minSpeedForEngine=engineMinSpeed,speedWithEngine=engineSpeed;
+    QList<bvmgRow> rows;
+    rows.reserve(BVMG_TWS_COUNT);
+    for(int t=0;t<BVMG_TWS_COUNT;++t)
     {
-        if(fileVMG.size()<4329500 || fileVMG.size()>4329700)
-            fileVMG.remove();
+        bvmgRow row;
+        row.polar=this;
+        row.out=bvmgBuffer.data()+t*BVMG_TWA_COUNT;
+        row.useEngine=useEngine;
+        row.minSpeedForEngine=minSpeedForEngine;
+        row.speedWithEngine=speedWithEngine;
+        /* same tws bracketing as myGetSpeed() */
+        double windSpeed=(double) t/10.0;
+        if(windSpeed>tws.last()) windSpeed=tws.last();
+        if(windSpeed<tws.first()) windSpeed=tws.first();
+        int k2=qLowerBound(tws.constBegin(),tws.constEnd(),windSpeed)-tws.constBegin();
+        if(k2==tws.count())
+            k2=tws.count()-1;
+        row.k2=k2;
+        row.k1=tws[k2]==windSpeed?k2:k2-1;
+        row.windSpeed=windSpeed;
+        rows.append(row);
+    }
+    QtConcurrent::blockingMap(rows,Polar::computeBvmgRow);
+}
+
+void Polar::computeBvmgRow(bvmgRow &row)
+{
+    for (int twa=0;twa<BVMG_TWA_COUNT;twa++)
+    {
+        double wangle=0;
+        row.polar->rowBvmgWind(row,degToRad((double) twa/10.0),&wangle);
+        wangle = fmod(wangle, TWO_PI);
+        if (wangle > PI)
+            wangle -= TWO_PI;
+        else if (wangle < -PI)
+            wangle += TWO_PI;
+        double hdg=radToDeg(wangle);
+        if(hdg>=360) hdg=hdg-360;
+        if(hdg<0) hdg=hdg+360;
+        row.out[twa]=qRound(hdg*10.0);
+    }
+}
+
+double Polar::rowSpeed(const bvmgRow &row, double angle) const
+{
+    int i1,i2;
+    double a,b,c,d;
+    double infSpeed,supSpeed;
+    double boatSpeed;
+    const int k1=row.k1;
+    const int k2=row.k2;
+    const double windSpeed=row.windSpeed;
+
+    angle=qAbs(angle);
+    if(angle>twa.last()) angle=twa.last();
+    if(angle<twa.first()) angle=twa.first();
+    i2=qLowerBound(twa.constBegin(),twa.constEnd(),angle)-twa.constBegin();
+    if(i2==twa.count())
+        i2=twa.count()-1;
+    if(twa[i2]==angle)
+        i1=i2;
+    else
+        i1=i2-1;
+    a=polar_data[tws.count()*i1+k1];
+    b=polar_data[tws.count()*i2+k1];
+    c=polar_data[tws.count()*i1+k2];
+    d=polar_data[tws.count()*i2+k2];
+    if(i1==i2)
+        infSpeed=a;
+    else
+        infSpeed=a+(angle-twa[i1])*(b-a)/(twa[i2]-twa[i1]);
+    if(i1==i2)
+        supSpeed=c;
+    else
+        supSpeed=c+(angle-twa[i1])*(d-c)/(twa[i2]-twa[i1]);
+    if(supSpeed==infSpeed)
+        boatSpeed=infSpeed;
+    else
+        if(k1==k2)
+            boatSpeed=(infSpeed+supSpeed)/2.0;
         else
+            boatSpeed=infSpeed+(windSpeed-tws[k1])*(supSpeed-infSpeed)/(tws[k2]-tws[k1]);
+    if(row.useEngine && boatSpeed<row.minSpeedForEngine)
+        boatSpeed=row.speedWithEngine;
+    return boatSpeed;
+}
+
+void Polar::rowBvmgWind(const bvmgRow &row, double w_angle, double *wangle) const
+{
+    double speed=0;
+    double t_heading=0;
+    double t=0;
+    double t_max = -100;
+    double t_max2 = -100;
+    const double * cosTable=bvmgCos.constData();
+
+    for (int i=0; i<90; i++)
+    {
+        t_heading = w_angle + degToRad(((double)i));
+        speed = rowSpeed(row, A180(radToDeg(t_heading)));
+        if (speed < 0.0)
+            continue;
+        t = speed * cosTable[i];
+        if (t > t_max)
         {
-            QFileInfo info1(fileVMG);
-            QFileInfo info2(file);
-            if(this->mainWindow->isStartingUp && info1.lastModified()<info2.lastModified())
-                fileVMG.remove();
-            else
+            t_max = t;
+            *wangle = t_heading;
+        } else if ( t_max - t > (t_max/20.0))
+            break;
+    }
+    for (int i=0; i<90; i++)
+    {
+        t_heading = w_angle - degToRad(((double)i));
+        speed = rowSpeed(row, A180(radToDeg(t_heading)));
+        if (speed < 0.0)
+            continue;
+        t = speed * cosTable[i];
+        if (t > t_max2)
+        {
+          t_max2 = t;
+          if (t > t_max)
+          {
+            t_max = t;
+            *wangle = t_heading;
+          }
+        } else if (t_max2 - t > (t_max2/20.0))
+            break;
+    }
+}
+
+/* binary best-VMG cache: fixed header followed by BVMG_TWS_COUNT*BVMG_TWA_COUNT quint16 (twa*10, native byte order) */
+struct bvmgHeader
+{
+    char    magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint32 twsCount;
+    quint32 twaCount;
+    double  coeffPolar;
+    unsigned char digest[20];
+    quint32 useEngine;
+    double  minSpeedForEngine;
+    double  speedWithEngine;
+    char    reserved[8];
+};
+
+bool Polar::polarDigest(const QString &fileName, unsigned char * digest) const
+{
+    QFile f(fileName);
+    if(!f.open(QIODevice::ReadOnly))
+        return false;
+    QByteArray content=f.readAll();
+    f.close();
+    SHA1 sha1;
+    sha1.addBytes(content.constData(),content.size());
+    unsigned char * res=sha1.getDigest();
+    if(!res)
+        return false;
+    memcpy(digest,res,20);
+    free(res);
+    return true;
+}
+
+bool Polar::loadBvmgCache(const unsigned char * digest)
+{
+    if(!fileBvmg.open(QIODevice::ReadOnly))
+        return false;
+    const qint64 expectedSize=sizeof(bvmgHeader)+BVMG_TWS_COUNT*BVMG_TWA_COUNT*sizeof(quint16);
+    if(fileBvmg.size()==expectedSize)
+    {
+        bvmgHeader header;
+        if(fileBvmg.read((char*)&header,sizeof(bvmgHeader))==sizeof(bvmgHeader)
+                && memcmp(header.magic,BVMG_MAGIC,8)==0
+                && header.version==BVMG_VERSION
+                && header.byteOrder==0x01020304
+                && header.twsCount==BVMG_TWS_COUNT
+                && header.twaCount==BVMG_TWA_COUNT
+                && header.coeffPolar==coeffPolar
+                && memcmp(header.digest,digest,20)==0
+                && header.useEngine==(engineEnabled?1:0)
+                && header.minSpeedForEngine==engineMinSpeed
+                && header.speedWithEngine==engineSpeed)
+        {
+            uchar * data=fileBvmg.map(sizeof(bvmgHeader),BVMG_TWS_COUNT*BVMG_TWA_COUNT*sizeof(quint16));
+            if(data)
+            {
+                bvmgTable=(const quint16 *)data;
+                return true;
+            }
+            /* no mmap on this platform, read it in memory */
+            bvmgBuffer.resize(BVMG_TWS_COUNT*BVMG_TWA_COUNT);
+            qint64 len=BVMG_TWS_COUNT*BVMG_TWA_COUNT*sizeof(quint16);
+            if(fileBvmg.read((char*)bvmgBuffer.data(),len)==len)
             {
-                file.close();
-                return;
+                fileBvmg.close();
+                bvmgTable=bvmgBuffer.constData();
+                return true;
             }
+            bvmgBuffer.clear();
         }
     }
-    file.close();
-//precalculate regular VMGs
-    //qWarning() << "Start computing vmg";
-    fileVMG.open(QIODevice::WriteOnly | QIODevice::Text );
-    double vmg=0;
-    QTextStream sVmg(&fileVMG);
-    QString ssVmg;
-    QProgressDialog * progress;
-    progress=new QProgressDialog((QWidget*)mainWindow);
-    progress->setWindowModality(Qt::ApplicationModal);
-    progress->setLabelText(tr("Pre-calcul des valeurs de VMG pour ")+fname);
-    progress->setMaximum(600);
-    progress->setMinimum(0);
-    progress->setCancelButton(NULL);
-    progress->setMaximumHeight(100);
-    progress->show();
-    for (int tws=0;tws<601;tws++)
-    {
-        progress->setValue(tws);
-        for (int twa=0;twa<1801;twa++)
-        {
-            bvmgWind((double) twa/10.0,(double) tws/10.0,&vmg);
-            ssVmg.sprintf("%.4d",qRound(A360(vmg)*10.0));
-            sVmg<<ssVmg;
-        }
+    fileBvmg.close();
+    return false;
+}
+
+void Polar::saveBvmgCache(const unsigned char * digest)
+{
+    bvmgHeader header;
+    memset(&header,0,sizeof(bvmgHeader));
+    memcpy(header.magic,BVMG_MAGIC,8);
+    header.version=BVMG_VERSION;
+    header.byteOrder=0x01020304;
+    header.twsCount=BVMG_TWS_COUNT;
+    header.twaCount=BVMG_TWA_COUNT;
+    header.coeffPolar=coeffPolar;
+    memcpy(header.digest,digest,20);
+    header.useEngine=engineEnabled?1:0;
+    header.minSpeedForEngine=engineMinSpeed;
+    header.speedWithEngine=engineSpeed;
+    if(!fileBvmg.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning()<<"could not write vmg cache"<<fileBvmg.fileName();
+        return;
+    }
+    qint64 len=BVMG_TWS_COUNT*BVMG_TWA_COUNT*sizeof(quint16);
+    bool ok=fileBvmg.write((const char*)&header,sizeof(bvmgHeader))==sizeof(bvmgHeader)
+            && fileBvmg.write((const char*)bvmgBuffer.constData(),len)==len;
+    fileBvmg.close();
+    if(!ok)
+    {
+        qWarning()<<"could not write vmg cache"<<fileBvmg.fileName();
+        fileBvmg.remove();
     }
-    fileVMG.close();
-    if(!fileVMG.open(QIODevice::ReadOnly | QIODevice::Text ))
-        qWarning()<<"fileVMG could not be re-opened!";
-    progress->close();
-    delete progress;
 }
 
 void Polar::printPolar(void)
@@ -362,10 +660,10 @@ double Polar::getBvmgUp(double windSpeed, bool engine)
         angle=best_vmg_up.first();
     else
         angle=best_vmg_up.last();
-    if(engine && this->mainWindow->getSelectedBoat() && this->mainWindow->getSelectedBoat()->getMinSpeedForEngine()>0)
+    if(engine && engineEnabled && engineMinSpeed>0)
     {
         double bs=this->myGetSpeed(windSpeed,angle,false);
-        if(bs<this->mainWindow->getSelectedBoat()->getMinSpeedForEngine())
+        if(bs<engineMinSpeed)
             angle=0;
     }
     return angle;
@@ -384,10 +682,10 @@ double Polar::getBvmgDown(double windSpeed, bool engine)
         angle=best_vmg_up.first();
     else
         angle=best_vmg_down.last();
-    if(engine && this->mainWindow->getSelectedBoat() && this->mainWindow->getSelectedBoat()->getMinSpeedForEngine()>0)
+    if(engine && engineEnabled && engineMinSpeed>0)
     {
         double bs=this->getSpeed(windSpeed,angle,false);
-        if(bs<this->mainWindow->getSelectedBoat()->getMinSpeedForEngine())
+        if(bs<engineMinSpeed)
             angle=180;
     }
     return angle;
@@ -396,18 +694,108 @@ double Polar::getBvmgDown(double windSpeed, bool engine)
 double Polar::getSpeed(double windSpeed, double angle, bool engine,bool * engineUsed)
 {
     if(windSpeed<0) return 0;
-    double bs=myGetSpeed(windSpeed,angle,false);
+    double bs=lattice?latticeSpeed(windSpeed,angle):myGetSpeed(windSpeed,angle,false);
     if(engineUsed!=NULL)
         *engineUsed=false;
-    if(engine && mainWindow->getSelectedBoat() && bs<this->mainWindow->getSelectedBoat()->getMinSpeedForEngine())
+    if(engine && engineEnabled && bs<engineMinSpeed)
     {
-        bs=this->mainWindow->getSelectedBoat()->getSpeedWithEngine();
+        bs=engineSpeed;
         if(engineUsed!=NULL)
             *engineUsed=true;
     }
     return bs;
 }
 
+/* speed lattice: the polar is resampled at load every LATTICE_TWS_STEP kts and every LATTICE_TWA_STEP deg,
+ * a lookup is then two index computations and one bilinear blend. As the polar itself is bilinear between
+ * its points, the result is exact when the points of the polar file fall on the lattice */
+void Polar::buildLattice()
+{
+    if(lattice)
+        qFreeAligned(lattice);
+    lattice=NULL;
+    latticeTwsCount=qMax(2,qCeil(tws.last()/LATTICE_TWS_STEP)+1);
+    latticeTwaCount=qRound(180.0/LATTICE_TWA_STEP)+1;
+    /* one row per tws, padded to a whole number of cache lines */
+    latticeRowSize=((latticeTwaCount*sizeof(float)+63)/64)*64/sizeof(float);
+    lattice=(float *) qMallocAligned(latticeTwsCount*latticeRowSize*sizeof(float),64);
+    if(!lattice)
+        return;
+    for(int s=0;s<latticeTwsCount;++s)
+    {
+        float * row=lattice+s*latticeRowSize;
+        for(int a=0;a<latticeTwaCount;++a)
+            row[a]=myGetSpeed(s*LATTICE_TWS_STEP,a*LATTICE_TWA_STEP,true);
+        for(int a=latticeTwaCount;a<latticeRowSize;++a)
+            row[a]=row[latticeTwaCount-1];
+    }
+    latticeExact=true;
+    foreach(double ws,tws)
+    {
+        if(qAbs(ws/LATTICE_TWS_STEP-qRound(ws/LATTICE_TWS_STEP))>1e-6)
+            latticeExact=false;
+    }
+    foreach(double wa,twa)
+    {
+        if(qAbs(wa/LATTICE_TWA_STEP-qRound(wa/LATTICE_TWA_STEP))>1e-6)
+            latticeExact=false;
+    }
+}
+
+double Polar::latticeSpeed(double windSpeed, double angle) const
+{
+    angle=qAbs(angle);
+    if(windSpeed>tws.last()) windSpeed=tws.last();
+    if(windSpeed<tws.first()) windSpeed=tws.first();
+    if(angle>twa.last()) angle=twa.last();
+    if(angle<twa.first()) angle=twa.first();
+    double fs=windSpeed/LATTICE_TWS_STEP;
+    double fa=angle/LATTICE_TWA_STEP;
+    int s=qMin((int) fs,latticeTwsCount-2);
+    int a=qMin((int) fa,latticeTwaCount-2);
+    fs-=s;
+    fa-=a;
+    const float * r0=lattice+s*latticeRowSize+a;
+    const float * r1=r0+latticeRowSize;
+    double inf=r0[0]+fa*(r0[1]-r0[0]);
+    double sup=r1[0]+fa*(r1[1]-r1[0]);
+    return inf+fs*(sup-inf);
+}
+
+/* scan vs lattice lookups on random points, logged when the "polarBenchmark" setting is 1 */
+void Polar::benchmarkLattice()
+{
+    const int nb=2000000;
+    QVector<double> ws(nb),wa(nb);
+    qsrand(1);
+    for(int n=0;n<nb;++n)
+    {
+        ws[n]=tws.last()*qrand()/(double)RAND_MAX;
+        wa[n]=360.0*qrand()/(double)RAND_MAX-180.0;
+    }
+    float * saved=lattice;
+    lattice=NULL;
+    buildLattice();
+    QTime t;
+    t.start();
+    double sum1=0;
+    for(int n=0;n<nb;++n)
+        sum1+=myGetSpeed(ws.at(n),wa.at(n),true);
+    int msecsScan=t.elapsed();
+    t.start();
+    double sum2=0;
+    for(int n=0;n<nb;++n)
+        sum2+=latticeSpeed(ws.at(n),wa.at(n));
+    int msecsLattice=t.elapsed();
+    double maxErr=0;
+    for(int n=0;n<nb;++n)
+        maxErr=qMax(maxErr,qAbs(myGetSpeed(ws.at(n),wa.at(n),true)-latticeSpeed(ws.at(n),wa.at(n))));
+    qWarning()<<"polar benchmark"<<name<<nb<<"lookups: scan"<<msecsScan<<"ms, lattice"<<msecsLattice
+              <<"ms, max error"<<maxErr<<"kts"<<(latticeExact?"(exact lattice)":"")<<"checksum"<<sum1-sum2;
+    qFreeAligned(lattice);
+    lattice=saved;
+}
+
 double Polar::myGetSpeed(double windSpeed, double angle, bool force)
 {
     //qWarning() << "My get speed";
@@ -551,12 +939,14 @@ void Polar::getBvmg(double twaOrtho, double tws, double *twaVMG)
         babord=!babord;
         twaOrtho=360-twaOrtho;
     }
-    twaOrtho=twaOrtho*10.0;
-    char data[5];
-    fileVMG.seek(qRound(tws*10)*4*1801+qRound(twaOrtho)*4);
-    fileVMG.read(data,4);
-    data[4]='\0';
-    twa=atoi(data);
+    if(!bvmgTable)
+    {
+        *twaVMG=0;
+        return;
+    }
+    int twsIdx=qBound(0,qRound(tws*10),BVMG_TWS_COUNT-1);
+    int twaIdx=qBound(0,qRound(twaOrtho*10.0),BVMG_TWA_COUNT-1);
+    twa=bvmgTable[twsIdx*BVMG_TWA_COUNT+twaIdx];
 //    if(twa>3600)
 //        qWarning()<<"lol";
     twa=twa/10.0;
@@ -636,7 +1026,7 @@ void Polar::myBvmgWind(double w_angle, double w_speed, double *wangle)
     }
 }
 
-double Polar::A180(double angle)
+double Polar::A180(double angle) const
 {
     if(qAbs(angle)>180)
     {
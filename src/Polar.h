@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cmath>
 #include <QFile>
 #include <QMutex>
+#include <QVector>
 
 #include "inetClient.h"
 
@@ -38,11 +39,36 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define degToRad(angle) (((angle)/180.0) * PI)
 #define radToDeg(angle) (((angle)*180.0) / PI)
 
+/* best-VMG table: tws 0..60kts and twa 0..180deg, both by 0.1 */
+#define BVMG_TWS_COUNT 601
+#define BVMG_TWA_COUNT 1801
+#define BVMG_MAGIC     "QVLMBVMG"
+#define BVMG_VERSION   2
+
+/* resolution of the polar speed lattice */
+#define LATTICE_TWS_STEP 0.1
+#define LATTICE_TWA_STEP 0.5
+
+class Polar;
+
+/* one tws row of the best-VMG precompute, with the engine parameters captured up front */
+struct bvmgRow
+{
+    const Polar * polar;
+    quint16 * out;
+    double windSpeed;
+    int k1,k2;
+    bool useEngine;
+    double minSpeedForEngine;
+    double speedWithEngine;
+};
+
 class Polar : public QObject
 {Q_OBJECT
     public:
         Polar(MainWindow * mainWindow);
         Polar(QString fname,MainWindow * mainWindow);
+        ~Polar();
 
         QString getName() { if(loaded) return name; else return ""; }
         double   getSpeed(double windSpeed, double angle, bool engine=true, bool * engineUsed=NULL);
@@ -59,6 +85,9 @@ class Polar : public QObject
         void    bvmgWind(double w_angle, double w_speed,double *wangle);
         void    getBvmg(double twaOrtho,double tws,double *twa);
 
+    public slots:
+        void    slot_updateEngine();
+
     private:
         MainWindow * mainWindow;
         QList<double> polar_data;
@@ -80,11 +109,33 @@ class Polar : public QObject
         void    printPolar(void);
         double   maxSpeed;
         bool    isCsv;
-        double   A180(double angle);
+        double   A180(double angle) const;
         void    myBvmgWind(double w_angle, double w_speed,double *wangle);
         double  A360(double hdg);
-        QFile   fileVMG;
+        QFile   fileBvmg;
+        QString polarFileName;
+        QVector<quint16> bvmgBuffer;
+        const quint16 * bvmgTable;
+        void    loadBvmgTable();
+        void    releaseBvmgTable();
+        bool    polarDigest(const QString &fileName, unsigned char * digest) const;
+        bool    loadBvmgCache(const unsigned char * digest);
+        void    saveBvmgCache(const unsigned char * digest);
+        QVector<double> bvmgCos;
+        void    computeBvmgTable();
+        static void computeBvmgRow(bvmgRow &row);
+        double  rowSpeed(const bvmgRow &row, double angle) const;
+        void    rowBvmgWind(const bvmgRow &row, double w_angle, double *wangle) const;
         double  coeffPolar;
+        bool    engineEnabled;
+        double  engineMinSpeed;
+        double  engineSpeed;
+        float * lattice;
+        int     latticeTwsCount,latticeTwaCount,latticeRowSize;
+        bool    latticeExact;
+        void    buildLattice();
+        double  latticeSpeed(double windSpeed, double angle) const;
+        void    benchmarkLattice();
 };
 Q_DECLARE_TYPEINFO(Polar,Q_MOVABLE_TYPE);
 
@@ -41,6 +41,7 @@ Copyright (C) 2008 - Jacques Zaninetti - http://zygrib.free.fr
 #include "Projection.h"
 #include "mycentralwidget.h"
 #include "GshhsReader.h"
+#include "GshhsTileCache.h"
 #include "loadImg.h"
 #include "Orthodromie.h"
 #include "MyView.h"
@@ -114,6 +115,7 @@ Terrain::Terrain(myCentralWidget *centralWidget, Projection *proj_) : QGraphicsW
 
     gshhsReader = NULL;
     gisReader = NULL;
+    tileCache = new GshhsTileCache();
 
     setPalette(QPalette(backgroundColor));
     int sX=Settings::getSetting("scalePosX",5).toInt();
@@ -122,6 +124,11 @@ Terrain::Terrain(myCentralWidget *centralWidget, Projection *proj_) : QGraphicsW
     updateGraphicsParameters();    
 }
 
+Terrain::~Terrain()
+{
+    delete tileCache;
+}
+
 //-------------------------------------------
 void Terrain::updateGraphicsParameters()
 {
@@ -162,6 +169,7 @@ void Terrain::updateGraphicsParameters()
 void Terrain::setGSHHS_map(GshhsReader *map)
 {
     gshhsReader = map;
+    tileCache->clear();
     /* new gshhs => reload gis */
     if(gisReader)
     {
@@ -232,7 +240,7 @@ void Terrain::draw_GSHHSandGRIB()
             QTime t;
             t.start();
 #endif
-            gshhsReader->drawContinents(pnt1, proj, transparentColor, landColor);
+            tileCache->drawContinents(pnt1, proj, gshhsReader, transparentColor, landColor);
 #ifdef traceTime
         qWarning()<<"time to draw continents"<<t.elapsed();
 #endif
@@ -39,6 +39,7 @@ class Terrain : public QGraphicsWidget
 
 public:
     Terrain(myCentralWidget *centralWidget, Projection *proj);
+    ~Terrain();
 
     void  setGSHHS_map(GshhsReader *map);
     void setColorMapMode(int mode);
@@ -105,6 +106,7 @@ private:
     //-----------------------------------------------
     GshhsReader *gshhsReader;
     GisReader   *gisReader;
+    GshhsTileCache *tileCache;
     Projection  *proj;
     myCentralWidget *centralWidget;
 
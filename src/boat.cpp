@@ -488,7 +488,7 @@ void boat::drawEstime(double myHeading, double mySpeed)
         {
             //qWarning("crossing (%.5f,%.5f,%.5f,%.5f) (%.5f,%.5f,%.5f,%.5f)",I1,J1,I2,J2,lon,lat,tmp_lon,tmp_lat);
             //qWarning("estime=%.5f, myHeading=%.5f",estime,myHeading);
-            if(estime>0.0001 && map->crossing(QLineF(I1,J1,I2,J2),QLineF(lon,lat,tmp_lon,tmp_lat)))
+            if(estime>0.0001 && map->crossing(QLineF(lon,lat,tmp_lon,tmp_lat)))
             {
                 estimeTimer->start();
                 penLine1.setColor(Qt::red);
@@ -925,6 +925,12 @@ bool boat::cross(QLineF line) {
     return false;
 }
 
+void boat::appendBarrierSegments(QList<QLineF> * segments) {
+    QList<BarrierSet*>::const_iterator i;
+    for(i=barrierSets.constBegin();i<barrierSets.constEnd();++i)
+        (*i)->appendSegments(segments);
+}
+
 /**************************/
 /* Events                 */
 /**************************/
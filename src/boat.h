@@ -129,6 +129,7 @@ class boat: public QGraphicsWidget
         void setSetKeys(QList<QString> keys) { barrierKeys = keys; }
         void cleanBarrierList(void);
         bool cross(QLineF line);
+        void appendBarrierSegments(QList<QLineF> * segments);
 
 public slots:
         void slot_projectionUpdated();
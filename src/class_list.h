@@ -79,12 +79,18 @@ class DialogFinePosit;
 /* GisReader.h */
 class GisReader;
 
+/* GshhsTileCache.h */
+class GshhsTileCache;
+
 /* Grib.h */
 class MapDataDrawer;
+class GribScreenLookup;
 class DataManager;
 class Grib;
 class GribV2;
 class GribRecord;
+class GribSampler;
+class GribLoader;
 class GribV1Record;
 class GribV2Record;
 class DataColors;
@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 
 #include <QDebug>
+#include <QVector>
 
 #include <complex>
 #include "dataDef.h"
@@ -108,29 +109,29 @@ typedef complex<double> dcmplx;
 void interpolation::get_wind_info_latlong_TWSA_compute(double longitude,  double latitude, windData * data,
                                         double lat_step, double lon_step, double * u_res,
                                         double * v_res,bool UV,int /*debug*/)
+{
+    windCorners corners;
+    prepare_corners(data,INTERPOLATION_TWSA,UV,&corners);
+    blend_TWSA(longitude,latitude,&corners,lat_step,lon_step,u_res,v_res);
+}
+
+void interpolation::blend_TWSA(double longitude,double latitude,const windCorners * corners,
+                               double lat_step,double lon_step,double * u_res,double * v_res)
 {
     double u0,u1,u2,u3,v0,v1,v2,v3;
     double u01,u23,v01,v23;
     double u,v;
-#if OLD_C
-    double t_speed;
-#else
-    dcmplx c;
-#endif
-
-
-
     double d_long,d_lat;
     double angle;
 
-    u0=data->u0;
-    u1=data->u1;
-    u2=data->u2;
-    u3=data->u3;
-    v0=data->v0;
-    v1=data->v1;
-    v2=data->v2;
-    v3=data->v3;
+    u0=corners->u0;
+    u1=corners->u1;
+    u2=corners->u2;
+    u3=corners->u3;
+    v0=corners->v0;
+    v1=corners->v1;
+    v2=corners->v2;
+    v3=corners->v3;
 
     d_long = longitude; /* is there a +180 drift? see grib */
     if (d_long < 0) {
@@ -143,21 +144,6 @@ void interpolation::get_wind_info_latlong_TWSA_compute(double longitude,  double
     d_long = d_long/lon_step;
     d_lat = d_lat/lat_step;
 
-    /* we reuse u = speed v = angle after conversion */
-
-    if(UV) {
-        _transform_u_v(u0, v0);
-        _transform_u_v(u1, v1);
-        _transform_u_v(u2, v2);
-        _transform_u_v(u3, v3);
-    }
-    else {
-        _chk_angle(v0);
-        _chk_angle(v1);
-        _chk_angle(v2);
-        _chk_angle(v3);
-    }
-
     /* speed interpolation */
     u01 = u0 + (u1 - u0) * (d_lat - floor(d_lat));
     u23 = u2 + (u3 - u2) * (d_lat - floor(d_lat));
@@ -326,6 +312,35 @@ void interpolation::get_wind_info_latlong_selective_TWSA(double longitude,  doub
 
 void interpolation::get_wind_info_latlong_selective_TWSA_compute(double longitude,  double latitude, windData * data,
                                   double lat_step, double lon_step,double * u_res, double * v_res, int * rot,bool UV,int debug)
+{
+    windCorners corners;
+
+    if(debug)
+    {
+        qWarning("Donnée IN (step=%f)\n",lat_step);
+        qWarning("Lat= %f, Lon= %f\n",latitude,longitude);
+        qWarning("P0: u= %f, v= %f\n",data->u0,data->v0);
+        qWarning("P1: u= %f, v= %f\n",data->u1,data->v1);
+        qWarning("P2: u= %f, v= %f\n",data->u2,data->v2);
+        qWarning("P3: u= %f, v= %f\n",data->u3,data->v3);
+    }
+
+    prepare_corners(data,INTERPOLATION_SELECTIVE_TWSA,UV,&corners);
+
+    if(debug)
+    {
+        qWarning("\nAprès transfo en Complexe\n");
+        qWarning("P0: vit= %f, ang= %f\n",corners.u0,corners.v0);
+        qWarning("P1: vit= %f, ang= %f\n",corners.u1,corners.v1);
+        qWarning("P2: vit= %f, ang= %f\n",corners.u2,corners.v2);
+        qWarning("P3: vit= %f, ang= %f\n",corners.u3,corners.v3);
+    }
+
+    blend_selective_TWSA(longitude,latitude,&corners,lat_step,lon_step,u_res,v_res,rot,debug);
+}
+
+void interpolation::blend_selective_TWSA(double longitude,double latitude,const windCorners * corners,
+                                         double lat_step,double lon_step,double * u_res,double * v_res,int * rot,int debug)
 {
     double u0,u1,u2,u3,v0,v1,v2,v3;
     double u01,u23,v01,v23;
@@ -339,14 +354,14 @@ void interpolation::get_wind_info_latlong_selective_TWSA_compute(double longitud
     double angle;
     int rot_step1a, rot_step1b, rot_step2;
 
-    u0=data->u0;
-    u1=data->u1;
-    u2=data->u2;
-    u3=data->u3;
-    v0=data->v0;
-    v1=data->v1;
-    v2=data->v2;
-    v3=data->v3;
+    u0=corners->u0;
+    u1=corners->u1;
+    u2=corners->u2;
+    u3=corners->u3;
+    v0=corners->v0;
+    v1=corners->v1;
+    v2=corners->v2;
+    v3=corners->v3;
 
     d_long = longitude; /* is there a +180 drift? see grib */
     if (d_long < 0) {
@@ -356,42 +371,9 @@ void interpolation::get_wind_info_latlong_selective_TWSA_compute(double longitud
     }
     d_lat = latitude + 90; /* is there a +90 drift? see grib*/
 
-    if(debug)
-    {
-        qWarning("Donnée IN (step=%f)\n",lat_step);
-        qWarning("Lat= %f (=> %f ), Lon= %f (=> %f )\n",latitude,d_lat,longitude,d_long);
-        qWarning("grid : lat= %f, Lon= %f\n",floor(d_lat),floor(d_long));
-        qWarning("P0: u= %f, v= %f\n",u0,v0);
-        qWarning("P1: u= %f, v= %f\n",u1,v1);
-        qWarning("P2: u= %f, v= %f\n",u2,v2);
-        qWarning("P3: u= %f, v= %f\n",u3,v3);
-    }
-
     d_long = d_long/lon_step;
     d_lat = d_lat/lat_step;
 
-    if(UV) {
-        _transform_u_v(u0, v0);
-        _transform_u_v(u1, v1);
-        _transform_u_v(u2, v2);
-        _transform_u_v(u3, v3);
-    }
-    else {
-        _chk_angle(v0);
-        _chk_angle(v1);
-        _chk_angle(v2);
-        _chk_angle(v3);
-    }
-
-    if(debug)
-    {
-        qWarning("\nAprès transfo en Complexe\n");
-        qWarning("P0: vit= %f, ang= %f\n",u0,v0);
-        qWarning("P1: vit= %f, ang= %f\n",u1,v1);
-        qWarning("P2: vit= %f, ang= %f\n",u2,v2);
-        qWarning("P3: vit= %f, ang= %f\n",u3,v3);
-    }
-
     /* speed interpolation */
     u01 = u0 + (u1 - u0) * (d_lat - floor(d_lat));
     u23 = u2 + (u3 - u2) * (d_lat - floor(d_lat));
@@ -615,6 +597,24 @@ void interpolation::get_wind_info_latlong_hybrid_compute(double longitude,  doub
                       double lat_step, double lon_step, double * u_res, double * v_res, double * ro_res,
                                                          double gridOriginLat,double gridOriginLon,
                                                          bool UV,int debug)
+{
+    windCorners corners;
+
+    if(debug)
+    {
+        qWarning("P0: u0= %f, v0= %f",data->u0,data->v0);
+        qWarning("P1: u1= %f, v1= %f",data->u1,data->v1);
+        qWarning("P2: u2= %f, v2= %f",data->u2,data->v2);
+        qWarning("P3: u3= %f, v3= %f",data->u3,data->v3);
+    }
+
+    prepare_corners(data,INTERPOLATION_HYBRID,UV,&corners);
+    blend_hybrid(longitude,latitude,&corners,lat_step,lon_step,u_res,v_res,ro_res,gridOriginLat,gridOriginLon,debug);
+}
+
+void interpolation::blend_hybrid(double longitude,double latitude,const windCorners * corners,
+                                 double lat_step,double lon_step,double * u_res,double * v_res,double * ro_res,
+                                 double gridOriginLat,double gridOriginLon,int debug)
 {
     double u0,u1,u2,u3,v0,v1,v2,v3;
     double ro0,ro1,ro2,ro3;
@@ -624,14 +624,18 @@ void interpolation::get_wind_info_latlong_hybrid_compute(double longitude,  doub
     double ro;
     double d_long,d_lat;
 
-    u0=data->u0;
-    u1=data->u1;
-    u2=data->u2;
-    u3=data->u3;
-    v0=data->v0;
-    v1=data->v1;
-    v2=data->v2;
-    v3=data->v3;
+    u0=corners->u0;
+    u1=corners->u1;
+    u2=corners->u2;
+    u3=corners->u3;
+    v0=corners->v0;
+    v1=corners->v1;
+    v2=corners->v2;
+    v3=corners->v3;
+    ro0=corners->ro0;
+    ro1=corners->ro1;
+    ro2=corners->ro2;
+    ro3=corners->ro3;
 
     double ratioLat,ratioLon;
 #ifdef __QTVLM_WITH_TEST
@@ -675,10 +679,6 @@ void interpolation::get_wind_info_latlong_hybrid_compute(double longitude,  doub
         qWarning("Lat= %f (=> %f ), Lon= %f (=> %f )",latitude,d_lat,longitude,d_long);
         qWarning("grid : Lat= %f, Lon= %f",gridOriginLat,gridOriginLon);
         qWarning("ratios : Lat= %f, Lon= %f",ratioLat,ratioLon);
-        qWarning("P0: u0= %f, v0= %f",u0,v0);
-        qWarning("P1: u1= %f, v1= %f",u1,v1);
-        qWarning("P2: u2= %f, v2= %f",u2,v2);
-        qWarning("P3: u3= %f, v3= %f",u3,v3);
     }
 #ifdef __QTVLM_WITH_TEST
     if(qAbs(ratioLonDebug-ratioLon)>10e-10 || qAbs(ratioLatDebug-ratioLat)>10e-10)
@@ -700,26 +700,6 @@ void interpolation::get_wind_info_latlong_hybrid_compute(double longitude,  doub
 
     }
 #endif
-    /*
-      simple bilinear interpolation, we might factor the cos(lat) in
-      the computation to tackle the shape of the pseudo square
-
-      Doing interpolation on angle/speed might be better
-    */
-
-    if(UV) {
-        _speed_u_v(u0, v0, ro0);
-        _speed_u_v(u1, v1, ro1);
-        _speed_u_v(u2, v2, ro2);
-        _speed_u_v(u3, v3, ro3);
-    }
-    else {
-        SA_2_UV(u0,v1,ro0);
-        SA_2_UV(u1,v1,ro1);
-        SA_2_UV(u2,v2,ro2);
-        SA_2_UV(u3,v3,ro3);
-    }
-
     /* UV for geting the angle without too much hashing */
     u01 = u0 + (u1 - u0) * ratioLat;
     v01 = v0 + (v1 - v0) * ratioLat;
@@ -747,3 +727,187 @@ void interpolation::get_wind_info_latlong_hybrid_compute(double longitude,  doub
     *v_res=v;
     *ro_res=ro;
 }
+
+/*******************/
+/* batch of points */
+/*******************/
+
+void interpolation::prepare_corners(const windData * data,int interpolation_type,bool UV,windCorners * corners)
+{
+    double u0,u1,u2,u3,v0,v1,v2,v3;
+    double ro0=0,ro1=0,ro2=0,ro3=0;
+#if OLD_C
+    double t_speed;
+#else
+    dcmplx c;
+#endif
+
+    u0=data->u0;
+    u1=data->u1;
+    u2=data->u2;
+    u3=data->u3;
+    v0=data->v0;
+    v1=data->v1;
+    v2=data->v2;
+    v3=data->v3;
+
+    if(interpolation_type==INTERPOLATION_HYBRID) {
+        /*
+          simple bilinear interpolation, we might factor the cos(lat) in
+          the computation to tackle the shape of the pseudo square
+
+          Doing interpolation on angle/speed might be better
+        */
+        if(UV) {
+            _speed_u_v(u0, v0, ro0);
+            _speed_u_v(u1, v1, ro1);
+            _speed_u_v(u2, v2, ro2);
+            _speed_u_v(u3, v3, ro3);
+        }
+        else {
+            SA_2_UV(u0,v1,ro0);
+            SA_2_UV(u1,v1,ro1);
+            SA_2_UV(u2,v2,ro2);
+            SA_2_UV(u3,v3,ro3);
+        }
+    }
+    else {
+        /* we reuse u = speed v = angle after conversion */
+        if(UV) {
+            _transform_u_v(u0, v0);
+            _transform_u_v(u1, v1);
+            _transform_u_v(u2, v2);
+            _transform_u_v(u3, v3);
+        }
+        else {
+            _chk_angle(v0);
+            _chk_angle(v1);
+            _chk_angle(v2);
+            _chk_angle(v3);
+        }
+    }
+
+    corners->u0=u0;
+    corners->u1=u1;
+    corners->u2=u2;
+    corners->u3=u3;
+    corners->v0=v0;
+    corners->v1=v1;
+    corners->v2=v2;
+    corners->v3=v3;
+    corners->ro0=ro0;
+    corners->ro1=ro1;
+    corners->ro2=ro2;
+    corners->ro3=ro3;
+}
+
+/* space blend of all the points for each date, then time blend in a second pass */
+bool interpolation::get_wind_info_batch(int interpolation_type,int count,const double * longitude,const double * latitude,
+                                        time_t now,time_t t1,time_t t2,
+                                        const windCorners * const * prev,const windCorners * const * nxt,
+                                        const windGrid &grid_prev,const windGrid &grid_nxt,
+                                        double * u_res,double * v_res)
+{
+    if(interpolation_type!=INTERPOLATION_TWSA && interpolation_type!=INTERPOLATION_SELECTIVE_TWSA
+            && interpolation_type!=INTERPOLATION_HYBRID)
+        return false;
+    if(count<=0)
+        return true;
+
+    int nbDates=nxt?2:1;
+    QVector<double> u_t(2*count),v_t(2*count),ro_t(2*count);
+    QVector<int> rot_t(2*count);
+    for(int d=0;d<nbDates;++d) {
+        const windCorners * const * corners=(d==0)?prev:nxt;
+        const windGrid &grid=(d==0)?grid_prev:grid_nxt;
+        double * u=u_t.data()+d*count;
+        double * v=v_t.data()+d*count;
+        double * ro=ro_t.data()+d*count;
+        int * rot=rot_t.data()+d*count;
+        switch(interpolation_type) {
+            case INTERPOLATION_TWSA:
+                for(int k=0;k<count;++k)
+                    blend_TWSA(longitude[k],latitude[k],corners[k],grid.lat_step,grid.lon_step,&u[k],&v[k]);
+                break;
+            case INTERPOLATION_SELECTIVE_TWSA:
+                for(int k=0;k<count;++k)
+                    blend_selective_TWSA(longitude[k],latitude[k],corners[k],grid.lat_step,grid.lon_step,
+                                         &u[k],&v[k],&rot[k],0);
+                break;
+            case INTERPOLATION_HYBRID:
+                for(int k=0;k<count;++k)
+                    blend_hybrid(longitude[k],latitude[k],corners[k],grid.lat_step,grid.lon_step,
+                                 &u[k],&v[k],&ro[k],grid.originLat,grid.originLon,0);
+                break;
+        }
+    }
+
+    const double * u1=u_t.constData();
+    const double * v1=v_t.constData();
+    const double * ro1=ro_t.constData();
+    const int * rot1=rot_t.constData();
+    if(!nxt) {
+        for(int k=0;k<count;++k) {
+            if(interpolation_type==INTERPOLATION_HYBRID) {
+                double angle;
+                double ro=ro1[k];
+                _hybrid_comp(u1[k],v1[k],angle,ro);
+                u_res[k]=ro;
+                v_res[k]=angle;
+            }
+            else {
+                u_res[k]=u1[k];
+                v_res[k]=v1[k];
+            }
+        }
+        return true;
+    }
+
+    const double * u2=u1+count;
+    const double * v2=v1+count;
+    const double * ro2=ro1+count;
+    const int * rot2=rot1+count;
+    const double t_ratio = ((double)(now - t1)) / ((double)(t2 - t1));
+    for(int k=0;k<count;++k) {
+        double u,v;
+        if(interpolation_type==INTERPOLATION_HYBRID) {
+            double angle;
+            const double u_h = u1[k] + (u2[k] - u1[k]) * t_ratio;
+            const double v_h = v1[k] + (v2[k] - v1[k]) * t_ratio;
+            double ro = ro1[k] + (ro2[k] - ro1[k]) * t_ratio;
+            _hybrid_comp(u_h,v_h,angle,ro);
+            u=ro;
+            v=angle;
+        }
+        else if(interpolation_type==INTERPOLATION_TWSA
+                || (rot1[k] == rot2[k]) || (rot1[k] < 0) || (rot2[k] < 0)) {
+            u = u1[k] + (u2[k] - u1[k]) * t_ratio;
+            double angle = (v2[k] - v1[k]);
+            _check_angle_interp(angle);
+            v = v1[k] + (angle) * t_ratio;
+            _positive_angle(v);
+        }
+        else {
+#if OLD_C
+            double t_speed;
+            double uu1=u1[k],vv1=v1[k],uu2=u2[k],vv2=v2[k];
+            _transform_back_u_v(uu1, vv1);
+            _transform_back_u_v(uu2, vv2);
+            u = uu1 + (uu2 - uu1) * t_ratio;
+            v = vv1 + (vv2 - vv1) * t_ratio;
+            _transform_u_v(u, v);
+#else
+            dcmplx c, c01, c23;
+            _transform_back_u_v(u1[k], v1[k], c01);
+            _transform_back_u_v(u2[k], v2[k], c23);
+            c = c01 + (c23 - c01) * t_ratio;
+            u = abs(c);
+            v = arg(c);
+            _positive_angle(v);
+#endif
+        }
+        u_res[k]=u;
+        v_res[k]=v;
+    }
+    return true;
+}
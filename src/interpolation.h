@@ -25,6 +25,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "dataDef.h"
 
+/* corners of a grid square once converted for the blend: speed/angle
+   for (selective) TWSA, u/v plus speed (ro) for hybrid */
+struct windCorners
+{
+        double u0,u1,u2,u3;
+        double v0,v1,v2,v3;
+        double ro0,ro1,ro2,ro3;
+};
+
+/* steps and origin of the grid of a record pair */
+struct windGrid
+{
+        double lat_step,lon_step;
+        double originLat,originLon;
+};
+
 class interpolation
 {
     public:
@@ -53,6 +69,25 @@ class interpolation
 
         static void get_wind_info_latlong_hybrid_compute(double longitude,  double latitude, windData * data,double lat_step, double lon_step,
                 double * u_res, double * v_res, double * ro_res,double gridOriginLat,double gridOriginLon,bool UV,int debug);
+
+        /* batch of points of one date and one record pair: prev[k] (and nxt[k]) are the
+           corners of the square of point k, prepared once for all the points in the square.
+           Results are the ones of the point functions above */
+        static void prepare_corners(const windData * data,int interpolation_type,bool UV,windCorners * corners);
+        static bool get_wind_info_batch(int interpolation_type,int count,const double * longitude,const double * latitude,
+                                        time_t now,time_t t1,time_t t2,
+                                        const windCorners * const * prev,const windCorners * const * nxt,
+                                        const windGrid &grid_prev,const windGrid &grid_nxt,
+                                        double * u_res,double * v_res);
+
+    private:
+        static void blend_TWSA(double longitude,double latitude,const windCorners * corners,
+                               double lat_step,double lon_step,double * u_res,double * v_res);
+        static void blend_selective_TWSA(double longitude,double latitude,const windCorners * corners,
+                                         double lat_step,double lon_step,double * u_res,double * v_res,int * rot,int debug);
+        static void blend_hybrid(double longitude,double latitude,const windCorners * corners,
+                                 double lat_step,double lon_step,double * u_res,double * v_res,double * ro_res,
+                                 double gridOriginLat,double gridOriginLon,int debug);
 };
 Q_DECLARE_TYPEINFO(interpolation,Q_MOVABLE_TYPE);
 
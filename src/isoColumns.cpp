@@ -0,0 +1,167 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2008 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#include "isoColumns.h"
+#include "vlmPoint.h"
+
+#define FOR_EACH_COLUMN(DO) \
+    DO(lon) DO(lat) DO(x) DO(y) DO(convertionLon) DO(convertionLat) DO(eta) DO(origin) \
+    DO(capOrigin) DO(distOrigin) DO(capStart) DO(distStart) DO(capArrival) DO(distArrival) \
+    DO(distIso) DO(wind_angle) DO(wind_speed) DO(current_angle) DO(current_speed) \
+    DO(isDead) DO(isBroken) DO(notSimplificable)
+
+template <typename T> static void compactColumn(QVector<T> * column, const QBitArray &removed)
+{
+    int k=0;
+    for(int n=0;n<column->size();++n)
+    {
+        if(removed.testBit(n)) continue;
+        if(k!=n)
+            (*column)[k]=column->at(n);
+        ++k;
+    }
+    column->resize(k);
+}
+
+isoColumns::isoColumns()
+{
+}
+void isoColumns::clear()
+{
+#define DO_CLEAR(c) c.clear();
+    FOR_EACH_COLUMN(DO_CLEAR)
+#undef DO_CLEAR
+}
+void isoColumns::reserve(const int &size)
+{
+#define DO_RESERVE(c) c.reserve(size);
+    FOR_EACH_COLUMN(DO_RESERVE)
+#undef DO_RESERVE
+}
+/* a new row with the defaults of vlmPoint(lon,lat) */
+int isoColumns::append(const double &lon, const double &lat, const int &origin)
+{
+    this->lon.append(lon);
+    this->lat.append(lat);
+    x.append(0);
+    y.append(0);
+    convertionLon.append(lon);
+    convertionLat.append(lat);
+    eta.append(0);
+    this->origin.append(origin);
+    capOrigin.append(0);
+    distOrigin.append(0);
+    capStart.append(0);
+    distStart.append(0);
+    capArrival.append(0);
+    distArrival.append(0);
+    distIso.append(-1);
+    wind_angle.append(0);
+    wind_speed.append(0);
+    current_angle.append(0);
+    current_speed.append(-1);
+    isDead.append(false);
+    isBroken.append(false);
+    notSimplificable.append(false);
+    return this->lon.size()-1;
+}
+int isoColumns::append(const isoColumns &other, const int &n)
+{
+#define DO_APPEND(c) c.append(other.c.at(n));
+    FOR_EACH_COLUMN(DO_APPEND)
+#undef DO_APPEND
+    return lon.size()-1;
+}
+void isoColumns::append(const isoColumns &other)
+{
+#define DO_APPEND(c) c+=other.c;
+    FOR_EACH_COLUMN(DO_APPEND)
+#undef DO_APPEND
+}
+void isoColumns::replace(const int &n, const isoColumns &other, const int &m)
+{
+#define DO_REPLACE(c) c[n]=other.c.at(m);
+    FOR_EACH_COLUMN(DO_REPLACE)
+#undef DO_REPLACE
+}
+void isoColumns::removeAt(const int &n)
+{
+#define DO_REMOVE(c) c.remove(n);
+    FOR_EACH_COLUMN(DO_REMOVE)
+#undef DO_REMOVE
+}
+/* drops the rows set in removed in one pass */
+void isoColumns::remove(const QBitArray &removed)
+{
+#define DO_COMPACT(c) compactColumn(&c,removed);
+    FOR_EACH_COLUMN(DO_COMPACT)
+#undef DO_COMPACT
+}
+void isoColumns::swap(const int &a, const int &b)
+{
+#define DO_SWAP(c) qSwap(c[a],c[b]);
+    FOR_EACH_COLUMN(DO_SWAP)
+#undef DO_SWAP
+}
+/* contiguous chunks for the worker threads, in order */
+QList<isoColumns> isoColumns::split(const int &count) const
+{
+    QList<isoColumns> chunks;
+    int pp=0;
+    for (int t=1;t<=count;++t)
+    {
+        isoColumns chunk;
+        int end=pp;
+        while((double)end<(double)size()*(double)t/(double)count)
+            ++end;
+        chunk.reserve(end-pp);
+        for (;pp<end;++pp)
+            chunk.append(*this,pp);
+        chunks.append(chunk);
+    }
+    return chunks;
+}
+/* origin and isoIndex are left to the caller, they depend on the vlmLines */
+vlmPoint isoColumns::toVlmPoint(const int &n) const
+{
+    vlmPoint p(lon.at(n),lat.at(n));
+    p.x=x.at(n);
+    p.y=y.at(n);
+    p.convertionLon=convertionLon.at(n);
+    p.convertionLat=convertionLat.at(n);
+    p.eta=eta.at(n);
+    p.isStart=isStart(n);
+    p.originNb=qMax(0,origin.at(n));
+    p.capOrigin=capOrigin.at(n);
+    p.distOrigin=distOrigin.at(n);
+    p.capStart=capStart.at(n);
+    p.distStart=distStart.at(n);
+    p.capArrival=capArrival.at(n);
+    p.distArrival=distArrival.at(n);
+    p.distIso=distIso.at(n);
+    p.wind_angle=wind_angle.at(n);
+    p.wind_speed=wind_speed.at(n);
+    p.current_angle=current_angle.at(n);
+    p.current_speed=current_speed.at(n);
+    p.isDead=isDead.at(n);
+    p.isBroken=isBroken.at(n);
+    p.notSimplificable=notSimplificable.at(n);
+    return p;
+}
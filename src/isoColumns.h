@@ -0,0 +1,82 @@
+/**********************************************************************
+qtVlm: Virtual Loup de mer GUI
+Copyright (C) 2008 - Christophe Thomas aka Oxygen77
+
+http://qtvlm.sf.net
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+
+#ifndef ISOCOLUMNS_H
+#define ISOCOLUMNS_H
+
+#include <ctime>
+#include <QVector>
+#include <QList>
+#include <QBitArray>
+
+#include "class_list.h"
+
+/* the isochrones as the router works on them, one column per field and
+   the same row in each column for a point. Candidates, the isochrone
+   being built and the last accepted one live here; vlmPoints are only
+   made by toVlmPoint() when an isochrone is handed to its vlmLine.
+   origin is the row of the parent in the previous isochrone, -1 for
+   the start point */
+class isoColumns
+{
+    public:
+        isoColumns();
+        void clear();
+        void reserve(const int &size);
+        int size() const {return lon.size();}
+        bool isEmpty() const {return lon.isEmpty();}
+        bool isStart(const int &n) const {return origin.at(n)==-1;}
+
+        int append(const double &lon, const double &lat, const int &origin);
+        int append(const isoColumns &other, const int &n);
+        void append(const isoColumns &other);
+        void replace(const int &n, const isoColumns &other, const int &m);
+        void removeAt(const int &n);
+        void remove(const QBitArray &removed);
+        void swap(const int &a, const int &b);
+        QList<isoColumns> split(const int &count) const;
+        vlmPoint toVlmPoint(const int &n) const;
+
+        QVector<double> lon;
+        QVector<double> lat;
+        QVector<double> x;      /* routing frame */
+        QVector<double> y;
+        QVector<double> convertionLon;
+        QVector<double> convertionLat;
+        QVector<time_t> eta;
+        QVector<int>    origin;
+        QVector<double> capOrigin;
+        QVector<double> distOrigin;
+        QVector<double> capStart;
+        QVector<double> distStart;
+        QVector<double> capArrival;
+        QVector<double> distArrival;
+        QVector<double> distIso;
+        QVector<double> wind_angle; /* sampled when the isochrone is expanded */
+        QVector<double> wind_speed;
+        QVector<double> current_angle;
+        QVector<double> current_speed;
+        QVector<bool>   isDead;
+        QVector<bool>   isBroken;
+        QVector<bool>   notSimplificable;
+};
+Q_DECLARE_TYPEINFO(isoColumns,Q_MOVABLE_TYPE);
+
+#endif // ISOCOLUMNS_H
@@ -239,6 +239,14 @@ void jpc_initluts()
 	float u;
 	float v;
 	float t;
+	static int initialized = 0;
+
+	/* The tables never change: only the first call fills them, so that
+	  decoders running in several threads do not write them concurrently.
+	  The first call must be made before starting such threads. */
+	if (initialized) {
+		return;
+	}
 
 /* XXX - hack */
 jpc_initmqctxs();
@@ -280,6 +288,8 @@ jpc_initmqctxs();
 /* XXX - this calc is not correct */
 		jpc_refnmsedec0[i] = jpc_dbltofix(floor((u * u) * jpc_pow2i(JPC_NMSEDEC_FRACBITS) + 0.5) / jpc_pow2i(JPC_NMSEDEC_FRACBITS));
 	}
+
+	initialized = 1;
 }
 
 jpc_fix_t jpc_getsignmsedec_func(jpc_fix_t x, int bitpos)
@@ -115,7 +115,9 @@ int main(int argc, char *argv[])
     appFolder.insert("flags",dataDir+"/img/flags/");
     appFolder.insert("boatsImg",dataDir+"/img/boats/");
     appFolder.insert("grib",dataDir+"/grib/");
+    appFolder.insert("gribCache",dataDir+"/grib/cache/");
     appFolder.insert("maps",dataDir+"/maps/");
+    appFolder.insert("mapsCache",dataDir+"/maps/cache/");
     appFolder.insert("polar",dataDir+"/polar/");
     appFolder.insert("tr",appExeFolder+"/tr/");
     appFolder.insert("tracks",dataDir+"/tracks/");
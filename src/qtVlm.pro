@@ -91,9 +91,15 @@ HEADERS += Dialogs/DialogGraphicsParams.h \
     Dialogs/DialogWp.h \
     Dialogs/DialogInetProgess.h \
     GshhsReader.h \
+    GshhsTileCache.h \
     GisReader.h \
     Grib.h \
+    GribCache.h \
+    GribBlendedRecord.h \
+    GribCacheFile.h \
+    GribLoader.h \
     GribRecord.h \
+    GribSampler.h \
     inetConnexion.h \
     LoadGribFile.h \
     MainWindow.h \
@@ -125,6 +131,7 @@ HEADERS += Dialogs/DialogGraphicsParams.h \
     Point.h \
     triangulation.h \
     vlmPoint.h \
+    isoColumns.h \
     IsoLine.h \
     dataDef.h \
     boatReal.h \
@@ -248,9 +255,15 @@ SOURCES += Dialogs/DialogGraphicsParams.cpp \
     BoardVLM.cpp \
     BoardReal.cpp \
     GshhsReader.cpp \
+    GshhsTileCache.cpp \
     GisReader.cpp \
     Grib.cpp \
+    GribCache.cpp \
+    GribBlendedRecord.cpp \
+    GribCacheFile.cpp \
+    GribLoader.cpp \
     GribRecord.cpp \
+    GribSampler.cpp \
     inetConnexion.cpp \
     LoadGribFile.cpp \
     main.cpp \
@@ -281,6 +294,7 @@ SOURCES += Dialogs/DialogGraphicsParams.cpp \
     Polygon.cpp \
     Point.cpp \
     vlmPoint.cpp \
+    isoColumns.cpp \
     IsoLine.cpp \
     boatReal.cpp \
     boat.cpp \
@@ -21,6 +21,7 @@ Original code: virtual-winds.com
 ***********************************************************************/
 #include <cassert>
 #include <QDateTime>
+#include <QBitArray>
 #include <QMessageBox>
 
 
@@ -62,23 +63,33 @@ Original code: virtual-winds.com
 
 //#define HAS_ICEGATE
 #define USE_SHAPEISO
-QList<vlmPoint> ROUTAGE::findPointThreaded(const QList<vlmPoint> &list)
+isoColumns ROUTAGE::findPointThreaded(const RoutingContext &context, const isoColumns &list)
 {
-    QList<vlmPoint> result;
+    isoColumns result;
+    result.reserve(list.size());
+    const isoColumns * pIso=context.lastIso;
+    /* neighbouring candidates share grib cells, keep the cache across the whole list */
+    GribSamplerCache cache;
+    /* the neighbours of the origin bound its fan, see the orientation tests below */
+    int neighboursOf=-1;
+    bool hasM1=false,hasP1=false;
     for(int g=0;g<list.size();++g)
     {
-        vlmPoint pt=list.at(g);
-        double cap=pt.capOrigin;
-        double windAngle=pt.wind_angle;
-        double windSpeed=pt.wind_speed;
-        double lat=pt.origin->lat;
-        double lon=pt.origin->lon;
+        const int o=list.origin.at(g);
+        double cap=list.capOrigin.at(g);
+        double windAngle=pIso->wind_angle.at(o);
+        double windSpeed=pIso->wind_speed.at(o);
+        double lat=pIso->lat.at(o);
+        double lon=pIso->lon.at(o);
+        time_t eta=list.eta.at(g);
         cap=Util::A360(cap);
         double angle,newSpeed;
         double res_lon,res_lat;
         double distanceParcourue=0;
-        double current_speed=pt.current_speed;
-        double current_angle=pt.current_angle;
+        const double origin_current_speed=pIso->current_speed.at(o);
+        const double origin_current_angle=pIso->current_angle.at(o);
+        double current_speed=origin_current_speed;
+        double current_angle=origin_current_angle;
         bool bad=false;
         for(int a=0;a<=1;++a)
         {
@@ -90,22 +101,22 @@ QList<vlmPoint> ROUTAGE::findPointThreaded(const QList<vlmPoint> &list)
                 else
                     angle=angle-360;
             }
-            double limit=pt.routage->getBoat()->getPolarData()->getBvmgUp(windSpeed);
+            double limit=context.polar->getBvmgUp(windSpeed);
             if(qAbs(angle)<limit && angle!=90) //if too close to wind then use VB-VMG technique
             {
-                newSpeed=pt.routage->getBoat()->getPolarData()->getSpeed(windSpeed,limit);
+                newSpeed=context.polar->getSpeed(windSpeed,limit);
                 newSpeed=newSpeed*qAbs(cos(degToRad(limit))/cos(degToRad(qAbs(angle))));
             }
             else
             {
-                limit=pt.routage->getBoat()->getPolarData()->getBvmgDown(windSpeed);
+                limit=context.polar->getBvmgDown(windSpeed);
                 if(qAbs(angle)>limit && angle!=90)
                 {
-                    newSpeed=pt.routage->getBoat()->getPolarData()->getSpeed(windSpeed,limit);
+                    newSpeed=context.polar->getSpeed(windSpeed,limit);
                     newSpeed=newSpeed*qAbs(cos(degToRad(limit))/cos(degToRad(qAbs(angle))));
                 }
                 else
-                    newSpeed=pt.routage->getBoat()->getPolarData()->getSpeed(windSpeed,angle);
+                    newSpeed=context.polar->getSpeed(windSpeed,angle);
             }
             if(current_speed>0)
             {
@@ -113,33 +124,26 @@ QList<vlmPoint> ROUTAGE::findPointThreaded(const QList<vlmPoint> &list)
                 newSpeed=p.x(); //in this case newSpeed is SOG
                 cap=p.y(); //in this case cap is COG
             }
-            distanceParcourue=newSpeed*pt.routage->getTimeStep()/60.0;
+            distanceParcourue=newSpeed*context.timeStep/60.0;
             Util::getCoordFromDistanceAngle(lat, lon, distanceParcourue, cap, &res_lat, &res_lon);
-            pt.lon=res_lon;
-            pt.lat=res_lat;
-            pt.distOrigin=distanceParcourue;
-            pt.capOrigin=cap;
-            time_t isoStep=pt.routage->getTimeStep()*60;
-            if(pt.routage->getI_iso())
+            time_t isoStep=context.timeStep*60;
+            if(context.i_iso)
             {
                 isoStep=-isoStep;
             }
-            pt.eta+=isoStep;
-            //if(!pt.routage->getUseRouteModule()) break;
+            eta+=isoStep;
             if(a==0)
             {
                 double newWindAngle,newWindSpeed;
-                if(pt.routage->getWhatIfUsed() && pt.routage->getWhatIfJour()<=pt.eta)
-                    pt.eta+=pt.routage->getWhatIfTime()*3600;
-                if(!pt.routage->get_dataManager()->getInterpolatedWind(res_lon,res_lat,
-                       pt.eta,&newWindSpeed,&newWindAngle,INTERPOLATION_DEFAULT)||pt.eta>pt.routage->get_dataManager()->get_maxDate())
+                if(context.whatIfUsed && context.whatIfJour<=eta)
+                    eta+=context.whatIfTime*3600;
+                if(!context.getWind(res_lon,res_lat,eta,&newWindSpeed,&newWindAngle,&cache)||eta>context.maxDate)
                 {
                     bad=true;
                     break;
                 }
                 newWindAngle=radToDeg(newWindAngle);
-                if(pt.routage->get_dataManager()->hasData(DATA_CURRENT_VX,DATA_LV_MSL,0) && pt.routage->get_dataManager()->getInterpolatedCurrent(res_lon,res_lat,
-                       pt.eta,&current_speed,&current_angle,INTERPOLATION_DEFAULT))
+                if(context.hasCurrent && context.getCurrent(res_lon,res_lat,eta,&current_speed,&current_angle,&cache))
                 {
                     current_angle=radToDeg(current_angle);
                     QPointF p=Util::calculateSumVect(newWindAngle,newWindSpeed,current_angle,current_speed);
@@ -151,63 +155,62 @@ QList<vlmPoint> ROUTAGE::findPointThreaded(const QList<vlmPoint> &list)
                     current_speed=-1;
                     current_angle=0;
                 }
-                if(pt.routage->getI_iso())
+                if(context.i_iso)
                 {
                     newWindAngle=Util::A360(newWindAngle+180.0);
                     current_angle=Util::A360(current_angle+180.0);
                 }
-                if(pt.routage->getWhatIfUsed() && pt.routage->getWhatIfJour()<=pt.eta)
-                    windSpeed=windSpeed*pt.routage->getWhatIfWind()/100.00;
+                if(context.whatIfUsed && context.whatIfJour<=eta)
+                    windSpeed=windSpeed*context.whatIfWind/100.00;
                 windAngle=Util::A360((windAngle+newWindAngle)/2.0);
                 windSpeed=(windSpeed+newWindSpeed)/2.0;
-                if(current_speed!=-1 && pt.current_speed!=-1)
+                if(current_speed!=-1 && origin_current_speed!=-1)
                 {
-                    current_speed=(pt.current_speed+current_speed)/2.0;
-                    current_angle=Util::A360((current_angle+pt.current_angle)/2.0);
+                    current_speed=(origin_current_speed+current_speed)/2.0;
+                    current_angle=Util::A360((current_angle+origin_current_angle)/2.0);
                 }
             }
         }
         if(bad) continue;
-        if(qAbs(pt.lat)>=89.9)
+        if(qAbs(res_lat)>=89.9)
         {
             continue;
         }
         double x,y;
-        pt.routage->getProj()->map2screenDouble(pt.lon,pt.lat,&x,&y);
-        pt.x=x;
-        pt.y=y;
-        if(pt.routage->getVisibleOnly() && !pt.routage->getProj()->isInBounderies_strict(pt.x,pt.y))
+        context.frame.map2frame(res_lon,res_lat,&x,&y);
+        if(context.visibleOnly && !context.visibleArea.contains(x,y))
         {
             continue;
         }
+        const double ox=pIso->x.at(o);
+        const double oy=pIso->y.at(o);
     #if 1
-        vlmPoint * O=pt.origin;
-    //    int nbCheck=0;
-    //    for (nbCheck=0;nbCheck<10;++nbCheck)
-    //    {
-    //        if(O->isStart)
-    //            break;
-    //        if(!O->isBroken)
-    //            break;
-    //        O=O->origin;
-    //    }
-        if(!O->isBroken)
+        if(!pIso->isBroken.at(o))
         {
-            if(pt.xM1<10e4)
+            if(o!=neighboursOf)
             {
-                Triangle t(Point(pt.origin->x,pt.origin->y),
-                           Point(pt.x,pt.y),
-                           Point(pt.xM1,pt.yM1));
+                neighboursOf=o;
+                QLineF line1(context.xa,context.ya,ox,oy);
+                hasM1=o!=0 &&
+                        qAbs(Util::A180(qAbs(line1.angleTo(QLineF(context.xa,context.ya,pIso->x.at(o-1),pIso->y.at(o-1))))))<60;
+                hasP1=o!=pIso->size()-1 &&
+                        qAbs(Util::A180(qAbs(line1.angleTo(QLineF(context.xa,context.ya,pIso->x.at(o+1),pIso->y.at(o+1))))))<60;
+            }
+            if(hasM1)
+            {
+                Triangle t(Point(ox,oy),
+                           Point(x,y),
+                           Point(pIso->x.at(o-1),pIso->y.at(o-1)));
                 if (t.orientation()==right_turn)
                 {
                     continue;
                 }
             }
-            if(pt.xP1<10e4)
+            if(hasP1)
             {
-                Triangle t(Point(pt.origin->x,pt.origin->y),
-                           Point(pt.x,pt.y),
-                           Point(pt.xP1,pt.yP1));
+                Triangle t(Point(ox,oy),
+                           Point(x,y),
+                           Point(pIso->x.at(o+1),pIso->y.at(o+1)));
                 if (t.orientation()==left_turn)
                 {
                     continue;
@@ -215,28 +218,20 @@ QList<vlmPoint> ROUTAGE::findPointThreaded(const QList<vlmPoint> &list)
             }
         }
     #endif
-    #ifdef HAS_ICEGATE
-        if(!pt.routage->checkIceGate(pt))
-        {
-            pt.isDead=true;
-            return pt;
-        }
-    #endif
 
 
     #ifndef USE_SHAPEISO
-        QPolygonF * previousIso=pt.routage->getPreviousIso();
-        QList<QLineF> * previousSegments=pt.routage->getPreviousSegments();
-        if(!pt.origin->isStart && previousIso->size()>1)
+        const QPolygonF * previousIso=context.previousIso;
+        const QList<QLineF> * previousSegments=context.previousSegments;
+        if(!pIso->isStart(o) && previousIso->size()>1)
         {
-            QLineF temp1(pt.origin->x,pt.origin->y,pt.x,pt.y);
+            QLineF temp1(ox,oy,x,y);
             QPointF dummy(0,0);
             for (int i=0;i<previousIso->size()-1;++i)
             {
                 QLineF s(previousIso->at(i),previousIso->at(i+1));
-                if(pt.originNb!=i && pt.originNb!=i+1)
+                if(o!=i && o!=i+1)
                 {
-                    //if(temp1.intersect(s,&dummy)==QLineF::BoundedIntersection)
                     if(temp1.intersect(s,&dummy)==QLineF::BoundedIntersection)
                     {
                         bad=true;
@@ -252,10 +247,10 @@ QList<vlmPoint> ROUTAGE::findPointThreaded(const QList<vlmPoint> &list)
         }
     #else
     #ifndef debugCount
-        if(!list.at(g).isStart)
+        if(!list.isStart(g))
         {
-            QPolygonF * shape=pt.routage->getShapeIso();
-            QPointF p=QPointF(pt.x,pt.y);
+            const QPolygonF * shape=context.shapeIso;
+            QPointF p=QPointF(x,y);
             if(shape->containsPoint(p,Qt::OddEvenFill))
             {
                 bad=true;
@@ -264,104 +259,39 @@ QList<vlmPoint> ROUTAGE::findPointThreaded(const QList<vlmPoint> &list)
     #endif
     #endif
         if (bad) continue;
-        pt.convertionLat=pt.lat;
-        pt.convertionLon=pt.lon;
-        Orthodromie orth(pt.origin->lon,pt.origin->lat,pt.lon,pt.lat);
-        pt.distOrigin=orth.getDistance();
-        if(pt.routage->getRoutageOrtho())
+        const int r=result.append(list,g);
+        result.lon[r]=res_lon;
+        result.lat[r]=res_lat;
+        result.x[r]=x;
+        result.y[r]=y;
+        result.eta[r]=eta;
+        result.capOrigin[r]=cap;
+        result.convertionLat[r]=res_lat;
+        result.convertionLon[r]=res_lon;
+        Orthodromie orth(pIso->lon.at(o),pIso->lat.at(o),res_lon,res_lat);
+        result.distOrigin[r]=orth.getDistance();
+        if(context.routageOrtho)
         {
-            orth.setPoints(pt.routage->getStart().x(),pt.routage->getStart().y(),pt.lon,pt.lat);
-            pt.distStart=orth.getDistance();
-            pt.capStart=orth.getAzimutDeg();
-            orth.setPoints(pt.lon,pt.lat,pt.routage->getArrival().x(),pt.routage->getArrival().y());
-            pt.distArrival=orth.getDistance();
-            pt.capArrival=orth.getAzimutDeg();
+            orth.setPoints(context.start.x(),context.start.y(),res_lon,res_lat);
+            result.distStart[r]=orth.getDistance();
+            result.capStart[r]=orth.getAzimutDeg();
+            orth.setPoints(res_lon,res_lat,context.arrival.x(),context.arrival.y());
+            result.distArrival[r]=orth.getDistance();
+            result.capArrival[r]=orth.getAzimutDeg();
         }
         else
         {
-            QLineF tempLine(pt.x,pt.y,pt.routage->getXs(),pt.routage->getYs());
-            pt.distStart=tempLine.length();
-            pt.capStart=Util::A360(-tempLine.angle()+90.0+180.0);
-            tempLine.setP2(QPointF(pt.routage->getXa(),pt.routage->getYa()));
-            pt.distArrival=tempLine.length();
-            pt.capArrival=Util::A360(-tempLine.angle()+90);
+            QLineF tempLine(x,y,context.xs,context.ys);
+            result.distStart[r]=tempLine.length();
+            result.capStart[r]=Util::A360(-tempLine.angle()+90.0+180.0);
+            tempLine.setP2(QPointF(context.xa,context.ya));
+            result.distArrival[r]=tempLine.length();
+            result.capArrival[r]=Util::A360(-tempLine.angle()+90);
         }
-        if(pt.origin->isStart)
-            pt.distIso=QLineF(pt.x,pt.y,pt.origin->x,pt.origin->y).length();
+        if(pIso->isStart(o))
+            result.distIso[r]=QLineF(x,y,ox,oy).length();
         else
-        {
-#if 0
-            const double max=pt.routage->get_maxDist();
-            vlmPoint O=*(pt.origin);
-            QPointF ptO(O.x,O.y);
-            QPolygonF * iso=pt.routage->getShapeMiddle();
-            QPolygonF isoProche;
-            int pointNb=iso->indexOf(ptO);
-            bool shapeReturned=false;
-            if(pointNb<0)
-            {
-                //qWarning()<<"anomaly with distIso calculation!";
-                shapeReturned=true;
-            }
-            else
-            {
-                int work=pointNb;
-                isoProche.append(ptO);
-                bool stopped=false;
-                while(true)
-                {
-                    if(work>=iso->size()-1) break;
-                    ptO=iso->at(++work);
-                    if(!stopped)
-                        isoProche.append(ptO);
-                    if (QLineF(pt.x,pt.y,ptO.x(),ptO.y()).length()>max)
-                    {
-                        stopped=true;
-                    }
-                    else if (stopped)
-                    {
-                        shapeReturned=true;
-                        break;
-                    }
-                }
-                if(!shapeReturned)
-                {
-                    stopped=false;
-                    ptO=iso->at(pointNb);
-                    work=pointNb;
-                    while(true)
-                    {
-                        if(work<=0) break;
-                        ptO=iso->at(--work);
-                        if(!stopped)
-                            isoProche.prepend(ptO);
-                        if (QLineF(pt.x,pt.y,ptO.x(),ptO.y()).length()>max)
-                        {
-                            stopped=true;
-                        }
-                        else if (stopped)
-                        {
-                            shapeReturned=true;
-                            break;
-                        }
-                    }
-                }
-            }
-            if(!shapeReturned)
-            {
-                pt.distIso=ROUTAGE::findDistancePreviousIso(pt, &isoProche);
-                //qWarning()<<"isoProche size="<<isoProche.size()<<"against"<<pt.routage->getShapeMiddle()->size();
-            }
-            else
-                pt.distIso=ROUTAGE::findDistancePreviousIso(pt, pt.routage->getShapeMiddle());
-//            double diff=pt.distIso-ROUTAGE::findDistancePreviousIso(pt, pt.routage->getShapeMiddle());
-//            if(qRound(diff*10e8)!=0)
-//                qWarning()<<"erreur disIso"<<diff<<"max="<<max<<isoProche.size();
-#else
-            pt.distIso=ROUTAGE::findDistancePreviousIso(pt, pt.routage->getShapeMiddle());
-#endif
-        }
-        result.append(pt);
+            result.distIso[r]=ROUTAGE::findDistancePreviousIso(x,y,context.shapeMiddle);
     }
     return result;
 }
@@ -369,48 +299,70 @@ QList<vlmPoint> ROUTAGE::findPointThreaded(const QList<vlmPoint> &list)
 
 /*threadable functions*/
 
-vlmPoint ROUTAGE::checkCoastCollision(const vlmPoint &point)
+isoColumns ROUTAGE::checkCoastCollision(const RoutingContext &context, const isoColumns &points)
 {
-    vlmPoint newPoint=point;
-    double x1,y1,x2,y2;
-    x1=newPoint.origin->x;
-    y1=newPoint.origin->y;
-    x2=newPoint.x;
-    y2=newPoint.y;
-    newPoint.isDead=(newPoint.routage->getCheckCoast() && (newPoint.routage->getMap() && newPoint.routage->getMap()->crossing(QLineF(x1,y1,x2,y2),QLineF(newPoint.origin->lon,newPoint.origin->lat,newPoint.lon,newPoint.lat))))
-                 || (newPoint.routage->getCheckLine() && newPoint.routage->crossBarriere(QLineF(x1,y1,x2,y2)));
-    return newPoint;
+    isoColumns newPoints=points;
+    const isoColumns * pIso=context.lastIso;
+    QBitArray hits(newPoints.size(),false);
+    if(context.checkCoast && context.map)
+    {
+        QList<QLineF> legs;
+        legs.reserve(newPoints.size());
+        for(int n=0;n<newPoints.size();++n)
+        {
+            const int o=newPoints.origin.at(n);
+            legs.append(QLineF(pIso->lon.at(o),pIso->lat.at(o),newPoints.lon.at(n),newPoints.lat.at(n)));
+        }
+        context.map->crossing(legs,&hits);
+    }
+    for(int n=0;n<newPoints.size();++n)
+    {
+        const int o=newPoints.origin.at(n);
+        newPoints.isDead[n]=hits.testBit(n)
+                || (context.checkLine && context.crossBarrier(QLineF(pIso->x.at(o),pIso->y.at(o),newPoints.x.at(n),newPoints.y.at(n))));
+    }
+    return newPoints;
 }
-bool ROUTAGE::checkCoastCollision2(const vlmPoint &point1, const vlmPoint &point2)
+bool ROUTAGE::checkCoastCollision2(const RoutingContext &context, const isoColumns &points1, const int &n1, const isoColumns &points2, const int &n2)
 {
     double x1,y1,x2,y2;
-    x1=point1.x;
-    y1=point1.y;
-    x2=point2.x;
-    y2=point2.y;
-    return (point1.routage->getCheckCoast() && (point1.routage->getMap() && point1.routage->getMap()->crossing(QLineF(x1,y1,x2,y2),QLineF(point1.lon,point1.lat,point2.lon,point2.lat))))
-                 || (point1.routage->getCheckLine() && point1.routage->crossBarriere(QLineF(x1,y1,x2,y2)));
+    x1=points1.x.at(n1);
+    y1=points1.y.at(n1);
+    x2=points2.x.at(n2);
+    y2=points2.y.at(n2);
+    return (context.checkCoast && (context.map && context.map->crossing(QLineF(points1.lon.at(n1),points1.lat.at(n1),points2.lon.at(n2),points2.lat.at(n2)))))
+                 || (context.checkLine && context.crossBarrier(QLineF(x1,y1,x2,y2)));
 }
-QList<vlmPoint> ROUTAGE::finalEpuration(const QList<vlmPoint> &listPoints)
+epurationRange ROUTAGE::finalEpuration(const RoutingContext &context, const epurationRange &range)
 {
-    if(listPoints.isEmpty()) return listPoints;
-    if(listPoints.first().origin->isStart) return listPoints;
-    const double maxDist=listPoints.at(0).routage->get_maxDist();
-    int toBeRemoved=listPoints.at(0).internal_1;
-    double initialDist=listPoints.at(0).internal_2;
-    if(toBeRemoved<=0) return listPoints;
+    epurationRange result=range;
+    const int size=range.end-range.begin;
+    result.removed=QBitArray(size,false);
+    if(size<=0) return result;
+    const isoColumns &P=*range.points;
+    const isoColumns &O=*context.lastIso;
+    const int b=range.begin;
+    if(O.isStart(P.origin.at(b))) return result;
+    const double maxDist=context.maxDist;
+    int toBeRemoved=range.toBeRemoved;
+    double initialDist=range.initialDist;
+    if(toBeRemoved<=0) return result;
     QMultiMap<double,QPoint> byCriteres;
     QHash<quint32,double> byIndices;
     QList<bool> deadStatus;
     quint32 s;
     double critere=0;
-    double xa=listPoints.at(0).routage->getXa();
-    double ya=listPoints.at(0).routage->getYa();
-    for(int n=0;n<listPoints.size()-1;++n)
+    double xa=context.xa;
+    double ya=context.ya;
+    for(int n=0;n<size-1;++n)
     {
-        QLineF line1(xa,ya,listPoints.at(n).x,listPoints.at(n).y);
-        QLineF line2(xa,ya,listPoints.at(n+1).x,listPoints.at(n+1).y);
-        if(listPoints.at(n).originNb!=listPoints.at(n+1).originNb && (listPoints.at(n).origin->isBroken || listPoints.at(n+1).origin->isBroken))
+        const int i1=b+n;
+        const int i2=b+n+1;
+        const int o1=P.origin.at(i1);
+        const int o2=P.origin.at(i2);
+        QLineF line1(xa,ya,P.x.at(i1),P.y.at(i1));
+        QLineF line2(xa,ya,P.x.at(i2),P.y.at(i2));
+        if(o1!=o2 && (O.isBroken.at(o1) || O.isBroken.at(o2)))
             critere=179;
         else if(qAbs(Util::A180(qAbs(line1.angleTo(line2)))) > 60 ||
                 qAbs(line1.length()-line2.length())>maxDist)
@@ -420,22 +372,22 @@ QList<vlmPoint> ROUTAGE::finalEpuration(const QList<vlmPoint> &listPoints)
             critere=0;
             QLineF temp1;
             QPointF middle;
-            if(listPoints.at(n).originNb!=listPoints.at(n+1).originNb)
+            if(o1!=o2)
             {
-                temp1.setPoints(QPointF(listPoints.at(n).origin->x,listPoints.at(n).origin->y),
-                         QPointF(listPoints.at(n+1).origin->x,listPoints.at(n+1).origin->y));
+                temp1.setPoints(QPointF(O.x.at(o1),O.y.at(o1)),
+                         QPointF(O.x.at(o2),O.y.at(o2)));
                 middle=temp1.pointAt(0.5);
             }
             else
-                middle=QPointF(listPoints.at(n).origin->x,listPoints.at(n).origin->y);
-            temp1.setPoints(QPointF(listPoints.at(n).x,listPoints.at(n).y),
-                            QPointF(listPoints.at(n+1).x,listPoints.at(n+1).y));
+                middle=QPointF(O.x.at(o1),O.y.at(o1));
+            temp1.setPoints(QPointF(P.x.at(i1),P.y.at(i1)),
+                            QPointF(P.x.at(i2),P.y.at(i2)));
             QPointF middleBis=temp1.pointAt(0.5);
             temp1.setPoints(middleBis,middle);
             temp1.setLength(initialDist);
             middle=temp1.p2();
-            QLineF temp2(middle.x(),middle.y(),listPoints.at(n).x,listPoints.at(n).y);
-            QLineF temp3(middle.x(),middle.y(),listPoints.at(n+1).x,listPoints.at(n+1).y);
+            QLineF temp2(middle.x(),middle.y(),P.x.at(i1),P.y.at(i1));
+            QLineF temp3(middle.x(),middle.y(),P.x.at(i2),P.y.at(i2));
             critere=qAbs(temp2.angleTo(temp3));
             if(critere>180)
             {
@@ -449,20 +401,22 @@ QList<vlmPoint> ROUTAGE::finalEpuration(const QList<vlmPoint> &listPoints)
     }
     deadStatus.append(false);
     QMutableMapIterator<double,QPoint> d(byCriteres);
-    int currentCount=listPoints.size();
+    int currentCount=size;
     while(toBeRemoved>0 && currentCount>=0)
     {
         d.toFront();
         if(!d.hasNext()) break;
         QPoint couple=d.next().value();
+        const int i1=b+couple.x();
+        const int i2=b+couple.y();
         int badOne=0;
-        if(!listPoints.at(couple.x()).origin->isBroken &&
-           listPoints.at(couple.y()).origin->isBroken)
+        if(!O.isBroken.at(P.origin.at(i1)) &&
+           O.isBroken.at(P.origin.at(i2)))
             badOne=couple.x();
-        else if(listPoints.at(couple.x()).origin->isBroken &&
-           !listPoints.at(couple.y()).origin->isBroken)
+        else if(O.isBroken.at(P.origin.at(i1)) &&
+           !O.isBroken.at(P.origin.at(i2)))
             badOne=couple.y();
-        else if(listPoints.at(couple.x()).distIso<listPoints.at(couple.y()).distIso)
+        else if(P.distIso.at(i1)<P.distIso.at(i2))
             badOne=couple.x();
         else
             badOne=couple.y();
@@ -471,7 +425,7 @@ QList<vlmPoint> ROUTAGE::finalEpuration(const QList<vlmPoint> &listPoints)
         int next=-1;
         if(badOne>0)
             previous=deadStatus.lastIndexOf(false,badOne);
-        if(badOne<listPoints.size()-1)
+        if(badOne<size-1)
             next=deadStatus.indexOf(false,badOne);
         if(currentCount<=1) break;
         if(previous!=-1 && next!=-1)
@@ -482,32 +436,36 @@ QList<vlmPoint> ROUTAGE::finalEpuration(const QList<vlmPoint> &listPoints)
             double critereNext=byIndices.value(s);
             byCriteres.remove(criterePrevious,QPoint(previous,badOne));
             byCriteres.remove(critereNext,QPoint(badOne,next));
+            const int ip=b+previous;
+            const int in=b+next;
+            const int op=P.origin.at(ip);
+            const int on=P.origin.at(in);
             QLineF temp1;
             QPointF middle;
-            if(listPoints.at(previous).originNb!=listPoints.at(next).originNb)
+            if(op!=on)
             {
-                temp1.setPoints(QPointF(listPoints.at(previous).origin->x,listPoints.at(previous).origin->y),
-                             QPointF(listPoints.at(next).origin->x,listPoints.at(next).origin->y));
+                temp1.setPoints(QPointF(O.x.at(op),O.y.at(op)),
+                             QPointF(O.x.at(on),O.y.at(on)));
                 middle=temp1.pointAt(0.5);
             }
             else
-                middle=QPointF(listPoints.at(previous).origin->x,listPoints.at(previous).origin->y);
-            temp1.setPoints(QPointF(listPoints.at(previous).x,listPoints.at(previous).y),
-                            QPointF(listPoints.at(next).x,listPoints.at(next).y));
+                middle=QPointF(O.x.at(op),O.y.at(op));
+            temp1.setPoints(QPointF(P.x.at(ip),P.y.at(ip)),
+                            QPointF(P.x.at(in),P.y.at(in)));
             QPointF middleBis=temp1.pointAt(0.5);
             temp1.setPoints(middleBis,middle);
             temp1.setLength(initialDist);
             middle=temp1.p2();
-            QLineF temp2(middle.x(),middle.y(),listPoints.at(previous).x,listPoints.at(previous).y);
-            QLineF temp3(middle.x(),middle.y(),listPoints.at(next).x,listPoints.at(next).y);
+            QLineF temp2(middle.x(),middle.y(),P.x.at(ip),P.y.at(ip));
+            QLineF temp3(middle.x(),middle.y(),P.x.at(in),P.y.at(in));
             double critere=qAbs(temp2.angleTo(temp3));
             if(critere>180)
             {
                 critere=360-critere;
             }
-            QLineF line1(xa,ya,listPoints.at(previous).x,listPoints.at(previous).y);
-            QLineF line2(xa,ya,listPoints.at(next).x,listPoints.at(next).y);
-            if(listPoints.at(previous).originNb!=listPoints.at(next).originNb && (listPoints.at(previous).origin->isBroken || listPoints.at(next).origin->isBroken))
+            QLineF line1(xa,ya,P.x.at(ip),P.y.at(ip));
+            QLineF line2(xa,ya,P.x.at(in),P.y.at(in));
+            if(op!=on && (O.isBroken.at(op) || O.isBroken.at(on)))
                 critere=179;
             else if(qAbs(Util::A180(qAbs(line1.angleTo(line2)))) > 60 ||
                     qAbs(line1.length()-line2.length())>maxDist)
@@ -531,58 +489,42 @@ QList<vlmPoint> ROUTAGE::finalEpuration(const QList<vlmPoint> &listPoints)
         --toBeRemoved;
         --currentCount;
     }
-    QList<vlmPoint> result;
     for (int nn=0;nn<deadStatus.size();++nn)
     {
-        if(!deadStatus.at(nn))
-            result.append(listPoints.at(nn));
+        if(deadStatus.at(nn))
+            result.removed.setBit(nn);
     }
     return result;
 }
-QList<vlmPoint> ROUTAGE::findRoute(const QList<vlmPoint> & pointList)
+isoColumns ROUTAGE::findRoute(const RoutingContext &context, const isoColumns & pointList)
 {
     if(pointList.isEmpty()) return pointList;
-    ROUTAGE * routage=pointList.at(0).routage;
-    datathread dataThread;
-    dataThread.Boat=routage->getBoat();
-    if(routage->getI_iso())
-        dataThread.Eta=routage->getI_eta();
-    else
-        dataThread.Eta=routage->getEta();
-    dataThread.Eta=pointList.first().origin->eta;
-    dataThread.dataManager=routage->get_dataManager();
-    dataThread.whatIfJour=routage->getWhatIfJour();
-    dataThread.whatIfUsed=routage->getWhatIfUsed();
-    dataThread.whatIfTime=routage->getWhatIfTime();
-    dataThread.whatIfWind=routage->getWhatIfWind();
-    dataThread.timeStep=routage->getTimeStep();
-    dataThread.speedLossOnTack=routage->getSpeedLossOnTack();
-    dataThread.i_iso=routage->getI_iso();
-    QList<vlmPoint> resultList;
+    const isoColumns * pIso=context.lastIso;
+    datathread dataThread=context.threadData(pIso->eta.at(pointList.origin.first()));
+    isoColumns resultList;
+    resultList.reserve(pointList.size());
     for (int pp=0;pp<pointList.size();++pp)
     {
-        vlmPoint point=pointList.at(pp);
-        double cap=point.capOrigin;
-        double lon=point.origin->lon;
-        double lat=point.origin->lat;
-        vlmPoint resultP=point;
-        double res_lon=point.lon;
-        double res_lat=point.lat;
-        double distanceParcourue=point.distOrigin;
+        const int o=pointList.origin.at(pp);
+        double cap=pointList.capOrigin.at(pp);
+        double lon=pIso->lon.at(o);
+        double lat=pIso->lat.at(o);
+        double res_lon=pointList.lon.at(pp);
+        double res_lat=pointList.lat.at(pp);
+        double distanceParcourue=pointList.distOrigin.at(pp);
+        /* the time solver works on two throw-away vlmPoints */
         vlmPoint from(lon,lat);
-        from.wind_angle=point.origin->wind_angle;
-        from.isStart=point.origin->isStart;
+        from.wind_angle=pIso->wind_angle.at(o);
+        from.isStart=pIso->isStart(o);
         vlmPoint to(res_lon,res_lat);
         double lastLonFound,lastLatFound;
         int realTime=ROUTAGE::calculateTimeRoute(from, to, &dataThread, &lastLonFound, &lastLatFound);
         if(realTime>10e4)
         {
-            resultP.isDead=true;
-            //resultList.append(resultP);
             continue;
         }
         bool found=false;
-        int timeStepSec=point.routage->getTimeStep()*60.0;
+        int timeStepSec=context.timeStep*60.0;
         if(realTime==timeStepSec)
         {
             found=true;
@@ -598,8 +540,6 @@ QList<vlmPoint> ROUTAGE::findRoute(const QList<vlmPoint> & pointList)
             realTime=ROUTAGE::calculateTimeRoute(from, to, &dataThread, &lastLonFound, &lastLatFound);
             if(realTime>10e4)
             {
-                resultP.isDead=true;
-                //resultList.append(resultP);
                 continue;
             }
             if(realTime==timeStepSec)
@@ -623,7 +563,6 @@ QList<vlmPoint> ROUTAGE::findRoute(const QList<vlmPoint> & pointList)
                         double res_lon,res_lat;
                         Util::getCoordFromDistanceAngle(from.lat, from.lon, x, from.capOrigin, &res_lat, &res_lon);
                         to=vlmPoint(res_lon,res_lat);
-                        resultP.foundByNewtonRaphson=true;
                         break;
                     }
                     double deriv=ROUTAGE::routeFunctionDeriv(x,from,&lastLonFound,&lastLatFound,&dataThread);
@@ -638,14 +577,14 @@ QList<vlmPoint> ROUTAGE::findRoute(const QList<vlmPoint> & pointList)
         }
         if(found)
         {
-            resultP.convertionLat=to.lat;
-            resultP.convertionLon=to.lon;
-            resultP.lon=lastLonFound;
-            resultP.lat=lastLatFound;
-            Orthodromie oo(from.lon,from.lat,resultP.lon,resultP.lat);
-            resultP.distOrigin=oo.getDistance();
-            resultP.capOrigin=oo.getAzimutDeg();
-            resultList.append(resultP);
+            const int r=resultList.append(pointList,pp);
+            resultList.convertionLat[r]=to.lat;
+            resultList.convertionLon[r]=to.lon;
+            resultList.lon[r]=lastLonFound;
+            resultList.lat[r]=lastLatFound;
+            Orthodromie oo(from.lon,from.lat,lastLonFound,lastLatFound);
+            resultList.distOrigin[r]=oo.getDistance();
+            resultList.capOrigin[r]=oo.getAzimutDeg();
         }
     }
     return resultList;
@@ -692,10 +631,10 @@ inline int ROUTAGE::calculateTimeRoute(const vlmPoint &routeFrom,const vlmPoint
     double lon,lat;
     lon=routeFrom.lon;
     lat=routeFrom.lat;
-    int vacLen=dataThread->Boat->getVacLen();
+    int vacLen=dataThread->vacLen;
     double newSpeed,distanceParcourue,remaining_distance,res_lon,res_lat,cap1,cap2,diff1,diff2;
     double windAngle,windSpeed,cap,angle;
-    time_t maxDate=dataThread->dataManager->get_maxDate();
+    time_t maxDate=dataThread->maxDate;
     newSpeed=0;
     distanceParcourue=0;
     res_lon=0;
@@ -716,7 +655,7 @@ inline int ROUTAGE::calculateTimeRoute(const vlmPoint &routeFrom,const vlmPoint
         if(dataThread->dataManager->getInterpolatedWind(lon, lat, workEta,&windSpeed,&windAngle,INTERPOLATION_DEFAULT && workEta<=maxDate && (!hasLimit || etaRoute<=etaLimit)))
         {
             windAngle=radToDeg(windAngle);
-            if (dataThread->dataManager->hasData(DATA_CURRENT_VX,DATA_LV_MSL,0) && dataThread->dataManager->getInterpolatedCurrent(lon, lat, workEta,&current_speed,&current_angle,INTERPOLATION_DEFAULT))
+            if (dataThread->hasCurrent && dataThread->dataManager->getInterpolatedCurrent(lon, lat, workEta,&current_speed,&current_angle,INTERPOLATION_DEFAULT))
             {
                 current_angle=radToDeg(current_angle);
                 QPointF p=Util::calculateSumVect(windAngle,windSpeed,current_angle,current_speed);
@@ -741,9 +680,9 @@ inline int ROUTAGE::calculateTimeRoute(const vlmPoint &routeFrom,const vlmPoint
                 else
                     angle=angle-360;
             }
-            if(qAbs(angle)<dataThread->Boat->getPolarData()->getBvmgUp(windSpeed))
+            if(qAbs(angle)<dataThread->polar->getBvmgUp(windSpeed))
             {
-                angle=dataThread->Boat->getPolarData()->getBvmgUp(windSpeed);
+                angle=dataThread->polar->getBvmgUp(windSpeed);
                 cap1=Util::A360(windAngle+angle);
                 cap2=Util::A360(windAngle-angle);
                 diff1=Util::myDiffAngle(cap,cap1);
@@ -753,9 +692,9 @@ inline int ROUTAGE::calculateTimeRoute(const vlmPoint &routeFrom,const vlmPoint
                 else
                     cap=cap2;
             }
-            else if(qAbs(angle)>dataThread->Boat->getPolarData()->getBvmgDown(windSpeed))
+            else if(qAbs(angle)>dataThread->polar->getBvmgDown(windSpeed))
             {
-                angle=dataThread->Boat->getPolarData()->getBvmgDown(windSpeed);
+                angle=dataThread->polar->getBvmgDown(windSpeed);
                 cap1=Util::A360(windAngle+angle);
                 cap2=Util::A360(windAngle-angle);
                 diff1=Util::myDiffAngle(cap,cap1);
@@ -765,7 +704,7 @@ inline int ROUTAGE::calculateTimeRoute(const vlmPoint &routeFrom,const vlmPoint
                 else
                     cap=cap2;
             }
-            newSpeed=dataThread->Boat->getPolarData()->getSpeed(windSpeed,angle);
+            newSpeed=dataThread->polar->getSpeed(windSpeed,angle);
             if(current_speed>0)
             {
                 QPointF p=Util::calculateSumVect(cap,newSpeed,Util::A360(current_angle+180.0),current_speed);
@@ -909,6 +848,9 @@ ROUTAGE::ROUTAGE(QString name, Projection *proj, DataManager *dataManager, QGrap
     result->setParent(this);
     way=new vlmLine(proj,myscene,Z_VALUE_ROUTAGE+0.1);
     way->setParent(this);
+    isoPoints=new vlmPointGraphic(this,proj,myscene,Z_VALUE_ISOPOINT);
+    isoPoints->setParent(this);
+    connect(this,SIGNAL(updateVgTip(int,int,QString)),isoPoints,SLOT(slot_updateTip(int,int,QString)));
     this->routeFromBoat=true;
     this->aborted=false;
     createPopupMenu();
@@ -925,6 +867,7 @@ ROUTAGE::ROUTAGE(QString name, Projection *proj, DataManager *dataManager, QGrap
     this->multiDays=0;
     this->multiHours=0;
     this->multiMin=0;
+    zoneW=zoneE=zoneN=zoneS=0;
 }
 ROUTAGE::~ROUTAGE()
 {
@@ -942,8 +885,7 @@ ROUTAGE::~ROUTAGE()
         delete i_segments.takeFirst();
     if(result!=NULL)
         delete result;
-    while(!isoPointList.isEmpty())
-        delete isoPointList.takeFirst();
+    delete isoPoints;
     delete way;
     if(this->popup && !parent->getAboutToQuit())
         delete popup;
@@ -1074,85 +1016,109 @@ void ROUTAGE::calculate()
         start.setY(i_start.lat);
         //qWarning()<<QDateTime().fromTime_t(i_eta).toUTC().toString("dd MMM-hh:mm");
     }
+    /* the inverse run keeps the zone and frame of the direct one */
+    if(!i_iso)
+        computeZone();
     if(autoZoom)
     {
-        Orthodromie ortho (start.x(), start.y(), arrival.x(), arrival.y());
-        const double    distance = ortho.getDistance();
+        proj->zoomOnZone(zoneW,zoneN,zoneE,zoneS);
+        connect(proj,SIGNAL(projectionUpdated()),this,SLOT(slot_calculate_with_tempo()));
+        proj->setScale(proj->getScale()*.9);
+        QApplication::processEvents();
+    }
+    else
+        slot_calculate();
+}
+void RoutingFrame::init(const double &xW, const double &yN, const double &xE, const double &yS)
+{
+    CX=(xW+xE)/2.0;
+    if(CX>180.0) CX-=360.0;
+    else if(CX<=-180.0) CX+=360.0;
+    const double mN=mercator(yN);
+    const double mS=mercator(yS);
+    PY=(mN+mS)/2.0;
+    /* the larger side of the zone spans ROUTAGE_FRAME_SIZE units */
+    const double extent=qMax(0.01,qMax(qAbs(xE-xW),qAbs(mN-mS)));
+    scale=ROUTAGE_FRAME_SIZE/extent;
+}
+/* zone of the routing, from start/arrival and the zoom level: used to size the routing
+   frame, as the visibleOnly limit and as the autoZoom target */
+void ROUTAGE::computeZone()
+{
+    Orthodromie ortho (start.x(), start.y(), arrival.x(), arrival.y());
+    const double    distance = ortho.getDistance();
 
-        double xW, xE, yN, yS, xTmp, yTmp;
-        double    ratio = 0.5;
-        switch (zoomLevel)
-        {
-            case 3:
-                ratio=0.1;
-                break;
-            case 2:
-                ratio=0.5;
-                break;
-            case 1:
-                ratio=0.8;
-                break;
-        }
-        const double    angle = ortho.getLoxoCap();
-        Util::getCoordFromDistanceAngle (start.y(), start.x(), ratio*distance/2, angle+90, &yTmp, &xTmp);
-        xW = xE = xTmp;
-        yN = yS = yTmp;
-        //qWarning()<<"1"<<xW<<xE<<xTmp;
-        Util::getCoordFromDistanceAngle (start.y(), start.x(), ratio*distance/2, angle-90, &yTmp, &xTmp);
-        if(mySignedDiffAngle(Util::A360(xW),Util::A360(xTmp))<0) xW=xTmp;
-        if(mySignedDiffAngle(Util::A360(xTmp),Util::A360(xE))<0) xE=xTmp;
+    double xW, xE, yN, yS, xTmp, yTmp;
+    double    ratio = 0.5;
+    switch (zoomLevel)
+    {
+        case 3:
+            ratio=0.1;
+            break;
+        case 2:
+            ratio=0.5;
+            break;
+        case 1:
+            ratio=0.8;
+            break;
+    }
+    const double    angle = ortho.getLoxoCap();
+    Util::getCoordFromDistanceAngle (start.y(), start.x(), ratio*distance/2, angle+90, &yTmp, &xTmp);
+    xW = xE = xTmp;
+    yN = yS = yTmp;
+    //qWarning()<<"1"<<xW<<xE<<xTmp;
+    Util::getCoordFromDistanceAngle (start.y(), start.x(), ratio*distance/2, angle-90, &yTmp, &xTmp);
+    if(mySignedDiffAngle(Util::A360(xW),Util::A360(xTmp))<0) xW=xTmp;
+    if(mySignedDiffAngle(Util::A360(xTmp),Util::A360(xE))<0) xE=xTmp;
 //        if (xTmp < xW) xW = xTmp;
 //        if (xTmp > xE) xE = xTmp;
-        if (yTmp < yS) yS = yTmp;
-        if (yTmp > yN) yN = yTmp;
-        //qWarning()<<"2"<<xW<<xE<<xTmp;
-        Util::getCoordFromDistanceAngle (arrival.y(), arrival.x(), ratio*distance/2, angle+90, &yTmp, &xTmp);
-        if(mySignedDiffAngle(Util::A360(xW),Util::A360(xTmp))<0) xW=xTmp;
-        if(mySignedDiffAngle(Util::A360(xTmp),Util::A360(xE))<0) xE=xTmp;
+    if (yTmp < yS) yS = yTmp;
+    if (yTmp > yN) yN = yTmp;
+    //qWarning()<<"2"<<xW<<xE<<xTmp;
+    Util::getCoordFromDistanceAngle (arrival.y(), arrival.x(), ratio*distance/2, angle+90, &yTmp, &xTmp);
+    if(mySignedDiffAngle(Util::A360(xW),Util::A360(xTmp))<0) xW=xTmp;
+    if(mySignedDiffAngle(Util::A360(xTmp),Util::A360(xE))<0) xE=xTmp;
 //        if (xTmp < xW) xW = xTmp;
 //        if (xTmp > xE) xE = xTmp;
-        if (yTmp < yS) yS = yTmp;
-        if (yTmp > yN) yN = yTmp;
-        //qWarning()<<"3"<<xW<<xE<<xTmp;
-        Util::getCoordFromDistanceAngle (arrival.y(), arrival.x(), ratio*distance/2, angle-90, &yTmp, &xTmp);
-        if(mySignedDiffAngle(Util::A360(xW),Util::A360(xTmp))<0) xW=xTmp;
-        if(mySignedDiffAngle(Util::A360(xTmp),Util::A360(xE))<0) xE=xTmp;
+    if (yTmp < yS) yS = yTmp;
+    if (yTmp > yN) yN = yTmp;
+    //qWarning()<<"3"<<xW<<xE<<xTmp;
+    Util::getCoordFromDistanceAngle (arrival.y(), arrival.x(), ratio*distance/2, angle-90, &yTmp, &xTmp);
+    if(mySignedDiffAngle(Util::A360(xW),Util::A360(xTmp))<0) xW=xTmp;
+    if(mySignedDiffAngle(Util::A360(xTmp),Util::A360(xE))<0) xE=xTmp;
 //        if (xTmp < xW) xW = xTmp;
 //        if (xTmp > xE) xE = xTmp;
-        if (yTmp < yS) yS = yTmp;
-        if (yTmp > yN) yN = yTmp;
-        //qWarning()<<"5"<<xW<<xE<<xTmp;
+    if (yTmp < yS) yS = yTmp;
+    if (yTmp > yN) yN = yTmp;
+    //qWarning()<<"5"<<xW<<xE<<xTmp;
 
-        if((xW>0 && xE<0) || (xW<0 && xE>0))
+    if((xW>0 && xE<0) || (xW<0 && xE>0))
+    {
+        //qWarning()<<"6"<<xW<<xE<<xTmp;
+        if(qAbs(xW-xE)>180)
         {
-            //qWarning()<<"6"<<xW<<xE<<xTmp;
-            if(qAbs(xW-xE)>180)
-            {
-                swap(xW,xE);
-                //qWarning()<<"7"<<xW<<xE<<xTmp;
-                if(xW>0)
-                    xW-=360;
-                else
-                    xE-=360;
-                //qWarning()<<"8"<<xW<<xE<<xTmp;
-            }
+            swap(xW,xE);
+            //qWarning()<<"7"<<xW<<xE<<xTmp;
+            if(xW>0)
+                xW-=360;
+            else
+                xE-=360;
+            //qWarning()<<"8"<<xW<<xE<<xTmp;
         }
+    }
 
 #if 0
-        qWarning() << "Routing from " << start.x() << ", " << start.y() << " to " << arrival.x() << ", " << arrival.y();
-        qWarning() << "-- Distance: " << distance;
-        qWarning() << "-- North:    " << yN;
-        qWarning() << "-- South:    " << yS;
-        qWarning() << "-- West:     " << xW;
-        qWarning() << "-- East:     " << xE;
+    qWarning() << "Routing from " << start.x() << ", " << start.y() << " to " << arrival.x() << ", " << arrival.y();
+    qWarning() << "-- Distance: " << distance;
+    qWarning() << "-- North:    " << yN;
+    qWarning() << "-- South:    " << yS;
+    qWarning() << "-- West:     " << xW;
+    qWarning() << "-- East:     " << xE;
 #endif
-        proj->zoomOnZone(xW,yN,xE,yS);
-        connect(proj,SIGNAL(projectionUpdated()),this,SLOT(slot_calculate_with_tempo()));
-        proj->setScale(proj->getScale()*.9);
-        QApplication::processEvents();
-    }
-    else
-        slot_calculate();
+    zoneW=xW;
+    zoneE=xE;
+    zoneN=yN;
+    zoneS=yS;
 }
 void ROUTAGE::slot_calculate_with_tempo()
 {
@@ -1164,21 +1130,30 @@ void ROUTAGE::calculateMaxDist()
     int timeStep=qMax(timeStepLess24,timeStepMore24);
     double maxSpeed=myBoat->getPolarData()->getMaxSpeed();
     maxDist=maxSpeed*2.0*timeStep/60.0;
-    double X1=proj->getCX();
-    double Y1=proj->getCY();
+    double X1=start.x();
+    double Y1=start.y();
     double X2,Y2;
     Util::getCoordFromDistanceAngle(Y1,X1,maxDist,0.0,&Y2,&X2);
     double x1,y1,x2,y2;
-    proj->map2screenDouble(X1,Y1,&x1,&y1);
-    proj->map2screenDouble(X2,Y2,&x2,&y2);
+    frame.map2frame(X1,Y1,&x1,&y1);
+    frame.map2frame(X2,Y2,&x2,&y2);
     maxDist=QLineF(x1,y1,x2,y2).length();
 }
 
 void ROUTAGE::slot_calculate()
 {
     disconnect(proj,SIGNAL(projectionUpdated()),this,SLOT(slot_calculate()));
+    if(zoneW==zoneE && zoneN==zoneS)
+        computeZone();
+    frame.init(zoneW,zoneN,zoneE,zoneS);
+    /* visibleOnly keeps the points in the routing zone plus the margin autoZoom shows */
+    double zx1,zy1,zx2,zy2;
+    frame.map2frame(zoneW,zoneN,&zx1,&zy1);
+    frame.map2frame(zoneE,zoneS,&zx2,&zy2);
+    visibleArea=QRectF(QPointF(zx1,zy1),QPointF(zx2,zy2)).normalized();
+    visibleArea.adjust(-visibleArea.width()*0.05,-visibleArea.height()*0.05,
+                       visibleArea.width()*0.05,visibleArea.height()*0.05);
     calculateMaxDist();
-    double   cap;
     QTime timeTotal;
 #ifdef traceTime
     QTime tfp;
@@ -1226,8 +1201,8 @@ void ROUTAGE::slot_calculate()
             POI * poi2=poiList.at(p)->getConnectedPoi();
             poiList.removeOne(poi2);
             double x1,y1,x2,y2;
-            proj->map2screenDouble(poi1->getLongitude(),poi1->getLatitude(),&x1,&y1);
-            proj->map2screenDouble(poi2->getLongitude(),poi2->getLatitude(),&x2,&y2);
+            frame.map2frame(poi1->getLongitude(),poi1->getLatitude(),&x1,&y1);
+            frame.map2frame(poi2->getLongitude(),poi2->getLatitude(),&x2,&y2);
             barrieres.append(QLineF(x1,y1,x2,y2));
         }
     }
@@ -1240,10 +1215,10 @@ void ROUTAGE::slot_calculate()
         const vlmPoint p1=gates.at(n)->getPoints()->first();
         const vlmPoint p2=gates.at(n)->getPoints()->last();
         double x1,y1,x2,y2;
-        proj->map2screenDouble(p1.lon,p1.lat,&x1,&y1);
-        proj->map2screenDouble(p2.lon,p2.lat,&x2,&y2);
-        if(!proj->isInBounderies(x1,y1)) continue;
-        if(!proj->isInBounderies(x2,y2)) continue;
+        frame.map2frame(p1.lon,p1.lat,&x1,&y1);
+        frame.map2frame(p2.lon,p2.lat,&x2,&y2);
+        if(!visibleArea.contains(x1,y1)) continue;
+        if(!visibleArea.contains(x2,y2)) continue;
         QPointF P1(x1,y1);
         QPointF P2(x2,y2);
         if(x1>x2)
@@ -1282,42 +1257,41 @@ void ROUTAGE::slot_calculate()
     orth.setPoints(start.x(),start.y(),arrival.x(),arrival.y());
     loxoCap=orth.getAzimutDeg();
     initialDist=orth.getDistance();
-    proj->setFrozen(true);
     iso=new vlmLine(proj,myscene,Z_VALUE_ROUTAGE);
     iso->setParent(this);
-    vlmPoint point(start.x(),start.y());
-    point.convertionLat=point.lat;
-    point.convertionLon=point.lon;
-    point.isStart=true;
-    proj->map2screenDouble(start.x(),start.y(),&xs,&ys);
-    proj->map2screenDouble(arrival.x(),arrival.y(),&xa,&ya);
-    point.x=xs;
-    point.y=ys;
+    frame.map2frame(start.x(),start.y(),&xs,&ys);
+    frame.map2frame(arrival.x(),arrival.y(),&xa,&ya);
+    buildContext();
+    tempPoints.clear();
+    lastPoints.clear();
+    lastPoints.append(start.x(),start.y(),-1);
+    lastPoints.x[0]=xs;
+    lastPoints.y[0]=ys;
     if(routageOrtho)
     {
-        point.distArrival=initialDist;
-        point.distStart=0;
-        point.capArrival=orth.getAzimutDeg();
-        point.capStart=point.capArrival;
+        lastPoints.distArrival[0]=initialDist;
+        lastPoints.distStart[0]=0;
+        lastPoints.capArrival[0]=orth.getAzimutDeg();
+        lastPoints.capStart[0]=lastPoints.capArrival.at(0);
     }
     else
     {
-        QLineF tempLine(point.x,point.y,xa,ya);
-        point.distStart=0;
-        point.distArrival=tempLine.length();
-        point.capArrival=Util::A360(-tempLine.angle()+90.0);
-        point.capStart=point.capArrival;
-        point.distOrigin=0;
+        QLineF tempLine(xs,ys,xa,ya);
+        lastPoints.distStart[0]=0;
+        lastPoints.distArrival[0]=tempLine.length();
+        lastPoints.capArrival[0]=Util::A360(-tempLine.angle()+90.0);
+        lastPoints.capStart[0]=lastPoints.capArrival.at(0);
+        lastPoints.distOrigin[0]=0;
         initialDist=tempLine.length();
     }
     approaching=false;
-    point.origin=NULL;
-    point.routage=this;
-    point.capOrigin=Util::A360(loxoCap);
+    lastPoints.capOrigin[0]=Util::A360(loxoCap);
     if(i_iso)
-        point.eta=i_eta;
+        lastPoints.eta[0]=i_eta;
     else
-        point.eta=eta;
+        lastPoints.eta[0]=eta;
+    vlmPoint point=lastPoints.toVlmPoint(0);
+    point.origin=NULL;
     point.isoIndex=0;
     pivotPoint=point;
     iso->addVlmPoint(point);
@@ -1364,38 +1338,53 @@ void ROUTAGE::slot_calculate()
 #ifdef traceTime
         tfp.start();
 #endif
-        for(int n=0;n<list->size();++n)
+        if(i_iso)
+            workEta = i_eta;
+        else
+            workEta = eta;
+        if(whatIfUsed && whatIfJour<=workEta)
+            workEta=workEta+whatIfTime*3600;
+        /* wind and current of the whole isochrone in one pass, the records around workEta being looked up once */
+        bool hasCurrent=dataManager->hasData(DATA_CURRENT_VX,DATA_LV_MSL,0);
+        const int isoSize=lastPoints.size();
+        QVector<double> isoTws(isoSize),isoTwd(isoSize),isoCs(isoSize),isoCd(isoSize);
+        QVector<bool> isoWindOk(isoSize),isoCurrentOk(isoSize,false);
+        GribSampler sampler;
+        dataManager->init_windSampler(&sampler,workEta,INTERPOLATION_DEFAULT);
+        sampler.sample(lastPoints.lon.constData(),lastPoints.lat.constData(),isoSize,isoTws.data(),isoTwd.data(),isoWindOk.data());
+        if(hasCurrent)
+        {
+            dataManager->init_currentSampler(&sampler,workEta,INTERPOLATION_DEFAULT);
+            sampler.sample(lastPoints.lon.constData(),lastPoints.lat.constData(),isoSize,isoCs.data(),isoCd.data(),isoCurrentOk.data());
+        }
+        for(int n=0;n<isoSize;++n)
         {
-            if(list->at(n).isDead)
+            if(lastPoints.isDead.at(n))
             {
                 continue;
             }
-            if(list->at(n).distArrival<minDist)
+            if(lastPoints.distArrival.at(n)<minDist)
             {
-                minDist=list->at(n).distArrival;
-                distStart=list->at(n).distStart;
+                minDist=lastPoints.distArrival.at(n);
+                distStart=lastPoints.distStart.at(n);
                 if(!i_iso && distStart>0 && ((eta-etaStart)*minDist)/distStart < 12*3600)
                     approaching=true;
             }
-            double windSpeed,windAngle;
+            double windSpeed=isoTws.at(n);
+            double windAngle=isoTwd.at(n);
             double current_speed=-1;
             double current_angle=0;
-            if(i_iso)
-                workEta = i_eta;
-            else
-                workEta = eta;
-            if(whatIfUsed && whatIfJour<=workEta)
-                workEta=workEta+whatIfTime*3600;
-            if(!dataManager->getInterpolatedWind((double) list->at(n).lon,(double) list->at(n).lat,
-                   workEta,&windSpeed,&windAngle,INTERPOLATION_DEFAULT)||workEta+this->getTimeStep()*60>maxDate)
+            if(!isoWindOk.at(n)||workEta+this->getTimeStep()*60>maxDate)
             {
+                lastPoints.isDead[n]=true;
                 iso->setPointDead(n);
                 continue;
             }
             windAngle=radToDeg(windAngle);
-            if(dataManager->hasData(DATA_CURRENT_VX,DATA_LV_MSL,0) && dataManager->getInterpolatedCurrent((double) list->at(n).lon,(double) list->at(n).lat,
-                   workEta,&current_speed,&current_angle,INTERPOLATION_DEFAULT))
+            if(isoCurrentOk.at(n))
             {
+                current_speed=isoCs.at(n);
+                current_angle=isoCd.at(n);
                 current_angle=radToDeg(current_angle);
                 QPointF p=Util::calculateSumVect(windAngle,windSpeed,current_angle,current_speed);
                 windSpeed=p.x();
@@ -1414,10 +1403,14 @@ void ROUTAGE::slot_calculate()
                 current_angle=Util::A360(current_angle+180.0);
             }
             ++nbNotDead;
+            lastPoints.wind_angle[n]=windAngle;
+            lastPoints.wind_speed[n]=windSpeed;
+            lastPoints.current_angle[n]=current_angle;
+            lastPoints.current_speed[n]=current_speed;
             iso->setPointWind(n,windAngle,windSpeed);
             iso->setPointCurrent(n,current_angle,current_speed);
             double vmg;
-            myBoat->getPolarData()->getBvmg(Util::A360(list->at(n).capArrival-windAngle),windSpeed,&vmg);
+            myBoat->getPolarData()->getBvmg(Util::A360(lastPoints.capArrival.at(n)-windAngle),windSpeed,&vmg);
             //iso->setPointCapVmg(n,Util::A360(vmg+windAngle));
         }
 #ifdef traceTime
@@ -1429,6 +1422,7 @@ void ROUTAGE::slot_calculate()
             arrivalIsClosest=false;
         if(nbNotDead==0)
             break;
+        refreshContext();
         double workAngleStep=0;
         double workAngleRange=0;
         tempPoints.clear();
@@ -1437,12 +1431,32 @@ void ROUTAGE::slot_calculate()
         time.start();
 #endif
         bool hasTouchCoast=false;
-//        int passe=0;
-        for(int n=0;n<list->size();++n)
+/*expansion: generate the candidates of every live point first, evaluate them in one batched pass, then filter*/
+#ifdef traceTime
+        QTime isoTime;
+        isoTime.start();
+        int nbCandidates=0;
+#endif
+        QList<isoColumns> candidates;
+        candidates.reserve(lastPoints.size());
+/*the legs from every origin to the arrival are tested against the coast in one batch*/
+        QBitArray blockedToArrival(lastPoints.size(),false);
+        if(useConverge && arrivalIsClosest && !lastPoints.isEmpty() && !lastPoints.isStart(0) && checkCoast && map)
+        {
+            QList<QLineF> legs;
+            for(int n=0;n<lastPoints.size();++n)
+                legs.append(QLineF(lastPoints.lon.at(n),lastPoints.lat.at(n),arrival.x(),arrival.y()));
+            map->crossing(legs,&blockedToArrival);
+        }
+        for(int n=0;n<lastPoints.size();++n)
         {
             if(aborted) break;
-            if(list->at(n).isDead) continue;
-            if(list->at(0).isStart)
+            if(lastPoints.isDead.at(n))
+            {
+                candidates.append(isoColumns());
+                continue;
+            }
+            if(lastPoints.isStart(0))
             {
                 workAngleStep=angleStep;
                 workAngleRange=angleRange;
@@ -1452,8 +1466,8 @@ void ROUTAGE::slot_calculate()
         /*force une convergence logarithmique vers l'arrivee*/
                 if(useConverge && arrivalIsClosest /*&& !i_iso*/)
                 {
-                    if((checkCoast && map && map->crossing(QLineF(list->at(n).x,list->at(n).y,xa,ya),QLineF(list->at(n).lon,list->at(n).lat,arrival.x(),arrival.y())))
-                            || (checkLine && crossBarriere(QLineF(list->at(n).x,list->at(n).y,xa,ya))))
+                    if(blockedToArrival.testBit(n)
+                            || (checkLine && crossBarriere(QLineF(lastPoints.x.at(n),lastPoints.y.at(n),xa,ya))))
                     {
                         workAngleRange=angleRange;
                         workAngleStep=qMax(3.0,angleStep);
@@ -1462,7 +1476,7 @@ void ROUTAGE::slot_calculate()
                     {
                         workAngleRange=qMax((double)angleRange/2.0,
                                             qMin((double) angleRange,
-                                                 (double)angleRange/(1.0+log(2.0*(list->at(n).distArrival/minDist)))));
+                                                 (double)angleRange/(1.0+log(2.0*(lastPoints.distArrival.at(n)/minDist)))));
                         workAngleStep=qMax(angleStep/2.0,workAngleRange/(angleRange/angleStep));
                         workAngleStep=qMax(3.0,workAngleStep); /*this allows less points generated but keep orginal total per iso*/
                     }
@@ -1473,279 +1487,82 @@ void ROUTAGE::slot_calculate()
                     workAngleStep=qMax(3.0,angleStep);
                 }
             }
-            double windAngle=list->at(n).wind_angle;
-            double windSpeed=list->at(n).wind_speed;
-            double currentAngle=list->at(n).current_angle;
-            double currentSpeed=list->at(n).current_speed;
             QList<double> caps;
             caps.reserve(workAngleRange/workAngleStep);
-            calculateCaps(&caps,list->at(n),workAngleStep,workAngleRange);
-            QList<vlmPoint> polarPoints;/**/
-            bool tryingToFindHole=false;
-#if 1 /*calculate angle limits*/
-            QLineF limitRight,limitLeft;
-            if(n>1)
-            {
-                limitRight.setPoints(QPointF(list->at(n-2).x,list->at(n-2).y),QPointF(xa,ya));
-//                limitRight.setAngle(A360(90-list->at(n).capVmg));
-                limitRight.setAngle(Util::A360(90-list->at(n-2).capOrigin));
-                limitRight.setLength(list->at(n-2).distIso);
-            }
-            if(n<list->size()-2)
-            {
-                limitLeft.setPoints(QPointF(list->at(n+2).x,list->at(n+2).y),QPointF(xa,ya));
-//                limitLeft.setAngle(A360(90-list->at(n).capVmg));
-                limitLeft.setAngle(Util::A360(90-list->at(n+2).capOrigin));
-                limitLeft.setLength(list->at(n+2).distIso);
-            }
-#endif
-//            int nbHitsLand=0;
-//            bool reverseCap=false;
-            while(true)
-            {
-                QList<vlmPoint> findPoints;
-                findPoints.reserve(caps.size());
-                for(int ccc=0;ccc<caps.size();++ccc)
-                {
-                    ++nbCaps;
-    #if 1 /*use angle limits*/
-                    if(!tryingToFindHole && !list->at(0).isStart && !list->at(n).notSimplificable)
-                    {
-                        QLineF temp(list->at(n).x,list->at(n).y,xa,ya);
-                        temp.setAngle(Util::A360(90-caps.at(ccc)));
-                        temp.setLength(list->at(n).distIso);
-                        QPointF dummy;
-                        if(n>1)
-                        {
-                            if(list->at(n).distIso<list->at(n-1).distIso)
-                            {
-                                if(temp.intersect(limitRight,&dummy)==QLineF::BoundedIntersection)
-                                {
-                                    ++nbCapsPruned;
-                                    continue;
-                                }
-                            }
-                        }
-                        if(n<list->size()-2)
-                        {
-                            if(list->at(n).distIso<list->at(n+1).distIso)
-                            {
-                                if(temp.intersect(limitLeft,&dummy)==QLineF::BoundedIntersection)
-                                {
-                                    ++nbCapsPruned;
-                                    continue;
-                                }
-                            }
-                        }
-                    }
-
-    #endif
-                    vlmPoint newPoint(0,0);
-                    cap=caps.at(ccc);
-                    newPoint.routage=this;
-                    newPoint.origin=iso->getPoint(n);
-                    newPoint.originNb=n;
-                    newPoint.wind_angle=windAngle;
-                    newPoint.wind_speed=windSpeed;
-                    newPoint.current_speed=currentSpeed;
-                    newPoint.current_angle=currentAngle;
-                    newPoint.capOrigin=cap;
-                    if(i_iso)
-                        newPoint.eta=i_eta;
-                    else
-                        newPoint.eta=eta;
-                    if(n!=list->size()-1)
-                    {
-                        QLineF line1(xa,ya,newPoint.origin->x,newPoint.origin->y);
-                        QLineF line2(xa,ya,list->at(n+1).x,list->at(n+1).y);
-                        if(qAbs(Util::A180(qAbs(line1.angleTo(line2))))<60)
-                        {
-                            newPoint.xP1=list->at(n+1).x;
-                            newPoint.yP1=list->at(n+1).y;
-                        }
-                    }
-                    if(n!=0)
-                    {
-                        QLineF line1(xa,ya,newPoint.origin->x,newPoint.origin->y);
-                        QLineF line2(xa,ya,list->at(n-1).x,list->at(n-1).y);
-                        if(qAbs(Util::A180(qAbs(line1.angleTo(line2))))<60)
-                        {
-                            newPoint.xM1=list->at(n-1).x;
-                            newPoint.yM1=list->at(n-1).y;
-                        }
-                    }
-                    findPoints.append(newPoint);
-                }
-#ifdef traceTime
-                tfp.start();
-#endif
-                if(!this->useMultiThreading)
-                    findPoints=findPointThreaded(findPoints);
-                else
-                {
-                    QList<QList<vlmPoint> > listList;
-                    QList<vlmPoint> tempList;
-                    int pp=0;
-                    int threadCount=qMax(1,QThread::idealThreadCount()*2);
-                    for (int t=1;t<=threadCount;++t)
-                    {
-                        tempList.clear();
-                        for (;(double)pp<(double)findPoints.size()*(double)t/(double)threadCount;++pp)
-                        {
-                            tempList.append(findPoints.at(pp));
-                        }
-                        listList.append(tempList);
-                    }
-                    tempList.clear();
-                    //qWarning()<<"1 listlist has"<<listList.size();
-                    listList = QtConcurrent::blockingMapped(listList, ROUTAGE::findPointThreaded);
-                    //qWarning()<<"2 listlist has"<<listList.size();
-                    findPoints.clear();
-                    for(int l=0;l<listList.size();++l)
-                        findPoints.append(listList.at(l));
-                    //qWarning()<<"findPoints has"<<findPoints.size();
-                }
-//                for (int pp=findPoints.size()-1;pp>=0;--pp)
-//                {
-//                    if(findPoints.at(pp).isDead)
-//                        findPoints.removeAt(pp);
-//                }
-#ifdef traceTime
-                msecs_3=msecs_3+tfp.elapsed();
-#endif
-                bool toBeRestarted=false;
-                for(int fp=0;fp<findPoints.size();++fp)
-                {
-                    vlmPoint newPoint=findPoints.at(fp);
-                    if(checkCoast||checkLine)
-                    {
-/*check crossing with coast*/
+            calculateCaps(&caps,lastPoints.capArrival.at(n),workAngleStep,workAngleRange);
+            candidates.append(generateCandidates(n,caps,false,&nbCaps,&nbCapsPruned));
 #ifdef traceTime
-                        tfp.start();
+            nbCandidates+=candidates.last().size();
 #endif
-                        double twa_x=qAbs(newPoint.capOrigin-newPoint.wind_angle);
-                        if(qAbs(twa_x)>180)
-                        {
-                            if(twa_x<0)
-                                twa_x=360+twa_x;
-                            else
-                                twa_x=twa_x-360;
-                        }
-                        twa_x=qAbs(twa_x);
-                        if((checkCoast && map && map->crossing(QLineF(list->at(n).x,list->at(n).y,newPoint.x,newPoint.y),QLineF(list->at(n).lon,list->at(n).lat,newPoint.lon,newPoint.lat)))
-                                || (checkLine && crossBarriere(QLineF(list->at(n).x,list->at(n).y,newPoint.x,newPoint.y))) ||
-                            (twa_x<=90 && newPoint.wind_speed>this->maxPres) ||
-                            (twa_x<=90 && newPoint.wind_speed<this->minPres) ||
-                            (twa_x>=90 && newPoint.wind_speed>this->maxPortant) ||
-                            (twa_x>=90 && newPoint.wind_speed<this->minPortant) ||
-                            (dataWave>0 && dataManager->getInterpolatedValue_1D(dataWave,DATA_LV_GND_SURF,0,newPoint.lon,newPoint.lat,newPoint.eta)>maxWaveHeight))
-                        {
+        }
+        if(aborted)
+            break;
 #ifdef traceTime
-                            msecs_14=msecs_14+tfp.elapsed();
-#endif
-                            if(!tryingToFindHole)
-                            {
-                                toBeRestarted=true;
-                                tryingToFindHole=true;
-                                hasTouchCoast=true;
-                                polarPoints.clear();
-                                caps.clear();
-                                caps.reserve(180);
-                                calculateCaps(&caps,list->at(n),1,179);
-                                iso->setNotSimplificable(n);
-                                break;
-                            }
-#if 0
-                            if(!reverseCap && fp==findPoints.size()-1 && polarPoints.isEmpty() && nbHitsLand>findPoints.size()*.9)
-                            {
-                                reverseCap=true;
-                                toBeRestarted=true;
-                                tryingToFindHole=true;
-                                hasTouchCoast=true;
-                                polarPoints.clear();
-                                caps.clear();
-                                caps.reserve(180);
-                                vlmPoint pt=list->at(n);
-                                pt.capArrival=pt.capStart;
-                                pt.capVmg=-1;
-                                qWarning()<<"inside lastTrick with"<<pt.capArrival<<pt.capStart<<findPoints.size()<<nbHitsLand;
-                                calculateCaps(&caps,pt,1,179);
-                                iso->setNotSimplificable(n);
-                                break;
-                            }
-                            ++nbHitsLand;
+        int msecsGenerate=isoTime.elapsed();
+        tfp.start();
 #endif
-                            continue;
-                        }
+        evaluateCandidates(&candidates);
+        checkCandidates(&candidates);
 #ifdef traceTime
-                        msecs_14=msecs_14+tfp.elapsed();
+        msecs_3=msecs_3+tfp.elapsed();
+        int msecsEvaluate=isoTime.elapsed()-msecsGenerate;
 #endif
-                    }
+/*points touching coast or out of limits are re-expanded with a 1 degree step to find a hole, again in one batch*/
 #ifdef traceTime
-                    tfp.start();
+        tfp.start();
 #endif
+        QList<isoColumns> polarPointsList;
+        QList<int> restartOrigins;
+        QList<isoColumns> restartCandidates;
+        polarPointsList.reserve(candidates.size());
+        for(int n=0;n<candidates.size();++n)
+        {
+            bool toBeRestarted=false;
+            polarPointsList.append(filterCandidates(candidates.at(n),false,dataWave,&toBeRestarted));
+            if(!toBeRestarted) continue;
+            hasTouchCoast=true;
+            QList<double> caps;
+            caps.reserve(180);
+            calculateCaps(&caps,lastPoints.capArrival.at(n),1,179);
+            lastPoints.notSimplificable[n]=true;
+            iso->setNotSimplificable(n);
+            restartOrigins.append(n);
+            restartCandidates.append(generateCandidates(n,caps,true,&nbCaps,&nbCapsPruned));
 #ifdef traceTime
-                    msecs_21=msecs_21+tfp.elapsed();
-#endif
-                    if(tryingToFindHole)
-                        newPoint.notSimplificable=true;
-#if 0
-                    else if(!list->at(n).notSimplificable && !list->first().isStart)
-                    {
-                        if(newPoint.distStart<newPoint.distArrival)
-                        {
-                            if(newPoint.distStart<list->at(n).distStart) continue;
-                        }
-                        else
-                        {
-                            if(newPoint.distArrival>list->at(n).distArrival) continue;
-                        }
-                    }
-#endif
-                    polarPoints.append(newPoint);
-                } /*end looping on caps*/
-                if(!toBeRestarted || aborted) break;
-                polarPoints.clear();
-            }
-            if(aborted)
-                break;
-#if 0 /* keep only max 80% of initial number of points per polar, based on distIso*/
-            if(!tryingToFindHole && !list->at(n).isStart && !list->at(n).notSimplificable)
-            {
-                int max=(angleRange/angleStep)*0.8;
-                if(max<polarPoints.size())
-                {
-                    QMultiMap<double,vlmPoint> dist;
-                    for (int nn=polarPoints.size()-1;nn>=0;--nn)
-                    {
-                        dist.insert(polarPoints.at(nn).distIso,polarPoints.at(nn));
-                    }
-//                    QMapIterator<double,vlmPoint> it(dist);
-//                    it.toFront();
-//                    while(it.hasNext() && polarPoints.size()>max)
-                    QMap<double,vlmPoint>::const_iterator it;
-                    for(it=dist.constBegin();polarPoints.size()>max && it!=dist.constEnd();++it)
-                    {
-                        polarPoints.removeOne(it.value());
-                    }
-                }
-            }
+            nbCandidates+=restartCandidates.last().size();
 #endif
-            //qWarning()<<nbIso<<"/"<<n<<"generated"<<polarPoints.size()<<"points";
-            if(!polarPoints.isEmpty())
+        }
+        if(!restartCandidates.isEmpty())
+        {
+            evaluateCandidates(&restartCandidates);
+            checkCandidates(&restartCandidates);
+            for(int r=0;r<restartOrigins.size();++r)
             {
-                tempPoints.append(polarPoints);
+                bool toBeRestarted=false;
+                polarPointsList[restartOrigins.at(r)]=filterCandidates(restartCandidates.at(r),true,dataWave,&toBeRestarted);
             }
         }
+        for(int n=0;n<polarPointsList.size();++n)
+        {
+            //qWarning()<<nbIso<<"/"<<n<<"generated"<<polarPointsList.at(n).size()<<"points";
+            if(!polarPointsList.at(n).isEmpty())
+                tempPoints.append(polarPointsList.at(n));
+        }
+#ifdef traceTime
+        msecs_14=msecs_14+tfp.elapsed();
+        qWarning()<<"isochrone"<<nbIso+1<<":"<<nbCandidates<<"candidates"<<"("<<restartOrigins.size()<<"re-expanded)"
+                  <<"generation"<<msecsGenerate<<"ms, evaluation"<<msecsEvaluate<<"ms, filtering"
+                  <<isoTime.elapsed()-msecsGenerate-msecsEvaluate<<"ms"<<(useMultiThreading?"(batched on":"(serial")
+                  <<(useMultiThreading?QThread::idealThreadCount():1)<<"threads)";
+#endif
 #ifdef debugCount
         this->countDebug(nbIso,"initial count in tempPoints");
         for(int deb=tempPoints.size()-1;deb>=0;--deb)
         {
-            vlmPoint point=tempPoints.at(deb);
-            if(!point.origin->isStart)
+            if(!lastPoints.isStart(tempPoints.origin.at(deb)))
             {
                 QPolygonF * shape=this->getShapeIso();
-                QPointF p=QPointF(point.x,point.y);
+                QPointF p=QPointF(tempPoints.x.at(deb),tempPoints.y.at(deb));
                 if(shape->containsPoint(p,Qt::OddEvenFill))
                 {
                     tempPoints.removeAt(deb);
@@ -1764,7 +1581,7 @@ void ROUTAGE::slot_calculate()
         time.start();
 #endif
 #if 1
-        if(tempPoints.size()>0 && !tempPoints.first().origin->isStart)
+        if(tempPoints.size()>0 && !lastPoints.isStart(tempPoints.origin.first()))
              removeCrossedSegments();
 #endif
 #ifdef debugCount
@@ -1780,7 +1597,7 @@ void ROUTAGE::slot_calculate()
 #ifdef traceTime
         time.start();
 #endif
-        if(!tempPoints.at(0).origin->isStart)
+        if(!lastPoints.isStart(tempPoints.origin.at(0)))
         {
             checkIsoCrossingPreviousSegments();
         }
@@ -1795,7 +1612,7 @@ void ROUTAGE::slot_calculate()
 #ifdef traceTime
         time.start();
 #endif
-        if(arrivalIsClosest && !tempPoints.first().origin->isStart)
+        if(arrivalIsClosest && !lastPoints.isStart(tempPoints.origin.first()))
         {
             pruneWake(pruneWakeAngle);
         }
@@ -1831,30 +1648,30 @@ void ROUTAGE::slot_calculate()
 #ifdef traceTime
         time.start();
 #endif
-        if(!tempPoints.isEmpty() && !tempPoints.first().origin->isStart)
+        if(!tempPoints.isEmpty() && !lastPoints.isStart(tempPoints.origin.first()))
         {
             int nbPathSmooth=i_iso?10:2;
             for(int pass=1;pass<=nbPathSmooth;++pass)
             {
                 for(int jj=1;jj<tempPoints.size()-1;++jj)
                 {
-                    if(tempPoints.at(jj).notSimplificable &&
-                       !tempPoints.at(jj-1).notSimplificable &&
-                       !tempPoints.at(jj+1).notSimplificable)
+                    if(tempPoints.notSimplificable.at(jj) &&
+                       !tempPoints.notSimplificable.at(jj-1) &&
+                       !tempPoints.notSimplificable.at(jj+1))
                         continue;
-                    if(tempPoints.at(jj).origin->notSimplificable &&
-                       !tempPoints.at(jj-1).origin->notSimplificable &&
-                       !tempPoints.at(jj+1).origin->notSimplificable)
+                    if(lastPoints.notSimplificable.at(tempPoints.origin.at(jj)) &&
+                       !lastPoints.notSimplificable.at(tempPoints.origin.at(jj-1)) &&
+                       !lastPoints.notSimplificable.at(tempPoints.origin.at(jj+1)))
                         continue;
-                    if(tempPoints.at(jj).distIso<tempPoints.at(jj-1).distIso &&
-                       tempPoints.at(jj).distIso<tempPoints.at(jj+1).distIso)
+                    if(tempPoints.distIso.at(jj)<tempPoints.distIso.at(jj-1) &&
+                       tempPoints.distIso.at(jj)<tempPoints.distIso.at(jj+1))
                     {
-                        QLineF temp1(tempPoints.at(jj).x,tempPoints.at(jj).y,
-                                     tempPoints.at(jj-1).x,tempPoints.at(jj-1).y);
-                        QLineF temp2(tempPoints.at(jj).x,tempPoints.at(jj).y,
-                                     tempPoints.at(jj+1).x,tempPoints.at(jj+1).y);
-                        if(temp1.length()>tempPoints.at(jj).distIso*5.0) continue;
-                        if(temp2.length()>tempPoints.at(jj).distIso*5.0) continue;
+                        QLineF temp1(tempPoints.x.at(jj),tempPoints.y.at(jj),
+                                     tempPoints.x.at(jj-1),tempPoints.y.at(jj-1));
+                        QLineF temp2(tempPoints.x.at(jj),tempPoints.y.at(jj),
+                                     tempPoints.x.at(jj+1),tempPoints.y.at(jj+1));
+                        if(temp1.length()>tempPoints.distIso.at(jj)*5.0) continue;
+                        if(temp2.length()>tempPoints.distIso.at(jj)*5.0) continue;
                         double a=qAbs(temp1.angleTo(temp2));
                         if(a>180) a=360-a;
                         if(a>120) continue;
@@ -1896,7 +1713,7 @@ void ROUTAGE::slot_calculate()
             QTime t1,t2;
             t1.start();
 #endif
-            if(!tempPoints.first().origin->isStart && nbLoop<=5)
+            if(!lastPoints.isStart(tempPoints.origin.first()) && nbLoop<=5)
             {
                 checkIsoCrossingPreviousSegments();
             }
@@ -1917,32 +1734,14 @@ void ROUTAGE::slot_calculate()
                 routeDone=true;
                 if(useMultiThreading)
                 {
-                    QList<QList<vlmPoint> > listList;
-                    QList<vlmPoint> tempList;
-                    int pp=0;
 #if 1
-                    int threadCount=qMax(1,QThread::idealThreadCount()*2);
-                    for (int t=1;t<=threadCount;++t)
-                    {
-                        tempList.clear();
-                        for (;(double)pp<(double)tempPoints.size()*(double)t/(double)threadCount;++pp)
-                        {
-                            tempList.append(tempPoints.at(pp));
-                        }
-                        listList.append(tempList);
-                    }
+                    QList<isoColumns> listList=tempPoints.split(qMax(1,QThread::idealThreadCount()*2));
 #else
-                    for (pp=0;pp<tempPoints.size();++pp)
-                    {
-                        tempList.clear();
-                        tempList.append(tempPoints.at(pp));
-                        listList.append(tempList);
-                    }
+                    QList<isoColumns> listList=tempPoints.split(tempPoints.size());
 #endif
-                    tempList.clear();
-                    listList = QtConcurrent::blockingMapped(listList, ROUTAGE::findRoute);
+                    listList = QtConcurrent::blockingMapped(listList, contextMapper<isoColumns,ROUTAGE::findRoute>(&context));
                     tempPoints.clear();
-                    for(pp=0;pp<listList.size();++pp)
+                    for(int pp=0;pp<listList.size();++pp)
                         tempPoints.append(listList.at(pp));
 #ifdef debugCount
                     this->countDebug(nbIso,"after calculating route");
@@ -1950,18 +1749,16 @@ void ROUTAGE::slot_calculate()
                 }
                 for(int np=0;np<tempPoints.size();++np)
                 {
-                    vlmPoint newPoint=tempPoints.at(np);
                     if(!useMultiThreading)
                     {
-                        QList<vlmPoint> tempPList;
-                        tempPList.append(newPoint);
-                        tempPList=findRoute(tempPList);
+                        isoColumns tempPList;
+                        tempPList.append(tempPoints,np);
+                        tempPList=findRoute(context,tempPList);
                         if(tempPList.isEmpty()) continue;
-                        newPoint=tempPList.first();
+                        tempPoints.replace(np,tempPList,0);
                     }
-                    if(this->visibleOnly && !proj->isInBounderies(newPoint.x,newPoint.y))
-                        newPoint.isDead=true;
-                    if(newPoint.isDead)
+                    if(tempPoints.isDead.at(np) ||
+                       (this->visibleOnly && !visibleArea.contains(tempPoints.x.at(np),tempPoints.y.at(np))))
                     {
                         tempPoints.removeAt(np);
                         --np;
@@ -1969,7 +1766,8 @@ void ROUTAGE::slot_calculate()
                     }
                     if(np!=0)
                     {
-                        if(tempPoints.at(np-1)==newPoint)
+                        if(qRound(tempPoints.lon.at(np-1)*10e6)==qRound(tempPoints.lon.at(np)*10e6) &&
+                           qRound(tempPoints.lat.at(np-1)*10e6)==qRound(tempPoints.lat.at(np)*10e6))
                         {
                             tempPoints.removeAt(np);
                             --np;
@@ -1977,21 +1775,22 @@ void ROUTAGE::slot_calculate()
                         }
                     }
                     double x,y;
-                    proj->map2screenDouble(newPoint.lon,newPoint.lat,&x,&y);
-                    newPoint.x=x;
-                    newPoint.y=y;
+                    frame.map2frame(tempPoints.lon.at(np),tempPoints.lat.at(np),&x,&y);
+                    tempPoints.x[np]=x;
+                    tempPoints.y[np]=y;
 #if 1 /*check again if crossing with coast*/
                     if((checkCoast||checkLine) && !this->useMultiThreading)
                     {
 #ifdef traceTime
                         t2.start();
 #endif
+                        const int o=tempPoints.origin.at(np);
                         double x1,y1,x2,y2;
-                        x1=newPoint.origin->x;
-                        y1=newPoint.origin->y;
-                        x2=newPoint.x;
-                        y2=newPoint.y;
-                        if((checkCoast && map && map->crossing(QLineF(x1,y1,x2,y2),QLineF(newPoint.origin->lon,newPoint.origin->lat,newPoint.lon,newPoint.lat)))
+                        x1=lastPoints.x.at(o);
+                        y1=lastPoints.y.at(o);
+                        x2=x;
+                        y2=y;
+                        if((checkCoast && map && map->crossing(QLineF(lastPoints.lon.at(o),lastPoints.lat.at(o),tempPoints.lon.at(np),tempPoints.lat.at(np))))
                             ||( checkLine && crossBarriere(QLineF(x1,y1,x2,y2))))
                         {
 #ifdef traceTime
@@ -2004,7 +1803,7 @@ void ROUTAGE::slot_calculate()
 #ifdef traceTime
                         msecs_14=msecs_14+t2.elapsed();
 #endif
-                        if(this->getVisibleOnly() && !proj->isInBounderies_strict(x2,y2))
+                        if(this->getVisibleOnly() && !visibleArea.contains(x2,y2))
                         {
                             tempPoints.removeAt(np);
                             --np;
@@ -2013,12 +1812,11 @@ void ROUTAGE::slot_calculate()
                     }
 #endif
 #if 0
-                    if(newPoint.origin->isStart)
-                        newPoint.distIso=newPoint.distStart;
+                    if(lastPoints.isStart(tempPoints.origin.at(np)))
+                        tempPoints.distIso[np]=tempPoints.distStart.at(np);
                     else
-                        newPoint.distIso=ROUTAGE::findDistancePreviousIso(newPoint, &shapeIso);
+                        tempPoints.distIso[np]=ROUTAGE::findDistancePreviousIso(x,y,&shapeIso);
 #endif
-                    tempPoints.replace(np,newPoint);
                 }
 #ifdef debugCount
                 this->countDebug(nbIso,"before checkCoastCollision");
@@ -2028,22 +1826,33 @@ void ROUTAGE::slot_calculate()
 #ifdef traceTime
                     t2.start();
 #endif
-                    tempPoints = QtConcurrent::blockingMapped(tempPoints, ROUTAGE::checkCoastCollision);
+/*one list per origin, as for the candidates*/
+                    QList<isoColumns> listList;
+                    for (int pp=0;pp<tempPoints.size();++pp)
+                    {
+                        if(pp==0 || tempPoints.origin.at(pp)!=tempPoints.origin.at(pp-1))
+                            listList.append(isoColumns());
+                        listList.last().append(tempPoints,pp);
+                    }
+                    checkCandidates(&listList);
+                    tempPoints.clear();
+                    for(int l=0;l<listList.size();++l)
+                        tempPoints.append(listList.at(l));
+                    QBitArray removed(tempPoints.size(),false);
                     for (int np=0;np<tempPoints.size();++np)
                     {
-                        if(tempPoints.at(np).isDead)
+                        if(tempPoints.isDead.at(np))
                         {
-                            tempPoints.removeAt(np);
-                            --np;
+                            removed.setBit(np);
                             continue;
                         }
-                        if(this->getVisibleOnly() && !proj->isInBounderies_strict(tempPoints.at(np).x,tempPoints.at(np).y))
+                        if(this->getVisibleOnly() && !visibleArea.contains(tempPoints.x.at(np),tempPoints.y.at(np)))
                         {
-                            tempPoints.removeAt(np);
-                            --np;
+                            removed.setBit(np);
                             continue;
                         }
                     }
+                    tempPoints.remove(removed);
 #ifdef traceTime
                     msecs_14=msecs_14+t2.elapsed();
 #endif
@@ -2060,12 +1869,11 @@ void ROUTAGE::slot_calculate()
 #endif
                 for (int pp=tempPoints.size()-1;pp>0;--pp)
                 {
-                    vlmPoint pt1=tempPoints.at(pp-1);
-                    vlmPoint pt2=tempPoints.at(pp);
-                    if(pt1.originNb!=pt2.originNb) continue;
-                    Triangle t(Point(pt1.origin->x,pt1.origin->y),
-                               Point(pt1.x,pt1.y),
-                               Point(pt2.x,pt2.y));
+                    const int o=tempPoints.origin.at(pp-1);
+                    if(o!=tempPoints.origin.at(pp)) continue;
+                    Triangle t(Point(lastPoints.x.at(o),lastPoints.y.at(o)),
+                               Point(tempPoints.x.at(pp-1),tempPoints.y.at(pp-1)),
+                               Point(tempPoints.x.at(pp),tempPoints.y.at(pp)));
                     int sens=t.orientation();
                     if (sens!=right_turn && sens!=collinear)
                     {
@@ -2080,7 +1888,7 @@ void ROUTAGE::slot_calculate()
 #ifdef traceTime
                 msecs_17+=t1.elapsed();
 #endif
-                if(tempPoints.size()>0 && !tempPoints.first().origin->isStart)
+                if(tempPoints.size()>0 && !lastPoints.isStart(tempPoints.origin.first()))
                 {
 #ifdef traceTime
                     t1.start();
@@ -2120,7 +1928,7 @@ void ROUTAGE::slot_calculate()
 #ifdef debugCount
         this->countDebug(nbIso,"before final epuration");
 #endif
-        if(tempPoints.size()>limit && !tempPoints.first().origin->isStart)
+        if(tempPoints.size()>limit && !lastPoints.isStart(tempPoints.origin.first()))
         {
             epuration(toBeRemoved);
         }
@@ -2139,37 +1947,38 @@ void ROUTAGE::slot_calculate()
         if(tempPoints.size()>0)
         {
             int mmm=0;
+            vlmLine * previousLine=iso;
             iso=new vlmLine(this->proj,this->myscene,Z_VALUE_ROUTAGE);
             iso->setParent(this);
             double averageGap=0;
             int averageN=0;
+            QBitArray removed(tempPoints.size(),false);
+            for (int n=0;n<tempPoints.size();++n)
+            {
+                if(tempPoints.isDead.at(n))
+                    removed.setBit(n);
+            }
+            tempPoints.remove(removed);
             for (int n=0;n<tempPoints.size();++n)
             {
-                if(tempPoints.at(n).isDead)
-                {
-                    tempPoints.removeAt(n);
-                    --n;
-                    continue;
-                }
-
                 if(n!=tempPoints.size()-1)
                 {
 #ifdef traceTime
                     t2.start();
 #endif
-                    x1=tempPoints.at(n).x;
-                    y1=tempPoints.at(n).y;
-                    x2=tempPoints.at(n+1).x;
-                    y2=tempPoints.at(n+1).y;
+                    x1=tempPoints.x.at(n);
+                    y1=tempPoints.y.at(n);
+                    x2=tempPoints.x.at(n+1);
+                    y2=tempPoints.y.at(n+1);
                     QLineF qf(x1,y1,x2,y2);
-                    if((checkCoast && map && map->crossing(qf,QLineF(tempPoints.at(n).lon,tempPoints.at(n).lat,tempPoints.at(n+1).lon,tempPoints.at(n+1).lat)))
+                    if((checkCoast && map && map->crossing(QLineF(tempPoints.lon.at(n),tempPoints.lat.at(n),tempPoints.lon.at(n+1),tempPoints.lat.at(n+1))))
                         || (checkLine && crossBarriere(qf)))
                     {
-                        tempPoints[n].isBroken=true;
+                        tempPoints.isBroken[n]=true;
                     }
                     else
                     {
-                        tempPoints[n].isBroken=false;
+                        tempPoints.isBroken[n]=false;
                         averageGap+=qf.length();
                         ++averageN;
                     }
@@ -2182,32 +1991,34 @@ void ROUTAGE::slot_calculate()
             averageGap=10.0*averageGap/averageN;
             for (int n=0;n<tempPoints.size();++n)
             {
-                if(n!=tempPoints.size()-1 && !tempPoints.at(n).isBroken)
+                if(n!=tempPoints.size()-1 && !tempPoints.isBroken.at(n))
                 {
-                    x1=tempPoints.at(n).x;
-                    y1=tempPoints.at(n).y;
-                    x2=tempPoints.at(n+1).x;
-                    y2=tempPoints.at(n+1).y;
+                    x1=tempPoints.x.at(n);
+                    y1=tempPoints.y.at(n);
+                    x2=tempPoints.x.at(n+1);
+                    y2=tempPoints.y.at(n+1);
                     QLineF qf(x1,y1,x2,y2);
                     if(qf.length()>averageGap
-                            || Util::myDiffAngle(tempPoints.at(n).capArrival,tempPoints.at(n+1).capArrival)>30.0
-                            || Util::myDiffAngle(tempPoints.at(n).capStart,tempPoints.at(n+1).capStart)>30.0
-                            || Util::myDiffAngle(tempPoints.at(n).capOrigin,tempPoints.at(n+1).capOrigin)>150.0)
-                        tempPoints[n].isBroken=true;
+                            || Util::myDiffAngle(tempPoints.capArrival.at(n),tempPoints.capArrival.at(n+1))>30.0
+                            || Util::myDiffAngle(tempPoints.capStart.at(n),tempPoints.capStart.at(n+1))>30.0
+                            || Util::myDiffAngle(tempPoints.capOrigin.at(n),tempPoints.capOrigin.at(n+1))>150.0)
+                        tempPoints.isBroken[n]=true;
                 }
                 if(i_iso)
-                    tempPoints[n].eta=i_eta-(int)this->getTimeStep()*60.00;
+                    tempPoints.eta[n]=i_eta-(int)this->getTimeStep()*60.00;
                 else
-                    tempPoints[n].eta=eta+(int)this->getTimeStep()*60.00;
-                tempPoints[n].isoIndex=n;
-                tempPoints.at(n).origin->myChildren.append(tempPoints.at(n));
-                iso->addVlmPoint(tempPoints.at(n));
+                    tempPoints.eta[n]=eta+(int)this->getTimeStep()*60.00;
+                /*the working set becomes a vlmPoint only here*/
+                vlmPoint point=tempPoints.toVlmPoint(n);
+                point.origin=previousLine->getPoint(tempPoints.origin.at(n));
+                point.isoIndex=n;
+                iso->addVlmPoint(point);
 #if 0
                 if(n>0)
                 {
-                    if(Util::myDiffAngle(tempPoints.at(n).capArrival,tempPoints.at(n-1).capArrival) < 60)
+                    if(Util::myDiffAngle(tempPoints.capArrival.at(n),tempPoints.capArrival.at(n-1)) < 60)
                     {
-                        previousIso.append(QPointF(tempPoints.at(n).x,tempPoints.at(n).y));
+                        previousIso.append(QPointF(tempPoints.x.at(n),tempPoints.y.at(n)));
                     }
                     else //insert same point not to loose increment
                     {
@@ -2216,55 +2027,32 @@ void ROUTAGE::slot_calculate()
                 }
                 else
                 {
-                    previousIso.append(QPointF(tempPoints.at(n).x,tempPoints.at(n).y));
+                    previousIso.append(QPointF(tempPoints.x.at(n),tempPoints.y.at(n)));
                 }
 #endif
                 if(!i_iso)
                 {
-                    vlmPointGraphic * vg=new vlmPointGraphic(this,nbIso+1,mmm,
-                                                           tempPoints.at(n).lon,
-                                                           tempPoints.at(n).lat,
-                                                           this->proj,this->myscene,
-                                                           Z_VALUE_ISOPOINT);
-                    vg->setParent(this);
+                    isoPoints->addPoint(nbIso+1,mmm,
+                                        tempPoints.lon.at(n),
+                                        tempPoints.lat.at(n),
+                                        eta+(int)this->getTimeStep()*60.00);
                     ++mmm;
-#if 0 //set to 1 to debug extra information on isopoint
-                    if(tempPoints.at(n).isBroken)
-                        vg->setDebug("Broken "+QString().setNum(isochrones.size()+1));
-                    else
-                        vg->setDebug("Not Broken "+QString().setNum(isochrones.size()+1));
-#endif
-                    vg->setEta(eta+(int)this->getTimeStep()*60.00);
-                    connect(this,SIGNAL(updateVgTip(int,int,QString)),vg,SLOT(slot_updateTip(int,int,QString)));
-                    this->isoPointList.append(vg);
-                    vg->slot_showMe();
 #if 0
-                    datathread dataThread;
-                    dataThread.Boat=this->getBoat();
-                    dataThread.dataManager=get_dataManager();
-                    dataThread.whatIfJour=this->getWhatIfJour();
-                    dataThread.whatIfUsed=this->getWhatIfUsed();
-                    dataThread.whatIfTime=this->getWhatIfTime();
-                    dataThread.whatIfWind=this->getWhatIfWind();
-                    dataThread.timeStep=this->getTimeStep();
-                    dataThread.speedLossOnTack=this->getSpeedLossOnTack();
-                    dataThread.i_iso=i_iso;
-                    vlmPoint to=tempPoints.at(n);
-                    to.lon=tempPoints.at(n).convertionLon;
-                    to.lat=tempPoints.at(n).convertionLat;
+                    vlmPoint to=point;
+                    to.lon=tempPoints.convertionLon.at(n);
+                    to.lat=tempPoints.convertionLat.at(n);
                     vlmPoint from(to.origin->lon, to.origin->lat);
-                    dataThread.Eta=to.origin->eta;
+                    datathread dataThread=context.threadData(to.origin->eta);
                     int realTime=calculateTimeRoute(from,to,&dataThread);
                     if(realTime!=this->getTimeStep()*60)
                     {
-                        qWarning()<<"anomaly"<<n<<nbIso+1<<realTime<<to.foundByNewtonRaphson<<"debug="<<to.debug;
+                        qWarning()<<"anomaly"<<n<<nbIso+1<<realTime;
                     }
-//                    else
-//                        qWarning()<<"OK"<<n<<nbIso+1<<realTime<<to.foundByNewtonRaphson<<"dead="<<to.isDead;
-
 #endif
                 }
             }
+            qSwap(lastPoints,tempPoints);
+            tempPoints.clear();
         }
         else
             break;
@@ -2316,18 +2104,6 @@ void ROUTAGE::slot_calculate()
             }
             temp.isBroken=false;
             segment->addVlmPoint(temp);
-#if 0 //debug left-right balancing
-            if(temp.debugInt==0)
-                penSegment.setColor(Qt::black);
-            else if (temp.debugInt==1)
-                penSegment.setColor(Qt::blue);
-            else if (temp.debugInt==2)
-                penSegment.setColor(Qt::red);
-            else if (temp.debugInt==3)
-                penSegment.setColor(Qt::yellow);
-            else if (temp.debugInt==4)
-                penSegment.setColor(Qt::magenta);
-#endif
             segment->setLinePen(penSegment);
             segment->slot_showMe();
             if(i_iso)
@@ -2366,6 +2142,7 @@ void ROUTAGE::slot_calculate()
             i_isochrones.append(iso);
         else
             isochrones.append(iso);
+        setChildren(iso);
 #ifdef traceTime
         time.start();
 #endif
@@ -2379,20 +2156,7 @@ void ROUTAGE::slot_calculate()
 #ifdef traceTime
         time.start();
 #endif
-        datathread dataThread;
-        dataThread.Boat=this->getBoat();
-        if(i_iso)
-            dataThread.Eta=i_eta;
-        else
-            dataThread.Eta=eta;
-        dataThread.dataManager=this->get_dataManager();
-        dataThread.whatIfJour=this->getWhatIfJour();
-        dataThread.whatIfUsed=this->getWhatIfUsed();
-        dataThread.whatIfTime=this->getWhatIfTime();
-        dataThread.whatIfWind=this->getWhatIfWind();
-        dataThread.timeStep=this->getTimeStep();
-        dataThread.speedLossOnTack=this->getSpeedLossOnTack();
-        dataThread.i_iso=i_iso;
+        datathread dataThread=context.threadData(i_iso?i_eta:eta);
         bool i_arrived=false;
         for (int n=0;n<list->size();++n)
         {
@@ -2400,7 +2164,7 @@ void ROUTAGE::slot_calculate()
             orth.setPoints(from.lon,from.lat,to.lon,to.lat);
             if(orth.getDistance()<myBoat->getPolarData()->getMaxSpeed()*1.1*(this->getTimeStep()/60.0))
             {
-                if((checkCoast && map && map->crossing(QLineF(list->at(n).x,list->at(n).y,xa,ya),QLineF(list->at(n).lon,list->at(n).lat,arrival.x(),arrival.y())))
+                if((checkCoast && map && map->crossing(QLineF(list->at(n).lon,list->at(n).lat,arrival.x(),arrival.y())))
                    || (checkLine && crossBarriere(QLineF(list->at(n).x,list->at(n).y,xa,ya))))
                     continue;
                 int thisTime=calculateTimeRoute(from,to, &dataThread, NULL, NULL, (this->getTimeStep()+1)*60);
@@ -2423,21 +2187,10 @@ void ROUTAGE::slot_calculate()
             int nBest=0;
             int minTime=this->getTimeStep()*10000*60;
             vlmPoint to(arrival.x(),arrival.y());
-            datathread dataThread;
-            dataThread.Boat=this->getBoat();
-            dataThread.Eta=this->getEta();
-            dataThread.dataManager=this->get_dataManager();
-            dataThread.whatIfJour=this->getWhatIfJour();
-            dataThread.whatIfUsed=this->getWhatIfUsed();
-            dataThread.whatIfTime=this->getWhatIfTime();
-            dataThread.whatIfWind=this->getWhatIfWind();
-            dataThread.timeStep=this->getTimeStep();
-            dataThread.speedLossOnTack=this->getSpeedLossOnTack();
-            dataThread.i_iso=i_iso;
+            datathread dataThread=context.threadData(this->getEta());
             for(int n=0;n<list->size();++n)
             {
-                if((checkCoast && map && map->crossing(QLineF(list->at(n).x,list->at(n).y,xa,ya),
-                        QLineF(list->at(n).lon,list->at(n).lat,arrival.x(),arrival.y())))
+                if((checkCoast && map && map->crossing(QLineF(list->at(n).lon,list->at(n).lat,arrival.x(),arrival.y())))
                     || (checkLine && crossBarriere(QLineF(list->at(n).x,list->at(n).y,xa,ya))))
                     continue;
                 vlmPoint from=list->at(n);
@@ -2658,7 +2411,6 @@ void ROUTAGE::slot_calculate()
         if(this->colorGrib && !multiRoutage)
             parent->getTerre()->setRoutageGrib(this);
     }
-    proj->setFrozen(false);
     if((multiRoutage || isConverted()) && !i_iso)
     {
         int rep=QMessageBox::Yes;
@@ -2693,7 +2445,7 @@ void ROUTAGE::countDebug(int nbIso, QString s)
     int nDead=0;
     for (int n=0;n<tempPoints.size();++n)
     {
-        if(tempPoints.at(n).originNb==56)
+        if(tempPoints.origin.at(n)==56)
         {
             ++count;
             if(s.contains("initial"))
@@ -2703,11 +2455,11 @@ void ROUTAGE::countDebug(int nbIso, QString s)
                 vlmLine * debug1=new vlmLine(proj,myscene,Z_VALUE_ROUTAGE+10);
                 debug1->setParent(this);
                 debug1->setLinePen(pendebug);
-                debug1->addVlmPoint(tempPoints.at(n));
-                debug1->addVlmPoint(*tempPoints.at(n).origin);
+                debug1->addVlmPoint(tempPoints.toVlmPoint(n));
+                debug1->addVlmPoint(lastPoints.toVlmPoint(tempPoints.origin.at(n)));
                 debug1->slot_showMe();
             }
-            if(tempPoints.at(n).isDead)
+            if(tempPoints.isDead.at(n))
             {
                 ++nDead;
             }
@@ -2716,10 +2468,8 @@ void ROUTAGE::countDebug(int nbIso, QString s)
     qWarning()<<"remains"<<count<<"points, dead="<<nDead<<s;
 }
 
-double ROUTAGE::findDistancePreviousIso(const vlmPoint &P, const QPolygonF * poly)
+double ROUTAGE::findDistancePreviousIso(const double &cx, const double &cy, const QPolygonF * poly)
 {
-    double cx=P.x;
-    double cy=P.y;
     double minDistanceSegment=10e6;
 
     for(int i=0;i<poly->size()-1;++i)
@@ -2829,48 +2579,47 @@ double ROUTAGE::findDistancePoly(const QPointF P, const QPolygonF * poly, QPoint
     }
     return minDistanceSegment;
 }
-QList<vlmPoint> ROUTAGE::pruneWakeThreaded(const QList<vlmPoint> &list)
+isoColumns ROUTAGE::pruneWakeThreaded(const RoutingContext &context, const isoColumns &list)
 {
-    QList<vlmPoint> listResult;
+    isoColumns listResult;
     if(list.isEmpty()) return listResult;
-    vlmPoint p=list.at(0);
-    QList<vlmPoint> *pIso;
+    listResult.reserve(list.size());
+    const isoColumns *pIso=context.lastIso;
     double wakeDir=0;
-    if(p.routage->getI_iso())
-        pIso=p.routage->getI_Isochrones()->at(p.routage->getI_Isochrones()->size()-1)->getPoints();
-    else
-        pIso=p.routage->getIsochrones()->at(p.routage->getIsochrones()->size()-1)->getPoints();
     for(int n=0;n<list.size();++n)
     {
-        p=list.at(n);
-        if(p.origin->isBroken)
+        if(pIso->isBroken.at(list.origin.at(n)))
         {
-            listResult.append(p);
+            listResult.append(list,n);
             continue;
         }
-        const QLineF l2(p.routage->getXa(),p.routage->getYa(),p.x,p.y);
+        const double px=list.x.at(n);
+        const double py=list.y.at(n);
+        const QLineF l2(context.xa,context.ya,px,py);
         bool bad=false;
         for(int m=0;m<pIso->size();++m)
         {
-            const QLineF l1(p.routage->getXa(),p.routage->getYa(),pIso->at(m).x,pIso->at(m).y);
+            const double mx=pIso->x.at(m);
+            const double my=pIso->y.at(m);
+            const QLineF l1(context.xa,context.ya,mx,my);
             if(l1.length()>=l2.length()) continue;
-            if(pIso->at(m).isDead) continue;
+            if(pIso->isDead.at(m)) continue;
             if(l1.length()/l2.length()<0.3) continue;
             QPolygonF wake;
-            wake.append(QPointF(pIso->at(m).x,pIso->at(m).y));
+            wake.append(QPointF(mx,my));
             wakeDir=l1.angle();
-            QLineF temp1(pIso->at(m).x,pIso->at(m).y,p.x,p.y);
+            QLineF temp1(mx,my,px,py);
             temp1.setLength(temp1.length()*2.0);
-            temp1.setAngle(wakeDir+(p.routage->pruneWakeAngle/2.0));
+            temp1.setAngle(wakeDir+(context.pruneWakeAngle/2.0));
             wake.append(temp1.p2());
-            temp1.setAngle(wakeDir-p.routage->pruneWakeAngle);
+            temp1.setAngle(wakeDir-context.pruneWakeAngle);
             wake.append(temp1.p2());
-            wake.append(QPointF(pIso->at(m).x,pIso->at(m).y));
-            if(wake.containsPoint(QPointF(p.x,p.y),Qt::OddEvenFill))
+            wake.append(QPointF(mx,my));
+            if(wake.containsPoint(QPointF(px,py),Qt::OddEvenFill))
             {
-                if(p.routage->getCheckCoast() || p.routage->getCheckLine())
+                if(context.checkCoast || context.checkLine)
                 {
-                    if(!p.routage->checkCoastCollision2(p,pIso->at(m)))
+                    if(!checkCoastCollision2(context,list,n,*pIso,m))
                         bad=true;
                 }
                 else
@@ -2878,7 +2627,7 @@ QList<vlmPoint> ROUTAGE::pruneWakeThreaded(const QList<vlmPoint> &list)
             }
         }
         if(!bad)
-            listResult.append(p);
+            listResult.append(list,n);
     }
     return listResult;
 }
@@ -2887,28 +2636,15 @@ void ROUTAGE::pruneWake(const int &wakeAngle)
     if(wakeAngle<1) return;
     if(useMultiThreading)
     {
-        QList<QList<vlmPoint> > listList;
-        QList<vlmPoint> tempList;
-        int pp=0;
-        int threadCount=qMax(1,QThread::idealThreadCount()*2);
-        for (int t=1;t<=threadCount;++t)
-        {
-            tempList.clear();
-            for (;(double)pp<(double)tempPoints.size()*(double)t/(double)threadCount;++pp)
-            {
-                tempList.append(tempPoints.at(pp));
-            }
-            listList.append(tempList);
-        }
-        tempList.clear();
-        listList = QtConcurrent::blockingMapped(listList, ROUTAGE::pruneWakeThreaded);
+        QList<isoColumns> listList=tempPoints.split(qMax(1,QThread::idealThreadCount()*2));
+        listList = QtConcurrent::blockingMapped(listList, contextMapper<isoColumns,ROUTAGE::pruneWakeThreaded>(&context));
         tempPoints.clear();
         for(int l=0;l<listList.size();++l)
             tempPoints.append(listList.at(l));
     }
     else
     {
-        tempPoints=ROUTAGE::pruneWakeThreaded(tempPoints);
+        tempPoints=ROUTAGE::pruneWakeThreaded(context,tempPoints);
     }
 }
 double ROUTAGE::findTime(const vlmPoint * pt, QPointF P, double * cap)
@@ -2995,11 +2731,8 @@ void ROUTAGE::setShowIso(const bool &b)
         segments[n]->setHidden(!showIso);
         segments[n]->blockSignals(!b);
     }
-    for (int n=0;n<isoPointList.size();++n)
-    {
-        isoPointList[n]->shown(b);
-        isoPointList[n]->blockSignals(!b);
-    }
+    isoPoints->shown(b);
+    isoPoints->blockSignals(!b);
     for (int n=0;n<alternateRoutes.size();++n)
     {
         alternateRoutes[n]->setHidden(!showIso);
@@ -3048,8 +2781,7 @@ void ROUTAGE::drawResult(vlmPoint P)
     pen.setColor(color);
     pen.setBrush(color);
     pen.setWidthF(2);
-    foreach(vlmPointGraphic * vg,this->isoPointList)
-        vg->setAcceptHover();
+    isoPoints->setAcceptHover();
 }
 void ROUTAGE::setPivotPoint(const int &isoNb,const int &pointNb)
 {
@@ -3270,45 +3002,51 @@ void ROUTAGE::convertToRoute()
     else if (multiNb>0)
         parent->addPivot(this,false);
 }
-vlmPoint ROUTAGE::multiThreadedContains(const vlmPoint &p)
+isoColumns ROUTAGE::multiThreadedContains(const RoutingContext &context, const isoColumns &points)
 {
-    vlmPoint pt=p;
-    if(pt.routage->getShapeIso()->containsPoint(QPointF(pt.x,pt.y),Qt::OddEvenFill))
-        pt.isDead=true;
-    return pt;
+    isoColumns newPoints=points;
+    for(int n=0;n<newPoints.size();++n)
+    {
+        if(context.shapeIso->containsPoint(QPointF(newPoints.x.at(n),newPoints.y.at(n)),Qt::OddEvenFill))
+            newPoints.isDead[n]=true;
+    }
+    return newPoints;
 }
 void ROUTAGE::checkIsoCrossingPreviousSegments()
 {
 #ifdef USE_SHAPEISO
     if(useMultiThreading)
     {
-        tempPoints=QtConcurrent::blockingMapped(tempPoints,ROUTAGE::multiThreadedContains);
+        QList<isoColumns> listList=tempPoints.split(qMax(1,QThread::idealThreadCount()*2));
+        listList=QtConcurrent::blockingMapped(listList,contextMapper<isoColumns,ROUTAGE::multiThreadedContains>(&context));
+        tempPoints.clear();
+        for(int l=0;l<listList.size();++l)
+            tempPoints.append(listList.at(l));
     }
+    /* the removed points are flagged and dropped in one pass at the end */
+    QBitArray removed(tempPoints.size(),false);
     for(int nn=0;nn<tempPoints.size();++nn)
     {
         if(!useMultiThreading)
         {
-            if(shapeIso.containsPoint(QPointF(tempPoints.at(nn).x,tempPoints.at(nn).y),Qt::OddEvenFill))
+            if(shapeIso.containsPoint(QPointF(tempPoints.x.at(nn),tempPoints.y.at(nn)),Qt::OddEvenFill))
             {
-                somethingHasChanged=true;
-                tempPoints.removeAt(nn);
-                --nn;
+                removed.setBit(nn);
                 continue;
             }
         }
         else
         {
-            if(tempPoints.at(nn).isDead)
+            if(tempPoints.isDead.at(nn))
             {
-                somethingHasChanged=true;
-                tempPoints.removeAt(nn);
-                --nn;
+                removed.setBit(nn);
                 continue;
             }
         }
-        if(tempPoints.at(nn).origin->isBroken)
+        const int o=tempPoints.origin.at(nn);
+        if(lastPoints.isBroken.at(o))
         {
-            QLineF S(tempPoints.at(nn).origin->x,tempPoints.at(nn).origin->y,tempPoints.at(nn).x,tempPoints.at(nn).y);
+            QLineF S(lastPoints.x.at(o),lastPoints.y.at(o),tempPoints.x.at(nn),tempPoints.y.at(nn));
             QPointF P=S.pointAt(0.01);
             S.setP1(P);
             bool bad=false;
@@ -3317,46 +3055,47 @@ void ROUTAGE::checkIsoCrossingPreviousSegments()
                 QLineF I(shapeIso.at(i),shapeIso.at(i+1));
                 if(S.intersect(I,&P)==QLineF::BoundedIntersection)
                 {
-                    somethingHasChanged=true;
-                    tempPoints.removeAt(nn);
-                    --nn;
+                    removed.setBit(nn);
                     bad=true;
                     break;
                 }
             }
             if (bad) continue;
-            if(nn!=tempPoints.size()-1 && !tempPoints.at(nn).isBroken)
+            if(nn!=tempPoints.size()-1 && !tempPoints.isBroken.at(nn))
             {
-                QLineF S2=QLineF(tempPoints.at(nn).x,tempPoints.at(nn).y,tempPoints.at(nn+1).x,tempPoints.at(nn+1).y);
+                QLineF S2=QLineF(tempPoints.x.at(nn),tempPoints.y.at(nn),tempPoints.x.at(nn+1),tempPoints.y.at(nn+1));
                 for (int i=0;i<shapeMiddle.size()-1;++i)
                 {
                     QLineF I(shapeMiddle.at(i),shapeMiddle.at(i+1));
                     if(S2.intersect(I,&P)==QLineF::BoundedIntersection)
                     {
-                        somethingHasChanged=true;
-                        tempPoints.removeAt(nn);
-                        --nn;
+                        removed.setBit(nn);
                         break;
                     }
                 }
             }
         }
     }
+    if(removed.count(true)>0)
+    {
+        somethingHasChanged=true;
+        tempPoints.remove(removed);
+    }
     return;
 #else
     QPointF dummy;
     for(int nn=0;nn<tempPoints.size()-1;++nn)
     {
-        if(tempPoints.at(nn).notSimplificable || tempPoints.at(nn+1).notSimplificable)
+        if(tempPoints.notSimplificable.at(nn) || tempPoints.notSimplificable.at(nn+1))
             continue;
-        if(tempPoints.at(nn).origin->notSimplificable || tempPoints.at(nn+1).origin->notSimplificable)
+        if(lastPoints.notSimplificable.at(tempPoints.origin.at(nn)) || lastPoints.notSimplificable.at(tempPoints.origin.at(nn+1)))
             continue;
-        QLineF S1(tempPoints.at(nn).x,tempPoints.at(nn).y,tempPoints.at(nn+1).x,tempPoints.at(nn+1).y);
+        QLineF S1(tempPoints.x.at(nn),tempPoints.y.at(nn),tempPoints.x.at(nn+1),tempPoints.y.at(nn+1));
 #if 0 /*better but slower*/
-        QLineF s1(tempPoints.at(nn).lon,tempPoints.at(nn).lat,tempPoints.at(nn+1).lon,tempPoints.at(nn+1).lat);
-        if(S1.length()>tempPoints.at(nn).distIso)
+        QLineF s1(tempPoints.lon.at(nn),tempPoints.lat.at(nn),tempPoints.lon.at(nn+1),tempPoints.lat.at(nn+1));
+        if(S1.length()>tempPoints.distIso.at(nn))
             continue;
-        if(checkCoast && getMap() && getMap()->crossing(S1,s1))
+        if(checkCoast && getMap() && getMap()->crossing(s1))
             continue;
         if(checkLine && crossBarriere(S1))
             continue;
@@ -3368,7 +3107,7 @@ void ROUTAGE::checkIsoCrossingPreviousSegments()
             {
                 bad=true;
                 somethingHasChanged=true;
-                if(tempPoints.at(nn).distArrival>tempPoints.at(nn+1).distArrival)
+                if(tempPoints.distArrival.at(nn)>tempPoints.distArrival.at(nn+1))
                     tempPoints.removeAt(nn);
                 else
                     tempPoints.removeAt(nn+1);
@@ -3384,7 +3123,7 @@ void ROUTAGE::checkIsoCrossingPreviousSegments()
             if(S1.intersect(S2,&dummy)==QLineF::BoundedIntersection)
 //                    if(fastIntersects(S1,S2))
             {
-                if(tempPoints.at(nn).distIso<tempPoints.at(nn+1).distIso)
+                if(tempPoints.distIso.at(nn)<tempPoints.distIso.at(nn+1))
                     tempPoints.removeAt(nn);
                 else
                     tempPoints.removeAt(nn+1);
@@ -3399,7 +3138,7 @@ void ROUTAGE::checkIsoCrossingPreviousSegments()
     QPointF dummy;
     for(int nn=0;nn<tempPoints.size()-1;++nn)
     {
-        QLineF S1(tempPoints.at(nn).x,tempPoints.at(nn).y,tempPoints.at(nn+1).x,tempPoints.at(nn+1).y);
+        QLineF S1(tempPoints.x.at(nn),tempPoints.y.at(nn),tempPoints.x.at(nn+1),tempPoints.y.at(nn+1));
         QList<vlmPoint> *iso=i_iso?i_isochrones.last()->getPoints():isochrones.last()->getPoints();
         for(int mm=0;mm<iso->size()-1;++mm) /*also check that new Iso does not cross previous iso*/
         {
@@ -3407,7 +3146,7 @@ void ROUTAGE::checkIsoCrossingPreviousSegments()
             QLineF S2(QPointF(iso->at(mm).x,iso->at(mm).y),QPointF(iso->at(mm+1).x,iso->at(mm+1).y));
             if(S1.intersect(S2,&dummy)==QLineF::BoundedIntersection)
             {
-                if(tempPoints.at(nn).distIso<tempPoints.at(nn+1).distIso)
+                if(tempPoints.distIso.at(nn)<tempPoints.distIso.at(nn+1))
                     tempPoints.removeAt(nn);
                 else
                     tempPoints.removeAt(nn+1);
@@ -3420,39 +3159,28 @@ void ROUTAGE::checkIsoCrossingPreviousSegments()
 }
 void ROUTAGE::epuration(int toBeRemoved)
 {
-    QList<vlmPoint> rightFromLoxo;
-    QList<vlmPoint> leftFromLoxo;
     if(tempPoints.size()<=1 || tempPoints.size()<=toBeRemoved) return;
+    /* the points right of the separation come first in tempPoints, then the
+       left ones: both sides are [0,split) and [split,size) */
+    int split=tempPoints.size();
 #if 0
-    bool rightSide=true;
     for(int n=0;n<tempPoints.size();++n)
     {
-        if(rightSide)
+        Triangle test(Point(xs,ys),Point(xa,ya),Point(tempPoints.x.at(n),tempPoints.y.at(n)));
+        if(test.orientation()!=left_turn)
         {
-            Triangle test(Point(xs,ys),Point(xa,ya),Point(tempPoints.at(n).x,tempPoints.at(n).y));
-            if(test.orientation()==left_turn)
-            {
-                tempPoints[n].debugInt=1;
-                rightFromLoxo.append(tempPoints.at(n));
-            }
-            else
-            {
-                rightSide=false;
-                tempPoints[n].debugInt=2;
-                leftFromLoxo.append(tempPoints.at(n));
-            }
+            split=n;
+            break;
         }
-        else
-            leftFromLoxo.append(tempPoints.at(n));
     }
 #else
 #if 0
     QPolygonF isoShape;
     for(int n=0;n<tempPoints.size();++n)
     {
-        isoShape.append(QPointF(tempPoints.at(n).x,tempPoints.at(n).y));
+        isoShape.append(QPointF(tempPoints.x.at(n),tempPoints.y.at(n)));
     }
-    isoShape.append(QPointF(tempPoints.first().x,tempPoints.first().y));
+    isoShape.append(QPointF(tempPoints.x.first(),tempPoints.y.first()));
     QRectF bounding=isoShape.boundingRect().normalized();
 #else
     QRectF bounding=shapeIso.boundingRect().normalized();
@@ -3466,61 +3194,39 @@ void ROUTAGE::epuration(int toBeRemoved)
     tempLine.setLength(tempLine.length()*10);
     separation=QLineF(tempLine.p2(),tempLine.p1());
     separation.setLength(separation.length()*10);
-    bool rightSide=true;
     for(int n=0;n<tempPoints.size();++n)
     {
-        if(rightSide)
+        Triangle test(Point(separation.x2(),separation.y2()),
+                      Point(separation.x1(),separation.y1()),
+                      Point(tempPoints.x.at(n),tempPoints.y.at(n)));
+        if(test.orientation()!=left_turn)
         {
-            Triangle test(Point(separation.x2(),separation.y2()),
-                          Point(separation.x1(),separation.y1()),
-                          Point(tempPoints.at(n).x,tempPoints.at(n).y));
-            if(test.orientation()==left_turn)
-            {
-                if(differentDirection)
-                    tempPoints[n].debugInt=3;
-                else
-                    tempPoints[n].debugInt=1;
-                rightFromLoxo.append(tempPoints.at(n));
-            }
-            else
-            {
-                rightSide=false;
-                if(differentDirection)
-                    tempPoints[n].debugInt=4;
-                else
-                    tempPoints[n].debugInt=2;
-                leftFromLoxo.append(tempPoints.at(n));
-            }
-        }
-        else
-        {
-            if(differentDirection)
-                tempPoints[n].debugInt=4;
-            else
-                tempPoints[n].debugInt=2;
-            leftFromLoxo.append(tempPoints.at(n));
+            split=n;
+            break;
         }
     }
 #endif
+    const int rightCount=split;
+    const int leftCount=tempPoints.size()-split;
     int toBeRemovedRight=0;
     int toBeRemovedLeft=0;
-    int balance=qAbs(leftFromLoxo.size()-rightFromLoxo.size());
-    if(leftFromLoxo.isEmpty())
+    int balance=qAbs(leftCount-rightCount);
+    if(leftCount==0)
     {
         toBeRemovedRight=toBeRemoved;
         toBeRemovedLeft=0;
     }
-    else if(rightFromLoxo.isEmpty())
+    else if(rightCount==0)
     {
         toBeRemovedRight=0;
         toBeRemovedLeft=toBeRemoved;
     }
-    else if(leftFromLoxo.size()==rightFromLoxo.size())
+    else if(leftCount==rightCount)
     {
         toBeRemovedRight=toBeRemoved/2;
         toBeRemovedLeft=toBeRemoved-toBeRemovedRight;
     }
-    else if(leftFromLoxo.size()>rightFromLoxo.size())
+    else if(leftCount>rightCount)
     {
         if(balance>=toBeRemoved)
         {
@@ -3546,37 +3252,38 @@ void ROUTAGE::epuration(int toBeRemoved)
             toBeRemovedLeft=toBeRemoved-toBeRemovedRight;
         }
     }
-    if(leftFromLoxo.size()>0)
-    {
-        leftFromLoxo[0].internal_1=toBeRemovedLeft;
-        leftFromLoxo[0].internal_2=initialDist;
-    }
-    if(rightFromLoxo.size()>0)
-    {
-        rightFromLoxo[0].internal_1=toBeRemovedRight;
-        rightFromLoxo[0].internal_2=initialDist;
-    }
-    //qWarning()<<isochrones.size()<<"tp"<<tempPoints.size()<<"tbr"<<toBeRemoved<<"lc"<<leftFromLoxo.size()<<"tbr_l"<<toBeRemovedLeft<<"rc"<<rightFromLoxo.size()<<"tbr_r"<<toBeRemovedRight;
+    //qWarning()<<isochrones.size()<<"tp"<<tempPoints.size()<<"tbr"<<toBeRemoved<<"lc"<<leftCount<<"tbr_l"<<toBeRemovedLeft<<"rc"<<rightCount<<"tbr_r"<<toBeRemovedRight;
+    QList<epurationRange> ranges;
+    epurationRange range;
+    range.points=&tempPoints;
+    range.initialDist=initialDist;
+    range.begin=0;
+    range.end=split;
+    range.toBeRemoved=toBeRemovedRight;
+    ranges.append(range);
+    range.begin=split;
+    range.end=tempPoints.size();
+    range.toBeRemoved=toBeRemovedLeft;
+    ranges.append(range);
     if(this->useMultiThreading)
     {
-        QList<QList<vlmPoint> > listList;
-        listList.append(rightFromLoxo);
-        listList.append(leftFromLoxo);
-        listList = QtConcurrent::blockingMapped(listList, ROUTAGE::finalEpuration);
-        tempPoints.clear();
-        tempPoints.reserve(listList.at(0).size()+listList.at(1).size());
-        tempPoints.append(listList.at(0));
-        tempPoints.append(listList.at(1));
+        ranges = QtConcurrent::blockingMapped(ranges, contextMapper<epurationRange,ROUTAGE::finalEpuration>(&context));
     }
     else
     {
-        leftFromLoxo=finalEpuration(leftFromLoxo);
-        rightFromLoxo=finalEpuration(rightFromLoxo);
-        tempPoints.clear();
-        tempPoints.reserve(rightFromLoxo.size()+leftFromLoxo.size());
-        tempPoints.append(rightFromLoxo);
-        tempPoints.append(leftFromLoxo);
+        for(int r=0;r<ranges.size();++r)
+            ranges[r]=finalEpuration(context,ranges.at(r));
     }
+    QBitArray removed(tempPoints.size(),false);
+    for(int r=0;r<ranges.size();++r)
+    {
+        for(int n=0;n<ranges.at(r).removed.size();++n)
+        {
+            if(ranges.at(r).removed.testBit(n))
+                removed.setBit(ranges.at(r).begin+n);
+        }
+    }
+    tempPoints.remove(removed);
 }
 #if 1
 void ROUTAGE::removeCrossedSegments()
@@ -3590,30 +3297,30 @@ void ROUTAGE::removeCrossedSegments()
     for(int n=0;n<tempPoints.size()-1;++n)
     {
         bool differentDirection=false;
-        QLineF line1(xa,ya,tempPoints.at(n).x,tempPoints.at(n).y);
-        QLineF line2(xa,ya,tempPoints.at(n+1).x,tempPoints.at(n+1).y);
+        QLineF line1(xa,ya,tempPoints.x.at(n),tempPoints.y.at(n));
+        QLineF line2(xa,ya,tempPoints.x.at(n+1),tempPoints.y.at(n+1));
         if(qAbs(Util::A180(qAbs(line1.angleTo(line2))))>60.0 ||
                 qAbs(line1.length()-line2.length())>maxDist)
         {
-            if(tempPoints.at(n).originNb!=tempPoints.at(n+1).originNb)
+            if(tempPoints.origin.at(n)!=tempPoints.origin.at(n+1))
             {
-                QLineF temp1(tempPoints.at(n).origin->x,tempPoints.at(n).origin->y,
-                             tempPoints.at(n).x,tempPoints.at(n).y);
-                QLineF temp2(tempPoints.at(n+1).origin->x,tempPoints.at(n+1).origin->y,
-                             tempPoints.at(n+1).x,tempPoints.at(n+1).y);
+                QLineF temp1(lastPoints.x.at(tempPoints.origin.at(n)),lastPoints.y.at(tempPoints.origin.at(n)),
+                             tempPoints.x.at(n),tempPoints.y.at(n));
+                QLineF temp2(lastPoints.x.at(tempPoints.origin.at(n+1)),lastPoints.y.at(tempPoints.origin.at(n+1)),
+                             tempPoints.x.at(n+1),tempPoints.y.at(n+1));
                 QPointF dummy;
                 if(temp1.intersect(temp2,&dummy)!=QLineF::BoundedIntersection)
                     differentDirection=true;
             }
         }
-        else if(tempPoints.at(n).origin->isBroken /* && !tempPoints.at(n+1).origin->isBroken*/)
+        else if(lastPoints.isBroken.at(tempPoints.origin.at(n)) /* && !lastPoints.isBroken.at(tempPoints.origin.at(n+1))*/)
         {
-            if(tempPoints.at(n).originNb!=tempPoints.at(n+1).originNb)
+            if(tempPoints.origin.at(n)!=tempPoints.origin.at(n+1))
             {
-                QLineF temp1(tempPoints.at(n).origin->x,tempPoints.at(n).origin->y,
-                             tempPoints.at(n).x,tempPoints.at(n).y);
-                QLineF temp2(tempPoints.at(n+1).origin->x,tempPoints.at(n+1).origin->y,
-                             tempPoints.at(n+1).x,tempPoints.at(n+1).y);
+                QLineF temp1(lastPoints.x.at(tempPoints.origin.at(n)),lastPoints.y.at(tempPoints.origin.at(n)),
+                             tempPoints.x.at(n),tempPoints.y.at(n));
+                QLineF temp2(lastPoints.x.at(tempPoints.origin.at(n+1)),lastPoints.y.at(tempPoints.origin.at(n+1)),
+                             tempPoints.x.at(n+1),tempPoints.y.at(n+1));
                 QPointF dummy;
                 if(temp1.intersect(temp2,&dummy)!=QLineF::BoundedIntersection)
                     differentDirection=true;
@@ -3623,13 +3330,13 @@ void ROUTAGE::removeCrossedSegments()
             critere=0;
         else
         {
-            QLineF temp1(tempPoints.at(n).origin->x,tempPoints.at(n).origin->y,
-                         tempPoints.at(n+1).origin->x,tempPoints.at(n+1).origin->y);
+            QLineF temp1(lastPoints.x.at(tempPoints.origin.at(n)),lastPoints.y.at(tempPoints.origin.at(n)),
+                         lastPoints.x.at(tempPoints.origin.at(n+1)),lastPoints.y.at(tempPoints.origin.at(n+1)));
             QPointF middle=temp1.pointAt(0.5);
-            QLineF temp2(middle.x(),middle.y(),tempPoints.at(n).x,tempPoints.at(n).y);
-            QLineF temp3(middle.x(),middle.y(),tempPoints.at(n+1).x,tempPoints.at(n+1).y);
-//            QLineF temp2(tempPoints.at(n).origin->x,tempPoints.at(n).origin->y,tempPoints.at(n).x,tempPoints.at(n).y);
-//            QLineF temp3(tempPoints.at(n+1).origin->x,tempPoints.at(n+1).origin->y,tempPoints.at(n+1).x,tempPoints.at(n+1).y);
+            QLineF temp2(middle.x(),middle.y(),tempPoints.x.at(n),tempPoints.y.at(n));
+            QLineF temp3(middle.x(),middle.y(),tempPoints.x.at(n+1),tempPoints.y.at(n+1));
+//            QLineF temp2(lastPoints.x.at(tempPoints.origin.at(n)),lastPoints.y.at(tempPoints.origin.at(n)),tempPoints.x.at(n),tempPoints.y.at(n));
+//            QLineF temp3(lastPoints.x.at(tempPoints.origin.at(n+1)),lastPoints.y.at(tempPoints.origin.at(n+1)),tempPoints.x.at(n+1),tempPoints.y.at(n+1));
             //++debugCross0;
             critere=temp2.angleTo(temp3);
             if(critere<0) critere+=360.0;
@@ -3641,7 +3348,7 @@ void ROUTAGE::removeCrossedSegments()
     }
     deadStatus.append(false);
     QMutableMapIterator<double,QPoint> d(byCriteres);
-    int currentCount=tempPoints.count();
+    int currentCount=tempPoints.size();
     while(currentCount>0)
     {
         d.toBack();
@@ -3650,16 +3357,16 @@ void ROUTAGE::removeCrossedSegments()
         if(d.key()<180) break;
         QPoint couple=d.value();
         int badOne=0;
-        double crit1=tempPoints.at(couple.x()).distIso;
-        double crit2=tempPoints.at(couple.y()).distIso;
+        double crit1=tempPoints.distIso.at(couple.x());
+        double crit2=tempPoints.distIso.at(couple.y());
 #if 0
         if(qAbs(crit1-crit2)<(crit1+crit2)/20.0)
         {
-            crit1=tempPoints.at(couple.x()).distArrival;
-            crit2=tempPoints.at(couple.y()).distArrival;
+            crit1=tempPoints.distArrival.at(couple.x());
+            crit2=tempPoints.distArrival.at(couple.y());
         }
 #endif
-        //if(tempPoints.at(couple.x()).distIso<tempPoints.at(couple.y()).distIso)
+        //if(tempPoints.distIso.at(couple.x())<tempPoints.distIso.at(couple.y()))
         if(crit1<crit2)
             badOne=couple.x();
         else
@@ -3681,30 +3388,30 @@ void ROUTAGE::removeCrossedSegments()
 
 
             bool differentDirection=false;
-            QLineF line1(xa,ya,tempPoints.at(previous).x,tempPoints.at(previous).y);
-            QLineF line2(xa,ya,tempPoints.at(next).x,tempPoints.at(next).y);
+            QLineF line1(xa,ya,tempPoints.x.at(previous),tempPoints.y.at(previous));
+            QLineF line2(xa,ya,tempPoints.x.at(next),tempPoints.y.at(next));
             if(qAbs(Util::A180(qAbs(line1.angleTo(line2))))>60.0 ||
                     qAbs(line1.length()-line2.length())>maxDist)
             {
-                if(tempPoints.at(previous).originNb!=tempPoints.at(next).originNb)
+                if(tempPoints.origin.at(previous)!=tempPoints.origin.at(next))
                 {
-                    QLineF temp1(tempPoints.at(previous).origin->x,tempPoints.at(previous).origin->y,
-                                 tempPoints.at(previous).x,tempPoints.at(previous).y);
-                    QLineF temp2(tempPoints.at(next).origin->x,tempPoints.at(next).origin->y,
-                                 tempPoints.at(next).x,tempPoints.at(next).y);
+                    QLineF temp1(lastPoints.x.at(tempPoints.origin.at(previous)),lastPoints.y.at(tempPoints.origin.at(previous)),
+                                 tempPoints.x.at(previous),tempPoints.y.at(previous));
+                    QLineF temp2(lastPoints.x.at(tempPoints.origin.at(next)),lastPoints.y.at(tempPoints.origin.at(next)),
+                                 tempPoints.x.at(next),tempPoints.y.at(next));
                     QPointF dummy;
                     if(temp1.intersect(temp2,&dummy)!=QLineF::BoundedIntersection)
                         differentDirection=true;
                 }
             }
-            else if(tempPoints.at(previous).origin->isBroken /* && !tempPoints.at(next).origin->isBroken*/)
+            else if(lastPoints.isBroken.at(tempPoints.origin.at(previous)) /* && !lastPoints.isBroken.at(tempPoints.origin.at(next))*/)
             {
-                if(tempPoints.at(previous).originNb!=tempPoints.at(next).originNb)
+                if(tempPoints.origin.at(previous)!=tempPoints.origin.at(next))
                 {
-                    QLineF temp1(tempPoints.at(previous).origin->x,tempPoints.at(previous).origin->y,
-                                 tempPoints.at(previous).x,tempPoints.at(previous).y);
-                    QLineF temp2(tempPoints.at(next).origin->x,tempPoints.at(next).origin->y,
-                                 tempPoints.at(next).x,tempPoints.at(next).y);
+                    QLineF temp1(lastPoints.x.at(tempPoints.origin.at(previous)),lastPoints.y.at(tempPoints.origin.at(previous)),
+                                 tempPoints.x.at(previous),tempPoints.y.at(previous));
+                    QLineF temp2(lastPoints.x.at(tempPoints.origin.at(next)),lastPoints.y.at(tempPoints.origin.at(next)),
+                                 tempPoints.x.at(next),tempPoints.y.at(next));
                     QPointF dummy;
                     if(temp1.intersect(temp2,&dummy)!=QLineF::BoundedIntersection)
                         differentDirection=true;
@@ -3714,13 +3421,13 @@ void ROUTAGE::removeCrossedSegments()
                 critere=0;
             else
             {
-                QLineF temp1(tempPoints.at(previous).origin->x,tempPoints.at(previous).origin->y,
-                             tempPoints.at(next).origin->x,tempPoints.at(next).origin->y);
+                QLineF temp1(lastPoints.x.at(tempPoints.origin.at(previous)),lastPoints.y.at(tempPoints.origin.at(previous)),
+                             lastPoints.x.at(tempPoints.origin.at(next)),lastPoints.y.at(tempPoints.origin.at(next)));
                 QPointF middle=temp1.pointAt(0.5);
-                QLineF temp2(middle.x(),middle.y(),tempPoints.at(previous).x,tempPoints.at(previous).y);
-                QLineF temp3(middle.x(),middle.y(),tempPoints.at(next).x,tempPoints.at(next).y);
-//                QLineF temp2(tempPoints.at(previous).origin->x,tempPoints.at(previous).origin->y,tempPoints.at(previous).x,tempPoints.at(previous).y);
-//                QLineF temp3(tempPoints.at(next).origin->x,tempPoints.at(next).origin->y,tempPoints.at(next).x,tempPoints.at(next).y);
+                QLineF temp2(middle.x(),middle.y(),tempPoints.x.at(previous),tempPoints.y.at(previous));
+                QLineF temp3(middle.x(),middle.y(),tempPoints.x.at(next),tempPoints.y.at(next));
+//                QLineF temp2(lastPoints.x.at(tempPoints.origin.at(previous)),lastPoints.y.at(tempPoints.origin.at(previous)),tempPoints.x.at(previous),tempPoints.y.at(previous));
+//                QLineF temp3(lastPoints.x.at(tempPoints.origin.at(next)),lastPoints.y.at(tempPoints.origin.at(next)),tempPoints.x.at(next),tempPoints.y.at(next));
                 critere=temp2.angleTo(temp3);
                 if(critere<0) critere+=360;
             }
@@ -3744,11 +3451,13 @@ void ROUTAGE::removeCrossedSegments()
         }
         --currentCount;
     }
-    for (int nn=deadStatus.count()-1;nn>=0;--nn)
+    QBitArray removed(deadStatus.size(),false);
+    for (int nn=0;nn<deadStatus.size();++nn)
     {
         if(deadStatus.at(nn))
-            tempPoints.removeAt(nn);
+            removed.setBit(nn);
     }
+    tempPoints.remove(removed);
 }
 #else
 void ROUTAGE::removeCrossedSegments()
@@ -3760,28 +3469,27 @@ void ROUTAGE::removeCrossedSegments()
     QList<bool> deadStatus;
     quint32 s;
     double critere=0;
-    QList<vlmLine *> isos=i_iso?i_isochrones:isochrones;
     for(int n=0;n<tempPoints.size()-1;++n)
     {
         bool differentDirection=false;
-        if(tempPoints.at(n).originNb!=tempPoints.at(n+1).originNb)
+        if(tempPoints.origin.at(n)!=tempPoints.origin.at(n+1))
         {
-            QLineF a1(tempPoints.at(n).origin->x,tempPoints.at(n).origin->y,tempPoints.at(n).x,tempPoints.at(n).y);
-            QLineF a2(tempPoints.at(n+1).origin->x,tempPoints.at(n+1).origin->y,tempPoints.at(n+1).x,tempPoints.at(n+1).y);
+            QLineF a1(lastPoints.x.at(tempPoints.origin.at(n)),lastPoints.y.at(tempPoints.origin.at(n)),tempPoints.x.at(n),tempPoints.y.at(n));
+            QLineF a2(lastPoints.x.at(tempPoints.origin.at(n+1)),lastPoints.y.at(tempPoints.origin.at(n+1)),tempPoints.x.at(n+1),tempPoints.y.at(n+1));
             if(a1.intersect(a2,&dummy)!=QLineF::BoundedIntersection)
             {
-                if(tempPoints.at(n).origin->isBroken)
+                if(lastPoints.isBroken.at(tempPoints.origin.at(n)))
                 {
-                    if(!tempPoints.at(n+1).origin->isBroken)
+                    if(!lastPoints.isBroken.at(tempPoints.origin.at(n+1)))
                         differentDirection=true;
                 }
-                else if(tempPoints.at(n).originNb!=tempPoints.at(n+1).originNb+1)
+                else if(tempPoints.origin.at(n)!=tempPoints.origin.at(n+1)+1)
                 {
-                    QList<vlmPoint> * iso=isos.at(isos.size()-1)->getPoints();
-                    int o=tempPoints.at(n).originNb+1;
-                    while(o<tempPoints.at(n+1).originNb && o<iso->count())
+                    const isoColumns * iso=&lastPoints;
+                    int o=tempPoints.origin.at(n)+1;
+                    while(o<tempPoints.origin.at(n+1) && o<iso->size())
                     {
-                        if(iso->at(o).isBroken)
+                        if(iso->isBroken.at(o))
                         {
                             differentDirection=true;
                             break;
@@ -3791,15 +3499,15 @@ void ROUTAGE::removeCrossedSegments()
                 }
             }
         }
-        if(!differentDirection && (Util::myDiffAngle(tempPoints.at(n).capArrival,tempPoints.at(n+1).capArrival)>60.0 ||
-                Util::myDiffAngle(tempPoints.at(n).capStart,tempPoints.at(n+1).capStart)>60.0))
+        if(!differentDirection && (Util::myDiffAngle(tempPoints.capArrival.at(n),tempPoints.capArrival.at(n+1))>60.0 ||
+                Util::myDiffAngle(tempPoints.capStart.at(n),tempPoints.capStart.at(n+1))>60.0))
         {
-            if(tempPoints.at(n).originNb!=tempPoints.at(n+1).originNb)
+            if(tempPoints.origin.at(n)!=tempPoints.origin.at(n+1))
             {
-                QLineF temp1(tempPoints.at(n).origin->x,tempPoints.at(n).origin->y,
-                             tempPoints.at(n).x,tempPoints.at(n).y);
-                QLineF temp2(tempPoints.at(n+1).origin->x,tempPoints.at(n+1).origin->y,
-                             tempPoints.at(n+1).x,tempPoints.at(n+1).y);
+                QLineF temp1(lastPoints.x.at(tempPoints.origin.at(n)),lastPoints.y.at(tempPoints.origin.at(n)),
+                             tempPoints.x.at(n),tempPoints.y.at(n));
+                QLineF temp2(lastPoints.x.at(tempPoints.origin.at(n+1)),lastPoints.y.at(tempPoints.origin.at(n+1)),
+                             tempPoints.x.at(n+1),tempPoints.y.at(n+1));
                 if(temp1.intersect(temp2,&dummy)!=QLineF::BoundedIntersection)
                     differentDirection=true;
             }
@@ -3808,11 +3516,11 @@ void ROUTAGE::removeCrossedSegments()
             critere=0;
         else
         {
-            QLineF temp1(tempPoints.at(n).origin->x,tempPoints.at(n).origin->y,
-                         tempPoints.at(n+1).origin->x,tempPoints.at(n+1).origin->y);
+            QLineF temp1(lastPoints.x.at(tempPoints.origin.at(n)),lastPoints.y.at(tempPoints.origin.at(n)),
+                         lastPoints.x.at(tempPoints.origin.at(n+1)),lastPoints.y.at(tempPoints.origin.at(n+1)));
             QPointF middle=temp1.pointAt(0.5);
-            QLineF temp2(middle.x(),middle.y(),tempPoints.at(n).x,tempPoints.at(n).y);
-            QLineF temp3(middle.x(),middle.y(),tempPoints.at(n+1).x,tempPoints.at(n+1).y);
+            QLineF temp2(middle.x(),middle.y(),tempPoints.x.at(n),tempPoints.y.at(n));
+            QLineF temp3(middle.x(),middle.y(),tempPoints.x.at(n+1),tempPoints.y.at(n+1));
             ++debugCross0;
             critere=temp2.angleTo(temp3);
             if(critere<0) critere+=360;
@@ -3833,7 +3541,7 @@ void ROUTAGE::removeCrossedSegments()
         if(d.key()<180) break;
         QPoint couple=d.value();
         int badOne=0;
-        if(tempPoints.at(couple.x()).distIso<tempPoints.at(couple.y()).distIso)
+        if(tempPoints.distIso.at(couple.x())<tempPoints.distIso.at(couple.y()))
             badOne=couple.x();
         else
             badOne=couple.y();
@@ -3854,24 +3562,24 @@ void ROUTAGE::removeCrossedSegments()
 
 
             bool differentDirection=false;
-            if(tempPoints.at(previous).originNb!=tempPoints.at(next).originNb)
+            if(tempPoints.origin.at(previous)!=tempPoints.origin.at(next))
             {
-                QLineF a1(tempPoints.at(previous).origin->x,tempPoints.at(previous).origin->y,tempPoints.at(previous).x,tempPoints.at(previous).y);
-                QLineF a2(tempPoints.at(next).origin->x,tempPoints.at(next).origin->y,tempPoints.at(next).x,tempPoints.at(next).y);
+                QLineF a1(lastPoints.x.at(tempPoints.origin.at(previous)),lastPoints.y.at(tempPoints.origin.at(previous)),tempPoints.x.at(previous),tempPoints.y.at(previous));
+                QLineF a2(lastPoints.x.at(tempPoints.origin.at(next)),lastPoints.y.at(tempPoints.origin.at(next)),tempPoints.x.at(next),tempPoints.y.at(next));
                 if(a1.intersect(a2,&dummy)!=QLineF::BoundedIntersection)
                 {
-                    if(tempPoints.at(previous).origin->isBroken)
+                    if(lastPoints.isBroken.at(tempPoints.origin.at(previous)))
                     {
-                        if(!tempPoints.at(next).origin->isBroken)
+                        if(!lastPoints.isBroken.at(tempPoints.origin.at(next)))
                             differentDirection=true;
                     }
-                    else if(tempPoints.at(previous).originNb!=tempPoints.at(next).originNb+1)
+                    else if(tempPoints.origin.at(previous)!=tempPoints.origin.at(next)+1)
                     {
-                        QList<vlmPoint> * iso=isos.at(isos.size()-1)->getPoints();
-                        int o=tempPoints.at(previous).originNb+1;
-                        while(o<tempPoints.at(next).originNb && o<iso->count())
+                        const isoColumns * iso=&lastPoints;
+                        int o=tempPoints.origin.at(previous)+1;
+                        while(o<tempPoints.origin.at(next) && o<iso->size())
                         {
-                            if(iso->at(o).isBroken)
+                            if(iso->isBroken.at(o))
                             {
                                 differentDirection=true;
                                 break;
@@ -3881,15 +3589,15 @@ void ROUTAGE::removeCrossedSegments()
                     }
                 }
             }
-            if(!differentDirection && (Util::myDiffAngle(tempPoints.at(previous).capArrival,tempPoints.at(next).capArrival)>60.0 ||
-                    Util::myDiffAngle(tempPoints.at(previous).capStart,tempPoints.at(next).capStart)>60.0))
+            if(!differentDirection && (Util::myDiffAngle(tempPoints.capArrival.at(previous),tempPoints.capArrival.at(next))>60.0 ||
+                    Util::myDiffAngle(tempPoints.capStart.at(previous),tempPoints.capStart.at(next))>60.0))
             {
-                if(tempPoints.at(previous).originNb!=tempPoints.at(next).originNb)
+                if(tempPoints.origin.at(previous)!=tempPoints.origin.at(next))
                 {
-                    QLineF temp1(tempPoints.at(previous).origin->x,tempPoints.at(previous).origin->y,
-                                 tempPoints.at(previous).x,tempPoints.at(previous).y);
-                    QLineF temp2(tempPoints.at(next).origin->x,tempPoints.at(next).origin->y,
-                                 tempPoints.at(next).x,tempPoints.at(next).y);
+                    QLineF temp1(lastPoints.x.at(tempPoints.origin.at(previous)),lastPoints.y.at(tempPoints.origin.at(previous)),
+                                 tempPoints.x.at(previous),tempPoints.y.at(previous));
+                    QLineF temp2(lastPoints.x.at(tempPoints.origin.at(next)),lastPoints.y.at(tempPoints.origin.at(next)),
+                                 tempPoints.x.at(next),tempPoints.y.at(next));
                     if(temp1.intersect(temp2,&dummy)!=QLineF::BoundedIntersection)
                         differentDirection=true;
                 }
@@ -3898,11 +3606,11 @@ void ROUTAGE::removeCrossedSegments()
                 critere=0;
             else
             {
-                QLineF temp1(tempPoints.at(previous).origin->x,tempPoints.at(previous).origin->y,
-                             tempPoints.at(next).origin->x,tempPoints.at(next).origin->y);
+                QLineF temp1(lastPoints.x.at(tempPoints.origin.at(previous)),lastPoints.y.at(tempPoints.origin.at(previous)),
+                             lastPoints.x.at(tempPoints.origin.at(next)),lastPoints.y.at(tempPoints.origin.at(next)));
                 QPointF middle=temp1.pointAt(0.5);
-                QLineF temp2(middle.x(),middle.y(),tempPoints.at(previous).x,tempPoints.at(previous).y);
-                QLineF temp3(middle.x(),middle.y(),tempPoints.at(next).x,tempPoints.at(next).y);
+                QLineF temp2(middle.x(),middle.y(),tempPoints.x.at(previous),tempPoints.y.at(previous));
+                QLineF temp3(middle.x(),middle.y(),tempPoints.x.at(next),tempPoints.y.at(next));
                 critere=temp2.angleTo(temp3);
                 if(critere<0) critere+=360;
             }
@@ -3926,20 +3634,22 @@ void ROUTAGE::removeCrossedSegments()
         }
         --currentCount;
     }
-    for (int nn=deadStatus.size()-1;nn>=0;--nn)
+    QBitArray removed(deadStatus.size(),false);
+    for (int nn=0;nn<deadStatus.size();++nn)
     {
         if(deadStatus.at(nn))
-            tempPoints.removeAt(nn);
+            removed.setBit(nn);
     }
+    tempPoints.remove(removed);
     /* checking again using brute force */
     for (int n=0;n<tempPoints.size()-1;++n)
     {
-        if(tempPoints.at(n).originNb==tempPoints.at(n+1).originNb) continue;
-        QLineF a1(tempPoints.at(n).origin->x,tempPoints.at(n).origin->y,tempPoints.at(n).x,tempPoints.at(n).y);
-        QLineF a2(tempPoints.at(n+1).origin->x,tempPoints.at(n+1).origin->y,tempPoints.at(n+1).x,tempPoints.at(n+1).y);
+        if(tempPoints.origin.at(n)==tempPoints.origin.at(n+1)) continue;
+        QLineF a1(lastPoints.x.at(tempPoints.origin.at(n)),lastPoints.y.at(tempPoints.origin.at(n)),tempPoints.x.at(n),tempPoints.y.at(n));
+        QLineF a2(lastPoints.x.at(tempPoints.origin.at(n+1)),lastPoints.y.at(tempPoints.origin.at(n+1)),tempPoints.x.at(n+1),tempPoints.y.at(n+1));
         if(a1.intersect(a2,&dummy)==QLineF::BoundedIntersection)
         {
-            if(tempPoints.at(n).distIso<tempPoints.at(n+1).distIso)
+            if(tempPoints.distIso.at(n)<tempPoints.distIso.at(n+1))
                 tempPoints.removeAt(n);
             else
                 tempPoints.removeAt(n+1);
@@ -3948,15 +3658,15 @@ void ROUTAGE::removeCrossedSegments()
     }
 }
 #endif
-void ROUTAGE::calculateCaps(QList<double> *caps, const vlmPoint &point, const double &workAngleStep, const double &workAngleRange)
+void ROUTAGE::calculateCaps(QList<double> *caps, const double &capArrival, const double &workAngleStep, const double &workAngleRange)
 {
     for(double cc=0;true;cc=cc+workAngleStep)
     {
         if(cc>workAngleRange/2.0)
             cc=workAngleRange/2;
-        caps->append(Util::A360(point.capArrival-cc));
+        caps->append(Util::A360(capArrival-cc));
         if(cc!=0)
-            caps->prepend(Util::A360(point.capArrival+cc));
+            caps->prepend(Util::A360(capArrival+cc));
         if(cc>=workAngleRange/2.0) break;
     }
 #if 0
@@ -3976,6 +3686,150 @@ void ROUTAGE::calculateCaps(QList<double> *caps, const vlmPoint &point, const do
 #endif
     return;
 }
+isoColumns ROUTAGE::generateCandidates(const int &n, const QList<double> &caps, const bool &tryingToFindHole, int * nbCaps, int * nbCapsPruned)
+{
+    const isoColumns * list=&lastPoints;
+    isoColumns findPoints;
+    findPoints.reserve(caps.size());
+/*calculate angle limits*/
+    QLineF limitRight,limitLeft;
+    if(n>1)
+    {
+        limitRight.setPoints(QPointF(list->x.at(n-2),list->y.at(n-2)),QPointF(xa,ya));
+        limitRight.setAngle(Util::A360(90-list->capOrigin.at(n-2)));
+        limitRight.setLength(list->distIso.at(n-2));
+    }
+    if(n<list->size()-2)
+    {
+        limitLeft.setPoints(QPointF(list->x.at(n+2),list->y.at(n+2)),QPointF(xa,ya));
+        limitLeft.setAngle(Util::A360(90-list->capOrigin.at(n+2)));
+        limitLeft.setLength(list->distIso.at(n+2));
+    }
+    for(int ccc=0;ccc<caps.size();++ccc)
+    {
+        ++(*nbCaps);
+/*use angle limits*/
+        if(!tryingToFindHole && !list->isStart(0) && !list->notSimplificable.at(n))
+        {
+            QLineF temp(list->x.at(n),list->y.at(n),xa,ya);
+            temp.setAngle(Util::A360(90-caps.at(ccc)));
+            temp.setLength(list->distIso.at(n));
+            QPointF dummy;
+            if(n>1)
+            {
+                if(list->distIso.at(n)<list->distIso.at(n-1))
+                {
+                    if(temp.intersect(limitRight,&dummy)==QLineF::BoundedIntersection)
+                    {
+                        ++(*nbCapsPruned);
+                        continue;
+                    }
+                }
+            }
+            if(n<list->size()-2)
+            {
+                if(list->distIso.at(n)<list->distIso.at(n+1))
+                {
+                    if(temp.intersect(limitLeft,&dummy)==QLineF::BoundedIntersection)
+                    {
+                        ++(*nbCapsPruned);
+                        continue;
+                    }
+                }
+            }
+        }
+/*findPointThreaded reads the neighbours of the origin from lastPoints*/
+        const int c=findPoints.append(0,0,n);
+        findPoints.wind_angle[c]=list->wind_angle.at(n);
+        findPoints.wind_speed[c]=list->wind_speed.at(n);
+        findPoints.current_speed[c]=list->current_speed.at(n);
+        findPoints.current_angle[c]=list->current_angle.at(n);
+        findPoints.capOrigin[c]=caps.at(ccc);
+        if(i_iso)
+            findPoints.eta[c]=i_eta;
+        else
+            findPoints.eta[c]=eta;
+    }
+    return findPoints;
+}
+void ROUTAGE::evaluateCandidates(QList<isoColumns> * batch) const
+{
+    if(!this->useMultiThreading)
+    {
+        for(int n=0;n<batch->size();++n)
+        {
+            if(!batch->at(n).isEmpty())
+                (*batch)[n]=findPointThreaded(context,batch->at(n));
+        }
+        return;
+    }
+/*one list per origin point, QtConcurrent hands them out dynamically to the pool so fast and slow origins balance out*/
+    *batch=QtConcurrent::blockingMapped(*batch, contextMapper<isoColumns,ROUTAGE::findPointThreaded>(&context));
+}
+/*coast and barrier tests of a batch, the legs of one list are tested against each coast cell in one pass*/
+void ROUTAGE::checkCandidates(QList<isoColumns> * batch) const
+{
+    if(!checkCoast && !checkLine) return;
+    if(!this->useMultiThreading)
+    {
+        for(int n=0;n<batch->size();++n)
+        {
+            if(!batch->at(n).isEmpty())
+                (*batch)[n]=checkCoastCollision(context,batch->at(n));
+        }
+        return;
+    }
+    *batch=QtConcurrent::blockingMapped(*batch, contextMapper<isoColumns,ROUTAGE::checkCoastCollision>(&context));
+}
+isoColumns ROUTAGE::filterCandidates(const isoColumns &findPoints, const bool &tryingToFindHole, const int &dataWave, bool * toBeRestarted)
+{
+    isoColumns polarPoints;
+    *toBeRestarted=false;
+    for(int fp=0;fp<findPoints.size();++fp)
+    {
+        if(checkCoast||checkLine)
+        {
+/*crossing with coast or barriers was set by checkCandidates*/
+            const double wind_speed=findPoints.wind_speed.at(fp);
+            double twa_x=qAbs(findPoints.capOrigin.at(fp)-findPoints.wind_angle.at(fp));
+            if(qAbs(twa_x)>180)
+            {
+                if(twa_x<0)
+                    twa_x=360+twa_x;
+                else
+                    twa_x=twa_x-360;
+            }
+            twa_x=qAbs(twa_x);
+            if(findPoints.isDead.at(fp) ||
+                (twa_x<=90 && wind_speed>this->maxPres) ||
+                (twa_x<=90 && wind_speed<this->minPres) ||
+                (twa_x>=90 && wind_speed>this->maxPortant) ||
+                (twa_x>=90 && wind_speed<this->minPortant) ||
+                (dataWave>0 && dataManager->getInterpolatedValue_1D(dataWave,DATA_LV_GND_SURF,0,findPoints.lon.at(fp),findPoints.lat.at(fp),findPoints.eta.at(fp))>maxWaveHeight))
+            {
+                if(!tryingToFindHole)
+                {
+                    *toBeRestarted=true;
+                    polarPoints.clear();
+                    break;
+                }
+                continue;
+            }
+        }
+#ifdef HAS_ICEGATE
+        vlmPoint p(findPoints.lon.at(fp),findPoints.lat.at(fp));
+        p.x=findPoints.x.at(fp);
+        p.y=findPoints.y.at(fp);
+        p.origin=iso->getPoint(findPoints.origin.at(fp));
+        if(!checkIceGate(p))
+            continue;
+#endif
+        const int c=polarPoints.append(findPoints,fp);
+        if(tryingToFindHole)
+            polarPoints.notSimplificable[c]=true;
+    }
+    return polarPoints;
+}
 void ROUTAGE::showContextMenu(const int &isoNb,const int &pointNb)
 {
     if(isoNb>=isochrones.size()) return;
@@ -4199,7 +4053,7 @@ void ROUTAGE::showIsoRoute()
             vlmPoint Cross;
             double lon,lat,X,Y;
             Cross=result->getPoints()->at(n);
-            proj->map2screenDouble(Cross.lon,Cross.lat,&X,&Y);
+            frame.map2frame(Cross.lon,Cross.lat,&X,&Y);
             int js=0;
             double minDist=10e10;
             for(int s=indice;s<isochrone->getPoints()->size()-1;++s)
@@ -4207,8 +4061,8 @@ void ROUTAGE::showIsoRoute()
                 vlmPoint p1=isochrone->getPoints()->at(s);
                 vlmPoint p2=isochrone->getPoints()->at(s+1);
                 double x1,y1,x2,y2; /*recalculation necessary because zoom has changed*/
-                proj->map2screenDouble(p1.lon,p1.lat,&x1,&y1);
-                proj->map2screenDouble(p2.lon,p2.lat,&x2,&y2);
+                frame.map2frame(p1.lon,p1.lat,&x1,&y1);
+                frame.map2frame(p2.lon,p2.lat,&x2,&y2);
                 QLineF line1(x1,y1,x2,y2);
                 for(int is=0;is<i_isochrone->getPoints()->size()-1;++is)
                 {
@@ -4222,7 +4076,7 @@ void ROUTAGE::showIsoRoute()
                         if(line3.length()<minDist)
                         {
                             minDist=line3.length();
-                            proj->screen2mapDouble(cross.x(),cross.y(),&lon,&lat);
+                            frame.frame2map(cross.x(),cross.y(),&lon,&lat);
                             Cross.lon=lon;
                             Cross.lat=lat;
                             Cross.x=cross.x();
@@ -4244,7 +4098,7 @@ void ROUTAGE::showIsoRoute()
                 for(int s=indice;s<isochrone->getPoints()->size();++s)
                 {
                     vlmPoint p1=isochrone->getPoints()->at(s);
-                    proj->map2screenDouble(p1.lon,p1.lat,&x1,&y1);
+                    frame.map2frame(p1.lon,p1.lat,&x1,&y1);
                     poly.append(QPointF(x1,y1));
                 }
                 int indicePrev=prev_isochrone->getPoints()->indexOf(result->getPoints()->at(n+1));
@@ -4256,7 +4110,7 @@ void ROUTAGE::showIsoRoute()
                 for(int s=indicePrev;s<prev_isochrone->getPoints()->size();++s)
                 {
                     vlmPoint p1=prev_isochrone->getPoints()->at(s);
-                    proj->map2screenDouble(p1.lon,p1.lat,&x1,&y1);
+                    frame.map2frame(p1.lon,p1.lat,&x1,&y1);
                     prev_poly.append(QPointF(x1,y1));
                 }
                 for(int s=js;s<i_isochrone->count();++s)
@@ -4264,7 +4118,7 @@ void ROUTAGE::showIsoRoute()
                     vlmPoint p1=i_isochrone->getPoints()->at(s);
                     if(p1.isBroken) break;
                     double x1,y1; /*recalculation necessary because zoom has changed*/
-                    proj->map2screenDouble(p1.lon,p1.lat,&x1,&y1);
+                    frame.map2frame(p1.lon,p1.lat,&x1,&y1);
                     i_poly.append(QPointF(x1,y1));
                 }
 #if 1
@@ -4273,8 +4127,8 @@ void ROUTAGE::showIsoRoute()
                     double x2,y2;
                     vlmPoint p1=result->getPoints()->at(rrr);
                     vlmPoint p2=result->getPoints()->at(rrr+1);
-                    proj->map2screenDouble(p1.lon,p1.lat,&x1,&y1);
-                    proj->map2screenDouble(p2.lon,p2.lat,&x2,&y2);
+                    frame.map2frame(p1.lon,p1.lat,&x1,&y1);
+                    frame.map2frame(p2.lon,p2.lat,&x2,&y2);
                     QLineF rLine(x1,y1,x2,y2);
                     found=false;
                     for(int pp=0;pp<i_poly.size()-1;++pp)
@@ -4300,7 +4154,7 @@ void ROUTAGE::showIsoRoute()
                 debug1->setLinePen(pendebug);
                 foreach (QPointF pp,poly)
                 {
-                    proj->screen2mapDouble(pp.x(),pp.y(),&lon,&lat);
+                    frame.frame2map(pp.x(),pp.y(),&lon,&lat);
                     debug1->addPoint(lat,lon);
                 }
                 debug1->slot_showMe();
@@ -4312,7 +4166,7 @@ void ROUTAGE::showIsoRoute()
                 debug2->setLinePen(pendebug);
                 foreach (QPointF pp,i_poly)
                 {
-                    proj->screen2mapDouble(pp.x(),pp.y(),&lon,&lat);
+                    frame.frame2map(pp.x(),pp.y(),&lon,&lat);
                     debug2->addPoint(lat,lon);
                 }
                 debug2->slot_showMe();
@@ -4324,7 +4178,7 @@ void ROUTAGE::showIsoRoute()
                 debug3->setLinePen(pendebug);
                 foreach (QPointF pp,prev_poly)
                 {
-                    proj->screen2mapDouble(pp.x(),pp.y(),&lon,&lat);
+                    frame.frame2map(pp.x(),pp.y(),&lon,&lat);
                     debug3->addPoint(lat,lon);
                 }
                 debug3->slot_showMe();
@@ -4334,7 +4188,7 @@ void ROUTAGE::showIsoRoute()
                 if(newtownRaphson(&root,goal,precision,&poly,&prev_poly,&i_poly))
                 {
                     QPointF cross=pointAt(&i_poly,root);
-                    proj->screen2mapDouble(cross.x(),cross.y(),&lon,&lat);
+                    frame.frame2map(cross.x(),cross.y(),&lon,&lat);
                     Cross.lon=lon;
                     Cross.lat=lat;
                     Cross.x=cross.x();
@@ -4347,7 +4201,7 @@ void ROUTAGE::showIsoRoute()
                 left.append(Cross);
             js=i_isochrone->getPoints()->size()-1;
             Cross=result->getPoints()->at(n);
-            proj->map2screenDouble(Cross.lon,Cross.lat,&X,&Y);
+            frame.map2frame(Cross.lon,Cross.lat,&X,&Y);
             found=false;
             minDist=10e10;
             for(int s=indice;s>0;--s)
@@ -4355,8 +4209,8 @@ void ROUTAGE::showIsoRoute()
                 vlmPoint p1=isochrone->getPoints()->at(s);
                 vlmPoint p2=isochrone->getPoints()->at(s-1);
                 double x1,y1,x2,y2; /*recalculation necessary because zoom has changed*/
-                proj->map2screenDouble(p1.lon,p1.lat,&x1,&y1);
-                proj->map2screenDouble(p2.lon,p2.lat,&x2,&y2);
+                frame.map2frame(p1.lon,p1.lat,&x1,&y1);
+                frame.map2frame(p2.lon,p2.lat,&x2,&y2);
                 QLineF line1(x1,y1,x2,y2);
                 for(int is=i_isochrone->getPoints()->size()-1;is>0;--is)
                 {
@@ -4370,7 +4224,7 @@ void ROUTAGE::showIsoRoute()
                         if(line3.length()<minDist)
                         {
                             minDist=line3.length();
-                            proj->screen2mapDouble(cross.x(),cross.y(),&lon,&lat);
+                            frame.frame2map(cross.x(),cross.y(),&lon,&lat);
                             Cross.lon=lon;
                             Cross.lat=lat;
                             Cross.x=cross.x();
@@ -4392,7 +4246,7 @@ void ROUTAGE::showIsoRoute()
                 for(int s=indice;s>=0;--s)
                 {
                     vlmPoint p1=isochrone->getPoints()->at(s);
-                    proj->map2screenDouble(p1.lon,p1.lat,&x1,&y1);
+                    frame.map2frame(p1.lon,p1.lat,&x1,&y1);
                     poly.append(QPointF(x1,y1));
                 }
                 int indicePrev=prev_isochrone->getPoints()->indexOf(result->getPoints()->at(n+1));
@@ -4404,7 +4258,7 @@ void ROUTAGE::showIsoRoute()
                 for(int s=indicePrev;s>=0;--s)
                 {
                     vlmPoint p1=prev_isochrone->getPoints()->at(s);
-                    proj->map2screenDouble(p1.lon,p1.lat,&x1,&y1);
+                    frame.map2frame(p1.lon,p1.lat,&x1,&y1);
                     prev_poly.append(QPointF(x1,y1));
                 }
 #if 1
@@ -4414,8 +4268,8 @@ void ROUTAGE::showIsoRoute()
                     double x2,y2;
                     vlmPoint p1=result->getPoints()->at(rrr);
                     vlmPoint p2=result->getPoints()->at(rrr+1);
-                    proj->map2screenDouble(p1.lon,p1.lat,&x1,&y1);
-                    proj->map2screenDouble(p2.lon,p2.lat,&x2,&y2);
+                    frame.map2frame(p1.lon,p1.lat,&x1,&y1);
+                    frame.map2frame(p2.lon,p2.lat,&x2,&y2);
                     QLineF rLine(x1,y1,x2,y2);
                     found=false;
                     for(int pp=0;pp<i_isochrone->getPoints()->size()-1;++pp)
@@ -4423,8 +4277,8 @@ void ROUTAGE::showIsoRoute()
                         QPointF dummy;
                         p1=i_isochrone->getPoints()->at(pp);
                         p2=i_isochrone->getPoints()->at(pp+1);
-                        proj->map2screenDouble(p1.lon,p1.lat,&x1,&y1);
-                        proj->map2screenDouble(p2.lon,p2.lat,&x2,&y2);
+                        frame.map2frame(p1.lon,p1.lat,&x1,&y1);
+                        frame.map2frame(p2.lon,p2.lat,&x2,&y2);
                         QLineF iLine(x1,y1,x2,y2);
                         if(rLine.intersect(iLine,&dummy)==QLineF::BoundedIntersection)
                         {
@@ -4447,7 +4301,7 @@ void ROUTAGE::showIsoRoute()
                         i_poly.clear();
                     }
                     double x1,y1; /*recalculation necessary because zoom has changed*/
-                    proj->map2screenDouble(p1.lon,p1.lat,&x1,&y1);
+                    frame.map2frame(p1.lon,p1.lat,&x1,&y1);
                     i_poly.append(QPointF(x1,y1));
                 }
                 QPen pendebug(Qt::blue);
@@ -4460,7 +4314,7 @@ void ROUTAGE::showIsoRoute()
                 debug1->setLinePen(pendebug);
                 foreach (QPointF pp,poly)
                 {
-                    proj->screen2mapDouble(pp.x(),pp.y(),&lon,&lat);
+                    frame.frame2map(pp.x(),pp.y(),&lon,&lat);
                     debug1->addPoint(lat,lon);
                 }
                 debug1->slot_showMe();
@@ -4472,7 +4326,7 @@ void ROUTAGE::showIsoRoute()
                 debug2->setLinePen(pendebug);
                 foreach (QPointF pp,i_poly)
                 {
-                    proj->screen2mapDouble(pp.x(),pp.y(),&lon,&lat);
+                    frame.frame2map(pp.x(),pp.y(),&lon,&lat);
                     debug2->addPoint(lat,lon);
                 }
                 debug2->slot_showMe();
@@ -4484,7 +4338,7 @@ void ROUTAGE::showIsoRoute()
                 debug3->setLinePen(pendebug);
                 foreach (QPointF pp,prev_poly)
                 {
-                    proj->screen2mapDouble(pp.x(),pp.y(),&lon,&lat);
+                    frame.frame2map(pp.x(),pp.y(),&lon,&lat);
                     debug3->addPoint(lat,lon);
                 }
                 debug3->slot_showMe();
@@ -4494,7 +4348,7 @@ void ROUTAGE::showIsoRoute()
                 if(newtownRaphson(&root,goal,precision,&poly,&prev_poly,&i_poly))
                 {
                     QPointF cross=pointAt(&i_poly,root);
-                    proj->screen2mapDouble(cross.x(),cross.y(),&lon,&lat);
+                    frame.frame2map(cross.x(),cross.y(),&lon,&lat);
                     Cross.lon=lon;
                     Cross.lat=lat;
                     Cross.x=cross.x();
@@ -4817,10 +4671,120 @@ bool ROUTAGE::crossBarriere(const QLineF &line) const
     }
     return false;
 #else
-    return myBoat->cross(line);
+    return context.crossBarrier(line);
     //return false;
 #endif
 }
+void ROUTAGE::buildContext()
+{
+    context.polar=myBoat->getPolarData();
+    context.dataManager=dataManager;
+    context.map=map;
+    context.frame=frame;
+    context.visibleArea=visibleArea;
+    context.maxDate=dataManager->get_maxDate();
+    context.hasCurrent=dataManager->hasData(DATA_CURRENT_VX,DATA_LV_MSL,0);
+    context.whatIfUsed=whatIfUsed;
+    context.whatIfJour=whatIfJour;
+    context.whatIfTime=whatIfTime;
+    context.whatIfWind=whatIfWind;
+    context.speedLossOnTack=speedLossOnTack;
+    context.vacLen=myBoat->getVacLen();
+    context.i_iso=i_iso;
+    context.routageOrtho=routageOrtho;
+    context.visibleOnly=visibleOnly;
+    context.checkCoast=checkCoast;
+    context.checkLine=checkLine;
+    context.start=start;
+    context.arrival=arrival;
+    context.xs=xs;
+    context.ys=ys;
+    context.xa=xa;
+    context.ya=ya;
+    context.maxDist=maxDist;
+    context.pruneWakeAngle=pruneWakeAngle;
+    context.barriers.clear();
+#ifdef OLD_BARRIER
+    context.barriers=barrieres;
+#else
+    /* barrier segments come in lon/lat, the crossing tests are done in the frame */
+    myBoat->appendBarrierSegments(&context.barriers);
+    for(int n=0;n<context.barriers.size();++n)
+    {
+        const QLineF &l=context.barriers.at(n);
+        double x1,y1,x2,y2;
+        frame.map2frame(l.x1(),l.y1(),&x1,&y1);
+        frame.map2frame(l.x2(),l.y2(),&x2,&y2);
+        context.barriers[n]=QLineF(x1,y1,x2,y2);
+    }
+#endif
+    context.timeStep=getTimeStep();
+    context.lastIso=NULL;
+    context.previousIso=&previousIso;
+    context.previousSegments=&previousSegments;
+    context.windSampler.clear();
+    context.currentSampler.clear();
+    context.shapeIso=&shapeIso;
+    context.shapeMiddle=&shapeMiddle;
+}
+/*time step changes with eta, called on the GUI thread before the workers are started*/
+void ROUTAGE::refreshContext()
+{
+    context.timeStep=getTimeStep();
+    context.lastIso=&lastPoints;
+    /* no worker is running here: decoded grib records over the memory cap can go */
+    dataManager->trim_gribCache();
+    /* the candidates of this step all land at the same eta (see findPointThreaded) */
+    time_t isoStep=context.timeStep*60;
+    time_t nextEta=i_iso?i_eta-isoStep:eta+isoStep;
+    if(whatIfUsed && whatIfJour<=nextEta)
+        nextEta+=whatIfTime*3600;
+    dataManager->init_windSampler(&context.windSampler,nextEta,INTERPOLATION_DEFAULT);
+    if(context.hasCurrent)
+        dataManager->init_currentSampler(&context.currentSampler,nextEta,INTERPOLATION_DEFAULT);
+    else
+        context.currentSampler.clear();
+}
+bool RoutingContext::getWind(const double &lon, const double &lat, const time_t &eta, double * tws, double * twd, GribSamplerCache * cache) const
+{
+    if(windSampler.isValid() && windSampler.get_date()==eta)
+        return windSampler.sample(lon,lat,tws,twd,cache);
+    return dataManager->getInterpolatedWind(lon,lat,eta,tws,twd,INTERPOLATION_DEFAULT);
+}
+bool RoutingContext::getCurrent(const double &lon, const double &lat, const time_t &eta, double * cs, double * cd, GribSamplerCache * cache) const
+{
+    if(currentSampler.isValid() && currentSampler.get_date()==eta)
+        return currentSampler.sample(lon,lat,cs,cd,cache);
+    return dataManager->getInterpolatedCurrent(lon,lat,eta,cs,cd,INTERPOLATION_DEFAULT);
+}
+bool RoutingContext::crossBarrier(const QLineF &line) const
+{
+    QPointF dummy;
+    for(int n=0;n<barriers.size();++n)
+    {
+        if(barriers.at(n).intersect(line,&dummy)==QLineF::BoundedIntersection)
+            return true;
+    }
+    return false;
+}
+datathread RoutingContext::threadData(const time_t &eta) const
+{
+    datathread dataThread;
+    dataThread.Eta=eta;
+    dataThread.dataManager=dataManager;
+    dataThread.whatIfUsed=whatIfUsed;
+    dataThread.whatIfJour=whatIfJour;
+    dataThread.whatIfTime=whatIfTime;
+    dataThread.whatIfWind=whatIfWind;
+    dataThread.polar=polar;
+    dataThread.vacLen=vacLen;
+    dataThread.maxDate=maxDate;
+    dataThread.hasCurrent=hasCurrent;
+    dataThread.timeStep=timeStep;
+    dataThread.speedLossOnTack=speedLossOnTack;
+    dataThread.i_iso=i_iso;
+    return dataThread;
+}
 void ROUTAGE::calculateAlternative()
 {
     while(!this->alternateRoutes.isEmpty())
@@ -4835,17 +4799,8 @@ void ROUTAGE::calculateAlternative()
     waitBox->show();
     QApplication::processEvents();
     vlmPoint to(this->toPOI->getLongitude(),this->toPOI->getLatitude());
-    datathread dataThread;
-    dataThread.Boat=this->getBoat();
-    dataThread.Eta=this->getEta();
-    dataThread.dataManager=get_dataManager();
-    dataThread.whatIfJour=this->getWhatIfJour();
-    dataThread.whatIfUsed=this->getWhatIfUsed();
-    dataThread.whatIfTime=this->getWhatIfTime();
-    dataThread.whatIfWind=this->getWhatIfWind();
-    dataThread.timeStep=this->getTimeStep();
-    dataThread.speedLossOnTack=this->getSpeedLossOnTack();
-    dataThread.i_iso=i_iso;
+    buildContext();
+    datathread dataThread=context.threadData(this->getEta());
     QList<vlmPoint> tempResult;
     for (int r=0;r<result->count();++r)
     {
@@ -4976,113 +4931,127 @@ bool ROUTAGE::checkIceGate(const vlmPoint &p) const
     }
     return true;
 }
+/* links each origin to the first and last of its children in the new isochrone (see calculateShapeIso) */
+void ROUTAGE::setChildren(vlmLine * line)
+{
+    QList<vlmPoint> * points=line->getPoints();
+    for(int n=0;n<points->size();++n)
+    {
+        vlmPoint * origin=points->at(n).origin;
+        if(!origin) continue;
+        if(origin->firstChild==-1)
+            origin->firstChild=n;
+        origin->lastChild=n;
+    }
+}
 void ROUTAGE::calculateShapeIso()
 {
 #ifndef USE_SHAPEISO
     return;
 #endif
-    QList<vlmLine *> isos=i_iso?i_isochrones:isochrones;
+    const QList<vlmLine *> &isos=i_iso?i_isochrones:isochrones;
     QPolygonF newShape;
     int isoNb=isos.size()-1;
-    QList<vlmPoint> * iso;
-    vlmPoint p;
+    const QList<vlmPoint> * iso;
+    const vlmPoint * p;
     int n=0;
 //left side
     n=0;
     iso=isos.at(isoNb)->getPoints();
-    p=iso->at(n);
+    p=&iso->at(n);
     while(true)
     {
-        newShape.prepend(QPointF(p.x,p.y));
-        if(p.isStart) break;
-        p=*(p.origin);
+        newShape.prepend(QPointF(p->x,p->y));
+        if(p->isStart) break;
+        p=p->origin;
         --isoNb;
-        n=p.isoIndex;
+        n=p->isoIndex;
         iso=isos.at(isoNb)->getPoints();
         while(n>0)
         {
             --n;
-            p=iso->at(n);
-            if(p.isBroken)
+            p=&iso->at(n);
+            if(p->isBroken)
             {
                 ++n;
-                p=iso->at(n);
+                p=&iso->at(n);
                 break;
             }
-            newShape.prepend(QPointF(p.x,p.y));
+            newShape.prepend(QPointF(p->x,p->y));
         }
     }
 //middle
+    /*a point reached through its parent is walked as childless, as the
+      former per-point copies of the children were*/
+    bool childless=false;
     isoNb=isos.size()-1;
     n=0;
     shapeMiddle.clear();
     while(true)
     {
         iso=isos.at(isoNb)->getPoints();
-        p=iso->at(n);
-        while(!p.isBroken && p.myChildren.isEmpty() && n<iso->size()-1)
+        p=&iso->at(n);
+        childless=false;
+        while(!p->isBroken && p->firstChild==-1 && n<iso->size()-1)
         {
-            newShape.append(QPointF(p.x,p.y));
-            shapeMiddle.append(QPointF(p.x,p.y));
-            p=iso->at(++n);
+            newShape.append(QPointF(p->x,p->y));
+            shapeMiddle.append(QPointF(p->x,p->y));
+            p=&iso->at(++n);
         }
-        newShape.append(QPointF(p.x,p.y));
-        shapeMiddle.append(QPointF(p.x,p.y));
+        newShape.append(QPointF(p->x,p->y));
+        shapeMiddle.append(QPointF(p->x,p->y));
         if (n>=iso->size()-1) break;
-        if(p.isBroken && p.myChildren.isEmpty())
+        if(p->isBroken && p->firstChild==-1)
         {
             bool sameOrigin=false;
-            while(p.isBroken)
+            while(p->isBroken)
             {
-                int i=p.isoIndex;
-                p=*p.origin;
+                int i=p->isoIndex;
+                p=p->origin;
                 --isoNb;
-                newShape.append(QPointF(p.x,p.y));
-                shapeMiddle.append(QPointF(p.x,p.y));
-                if(!p.myChildren.isEmpty() && p.myChildren.at(p.myChildren.size()-1).isoIndex>i)
+                newShape.append(QPointF(p->x,p->y));
+                shapeMiddle.append(QPointF(p->x,p->y));
+                if(p->lastChild!=-1 && p->lastChild>i)
                 {
                     sameOrigin=true;
                     ++isoNb;
-                    iso=isos.at(isoNb)->getPoints();
-                    p=iso->at(i+1);
+                    p=&isos.at(isoNb)->getPoints()->at(i+1);
                     break;
                 }
-                if (p.isStart) break;
+                if (p->isStart) break;
             }
-            n=p.isoIndex;
+            n=p->isoIndex;
             iso=isos.at(isoNb)->getPoints();
-            newShape.append(QPointF(p.x,p.y));
-            shapeMiddle.append(QPointF(p.x,p.y));
+            newShape.append(QPointF(p->x,p->y));
+            shapeMiddle.append(QPointF(p->x,p->y));
             if(!sameOrigin)
             {
-                while(!p.isBroken && n<iso->size()-1)
+                while(!p->isBroken && n<iso->size()-1)
                 {
-                    p=iso->at(++n);
-                    newShape.append(QPointF(p.x,p.y));
-                    shapeMiddle.append(QPointF(p.x,p.y));
-                    if(!p.myChildren.isEmpty())
+                    p=&iso->at(++n);
+                    newShape.append(QPointF(p->x,p->y));
+                    shapeMiddle.append(QPointF(p->x,p->y));
+                    if(p->firstChild!=-1)
                     {
                         ++isoNb;
-                        p=p.myChildren.at(0);
+                        p=&isos.at(isoNb)->getPoints()->at(p->firstChild);
+                        childless=true;
                         break;
                     }
                 }
             }
         }
-        if(!p.myChildren.isEmpty())
+        if(!childless && p->firstChild!=-1)
         {
-            newShape.append(QPointF(p.x,p.y));
-            shapeMiddle.append(QPointF(p.x,p.y));
-            while(!p.myChildren.isEmpty())
-            {
-                p=p.myChildren.at(0);
-                ++isoNb;
-                newShape.append(QPointF(p.x,p.y));
-                shapeMiddle.append(QPointF(p.x,p.y));
-            }
+            newShape.append(QPointF(p->x,p->y));
+            shapeMiddle.append(QPointF(p->x,p->y));
+            ++isoNb;
+            p=&isos.at(isoNb)->getPoints()->at(p->firstChild);
+            newShape.append(QPointF(p->x,p->y));
+            shapeMiddle.append(QPointF(p->x,p->y));
         }
         iso=isos.at(isoNb)->getPoints();
-        n=p.isoIndex;
+        n=p->isoIndex;
         if(n>=iso->size()-1) break;
     }
     //newShape.remove(newShape.size()-1);
@@ -5090,20 +5059,20 @@ void ROUTAGE::calculateShapeIso()
     isoNb=isos.size()-1;
     iso=isos.at(isoNb)->getPoints();
     n=iso->size()-1;
-    p=iso->at(n);
+    p=&iso->at(n);
     while(true)
     {
-        newShape.append(QPointF(p.x,p.y));
-        if(p.isStart) break;
-        p=*(p.origin);
+        newShape.append(QPointF(p->x,p->y));
+        if(p->isStart) break;
+        p=p->origin;
         --isoNb;
-        n=p.isoIndex;
+        n=p->isoIndex;
         iso=isos.at(isoNb)->getPoints();
-        while(n<iso->size()-1 && !p.isBroken)
+        while(n<iso->size()-1 && !p->isBroken)
         {
             ++n;
-            p=iso->at(n);
-            newShape.append(QPointF(p.x,p.y));
+            p=&iso->at(n);
+            newShape.append(QPointF(p->x,p->y));
         }
     }
     shapeIso.clear();
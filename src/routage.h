@@ -32,10 +32,13 @@ Copyright (C) 2008 - Jacques Zaninetti - http://zygrib.free.fr
 #include <cmath>
 
 #include "class_list.h"
+#include "dataDef.h"
 
 #include "vlmPoint.h"
+#include "isoColumns.h"
 #include "DataManager.h"
 #include "vlmLine.h"
+#include "GribSampler.h"
 
 #define NO_CROSS 1
 #define BOUNDED_CROSS 2
@@ -52,13 +55,125 @@ struct datathread
     time_t whatIfJour;
     int whatIfTime;
     double whatIfWind;
-    boat *Boat;
+    Polar *polar;
+    int vacLen;
+    time_t maxDate;
+    bool hasCurrent;
     int timeStep;
     double speedLossOnTack;
     bool i_iso;
 };
 Q_DECLARE_TYPEINFO(datathread,Q_PRIMITIVE_TYPE);
 
+/* private equal-scale mercator the engine computes in: x/y of the routing points,
+   pruning distances and barrier segments are in frame units, only drawing goes
+   through Projection. Set from the route extent, so the same routing gives the
+   same result whatever the map view is */
+#define ROUTAGE_FRAME_SIZE 2000.0
+struct RoutingFrame
+{
+    double CX;    /* central longitude */
+    double PY;    /* mercator ordinate of the central latitude, in degrees */
+    double scale; /* frame units per degree */
+
+    void init(const double &xW, const double &yN, const double &xE, const double &yS);
+    void map2frame(const double &lon, const double &lat, double *x, double *y) const;
+    void frame2map(const double &x, const double &y, double *lon, double *lat) const;
+    static double mercator(const double &lat);
+};
+Q_DECLARE_TYPEINFO(RoutingFrame,Q_PRIMITIVE_TYPE);
+
+inline double RoutingFrame::mercator(const double &lat)
+{
+    double y=lat;
+    if(y<=-90) y=-89.9999999999;
+    if(y>=90) y=89.9999999999;
+    return radToDeg(log(tan(degToRad(y)/2.0 + M_PI_4)));
+}
+inline void RoutingFrame::map2frame(const double &lon, const double &lat, double *x, double *y) const
+{
+    double diff=fmod(lon-CX,360.0);
+    if(diff>180.0) diff-=360.0;
+    else if(diff<-180.0) diff+=360.0;
+    *x=scale*diff;
+    *y=scale*(PY-mercator(lat));
+}
+inline void RoutingFrame::frame2map(const double &x, const double &y, double *lon, double *lat) const
+{
+    *lon=x/scale+CX;
+    if(*lon>180.0) *lon-=360.0;
+    else if(*lon<=-180.0) *lon+=360.0;
+    *lat=radToDeg(2*atan(exp(degToRad(PY-y/scale)))-M_PI_2);
+}
+
+/* read-only snapshot of a routing run, taken on the GUI thread before the run and
+   refreshed between isochrones. Worker kernels only see this, never ROUTAGE/boat */
+struct RoutingContext
+{
+    Polar *polar;
+    DataManager *dataManager;
+    GshhsReader *map;
+    RoutingFrame frame;
+    QRectF visibleArea;
+    time_t maxDate;
+    bool hasCurrent;
+    bool whatIfUsed;
+    time_t whatIfJour;
+    int whatIfTime;
+    double whatIfWind;
+    double speedLossOnTack;
+    int vacLen;
+    bool i_iso;
+    bool routageOrtho;
+    bool visibleOnly;
+    bool checkCoast;
+    bool checkLine;
+    QPointF start;
+    QPointF arrival;
+    double xs,ys,xa,ya;
+    double maxDist;
+    int pruneWakeAngle;
+    QList<QLineF> barriers;
+    /* per isochrone */
+    double timeStep;
+    const isoColumns *lastIso;
+    const QPolygonF *previousIso;
+    const QList<QLineF> *previousSegments;
+    const QPolygonF *shapeIso;
+    const QPolygonF *shapeMiddle;
+    GribSampler windSampler; /* frozen at the date of the next isochrone */
+    GribSampler currentSampler;
+
+    bool crossBarrier(const QLineF &line) const;
+    bool getWind(const double &lon, const double &lat, const time_t &eta, double * tws, double * twd, GribSamplerCache * cache) const;
+    bool getCurrent(const double &lon, const double &lat, const time_t &eta, double * cs, double * cd, GribSamplerCache * cache) const;
+    datathread threadData(const time_t &eta) const;
+};
+
+/* a slice [begin,end) of the isochrone being built for finalEpuration, which
+   answers with the rows to drop, removed[0] being row begin */
+struct epurationRange
+{
+    const isoColumns *points;
+    int begin;
+    int end;
+    int toBeRemoved;
+    double initialDist;
+    QBitArray removed;
+};
+
+/* QtConcurrent only maps one-argument functions, this binds the context to a kernel */
+template <typename T, T (*Kernel)(const RoutingContext &, const T &)>
+class contextMapper
+{
+    public:
+        typedef T result_type;
+        contextMapper(const RoutingContext *context) : context(context) {}
+        T operator()(const T &t) const {return Kernel(*context,t);}
+    private:
+        const RoutingContext *context;
+};
+
 //===================================================================
 class ROUTAGE : public QObject
 { Q_OBJECT
@@ -161,7 +276,7 @@ class ROUTAGE : public QObject
         void setMinPres(const double &d){this->minPres=d;}
         void setMinPortant(const double &d){this->minPortant=d;}
         Projection * getProj() const {return proj;}
-        static double findDistancePreviousIso(const vlmPoint &P, const QPolygonF * poly);
+        static double findDistancePreviousIso(const double &cx, const double &cy, const QPolygonF * poly);
         QPolygonF * getPreviousIso() {return &previousIso;}
         QList<QLineF> * getPreviousSegments() {return &previousSegments;}
         bool getVisibleOnly() const {return visibleOnly;}
@@ -211,13 +326,14 @@ class ROUTAGE : public QObject
         FCT_SETGET(int,multiNb)
         FCT_GET_CST(double,maxDist)
         FCT_SETGET_CST(double,maxWaveHeight)
-        static vlmPoint multiThreadedContains(const vlmPoint &p);
-        static QList<vlmPoint> finalEpuration(const QList<vlmPoint> &listPoints);
-        static QList<vlmPoint> findPointThreaded(const QList<vlmPoint> &list);
-        static QList<vlmPoint> findRoute(const QList<vlmPoint> &pointList);
-        static vlmPoint checkCoastCollision(const vlmPoint &point);
-        static bool checkCoastCollision2(const vlmPoint &point1, const vlmPoint &point2);
-        static QList<vlmPoint> pruneWakeThreaded(const QList<vlmPoint> &list);
+        const RoutingContext * getContext() const {return &context;}
+        static isoColumns multiThreadedContains(const RoutingContext &context, const isoColumns &points);
+        static epurationRange finalEpuration(const RoutingContext &context, const epurationRange &range);
+        static isoColumns findPointThreaded(const RoutingContext &context, const isoColumns &list);
+        static isoColumns findRoute(const RoutingContext &context, const isoColumns &pointList);
+        static isoColumns checkCoastCollision(const RoutingContext &context, const isoColumns &points);
+        static bool checkCoastCollision2(const RoutingContext &context, const isoColumns &points1, const int &n1, const isoColumns &points2, const int &n2);
+        static isoColumns pruneWakeThreaded(const RoutingContext &context, const isoColumns &list);
 public slots:
         void calculate();
         void slot_edit();
@@ -294,7 +410,8 @@ public slots:
         QDateTime finalEta;
         int msecsD1;
         int msecsD2;
-        QList<vlmPoint> tempPoints;
+        isoColumns tempPoints;
+        isoColumns lastPoints;
         QPolygonF previousIso;
         QList<bool> previousIsoLand;
         QList<QLineF> previousSegments;
@@ -304,12 +421,20 @@ public slots:
         void epuration(int toBeRemoved);
         void removeCrossedSegments();
         double xa,ya,xs,ys;
+        RoutingFrame frame;
+        double zoneW,zoneE,zoneN,zoneS;
+        QRectF visibleArea;
+        void computeZone();
         bool checkCoast,checkLine;
         int  nbAlternative;
         int  thresholdAlternative;
         bool arrivalIsClosest;
         bool routeFromBoat;
-        void calculateCaps(QList<double> *caps, const vlmPoint &point, const double &workAngleStep, const double &workAngleRange);
+        void calculateCaps(QList<double> *caps, const double &capArrival, const double &workAngleStep, const double &workAngleRange);
+        isoColumns generateCandidates(const int &n, const QList<double> &caps, const bool &tryingToFindHole, int * nbCaps, int * nbCapsPruned);
+        void evaluateCandidates(QList<isoColumns> * batch) const;
+        void checkCandidates(QList<isoColumns> * batch) const;
+        isoColumns filterCandidates(const isoColumns &findPoints, const bool &tryingToFindHole, const int &dataWave, bool * toBeRestarted);
         bool aborted;
         bool running;
         int debugCross0;
@@ -343,7 +468,7 @@ public slots:
         QTimer * timerTempo;
         bool approaching;
         int zoomLevel;
-        QList<vlmPointGraphic *> isoPointList;
+        vlmPointGraphic * isoPoints;
         bool arrived;
         time_t eta, etaStart;
         QList<vlmLine *> isochrones;
@@ -375,6 +500,7 @@ public slots:
         QPolygonF shapeIso;
         QPolygonF shapeMiddle;
         void calculateShapeIso();
+        void setChildren(vlmLine * line);
         bool multiRoutage;
         int multiNb;
         int multiDays;
@@ -382,6 +508,9 @@ public slots:
         int multiMin;
         double maxDist;
         void calculateMaxDist();
+        RoutingContext context;
+        void buildContext();
+        void refreshContext();
 };
 Q_DECLARE_TYPEINFO(ROUTAGE,Q_MOVABLE_TYPE);
 #endif // ROUTAGE_H
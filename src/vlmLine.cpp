@@ -202,8 +202,7 @@ void vlmLine::calculatePoly(void)
                 proj->map2screenByReference(previousWorldPoint.lon,previousX,worldPoint.lon,worldPoint.lat,&X,&Y);
             bool reverseWorld=!proj->isInBounderies(X,Y) && proj->isPointVisible(worldPoint.lon,worldPoint.lat) && n!=0;
             poly->putPoints(n,1,X-x(),Y-y());
-            if(this->coastDetection && n!=0 && !coasted && map && map->crossing(QLineF(previousX,previousY,X,Y),
-               QLineF(previousWorldPoint.lon,previousWorldPoint.lat,worldPoint.lon,worldPoint.lat)))
+            if(this->coastDetection && n!=0 && !coasted && map && map->crossing(QLineF(previousWorldPoint.lon,previousWorldPoint.lat,worldPoint.lon,worldPoint.lat)))
             {
                 coasted=true;
                 coastDetected=true;
@@ -70,14 +70,12 @@ class vlmLine : public QGraphicsWidget
 
         int count(void) const { return line.count(); }
         void setPointDead(const int &n){this->line[n].isDead=true;}
-        void setPointStartCap(const int &n,const double &c){this->line[n].startCap=c;}
         void setPointWind(const int &n, const double &twd, const double &tws){this->line[n].wind_angle=twd;this->line[n].wind_speed=tws;}
         void setPointCurrent(const int &n, const double &cd, const double &cs){this->line[n].current_angle=cd;this->line[n].current_speed=cs;}
         void setPointDistIso(const int &n, const double &d){this->line[n].distIso=d;}
         void setPointCapVmg(const int &n, const double &d){this->line[n].capVmg=d;}
         void setPointcapOrigin(const int &n,const double &d){this->line[n].capOrigin=d;}
         void setPointIsoIndex(const int &n, const int &i){this->line[n].isoIndex=i;}
-        void setPointCoordProj(const int &n,const double &x,const double &y){this->line[n].lonProj=x;this->line[n].latProj=y;}
         void setNotSimplificable(const int &n){this->line[n].notSimplificable=true;}
         void setLastPointIsPoi(){this->line[line.count()-1].isPOI=true;}
         vlmPoint * getOrigin(const int &n) {return this->line[n].origin;}
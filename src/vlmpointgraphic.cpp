@@ -2,23 +2,23 @@
 #include "Util.h"
 #include <QGraphicsSceneMouseEvent>
 #include <QDebug>
+#include <qmath.h>
 
 #include "routage.h"
 
-vlmPointGraphic::vlmPointGraphic(ROUTAGE * routage,int isoNb, int pointIsoNb,double lon, double lat, Projection * proj, QGraphicsScene * myScene,int z_level) : QGraphicsWidget()
+vlmPointGraphic::vlmPointGraphic(ROUTAGE * routage, Projection * proj, QGraphicsScene * myScene,int z_level) : QGraphicsWidget()
 {
     this->proj=proj;
     this->myScene=myScene;
-    this->lon=lon;
-    this->lat=lat;
+    this->routage=routage;
+    hovered=-1;
+    pivotOnHover=false;
     connect(proj,SIGNAL(projectionUpdated()),this,SLOT(slot_showMe()));
     myScene->addItem(this);
     this->setZValue(z_level);
-    this->isoNb=isoNb;
-    this->pointIsoNb=pointIsoNb;
-    this->routage=routage;
-    debug="";
     setData(0,7);
+    setPos(0,0);
+    setAcceptHoverEvents(true);
     show();
 }
 vlmPointGraphic::~vlmPointGraphic()
@@ -26,59 +26,165 @@ vlmPointGraphic::~vlmPointGraphic()
 //    if(myScene!=NULL)
 //        myScene->removeItem(this);
 }
-void vlmPointGraphic::slot_showMe()
+void vlmPointGraphic::addPoint(int isoNb, int pointIsoNb, double lon, double lat, time_t eta)
 {
+    int n=lons.size();
+    lons.append(lon);
+    lats.append(lat);
+    etas.append(eta);
+    isoNbs.append(isoNb);
+    pointIsoNbs.append(pointIsoNb);
+    pointIndex.insert(pointKey(isoNb,pointIsoNb),n);
     int pi,pj;
-    Util::computePos(proj,lat, lon, &pi, &pj);
-    setPos(pi,pj);
+    Util::computePos(proj,lat,lon,&pi,&pj);
+    screenPos.append(QPoint(pi,pj));
+    QRectF r(pi-ISOPOINT_HALF_SIZE,pj-ISOPOINT_HALF_SIZE,ISOPOINT_CELL_SIZE,ISOPOINT_CELL_SIZE);
+    if(!bRect.contains(r))
+    {
+        prepareGeometryChange();
+        bRect=bRect.isNull()?r:bRect.united(r);
+    }
+    indexPoint(n);
+}
+int vlmPointGraphic::cellOf(int v)
+{
+    /* floor division, screen positions can be negative */
+    return v>=0?v/ISOPOINT_CELL_SIZE:-((-v-1)/ISOPOINT_CELL_SIZE)-1;
+}
+void vlmPointGraphic::indexPoint(int n)
+{
+    const QPoint &p=screenPos.at(n);
+    grid[cellKey(cellOf(p.x()),cellOf(p.y()))].append(n);
+}
+void vlmPointGraphic::slot_showMe()
+{
+    set_hovered(-1);
+    prepareGeometryChange();
+    grid.clear();
+    bRect=QRectF();
+    if(lons.isEmpty()) return;
+    int xMin=0,xMax=0,yMin=0,yMax=0;
+    for(int n=0;n<lons.size();++n)
+    {
+        int pi,pj;
+        Util::computePos(proj,lats.at(n),lons.at(n),&pi,&pj);
+        screenPos[n]=QPoint(pi,pj);
+        if(n==0 || pi<xMin) xMin=pi;
+        if(n==0 || pi>xMax) xMax=pi;
+        if(n==0 || pj<yMin) yMin=pj;
+        if(n==0 || pj>yMax) yMax=pj;
+        indexPoint(n);
+    }
+    bRect=QRectF(xMin-ISOPOINT_HALF_SIZE,yMin-ISOPOINT_HALF_SIZE,
+                 xMax-xMin+ISOPOINT_CELL_SIZE,yMax-yMin+ISOPOINT_CELL_SIZE);
 }
 QRectF vlmPointGraphic::boundingRect() const
 {
-    return QRectF(-10,-10,20,20);
+    return bRect;
+}
+/* the last point added wins, as the top most item did when each
+   point had its own graphics item */
+int vlmPointGraphic::pointAt(const QPointF &pos) const
+{
+    int x=qFloor(pos.x());
+    int y=qFloor(pos.y());
+    int cx=cellOf(x);
+    int cy=cellOf(y);
+    int found=-1;
+    for(int i=cx-1;i<=cx+1;++i)
+    {
+        for(int j=cy-1;j<=cy+1;++j)
+        {
+            QHash<qint64,QVector<int> >::const_iterator it=grid.constFind(cellKey(i,j));
+            if(it==grid.constEnd()) continue;
+            const QVector<int> &cell=it.value();
+            for(int k=cell.size()-1;k>=0;--k)
+            {
+                int n=cell.at(k);
+                if(n<=found) break;
+                const QPoint &p=screenPos.at(n);
+                if(x>=p.x()-ISOPOINT_HALF_SIZE && x<p.x()+ISOPOINT_HALF_SIZE &&
+                   y>=p.y()-ISOPOINT_HALF_SIZE && y<p.y()+ISOPOINT_HALF_SIZE)
+                {
+                    found=n;
+                    break;
+                }
+            }
+        }
+    }
+    return found;
 }
-void vlmPointGraphic::setEta(time_t eta)
+bool vlmPointGraphic::contains(const QPointF &point) const
+{
+    return pointAt(point)!=-1;
+}
+QString vlmPointGraphic::tipOf(int n) const
 {
-    this->eta=eta;
     QDateTime tm;
     tm.setTimeSpec(Qt::UTC);
-    tm.setTime_t(eta);
-    if(this->debug.isEmpty())
-        this->setToolTip("eta: "+tm.toString("dd MMM-hh:mm"));
-    else
-        this->setToolTip("eta: "+tm.toString("dd MMM-hh:mm")
-                     +"<br>IsoNb->"+QString().setNum(isoNb)+" pt nb->"+QString().setNum(this->pointIsoNb)
-                     +"<br>debug->"+this->debug);
+    tm.setTime_t(etas.at(n));
+    QString tip="eta: "+tm.toString("dd MMM-hh:mm");
+    QHash<int,QString>::const_iterator it=extraTips.constFind(n);
+    if(it==extraTips.constEnd())
+        return tip;
+    tip=tip+"<br>"+it.value();
+    return tip.replace(" ","&nbsp;");
 }
 void vlmPointGraphic::slot_updateTip(int i,int n, QString t)
 {
-    if(i!=isoNb) return;
-    if(n!=pointIsoNb) return;
-    setEta(eta);
-    QString newtip=this->toolTip()+"<br>"+t;
-    newtip=newtip.replace(" ","&nbsp;");
-    setToolTip(newtip);
+    QHash<qint64,int>::const_iterator it=pointIndex.constFind(pointKey(i,n));
+    if(it==pointIndex.constEnd()) return;
+    extraTips.insert(it.value(),t);
+    if(it.value()==hovered)
+        setToolTip(tipOf(hovered));
 }
 
+/* tooltips are available as soon as points are added, the way
+   to the pivot point only once the routage is done */
 void  vlmPointGraphic::setAcceptHover()
 {
-    this->setAcceptHoverEvents(true);
+    this->pivotOnHover=true;
+}
+void vlmPointGraphic::set_hovered(int n)
+{
+    if(n==hovered) return;
+    if(hovered!=-1)
+        routage->eraseWay();
+    hovered=n;
+    if(hovered==-1)
+    {
+        setToolTip(QString());
+        return;
+    }
+    setToolTip(tipOf(hovered));
+    if(!pivotOnHover || !routage->getShowIso())
+        return;
+    routage->setPivotPoint(isoNbs.at(hovered),pointIsoNbs.at(hovered));
+    routage->slot_drawWay();
 }
 
 void  vlmPointGraphic::hoverLeaveEvent ( QGraphicsSceneHoverEvent * )
 {
-    routage->eraseWay();
+    set_hovered(-1);
 }
-void  vlmPointGraphic::hoverEnterEvent ( QGraphicsSceneHoverEvent * )
+void  vlmPointGraphic::hoverEnterEvent ( QGraphicsSceneHoverEvent * e)
 {
-    if(!routage->getShowIso())
-        return;
-    routage->setPivotPoint(this->isoNb,this->pointIsoNb);
-    routage->slot_drawWay();
+    set_hovered(pointAt(e->pos()));
+}
+void  vlmPointGraphic::hoverMoveEvent ( QGraphicsSceneHoverEvent * e)
+{
+    set_hovered(pointAt(e->pos()));
 }
 
-void vlmPointGraphic::contextMenuEvent(QGraphicsSceneContextMenuEvent *)
+void vlmPointGraphic::contextMenuEvent(QGraphicsSceneContextMenuEvent * e)
 {
-    routage->showContextMenu(this->isoNb,this->pointIsoNb);
+    int n=pointAt(e->pos());
+    if(n==-1)
+    {
+        e->ignore();
+        return;
+    }
+    routage->showContextMenu(isoNbs.at(n),pointIsoNbs.at(n));
 }
 void vlmPointGraphic::paint(QPainter *, const QStyleOptionGraphicsItem * , QWidget * )
 {
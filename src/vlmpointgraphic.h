@@ -4,27 +4,35 @@
 #include <QGraphicsWidget>
 #include <QPainter>
 #include <QObject>
+#include <QVector>
+#include <QHash>
 #include "Projection.h"
 #include "class_list.h"
 
+/* hit box half size of an isochrone point, in pixels */
+#define ISOPOINT_HALF_SIZE 10
+/* side of a cell of the screen index, in pixels */
+#define ISOPOINT_CELL_SIZE (2*ISOPOINT_HALF_SIZE)
+
+/* all the isochrone points of a routage in one graphics item:
+   points are stored in packed arrays and hover/tooltip/context menu
+   hit tests are answered by a grid index of their screen positions */
 class vlmPointGraphic : public QGraphicsWidget
 { Q_OBJECT
 public:
-    vlmPointGraphic(ROUTAGE * routage,int isoNb, int pointIsoNb, double lon, double lat, Projection * proj, QGraphicsScene * myScene,int z_level);
+    vlmPointGraphic(ROUTAGE * routage, Projection * proj, QGraphicsScene * myScene,int z_level);
     ~vlmPointGraphic();
-    void setIsoNb(int n){this->isoNb=n;}
-    void setPointIsoNb(int n){this->pointIsoNb=n;}
-    void setEta(time_t eta);
+    void addPoint(int isoNb, int pointIsoNb, double lon, double lat, time_t eta);
     void shown(bool b){if (b) show(); else hide();}
-    void setDebug(QString f){this->debug=f;}
-    void createPopupMenu();
     ROUTAGE * getRoutage(){return routage;}
     void setAcceptHover();
+    bool contains(const QPointF &point) const;
 protected:
     void paint(QPainter * pnt, const QStyleOptionGraphicsItem * , QWidget * );
     QRectF boundingRect() const;
     void contextMenuEvent(QGraphicsSceneContextMenuEvent * e);
     void hoverEnterEvent(QGraphicsSceneHoverEvent *event);
+    void hoverMoveEvent(QGraphicsSceneHoverEvent *event);
     void hoverLeaveEvent(QGraphicsSceneHoverEvent *event);
 
 public slots:
@@ -34,12 +42,28 @@ private:
     QGraphicsScene * myScene;
     Projection * proj;
     ROUTAGE * routage;
-    int isoNb;
-    int pointIsoNb;
-    double lon,lat;
-    time_t eta;
-    QString debug;
+
+    QVector<double> lons;
+    QVector<double> lats;
+    QVector<time_t> etas;
+    QVector<int> isoNbs;
+    QVector<int> pointIsoNbs;
+    QVector<QPoint> screenPos;
+    QHash<int,QString> extraTips;
+    QHash<qint64,int> pointIndex;
+
+    QHash<qint64,QVector<int> > grid;
+    QRectF bRect;
+    int hovered;
+    bool pivotOnHover;
+
+    static qint64 pointKey(int isoNb,int pointIsoNb) {return ((qint64)isoNb<<32)|(quint32)pointIsoNb;}
+    static qint64 cellKey(int x,int y) {return ((qint64)x<<32)|(quint32)y;}
+    static int cellOf(int v);
+    void indexPoint(int n);
+    int pointAt(const QPointF &pos) const;
+    void set_hovered(int n);
+    QString tipOf(int n) const;
 };
-Q_DECLARE_TYPEINFO(vlmPointGraphic,Q_MOVABLE_TYPE);
 
 #endif // VLMPOINTGRAPHIC_H